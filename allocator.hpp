@@ -23,6 +23,11 @@ public:
 		return reinterpret_cast<T *>(alloc_template::allocate(sizeof(T) * n));
 	}
 
+	/* n 个相邻的 T, 之后可以逐个 deallocate; 分配器不支持时返回 nullptr */
+	static T *allocate_contiguous(std::size_t n) {
+		return reinterpret_cast<T *>(alloc_template::allocate_contiguous(sizeof(T), n));
+	}
+
 	static void deallocate(T *ptr) {
 		return alloc_template::deallocate(static_cast<void *>(ptr), sizeof(T));
 	}
@@ -0,0 +1,1047 @@
+﻿#ifndef M_BTREE_HPP
+#define M_BTREE_HPP
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include "allocator.hpp"
+#include "construct.hpp"
+#include "iterator.hpp"
+#include "type_traits.hpp"
+#include "utility.hpp"
+
+namespace sx {
+
+template<typename Key, typename Value, typename KeyOfValue,
+	typename Compare, typename Alloc, std::size_t TargetNodeSize = 256>
+class btree;
+
+template<typename Key, typename Value, typename KeyOfValue,
+	typename Compare, typename Alloc, std::size_t TargetNodeSize>
+void swap(btree<Key, Value, KeyOfValue, Compare, Alloc, TargetNodeSize> &, btree<Key, Value, KeyOfValue, Compare, Alloc, TargetNodeSize> &) noexcept;
+
+
+/*
+ * B 树结点. 元素直接放在结点内连续的数组中, 一次缓存未命中就能比较一批 key;
+ * 叶子没有孩子指针, 内部结点在此之后再放 Slots + 1 个孩子
+ */
+template<typename Value, std::size_t Slots>
+struct __btree_node {
+	__btree_node	*parent;		/* 父结点, 根结点为 nullptr */
+	std::uint16_t	position;		/* 在父结点孩子数组中的下标 */
+	std::uint16_t	count;			/* 元素数量 */
+	bool			is_leaf;		/* 是否为叶子 */
+	alignas(Value) unsigned char	storage[Slots * sizeof(Value)];	/* 元素, 只有前 count 个已构造 */
+public:
+	explicit __btree_node(bool is_leaf) noexcept : parent(nullptr), position(0), count(0), is_leaf(is_leaf) {}
+
+	Value *value(std::size_t i) noexcept {
+		return reinterpret_cast<Value *>(storage) + i;
+	}
+
+	__btree_node *&child(std::size_t i) noexcept;
+};
+
+/* 第 i 个孩子中的元素都位于第 i - 1 个和第 i 个元素之间 */
+template<typename Value, std::size_t Slots>
+struct __btree_internal_node : public __btree_node<Value, Slots> {
+	__btree_node<Value, Slots>	*children[Slots + 1];
+public:
+	__btree_internal_node() noexcept : __btree_node<Value, Slots>(false) {}
+};
+
+template<typename Value, std::size_t Slots>
+inline __btree_node<Value, Slots> *&__btree_node<Value, Slots>::child(std::size_t i) noexcept {
+	return static_cast<__btree_internal_node<Value, Slots> *>(this)->children[i];
+}
+
+/* 每个结点的元素个数: 让叶子的大小接近 TargetNodeSize 字节, 至少 3 个 */
+template<typename Value, std::size_t TargetNodeSize>
+struct __btree_slots {
+	static constexpr std::size_t header	= sizeof(void *) + 2 * sizeof(std::uint16_t) + sizeof(bool);
+	static constexpr std::size_t fit	= TargetNodeSize > header ? (TargetNodeSize - header) / sizeof(Value) : 0;
+	static constexpr std::size_t value	= fit < 3 ? 3 : fit;
+
+	static_assert(value <= 0xffff, "too many values in one btree node");
+};
+
+
+/* 迭代器保存结点和结点内的下标; end() 是最右叶子的 (结点, count) */
+template<typename Value, std::size_t Slots, typename Ptr, typename Ref>
+struct __btree_iterator {
+	template<typename, typename, typename, typename, typename, std::size_t>
+	friend class btree;
+
+	template<typename, std::size_t, typename, typename>
+	friend struct __btree_iterator;
+
+	using value_type		= Value;
+	using pointer			= Ptr;
+	using reference			= Ref;
+	using difference_type	= std::ptrdiff_t;
+	using iterator_category = sx::bidirectional_iterator_tag;
+	using node_ptr			= __btree_node<Value, Slots> *;
+private:
+	node_ptr	node;
+	int			position;
+public:
+	__btree_iterator() noexcept : node(nullptr), position(0) {}
+	__btree_iterator(node_ptr node, int position) noexcept : node(node), position(position) {}
+	__btree_iterator(__btree_iterator const &) = default;
+	__btree_iterator &operator=(__btree_iterator const &) = default;
+
+	/* 普通迭代器可以隐式转换为 const 迭代器 */
+	template<typename OtherPtr, typename OtherRef, typename = std::enable_if_t<
+		std::is_same_v<Ptr, Value const *> && std::is_same_v<OtherPtr, Value *>>>
+	__btree_iterator(__btree_iterator<Value, Slots, OtherPtr, OtherRef> const &other) noexcept
+		: node(other.node), position(other.position) {}
+	~__btree_iterator() = default;
+public:
+	reference operator*() const noexcept {
+		return *node->value(position);
+	}
+
+	pointer operator->() const noexcept {
+		return &(this->operator*());
+	}
+
+	__btree_iterator operator++(int) noexcept {
+		__btree_iterator ret = *this;
+		increment();
+		return ret;
+	}
+
+	__btree_iterator &operator++() noexcept {
+		increment();
+		return *this;
+	}
+
+	__btree_iterator operator--(int) noexcept {
+		__btree_iterator ret = *this;
+		decrement();
+		return ret;
+	}
+
+	__btree_iterator &operator--() noexcept {
+		decrement();
+		return *this;
+	}
+
+	friend bool operator==(__btree_iterator const &first, __btree_iterator const &second) noexcept {
+		return first.node == second.node && first.position == second.position;
+	}
+
+	friend bool operator!=(__btree_iterator const &first, __btree_iterator const &second) noexcept {
+		return !(first == second);
+	}
+private:
+	/* 对 end() 自增是未定义行为 */
+	void increment() noexcept {
+		if (!node->is_leaf) {
+			node = node->child(position + 1);
+			while (!node->is_leaf)
+				node = node->child(0);
+			position = 0;
+			return;
+		}
+
+		if (++position < node->count)
+			return;
+
+		/* 叶子走完后回到第一个还有后续元素的祖先, 已经是最后一个元素时停在 end() */
+		node_ptr leaf = node;
+		while (position == node->count && node->parent != nullptr) {
+			position = node->position;
+			node = node->parent;
+		}
+		if (position == node->count) {
+			node = leaf;
+			position = leaf->count;
+		}
+	}
+
+	/* end() 自减得到最大元素, 对 begin() 自减是未定义行为 */
+	void decrement() noexcept {
+		if (!node->is_leaf) {
+			node = node->child(position);
+			while (!node->is_leaf)
+				node = node->child(node->count);
+			position = node->count - 1;
+			return;
+		}
+
+		while (position == 0 && node->parent != nullptr) {
+			position = node->position;
+			node = node->parent;
+		}
+		--position;
+	}
+};
+
+
+/*
+ * B 树: 每个结点存放 node_slots 个元素, 默认让叶子约为 256 字节 (4 个缓存行).
+ * 查找时每层只访问一个结点, 树高约为 log(n) / log(node_slots), 比红黑树少得多的指针跳转.
+ * 插入和删除会在结点之间移动元素, 所有迭代器和指向元素的指针都会失效;
+ * 元素的移动构造不应抛出异常
+ */
+template<typename Key, typename Value, typename KeyOfValue,
+	typename Compare, typename Alloc, std::size_t TargetNodeSize>
+class btree : public sx::container_helpful<btree<Key, Value, KeyOfValue, Compare, Alloc, TargetNodeSize>> {
+public:
+	static constexpr std::size_t node_slots = sx::__btree_slots<Value, TargetNodeSize>::value;
+
+	using key_type			= Key;
+	using value_type		= Value;
+	using pointer			= value_type *;
+	using reference			= value_type &;
+	using const_pointer		= value_type const *;
+	using const_reference	= value_type const &;
+	using size_type			= std::size_t;
+	using difference_type	= std::ptrdiff_t;
+	using iterator			= sx::__btree_iterator<Value, node_slots, Value *, Value &>;
+	using const_iterator	= sx::__btree_iterator<Value, node_slots, Value const *, Value const &>;
+protected:
+	using btree_node		= sx::__btree_node<Value, node_slots>;
+	using internal_node		= sx::__btree_internal_node<Value, node_slots>;
+	using node_ptr			= btree_node *;
+	using LeafAllocator		= decltype(sx::transform_alloator_type<Value, btree_node>(Alloc{}));
+	using InternalAllocator	= decltype(sx::transform_alloator_type<Value, internal_node>(Alloc{}));
+
+	/* 删除后元素少于一半的结点和兄弟合并, 或者从兄弟借元素 */
+	static constexpr int min_slots = static_cast<int>(node_slots / 2);
+protected:
+	static LeafAllocator		leaf_allocator;		/* 叶子分配器 */
+	static InternalAllocator	internal_allocator;	/* 内部结点分配器 */
+	node_ptr					root_node;			/* 根结点, 空树为 nullptr */
+	node_ptr					leftmost_node;		/* 最左叶子, begin() 所在 */
+	node_ptr					rightmost_node;		/* 最右叶子, end() 所在 */
+	size_type					node_size;			/* 元素数量 */
+	Compare						comp;				/* 比较器 */
+protected:
+	static node_ptr __create_leaf() {
+		btree_node *node = leaf_allocator.allocate(1);
+		leaf_allocator.construct(node, true);
+		return node;
+	}
+
+	static node_ptr __create_internal() {
+		internal_node *node = internal_allocator.allocate(1);
+		internal_allocator.construct(node);
+		return node;
+	}
+
+	/* 只释放结点本身, 其中的元素由调用者先析构或者移走 */
+	static void __destroy_node(node_ptr node) noexcept {
+		if (node->is_leaf) {
+			leaf_allocator.destroy(node);
+			leaf_allocator.deallocate(node, sizeof(btree_node));
+		} else {
+			internal_node *internal = static_cast<internal_node *>(node);
+			internal_allocator.destroy(internal);
+			internal_allocator.deallocate(internal, sizeof(internal_node));
+		}
+	}
+
+	static void __destroy(node_ptr node) noexcept {
+		for (int i = 0; i < node->count; ++i)
+			sx::destroy(node->value(i));
+		if (!node->is_leaf) {
+			for (int i = 0; i <= node->count; ++i)
+				__destroy(node->child(i));
+		}
+		__destroy_node(node);
+	}
+
+	static Key const &__key(node_ptr node, int i) noexcept {
+		return KeyOfValue()(*node->value(i));
+	}
+
+	/* 把 src 处的元素移动构造到未初始化的 dst 处, 再析构 src */
+	static void __relocate(Value *dst, Value *src) {
+		sx::construct(dst, std::move(*src));
+		sx::destroy(src);
+	}
+
+	/* 结点内 [first, last) 的元素整体移动 offset 个位置, 目标位置未初始化或者已经移走 */
+	static void __shift_values(node_ptr node, int first, int last, int offset) {
+		if (offset > 0) {
+			for (int i = last; i-- > first; )
+				__relocate(node->value(i + offset), node->value(i));
+		} else {
+			for (int i = first; i < last; ++i)
+				__relocate(node->value(i + offset), node->value(i));
+		}
+	}
+
+	/* 把 src 中从 src_first 开始的 n 个元素移到另一个结点 dst 的 dst_first 处 */
+	static void __transfer_values(node_ptr dst, int dst_first, node_ptr src, int src_first, int n) {
+		for (int i = 0; i < n; ++i)
+			__relocate(dst->value(dst_first + i), src->value(src_first + i));
+	}
+
+	static void __set_child(node_ptr node, int i, node_ptr child) noexcept {
+		node->child(i) = child;
+		child->parent = node;
+		child->position = static_cast<std::uint16_t>(i);
+	}
+
+	/* 孩子的移动同时更新孩子记录的父结点和下标 */
+	static void __shift_children(node_ptr node, int first, int last, int offset) noexcept {
+		if (offset > 0) {
+			for (int i = last; i-- > first; )
+				__set_child(node, i + offset, node->child(i));
+		} else {
+			for (int i = first; i < last; ++i)
+				__set_child(node, i + offset, node->child(i));
+		}
+	}
+
+	static void __transfer_children(node_ptr dst, int dst_first, node_ptr src, int src_first, int n) noexcept {
+		for (int i = 0; i < n; ++i)
+			__set_child(dst, dst_first + i, src->child(src_first + i));
+	}
+
+	static node_ptr __leftmost_leaf(node_ptr node) noexcept {
+		while (!node->is_leaf)
+			node = node->child(0);
+		return node;
+	}
+
+	static node_ptr __rightmost_leaf(node_ptr node) noexcept {
+		while (!node->is_leaf)
+			node = node->child(node->count);
+		return node;
+	}
+
+	/* 按原样复制 source 子树: 元素个数和分布都不变, 不比较 key */
+	static node_ptr __copy(node_ptr source, node_ptr parent) {
+		node_ptr node = source->is_leaf ? __create_leaf() : __create_internal();
+		node->parent = parent;
+		node->position = source->position;
+		int children = 0;
+		try {
+			for (; node->count < source->count; ++node->count)
+				sx::construct(node->value(node->count), *source->value(node->count));
+			if (!source->is_leaf) {
+				for (; children <= source->count; ++children)
+					node->child(children) = __copy(source->child(children), node);
+			}
+		} catch (...) {
+			for (int i = 0; i < children; ++i)
+				__destroy(node->child(i));
+			for (int i = 0; i < node->count; ++i)
+				sx::destroy(node->value(i));
+			__destroy_node(node);
+			throw;
+		}
+		return node;
+	}
+
+	iterator __end() const noexcept {
+		return iterator(rightmost_node, rightmost_node != nullptr ? rightmost_node->count : 0);
+	}
+
+	/* 结点内第一个不小于 key 的下标 */
+	template<typename K>
+	int __lower_index(node_ptr node, K const &key) const {
+		int first = 0, last = node->count;
+		while (first < last) {
+			int mid = (first + last) >> 1;
+			if (comp(__key(node, mid), key))
+				first = mid + 1;
+			else
+				last = mid;
+		}
+		return first;
+	}
+
+	/* 结点内第一个大于 key 的下标 */
+	template<typename K>
+	int __upper_index(node_ptr node, K const &key) const {
+		int first = 0, last = node->count;
+		while (first < last) {
+			int mid = (first + last) >> 1;
+			if (!comp(key, __key(node, mid)))
+				first = mid + 1;
+			else
+				last = mid;
+		}
+		return first;
+	}
+
+	/* 从根向下, 每层记下结点内的候选位置, 越深的候选越靠前 */
+	template<typename K>
+	iterator __lower_bound(K const &key) const {
+		iterator result = __end();
+		node_ptr node = root_node;
+		while (node != nullptr) {
+			int i = __lower_index(node, key);
+			if (i < node->count)
+				result = iterator(node, i);
+			if (node->is_leaf)
+				break;
+			node = node->child(i);
+		}
+		return result;
+	}
+
+	template<typename K>
+	iterator __upper_bound(K const &key) const {
+		iterator result = __end();
+		node_ptr node = root_node;
+		while (node != nullptr) {
+			int i = __upper_index(node, key);
+			if (i < node->count)
+				result = iterator(node, i);
+			if (node->is_leaf)
+				break;
+			node = node->child(i);
+		}
+		return result;
+	}
+
+	template<typename K>
+	iterator __find(K const &key) const {
+		iterator iter = __lower_bound(key);
+		if (iter == __end() || comp(key, KeyOfValue()(*iter)))
+			return __end();
+		return iter;
+	}
+
+	template<typename K>
+	size_type __count(K const &key) const {
+		size_type count = 0;
+		for (iterator first = __lower_bound(key), last = __upper_bound(key); first != last; ++first)
+			++count;
+		return count;
+	}
+
+	/* 唯一插入: 任何一层遇到相同 key 即返回该元素, 否则返回叶子中应插入的位置 */
+	template<typename K>
+	std::pair<iterator, bool> __unique_position(K const &key) const {
+		node_ptr node = root_node;
+		if (node == nullptr)
+			return std::pair<iterator, bool>(iterator(), true);
+		while (true) {
+			int i = __lower_index(node, key);
+			if (i < node->count && !comp(key, __key(node, i)))
+				return std::pair<iterator, bool>(iterator(node, i), false);
+			if (node->is_leaf)
+				return std::pair<iterator, bool>(iterator(node, i), true);
+			node = node->child(i);
+		}
+	}
+
+	/* 可重复插入: 排在相同 key 的元素之后 */
+	iterator __equal_position(Key const &key) const {
+		node_ptr node = root_node;
+		if (node == nullptr)
+			return iterator();
+		while (true) {
+			int i = __upper_index(node, key);
+			if (node->is_leaf)
+				return iterator(node, i);
+			node = node->child(i);
+		}
+	}
+
+	/* 紧挨在 position 之前的叶子位置: position 在内部结点时, 它的前驱一定是某个叶子的最后一个元素 */
+	iterator __leaf_position(iterator position) const noexcept {
+		if (position.node == nullptr || position.node->is_leaf)
+			return position;
+		--position;
+		++position.position;
+		return position;
+	}
+
+	/*
+	 * 结点已满, 先保证父结点有空位 (必要时递归分裂), 再把后半部分移到新的右兄弟, 中间的元素上移到父结点.
+	 * 在末尾插入时左边留满, 在开头插入时右边留满, 顺序插入的结点几乎都是满的.
+	 * 返回时 node 和 position 指向分裂后应该插入的位置
+	 */
+	void __split(node_ptr &node, int &position) {
+		node_ptr parent = node->parent;
+		if (parent == nullptr) {
+			parent = root_node = __create_internal();
+			__set_child(parent, 0, node);
+		} else if (parent->count == node_slots) {
+			int index = node->position;
+			__split(parent, index);
+			parent = node->parent;
+		}
+
+		int left_count = position == static_cast<int>(node_slots) ? static_cast<int>(node_slots) - 1
+			: position == 0 ? 0 : static_cast<int>(node_slots / 2);
+		int right_count = static_cast<int>(node_slots) - left_count - 1;
+		node_ptr sibling = node->is_leaf ? __create_leaf() : __create_internal();
+		__transfer_values(sibling, 0, node, left_count + 1, right_count);
+		if (!node->is_leaf)
+			__transfer_children(sibling, 0, node, left_count + 1, right_count + 1);
+
+		int index = node->position;
+		__shift_values(parent, index, parent->count, 1);
+		__shift_children(parent, index + 1, parent->count + 1, 1);
+		__relocate(parent->value(index), node->value(left_count));
+		__set_child(parent, index + 1, sibling);
+		++parent->count;
+		node->count = static_cast<std::uint16_t>(left_count);
+		sibling->count = static_cast<std::uint16_t>(right_count);
+		if (rightmost_node == node)
+			rightmost_node = sibling;
+
+		if (position > left_count) {
+			node = sibling;
+			position -= left_count + 1;
+		}
+	}
+
+	/* 在叶子的 position 处构造新元素; 空树时先建根 */
+	template<typename... Args>
+	iterator __emplace_at(iterator position, Args&&... args) {
+		node_ptr node = position.node;
+		int index = position.position;
+		if (node == nullptr) {
+			node = root_node = leftmost_node = rightmost_node = __create_leaf();
+			index = 0;
+		} else if (node->count == node_slots) {
+			__split(node, index);
+		}
+
+		__shift_values(node, index, node->count, 1);
+		try {
+			sx::construct(node->value(index), std::forward<Args>(args)...);
+		} catch (...) {
+			__shift_values(node, index + 1, node->count + 1, -1);
+			throw;
+		}
+		++node->count;
+		++node_size;
+		return iterator(node, index);
+	}
+
+	/* hint 恰好是新元素的后继时直接在相邻位置插入, 不再从根查找 */
+	template<typename... Args>
+	std::pair<iterator, bool> __emplace_hint_unique(const_iterator hint, Key const &key, Args&&... args) {
+		iterator position = transform_iterator(hint);
+		if (position == end() || comp(key, KeyOfValue()(*position))) {
+			iterator before = position;
+			if (position == begin() || comp(KeyOfValue()(*--before), key))
+				return std::pair<iterator, bool>(__emplace_at(__leaf_position(position), std::forward<Args>(args)...), true);
+		}
+
+		std::pair<iterator, bool> ret = __unique_position(key);
+		if (!ret.second)
+			return ret;
+		return std::pair<iterator, bool>(__emplace_at(ret.first, std::forward<Args>(args)...), true);
+	}
+
+	template<typename... Args>
+	iterator __emplace_hint_equal(const_iterator hint, Key const &key, Args&&... args) {
+		iterator position = transform_iterator(hint);
+		if (position == end() || !comp(KeyOfValue()(*position), key)) {
+			iterator before = position;
+			if (position == begin() || !comp(key, KeyOfValue()(*--before)))
+				return __emplace_at(__leaf_position(position), std::forward<Args>(args)...);
+		}
+		return __emplace_at(__equal_position(key), std::forward<Args>(args)...);
+	}
+
+	/*
+	 * 把分隔元素和 right 的全部内容并入左兄弟 left, 然后释放 right.
+	 * next 是被删除元素的后继, 随元素一起移动
+	 */
+	void __merge(node_ptr left, node_ptr right, iterator &next) {
+		node_ptr parent = left->parent;
+		int index = left->position;
+		int left_count = left->count;
+		__relocate(left->value(left_count), parent->value(index));
+		__transfer_values(left, left_count + 1, right, 0, right->count);
+		if (!left->is_leaf)
+			__transfer_children(left, left_count + 1, right, 0, right->count + 1);
+		__shift_values(parent, index + 1, parent->count, -1);
+		__shift_children(parent, index + 2, parent->count + 1, -1);
+		--parent->count;
+		left->count = static_cast<std::uint16_t>(left_count + 1 + right->count);
+
+		if (next.node == right)
+			next = iterator(left, next.position + left_count + 1);
+		else if (next.node == parent && next.position == index)
+			next = iterator(left, left_count);
+		else if (next.node == parent && next.position > index)
+			--next.position;
+
+		if (rightmost_node == right)
+			rightmost_node = left;
+		__destroy_node(right);
+	}
+
+	/* 分隔元素下移到 node 末尾, right 的前 k - 1 个元素跟在后面, 第 k 个上移成为新的分隔元素 */
+	void __borrow_from_right(node_ptr node, node_ptr right, iterator &next) {
+		node_ptr parent = node->parent;
+		int index = node->position;
+		int count = node->count;
+		int k = (right->count - count) / 2;
+		if (k < 1)
+			k = 1;
+
+		__relocate(node->value(count), parent->value(index));
+		__transfer_values(node, count + 1, right, 0, k - 1);
+		__relocate(parent->value(index), right->value(k - 1));
+		__shift_values(right, k, right->count, -k);
+		if (!node->is_leaf) {
+			__transfer_children(node, count + 1, right, 0, k);
+			__shift_children(right, k, right->count + 1, -k);
+		}
+		node->count = static_cast<std::uint16_t>(count + k);
+		right->count = static_cast<std::uint16_t>(right->count - k);
+
+		if (next.node == parent && next.position == index) {
+			next = iterator(node, count);
+		} else if (next.node == right) {
+			if (next.position < k - 1)
+				next = iterator(node, count + 1 + next.position);
+			else if (next.position == k - 1)
+				next = iterator(parent, index);
+			else
+				next.position -= k;
+		}
+	}
+
+	/* 与 __borrow_from_right 对称: left 的最后 k 个元素经过分隔元素移到 node 开头 */
+	void __borrow_from_left(node_ptr left, node_ptr node, iterator &next) {
+		node_ptr parent = node->parent;
+		int index = left->position;
+		int count = node->count;
+		int left_count = left->count;
+		int k = (left_count - count) / 2;
+		if (k < 1)
+			k = 1;
+
+		__shift_values(node, 0, count, k);
+		__relocate(node->value(k - 1), parent->value(index));
+		__transfer_values(node, 0, left, left_count - k + 1, k - 1);
+		__relocate(parent->value(index), left->value(left_count - k));
+		if (!node->is_leaf) {
+			__shift_children(node, 0, count + 1, k);
+			__transfer_children(node, 0, left, left_count - k + 1, k);
+		}
+		left->count = static_cast<std::uint16_t>(left_count - k);
+		node->count = static_cast<std::uint16_t>(count + k);
+
+		if (next.node == node) {
+			next.position += k;
+		} else if (next.node == parent && next.position == index) {
+			next = iterator(node, k - 1);
+		} else if (next.node == left && next.position >= left_count - k) {
+			if (next.position == left_count - k)
+				next = iterator(parent, index);
+			else
+				next = iterator(node, next.position - (left_count - k + 1));
+		}
+	}
+
+	/* 从删除了元素的结点开始向上修复, 能合并就合并, 否则从元素较多的兄弟借一半差额 */
+	void __rebalance(node_ptr node, iterator &next) {
+		while (node != root_node) {
+			if (node->count >= min_slots)
+				return;
+
+			node_ptr parent = node->parent;
+			int index = node->position;
+			node_ptr left = index > 0 ? parent->child(index - 1) : nullptr;
+			node_ptr right = index < parent->count ? parent->child(index + 1) : nullptr;
+			if (left != nullptr && left->count + node->count < static_cast<int>(node_slots)) {
+				__merge(left, node, next);
+			} else if (right != nullptr && node->count + right->count < static_cast<int>(node_slots)) {
+				__merge(node, right, next);
+			} else {
+				if (right != nullptr && (left == nullptr || right->count >= left->count))
+					__borrow_from_right(node, right, next);
+				else
+					__borrow_from_left(left, node, next);
+				return;
+			}
+			node = parent;
+		}
+
+		/* 根结点空了, 树降低一层 */
+		if (root_node->count == 0) {
+			node_ptr old_root = root_node;
+			if (old_root->is_leaf) {
+				root_node = leftmost_node = rightmost_node = nullptr;
+			} else {
+				root_node = old_root->child(0);
+				root_node->parent = nullptr;
+				root_node->position = 0;
+			}
+			__destroy_node(old_root);
+		}
+	}
+public:
+	btree() : root_node(nullptr), leftmost_node(nullptr), rightmost_node(nullptr), node_size(0) {}
+
+	btree(Compare const &comp) : root_node(nullptr), leftmost_node(nullptr), rightmost_node(nullptr),
+		node_size(0), comp(comp) {}
+
+	btree(btree const &other) : btree(other.comp) {
+		if (other.root_node == nullptr)
+			return;
+		root_node = __copy(other.root_node, nullptr);
+		leftmost_node = __leftmost_leaf(root_node);
+		rightmost_node = __rightmost_leaf(root_node);
+		node_size = other.node_size;
+	}
+
+	btree(btree &&other) noexcept : btree() {
+		swap(other);
+	}
+
+	btree &operator=(btree const &other) {
+		if (this == &other)
+			return *this;
+		btree tmp = other;
+		swap(tmp);
+		return *this;
+	}
+
+	btree &operator=(btree &&other) noexcept {
+		btree tmp = std::move(other);
+		swap(tmp);
+		return *this;
+	}
+
+	~btree() {
+		clear();
+	}
+public:
+	iterator begin() noexcept {
+		return iterator(leftmost_node, 0);
+	}
+
+	iterator end() noexcept {
+		return __end();
+	}
+
+	const_iterator begin() const noexcept {
+		return cbegin();
+	}
+
+	const_iterator end() const noexcept {
+		return cend();
+	}
+
+	const_iterator cbegin() const noexcept {
+		return const_iterator(leftmost_node, 0);
+	}
+
+	const_iterator cend() const noexcept {
+		return __end();
+	}
+
+	size_type size() const noexcept {
+		return node_size;
+	}
+
+	bool empty() const noexcept {
+		return node_size == 0;
+	}
+
+	void clear() noexcept {
+		if (root_node != nullptr)
+			__destroy(root_node);
+		root_node = leftmost_node = rightmost_node = nullptr;
+		node_size = 0;
+	}
+
+	std::pair<iterator, bool> insert_unique(Value const &value) {
+		return try_emplace_unique(KeyOfValue()(value), value);
+	}
+
+	/* 已有相同 key 时不构造元素 */
+	template<typename... Args>
+	std::pair<iterator, bool> try_emplace_unique(Key const &key, Args&&... args) {
+		std::pair<iterator, bool> ret = __unique_position(key);
+		if (!ret.second)
+			return ret;
+		return std::pair<iterator, bool>(__emplace_at(ret.first, std::forward<Args>(args)...), true);
+	}
+
+	/* 先在栈上构造出元素得到 key, 插入时再移动进结点 */
+	template<typename... Args>
+	std::pair<iterator, bool> emplace_unique(Args&&... args) {
+		Value value(std::forward<Args>(args)...);
+		return try_emplace_unique(KeyOfValue()(value), std::move(value));
+	}
+
+	std::pair<iterator, bool> insert_unique(const_iterator hint, Value const &value) {
+		return __emplace_hint_unique(hint, KeyOfValue()(value), value);
+	}
+
+	template<typename... Args>
+	std::pair<iterator, bool> emplace_hint_unique(const_iterator hint, Args&&... args) {
+		Value value(std::forward<Args>(args)...);
+		return __emplace_hint_unique(hint, KeyOfValue()(value), std::move(value));
+	}
+
+	template<typename... Args>
+	std::pair<iterator, bool> try_emplace_hint_unique(const_iterator hint, Key const &key, Args&&... args) {
+		return __emplace_hint_unique(hint, key, std::forward<Args>(args)...);
+	}
+
+	/* 以 end() 为提示逐个插入, 有序输入每次均摊 O(1), 并且除最右一列外结点都是满的 */
+	template<typename InputIterator,
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
+		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
+	void insert_unique(InputIterator first, InputIterator last) {
+		for (; first != last; ++first)
+			emplace_hint_unique(cend(), *first);
+	}
+
+	template<typename InputIterator,
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
+		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
+	void insert_unique(sx::sorted_unique_t, InputIterator first, InputIterator last) {
+		insert_unique(first, last);
+	}
+
+	iterator insert_equal(Value const &value) {
+		return __emplace_at(__equal_position(KeyOfValue()(value)), value);
+	}
+
+	template<typename... Args>
+	iterator emplace_equal(Args&&... args) {
+		Value value(std::forward<Args>(args)...);
+		return __emplace_at(__equal_position(KeyOfValue()(value)), std::move(value));
+	}
+
+	iterator insert_equal(const_iterator hint, Value const &value) {
+		return __emplace_hint_equal(hint, KeyOfValue()(value), value);
+	}
+
+	template<typename... Args>
+	iterator emplace_hint_equal(const_iterator hint, Args&&... args) {
+		Value value(std::forward<Args>(args)...);
+		return __emplace_hint_equal(hint, KeyOfValue()(value), std::move(value));
+	}
+
+	template<typename InputIterator,
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
+		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
+	void insert_equal(InputIterator first, InputIterator last) {
+		for (; first != last; ++first)
+			emplace_hint_equal(cend(), *first);
+	}
+
+	template<typename InputIterator,
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
+		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
+	void insert_equal(sx::sorted_equivalent_t, InputIterator first, InputIterator last) {
+		insert_equal(first, last);
+	}
+
+	/*
+	 * 内部结点上的元素用前驱 (左子树最右叶子的最后一个元素) 顶替, 删除总是发生在叶子上.
+	 * 返回被删除元素的后继
+	 */
+	iterator erase(const_iterator position) {
+		node_ptr node = position.node;
+		int index = position.position;
+		iterator next;
+		if (node->is_leaf) {
+			sx::destroy(node->value(index));
+			__shift_values(node, index + 1, node->count, -1);
+			--node->count;
+
+			next = iterator(node, index);
+			while (next.position == next.node->count && next.node->parent != nullptr)
+				next = iterator(next.node->parent, next.node->position);
+			if (next.position == next.node->count)
+				next = iterator();
+		} else {
+			node_ptr leaf = __rightmost_leaf(node->child(index));
+			next = iterator(__leftmost_leaf(node->child(index + 1)), 0);
+			sx::destroy(node->value(index));
+			__relocate(node->value(index), leaf->value(leaf->count - 1));
+			--leaf->count;
+			node = leaf;
+		}
+		--node_size;
+
+		__rebalance(node, next);
+		return next.node != nullptr ? next : end();
+	}
+
+	iterator erase(iterator position) {
+		return erase(transform_const_iterator(position));
+	}
+
+	/* 元素会在结点之间移动, last 在删除过程中可能失效, 所以先数出要删除的个数 */
+	iterator erase(const_iterator first, const_iterator last) {
+		if (first == cbegin() && last == cend()) {
+			clear();
+			return end();
+		}
+
+		size_type count = 0;
+		for (const_iterator iter = first; iter != last; ++iter)
+			++count;
+
+		iterator position = transform_iterator(first);
+		for (; count != 0; --count)
+			position = erase(position);
+		return position;
+	}
+
+	size_type erase(Key const &key) {
+		return __erase(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	size_type erase(K const &key) {
+		return __erase(key);
+	}
+
+	iterator find(Key const &key) {
+		return __find(key);
+	}
+
+	const_iterator find(Key const &key) const {
+		return __find(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	iterator find(K const &key) {
+		return __find(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator find(K const &key) const {
+		return __find(key);
+	}
+
+	iterator lower_bound(Key const &key) {
+		return __lower_bound(key);
+	}
+
+	const_iterator lower_bound(Key const &key) const {
+		return __lower_bound(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	iterator lower_bound(K const &key) {
+		return __lower_bound(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator lower_bound(K const &key) const {
+		return __lower_bound(key);
+	}
+
+	iterator upper_bound(Key const &key) {
+		return __upper_bound(key);
+	}
+
+	const_iterator upper_bound(Key const &key) const {
+		return __upper_bound(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	iterator upper_bound(K const &key) {
+		return __upper_bound(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator upper_bound(K const &key) const {
+		return __upper_bound(key);
+	}
+
+	std::pair<iterator, iterator> equal_range(Key const &key) {
+		return std::pair<iterator, iterator>(__lower_bound(key), __upper_bound(key));
+	}
+
+	std::pair<const_iterator, const_iterator> equal_range(Key const &key) const {
+		return std::pair<const_iterator, const_iterator>(__lower_bound(key), __upper_bound(key));
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	std::pair<iterator, iterator> equal_range(K const &key) {
+		return std::pair<iterator, iterator>(__lower_bound(key), __upper_bound(key));
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	std::pair<const_iterator, const_iterator> equal_range(K const &key) const {
+		return std::pair<const_iterator, const_iterator>(__lower_bound(key), __upper_bound(key));
+	}
+
+	size_type count(Key const &key) const {
+		return __count(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	size_type count(K const &key) const {
+		return __count(key);
+	}
+
+	iterator min() noexcept {
+		return begin();
+	}
+
+	iterator max() noexcept {
+		return empty() ? end() : iterator(rightmost_node, rightmost_node->count - 1);
+	}
+
+	const_iterator min() const noexcept {
+		return const_cast<btree *>(this)->min();
+	}
+
+	const_iterator max() const noexcept {
+		return const_cast<btree *>(this)->max();
+	}
+
+	static const_iterator transform_const_iterator(iterator iter) noexcept {
+		return const_iterator(iter);
+	}
+
+	static iterator transform_iterator(const_iterator iter) noexcept {
+		return iterator(iter.node, iter.position);
+	}
+
+	void swap(btree &other) noexcept {
+		using std::swap;
+		swap(root_node, other.root_node);
+		swap(leftmost_node, other.leftmost_node);
+		swap(rightmost_node, other.rightmost_node);
+		swap(node_size, other.node_size);
+		swap(comp, other.comp);
+	}
+private:
+	/* 相同 key 的元素连续排列, 每删除一个都从返回的后继继续 */
+	template<typename K>
+	size_type __erase(K const &key) {
+		size_type count = 0;
+		iterator iter = __lower_bound(key);
+		while (iter != end() && !comp(key, KeyOfValue()(*iter))) {
+			iter = erase(iter);
+			++count;
+		}
+		return count;
+	}
+};
+
+template<typename Key, typename Value, typename KeyOfValue,
+	typename Compare, typename Alloc, std::size_t TargetNodeSize>
+void swap(btree<Key, Value, KeyOfValue, Compare, Alloc, TargetNodeSize> &lhs, btree<Key, Value, KeyOfValue, Compare, Alloc, TargetNodeSize> &rhs) noexcept {
+	lhs.swap(rhs);
+}
+
+
+template<typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, std::size_t TargetNodeSize>
+typename btree<Key, Value, KeyOfValue, Compare, Alloc, TargetNodeSize>::LeafAllocator
+btree<Key, Value, KeyOfValue, Compare, Alloc, TargetNodeSize>::leaf_allocator{};
+
+template<typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, std::size_t TargetNodeSize>
+typename btree<Key, Value, KeyOfValue, Compare, Alloc, TargetNodeSize>::InternalAllocator
+btree<Key, Value, KeyOfValue, Compare, Alloc, TargetNodeSize>::internal_allocator{};
+}
+
+#endif // !M_BTREE_HPP
@@ -0,0 +1,613 @@
+﻿#ifndef M_BTREE_MAP_HPP
+#define M_BTREE_MAP_HPP
+#include "allocator.hpp"
+#include "utility.hpp"
+#include "btree.hpp"
+#include <tuple>
+#include <utility>
+
+namespace sx {
+
+template<typename Key, typename Value,
+	typename Compare = std::less<Key>,
+	typename Alloc = sx::allocator<std::pair<const Key, Value>>,
+	std::size_t TargetNodeSize = 256>
+class btree_map;
+
+template<typename Key, typename Value,
+	typename Compare = std::less<Key>,
+	typename Alloc = sx::allocator<std::pair<const Key, Value>>,
+	std::size_t TargetNodeSize = 256>
+class btree_multimap;
+
+
+/*
+ * 接口与 sx::map 相同, 底层换成 B 树: 查找和有序遍历的缓存命中率高得多.
+ * 插入和删除会移动元素, 之后所有迭代器和引用都失效; 不支持结点句柄和 NodeUpdate
+ */
+template<typename Key, typename Value,
+	typename Compare, typename Alloc, std::size_t TargetNodeSize>
+class btree_map : public sx::container_helpful<btree_map<Key, Value, Compare, Alloc, TargetNodeSize>> {
+public:
+	using key_type		= Key;
+	using mapped_type	= Value;
+	using value_type	= std::pair<const Key, Value>;
+	using key_compare	= Compare;
+
+	struct value_compare {
+		Compare comp;
+		value_compare(Compare comp) : comp(comp) {}
+	public:
+		bool operator()(value_type const &first, value_type const &second) const {
+			return comp(first.first, second.first);
+		}
+	};
+
+	struct key_of_value {
+		key_type const &operator()(value_type const &par) const {
+			return par.first;
+		}
+	};
+private:
+	using Container = sx::btree<key_type, value_type, key_of_value, key_compare, Alloc, TargetNodeSize>;
+public:
+	using pointer			= typename Container::pointer;
+	using reference			= typename Container::reference;
+	using const_pointer		= typename Container::const_pointer;
+	using const_reference	= typename Container::const_reference;
+	using difference_type	= typename Container::difference_type;
+	using size_type			= typename Container::size_type;
+	using iterator			= typename Container::iterator;
+	using const_iterator	= typename Container::const_iterator;
+private:
+	Container container;		/* 底层 B 树容器 */
+public:
+	btree_map() : container(Compare()) {}
+
+	explicit btree_map(Compare const &comp) : container(comp) {}
+
+	template<typename InputIterator,
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
+		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
+	btree_map(InputIterator first, InputIterator last) {
+		container.insert_unique(first, last);
+	}
+
+	/* 调用者保证输入按 key 严格递增, 每次在最右叶子追加, O(n) */
+	template<typename InputIterator,
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
+		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
+	btree_map(sx::sorted_unique_t, InputIterator first, InputIterator last) {
+		container.insert_unique(sx::sorted_unique, first, last);
+	}
+
+	btree_map(btree_map const &other) : container(other.container) {}
+
+	btree_map(btree_map &&other) noexcept : container(std::move(other.container)) {}
+
+	btree_map &operator=(btree_map const &other) {
+		container = other.container;
+		return *this;
+	}
+
+	btree_map &operator=(btree_map &&other) noexcept {
+		container = std::move(other.container);
+		return *this;
+	}
+
+	~btree_map() {}
+public:
+	size_type size() const noexcept {
+		return container.size();
+	}
+
+	bool empty() const noexcept {
+		return container.empty();
+	}
+
+	void clear() {
+		container.clear();
+	}
+
+	iterator begin() noexcept {
+		return container.begin();
+	}
+
+	iterator end() noexcept {
+		return container.end();
+	}
+
+	const_iterator begin() const noexcept {
+		return cbegin();
+	}
+
+	const_iterator end() const noexcept {
+		return cend();
+	}
+
+	const_iterator cbegin() const noexcept {
+		return container.cbegin();
+	}
+
+	const_iterator cend() const noexcept {
+		return container.cend();
+	}
+
+	void swap(btree_map &other) noexcept {
+		container.swap(other.container);
+	}
+
+
+	std::pair<iterator, bool> insert(value_type const &val) {
+		return container.insert_unique(val);
+	}
+
+	template<typename... Args>
+	std::pair<iterator, bool> emplace(Args&&... args) {
+		return container.emplace_unique(std::forward<Args>(args)...);
+	}
+
+	/* position 指向新元素之后的元素时不再从根查找, 例如按 key 递增追加时传入 end() */
+	iterator insert(const_iterator position, value_type const &val) {
+		return container.insert_unique(position, val).first;
+	}
+
+	template<typename... Args>
+	iterator emplace_hint(const_iterator position, Args&&... args) {
+		return container.emplace_hint_unique(position, std::forward<Args>(args)...).first;
+	}
+
+	/* key 已存在时什么也不做, args 也不会被移走 */
+	template<typename... Args>
+	std::pair<iterator, bool> try_emplace(key_type const &key, Args&&... args) {
+		return container.try_emplace_unique(key, std::piecewise_construct,
+			std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+	}
+
+	template<typename... Args>
+	std::pair<iterator, bool> try_emplace(key_type &&key, Args&&... args) {
+		return container.try_emplace_unique(key, std::piecewise_construct,
+			std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+	}
+
+	template<typename... Args>
+	iterator try_emplace(const_iterator position, key_type const &key, Args&&... args) {
+		return container.try_emplace_hint_unique(position, key, std::piecewise_construct,
+			std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...)).first;
+	}
+
+	template<typename... Args>
+	iterator try_emplace(const_iterator position, key_type &&key, Args&&... args) {
+		return container.try_emplace_hint_unique(position, key, std::piecewise_construct,
+			std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::forward<Args>(args)...)).first;
+	}
+
+	template<typename M>
+	std::pair<iterator, bool> insert_or_assign(key_type const &key, M &&obj) {
+		std::pair<iterator, bool> ret = container.try_emplace_unique(key, key, std::forward<M>(obj));
+		if (!ret.second)
+			(*ret.first).second = std::forward<M>(obj);
+		return ret;
+	}
+
+	template<typename M>
+	std::pair<iterator, bool> insert_or_assign(key_type &&key, M &&obj) {
+		std::pair<iterator, bool> ret = container.try_emplace_unique(key, std::move(key), std::forward<M>(obj));
+		if (!ret.second)
+			(*ret.first).second = std::forward<M>(obj);
+		return ret;
+	}
+
+	template<typename M>
+	iterator insert_or_assign(const_iterator position, key_type const &key, M &&obj) {
+		std::pair<iterator, bool> ret = container.try_emplace_hint_unique(position, key, key, std::forward<M>(obj));
+		if (!ret.second)
+			(*ret.first).second = std::forward<M>(obj);
+		return ret.first;
+	}
+
+	template<typename M>
+	iterator insert_or_assign(const_iterator position, key_type &&key, M &&obj) {
+		std::pair<iterator, bool> ret = container.try_emplace_hint_unique(position, key, std::move(key), std::forward<M>(obj));
+		if (!ret.second)
+			(*ret.first).second = std::forward<M>(obj);
+		return ret.first;
+	}
+
+	template<typename InputIterator,
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
+		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
+	void insert(InputIterator first, InputIterator last) {
+		container.insert_unique(first, last);
+	}
+
+	template<typename InputIterator,
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
+		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
+	void insert(sx::sorted_unique_t, InputIterator first, InputIterator last) {
+		container.insert_unique(sx::sorted_unique, first, last);
+	}
+
+	/* 返回被删除元素的后继, 其余迭代器全部失效 */
+	iterator erase(const_iterator position) {
+		return container.erase(position);
+	}
+
+	iterator erase(iterator position) {
+		return container.erase(position);
+	}
+
+	size_type erase(key_type const &key) {
+		return container.erase(key);
+	}
+
+	iterator erase(const_iterator first, const_iterator last) {
+		return container.erase(first, last);
+	}
+
+	iterator find(key_type const &key) {
+		return container.find(key);
+	}
+
+	const_iterator find(key_type const &key) const {
+		return container.find(key);
+	}
+
+	iterator lower_bound(key_type const &key) {
+		return container.lower_bound(key);
+	}
+
+	const_iterator lower_bound(key_type const &key) const {
+		return container.lower_bound(key);
+	}
+
+	iterator upper_bound(key_type const &key) {
+		return container.upper_bound(key);
+	}
+
+	const_iterator upper_bound(key_type const &key) const {
+		return container.upper_bound(key);
+	}
+
+	std::pair<iterator, iterator> equal_range(key_type const &key) {
+		return container.equal_range(key);
+	}
+
+	std::pair<const_iterator, const_iterator> equal_range(key_type const &key) const {
+		return container.equal_range(key);
+	}
+
+	iterator max() {
+		return container.max();
+	}
+
+	iterator min() {
+		return container.min();
+	}
+
+	size_type count(key_type const &key) const {
+		return container.count(key);
+	}
+
+	/* 比较器声明了 is_transparent 时, 可以用任何能与 Key 比较的类型查找 */
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	size_type erase(K const &key) {
+		return container.erase(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	iterator find(K const &key) {
+		return container.find(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator find(K const &key) const {
+		return container.find(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	iterator lower_bound(K const &key) {
+		return container.lower_bound(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator lower_bound(K const &key) const {
+		return container.lower_bound(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	iterator upper_bound(K const &key) {
+		return container.upper_bound(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator upper_bound(K const &key) const {
+		return container.upper_bound(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	std::pair<iterator, iterator> equal_range(K const &key) {
+		return container.equal_range(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	std::pair<const_iterator, const_iterator> equal_range(K const &key) const {
+		return container.equal_range(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	size_type count(K const &key) const {
+		return container.count(key);
+	}
+
+	Value &operator[](key_type const &key) {
+		return (*try_emplace(key).first).second;
+	}
+
+	Value &operator[](key_type &&key) {
+		return (*try_emplace(std::move(key)).first).second;
+	}
+};
+
+
+
+template<typename Key, typename Value,
+	typename Compare, typename Alloc, std::size_t TargetNodeSize>
+class btree_multimap : public sx::container_helpful<btree_multimap<Key, Value, Compare, Alloc, TargetNodeSize>> {
+public:
+	using key_type		= Key;
+	using mapped_type	= Value;
+	using value_type	= std::pair<const Key, Value>;
+	using key_compare	= Compare;
+
+	struct value_compare {
+		Compare comp;
+		value_compare(Compare comp) : comp(comp) {}
+	public:
+		bool operator()(value_type const &first, value_type const &second) const {
+			return comp(first.first, second.first);
+		}
+	};
+
+	struct key_of_value {
+		key_type const &operator()(value_type const &par) const {
+			return par.first;
+		}
+	};
+private:
+	using Container = sx::btree<key_type, value_type, key_of_value, key_compare, Alloc, TargetNodeSize>;
+public:
+	using pointer			= typename Container::pointer;
+	using reference			= typename Container::reference;
+	using const_pointer		= typename Container::const_pointer;
+	using const_reference	= typename Container::const_reference;
+	using difference_type	= typename Container::difference_type;
+	using size_type			= typename Container::size_type;
+	using iterator			= typename Container::iterator;
+	using const_iterator	= typename Container::const_iterator;
+private:
+	Container container;		/* 底层 B 树容器 */
+public:
+	btree_multimap() : container(Compare()) {}
+
+	explicit btree_multimap(Compare const &comp) : container(comp) {}
+
+	template<typename InputIterator,
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
+		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
+	btree_multimap(InputIterator first, InputIterator last) {
+		container.insert_equal(first, last);
+	}
+
+	/* 调用者保证输入按 key 非递减, O(n) */
+	template<typename InputIterator,
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
+		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
+	btree_multimap(sx::sorted_equivalent_t, InputIterator first, InputIterator last) {
+		container.insert_equal(sx::sorted_equivalent, first, last);
+	}
+
+	btree_multimap(btree_multimap const &other) : container(other.container) {}
+
+	btree_multimap(btree_multimap &&other) noexcept : container(std::move(other.container)) {}
+
+	btree_multimap &operator=(btree_multimap const &other) {
+		container = other.container;
+		return *this;
+	}
+
+	btree_multimap &operator=(btree_multimap &&other) noexcept {
+		container = std::move(other.container);
+		return *this;
+	}
+
+	~btree_multimap() {}
+public:
+	size_type size() const noexcept {
+		return container.size();
+	}
+
+	bool empty() const noexcept {
+		return container.empty();
+	}
+
+	void clear() {
+		container.clear();
+	}
+
+	iterator begin() noexcept {
+		return container.begin();
+	}
+
+	iterator end() noexcept {
+		return container.end();
+	}
+
+	const_iterator begin() const noexcept {
+		return cbegin();
+	}
+
+	const_iterator end() const noexcept {
+		return cend();
+	}
+
+	const_iterator cbegin() const noexcept {
+		return container.cbegin();
+	}
+
+	const_iterator cend() const noexcept {
+		return container.cend();
+	}
+
+	void swap(btree_multimap &other) noexcept {
+		container.swap(other.container);
+	}
+
+
+	iterator insert(value_type const &val) {
+		return container.insert_equal(val);
+	}
+
+	template<typename... Args>
+	iterator emplace(Args&&... args) {
+		return container.emplace_equal(std::forward<Args>(args)...);
+	}
+
+	iterator insert(const_iterator position, value_type const &val) {
+		return container.insert_equal(position, val);
+	}
+
+	template<typename... Args>
+	iterator emplace_hint(const_iterator position, Args&&... args) {
+		return container.emplace_hint_equal(position, std::forward<Args>(args)...);
+	}
+
+	template<typename InputIterator,
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
+		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
+	void insert(InputIterator first, InputIterator last) {
+		container.insert_equal(first, last);
+	}
+
+	template<typename InputIterator,
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
+		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
+	void insert(sx::sorted_equivalent_t, InputIterator first, InputIterator last) {
+		container.insert_equal(sx::sorted_equivalent, first, last);
+	}
+
+	iterator erase(const_iterator position) {
+		return container.erase(position);
+	}
+
+	iterator erase(iterator position) {
+		return container.erase(position);
+	}
+
+	/* 删除所有与 key 相同的元素 */
+	size_type erase(key_type const &key) {
+		return container.erase(key);
+	}
+
+	iterator erase(const_iterator first, const_iterator last) {
+		return container.erase(first, last);
+	}
+
+	iterator find(key_type const &key) {
+		return container.find(key);
+	}
+
+	const_iterator find(key_type const &key) const {
+		return container.find(key);
+	}
+
+	iterator lower_bound(key_type const &key) {
+		return container.lower_bound(key);
+	}
+
+	const_iterator lower_bound(key_type const &key) const {
+		return container.lower_bound(key);
+	}
+
+	iterator upper_bound(key_type const &key) {
+		return container.upper_bound(key);
+	}
+
+	const_iterator upper_bound(key_type const &key) const {
+		return container.upper_bound(key);
+	}
+
+	std::pair<iterator, iterator> equal_range(key_type const &key) {
+		return container.equal_range(key);
+	}
+
+	std::pair<const_iterator, const_iterator> equal_range(key_type const &key) const {
+		return container.equal_range(key);
+	}
+
+	iterator max() {
+		return container.max();
+	}
+
+	iterator min() {
+		return container.min();
+	}
+
+	size_type count(key_type const &key) const {
+		return container.count(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	size_type erase(K const &key) {
+		return container.erase(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	iterator find(K const &key) {
+		return container.find(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator find(K const &key) const {
+		return container.find(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	iterator lower_bound(K const &key) {
+		return container.lower_bound(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator lower_bound(K const &key) const {
+		return container.lower_bound(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	iterator upper_bound(K const &key) {
+		return container.upper_bound(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator upper_bound(K const &key) const {
+		return container.upper_bound(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	std::pair<iterator, iterator> equal_range(K const &key) {
+		return container.equal_range(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	std::pair<const_iterator, const_iterator> equal_range(K const &key) const {
+		return container.equal_range(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	size_type count(K const &key) const {
+		return container.count(key);
+	}
+};
+
+}
+
+#endif // !M_BTREE_MAP_HPP
@@ -0,0 +1,427 @@
+﻿#ifndef M_BTREE_SET_HPP
+#define M_BTREE_SET_HPP
+#include "allocator.hpp"
+#include "utility.hpp"
+#include "btree.hpp"
+#include <utility>
+
+namespace sx {
+
+template<typename Key,
+	typename Compare = std::less<Key>,
+	typename Alloc = sx::allocator<Key>,
+	std::size_t TargetNodeSize = 256>
+class btree_set;
+
+template<typename Key,
+	typename Compare = std::less<Key>,
+	typename Alloc = sx::allocator<Key>,
+	std::size_t TargetNodeSize = 256>
+class btree_multiset;
+
+
+/*
+ * 接口与 sx::set 相同, 底层换成 B 树.
+ * 插入和删除会移动元素, 之后所有迭代器都失效; 不支持结点句柄和 NodeUpdate
+ */
+template<typename Key,
+	typename Compare,
+	typename Alloc,
+	std::size_t TargetNodeSize>
+class btree_set : public sx::container_helpful<btree_set<Key, Compare, Alloc, TargetNodeSize>> {
+public:
+	using key_type			= Key;
+	using value_type		= Key;
+	using key_compare		= Compare;
+	using value_compare		= Compare;
+private:
+	using Container			= sx::btree<key_type, value_type, sx::identity<value_type>, Compare, Alloc, TargetNodeSize>;
+public:
+	using pointer			= typename Container::pointer;
+	using reference			= typename Container::reference;
+	using const_pointer		= typename Container::const_pointer;
+	using const_reference	= typename Container::const_reference;
+	using difference_type	= typename Container::difference_type;
+	using size_type			= typename Container::size_type;
+	using iterator			= typename Container::const_iterator;
+	using const_iterator	= typename Container::const_iterator;
+private:
+	Container container;			/* 底层 B 树容器 */
+public:
+	btree_set() : container(Compare{}) {}
+	explicit btree_set(Compare const &comp) : container(comp) {}
+
+	template<typename InputIterator,
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
+		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
+	btree_set(InputIterator first, InputIterator last) {
+		container.insert_unique(first, last);
+	}
+
+	/* 调用者保证输入严格递增, 每次在最右叶子追加, O(n) */
+	template<typename InputIterator,
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
+		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
+	btree_set(sx::sorted_unique_t, InputIterator first, InputIterator last) {
+		container.insert_unique(sx::sorted_unique, first, last);
+	}
+
+	btree_set(btree_set const &other) : container(other.container) { }
+
+	btree_set(btree_set &&other) noexcept : container(std::move(other.container)) { }
+
+	btree_set &operator=(btree_set const &other) {
+		container = other.container;
+		return *this;
+	}
+
+	btree_set &operator=(btree_set &&other) noexcept {
+		container = std::move(other.container);
+		return *this;
+	}
+
+	~btree_set() { }
+public:
+	size_type size() const noexcept {
+		return container.size();
+	}
+
+	bool empty() const noexcept {
+		return container.empty();
+	}
+
+	void clear() {
+		container.clear();
+	}
+
+	const_iterator begin() const noexcept {
+		return cbegin();
+	}
+
+	const_iterator end() const noexcept {
+		return cend();
+	}
+
+	const_iterator cbegin() const noexcept {
+		return container.cbegin();
+	}
+
+	const_iterator cend() const noexcept {
+		return container.cend();
+	}
+
+	std::pair<const_iterator, bool> insert(value_type const &val) {
+		std::pair<typename Container::iterator, bool> ret = container.insert_unique(val);
+		return std::pair<const_iterator, bool>(container.transform_const_iterator(ret.first), ret.second);
+	}
+
+	template<typename... Args>
+	std::pair<const_iterator, bool> emplace(Args&&... args) {
+		std::pair<typename Container::iterator, bool> ret = container.emplace_unique(std::forward<Args>(args)...);
+		return std::pair<const_iterator, bool>(container.transform_const_iterator(ret.first), ret.second);
+	}
+
+	/* position 指向新元素之后的元素时不再从根查找 */
+	std::pair<const_iterator, bool> insert(const_iterator position, value_type const &val) {
+		std::pair<typename Container::iterator, bool> ret = container.insert_unique(position, val);
+		return std::pair<const_iterator, bool>(container.transform_const_iterator(ret.first), ret.second);
+	}
+
+	template<typename... Args>
+	const_iterator emplace_hint(const_iterator position, Args&&... args) {
+		std::pair<typename Container::iterator, bool> ret = container.emplace_hint_unique(position, std::forward<Args>(args)...);
+		return container.transform_const_iterator(ret.first);
+	}
+
+	template<typename InputIterator,
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
+		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
+	void insert(InputIterator first, InputIterator last) {
+		container.insert_unique(first, last);
+	}
+
+	template<typename InputIterator,
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
+		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
+	void insert(sx::sorted_unique_t, InputIterator first, InputIterator last) {
+		container.insert_unique(sx::sorted_unique, first, last);
+	}
+
+	/* 返回被删除元素的后继, 其余迭代器全部失效 */
+	const_iterator erase(const_iterator position) {
+		return container.transform_const_iterator(container.erase(position));
+	}
+
+	size_type erase(value_type const &val) {
+		return container.erase(val);
+	}
+
+	const_iterator erase(const_iterator first, const_iterator last) {
+		return container.transform_const_iterator(container.erase(first, last));
+	}
+
+	const_iterator max() const noexcept {
+		return container.max();
+	}
+
+	const_iterator min() const noexcept {
+		return container.min();
+	}
+
+	const_iterator find(value_type const &val) const {
+		return container.find(val);
+	}
+
+	const_iterator lower_bound(value_type const &val) const {
+		return container.lower_bound(val);
+	}
+
+	const_iterator upper_bound(value_type const &val) const {
+		return container.upper_bound(val);
+	}
+
+	std::pair<const_iterator, const_iterator> equal_range(value_type const &val) const {
+		return container.equal_range(val);
+	}
+
+	size_type count(value_type const &key) const {
+		return container.count(key);
+	}
+
+	/* 比较器声明了 is_transparent 时, 可以用任何能与元素比较的类型查找 */
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	size_type erase(K const &key) {
+		return container.erase(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator find(K const &key) const {
+		return container.find(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator lower_bound(K const &key) const {
+		return container.lower_bound(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator upper_bound(K const &key) const {
+		return container.upper_bound(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	std::pair<const_iterator, const_iterator> equal_range(K const &key) const {
+		return container.equal_range(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	size_type count(K const &key) const {
+		return container.count(key);
+	}
+
+	void swap(btree_set &other) noexcept {
+		container.swap(other.container);
+	}
+
+};
+
+
+template<typename Key,
+	typename Compare,
+	typename Alloc,
+	std::size_t TargetNodeSize>
+class btree_multiset : public sx::container_helpful<btree_multiset<Key, Compare, Alloc, TargetNodeSize>> {
+public:
+	using key_type			= Key;
+	using value_type		= Key;
+	using key_compare		= Compare;
+	using value_compare		= Compare;
+private:
+	using Container			= sx::btree<key_type, value_type, sx::identity<value_type>, Compare, Alloc, TargetNodeSize>;
+public:
+	using pointer			= typename Container::pointer;
+	using reference			= typename Container::reference;
+	using const_pointer		= typename Container::const_pointer;
+	using const_reference	= typename Container::const_reference;
+	using difference_type	= typename Container::difference_type;
+	using size_type			= typename Container::size_type;
+	using iterator			= typename Container::const_iterator;
+	using const_iterator	= typename Container::const_iterator;
+private:
+	Container container;			/* 底层 B 树容器 */
+public:
+	btree_multiset() : container(Compare{}) {}
+
+	explicit btree_multiset(Compare const &comp) : container(comp) {}
+
+	template<typename InputIterator,
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
+		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
+	btree_multiset(InputIterator first, InputIterator last) {
+		container.insert_equal(first, last);
+	}
+
+	/* 调用者保证输入非递减, O(n) */
+	template<typename InputIterator,
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
+		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
+	btree_multiset(sx::sorted_equivalent_t, InputIterator first, InputIterator last) {
+		container.insert_equal(sx::sorted_equivalent, first, last);
+	}
+
+	btree_multiset(btree_multiset const &other) : container(other.container) { }
+
+	btree_multiset(btree_multiset &&other) noexcept : container(std::move(other.container)) { }
+
+	btree_multiset &operator=(btree_multiset const &other) {
+		container = other.container;
+		return *this;
+	}
+
+	btree_multiset &operator=(btree_multiset &&other) noexcept {
+		container = std::move(other.container);
+		return *this;
+	}
+
+	~btree_multiset() { }
+public:
+	size_type size() const noexcept {
+		return container.size();
+	}
+
+	bool empty() const noexcept {
+		return container.empty();
+	}
+
+	void clear() {
+		container.clear();
+	}
+
+	const_iterator begin() const noexcept {
+		return cbegin();
+	}
+
+	const_iterator end() const noexcept {
+		return cend();
+	}
+
+	const_iterator cbegin() const noexcept {
+		return container.cbegin();
+	}
+
+	const_iterator cend() const noexcept {
+		return container.cend();
+	}
+
+	const_iterator insert(value_type const &val) {
+		return container.insert_equal(val);
+	}
+
+	template<typename... Args>
+	const_iterator emplace(Args&&... args) {
+		return container.emplace_equal(std::forward<Args>(args)...);
+	}
+
+	const_iterator insert(const_iterator position, value_type const &val) {
+		return container.insert_equal(position, val);
+	}
+
+	template<typename... Args>
+	const_iterator emplace_hint(const_iterator position, Args&&... args) {
+		return container.emplace_hint_equal(position, std::forward<Args>(args)...);
+	}
+
+	template<typename InputIterator,
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
+		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
+	void insert(InputIterator first, InputIterator last) {
+		container.insert_equal(first, last);
+	}
+
+	template<typename InputIterator,
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
+		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
+	void insert(sx::sorted_equivalent_t, InputIterator first, InputIterator last) {
+		container.insert_equal(sx::sorted_equivalent, first, last);
+	}
+
+	const_iterator erase(const_iterator position) {
+		return container.transform_const_iterator(container.erase(position));
+	}
+
+	/* 删除所有与 val 相同的元素 */
+	size_type erase(value_type const &val) {
+		return container.erase(val);
+	}
+
+	const_iterator erase(const_iterator first, const_iterator last) {
+		return container.transform_const_iterator(container.erase(first, last));
+	}
+
+	const_iterator max() const noexcept {
+		return container.max();
+	}
+
+	const_iterator min() const noexcept {
+		return container.min();
+	}
+
+	const_iterator find(value_type const &val) const {
+		return container.find(val);
+	}
+
+	const_iterator lower_bound(value_type const &val) const {
+		return container.lower_bound(val);
+	}
+
+	const_iterator upper_bound(value_type const &val) const {
+		return container.upper_bound(val);
+	}
+
+	std::pair<const_iterator, const_iterator> equal_range(value_type const &val) const {
+		return container.equal_range(val);
+	}
+
+	size_type count(value_type const &key) const {
+		return container.count(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	size_type erase(K const &key) {
+		return container.erase(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator find(K const &key) const {
+		return container.find(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator lower_bound(K const &key) const {
+		return container.lower_bound(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator upper_bound(K const &key) const {
+		return container.upper_bound(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	std::pair<const_iterator, const_iterator> equal_range(K const &key) const {
+		return container.equal_range(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	size_type count(K const &key) const {
+		return container.count(key);
+	}
+
+	void swap(btree_multiset &other) noexcept {
+		container.swap(other.container);
+	}
+
+};
+
+}
+
+#endif // !M_BTREE_SET_HPP
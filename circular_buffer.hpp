@@ -0,0 +1,542 @@
+﻿#ifndef M_CIRCULAR_BUFFER_HPP
+#define M_CIRCULAR_BUFFER_HPP
+#include "allocator.hpp"
+#include "iterator.hpp"
+#include "utility.hpp"
+#include <cstddef>
+#include <exception>
+#include <initializer_list>
+#include <stdexcept>
+#include <utility>
+
+namespace sx {
+
+class circular_buffer_empty : public std::exception {
+};
+
+class circular_buffer_full : public std::exception {
+};
+
+/* 缓冲区满时的处理策略 */
+enum class circular_buffer_policy {
+	overwrite,		/* 覆盖最旧的元素 */
+	reject			/* 拒绝插入, 抛出 circular_buffer_full */
+};
+
+template<typename T, typename Alloc = sx::allocator<T>>
+class circular_buffer;
+
+template<typename T, typename Ptr, typename Ref>
+class __circular_buffer_iterator;
+
+
+/* 迭代器保存单调递增的逻辑下标, 解引用时才通过掩码映射到物理位置 */
+template<typename T, typename Ptr, typename Ref>
+class __circular_buffer_iterator {
+	template<typename, typename>
+	friend class circular_buffer;
+
+	template<typename U, typename P, typename R>
+	friend class __circular_buffer_iterator;
+public:
+	using value_type		= T;
+	using pointer			= Ptr;
+	using reference			= Ref;
+	using difference_type	= std::ptrdiff_t;
+	using size_type			= std::size_t;
+	using iterator_category = sx::random_access_iterator_tag;
+private:
+	T				*buffer;	/* 存储区 */
+	size_type		 mask;		/* 存储区掩码 */
+	size_type		 index;		/* 逻辑下标 */
+public:
+	__circular_buffer_iterator() : buffer(nullptr), mask(0), index(0) {}
+	__circular_buffer_iterator(T *buffer, size_type mask, size_type index)
+		: buffer(buffer), mask(mask), index(index) {}
+	__circular_buffer_iterator(__circular_buffer_iterator const &) = default;
+	__circular_buffer_iterator &operator=(__circular_buffer_iterator const &) = default;
+	~__circular_buffer_iterator() = default;
+
+	/* iterator 可以转换为 const_iterator */
+	template<typename P, typename R>
+	__circular_buffer_iterator(__circular_buffer_iterator<T, P, R> const &other)
+		: buffer(other.buffer), mask(other.mask), index(other.index) {}
+public:
+	reference operator*() const noexcept {
+		return buffer[index & mask];
+	}
+
+	pointer operator->() const noexcept {
+		return &(this->operator*());
+	}
+
+	reference operator[](difference_type n) const noexcept {
+		return buffer[(index + n) & mask];
+	}
+
+	__circular_buffer_iterator &operator++() noexcept {
+		++index;
+		return *this;
+	}
+
+	__circular_buffer_iterator operator++(int) noexcept {
+		__circular_buffer_iterator ret = *this;
+		++index;
+		return ret;
+	}
+
+	__circular_buffer_iterator &operator--() noexcept {
+		--index;
+		return *this;
+	}
+
+	__circular_buffer_iterator operator--(int) noexcept {
+		__circular_buffer_iterator ret = *this;
+		--index;
+		return ret;
+	}
+
+	__circular_buffer_iterator &operator+=(difference_type n) noexcept {
+		index += n;
+		return *this;
+	}
+
+	__circular_buffer_iterator &operator-=(difference_type n) noexcept {
+		index -= n;
+		return *this;
+	}
+
+	__circular_buffer_iterator operator+(difference_type n) const noexcept {
+		return __circular_buffer_iterator(buffer, mask, index + n);
+	}
+
+	__circular_buffer_iterator operator-(difference_type n) const noexcept {
+		return __circular_buffer_iterator(buffer, mask, index - n);
+	}
+
+	difference_type operator-(__circular_buffer_iterator const &other) const noexcept {
+		return static_cast<difference_type>(index - other.index);
+	}
+
+	friend bool operator==(__circular_buffer_iterator const &first, __circular_buffer_iterator const &second) noexcept {
+		return first.index == second.index;
+	}
+
+	friend bool operator!=(__circular_buffer_iterator const &first, __circular_buffer_iterator const &second) noexcept {
+		return !(first == second);
+	}
+
+	friend bool operator<(__circular_buffer_iterator const &first, __circular_buffer_iterator const &second) noexcept {
+		return first - second < 0;
+	}
+
+	friend bool operator>(__circular_buffer_iterator const &first, __circular_buffer_iterator const &second) noexcept {
+		return second < first;
+	}
+
+	friend bool operator<=(__circular_buffer_iterator const &first, __circular_buffer_iterator const &second) noexcept {
+		return !(second < first);
+	}
+
+	friend bool operator>=(__circular_buffer_iterator const &first, __circular_buffer_iterator const &second) noexcept {
+		return !(first < second);
+	}
+};
+
+
+/*
+ * 固定容量的环形缓冲区, 只占用一块连续内存
+ * 存储区大小上调至 2 的幂次, head / tail 是单调递增的逻辑下标, 通过掩码映射到存储区
+ * 可以作为 sx::queue 和 sx::stack 的底层容器; 默认构造时容量为 0, 第一次插入时按 default_capacity 分配
+ */
+template<typename T, typename Alloc>
+class circular_buffer : public sx::container_helpful<circular_buffer<T, Alloc>> {
+public:
+	using value_type			 = T;
+	using pointer				 = T *;
+	using reference				 = T &;
+	using const_pointer			 = T const *;
+	using const_reference		 = T const &;
+	using size_type				 = std::size_t;
+	using difference_type		 = std::ptrdiff_t;
+	using iterator				 = __circular_buffer_iterator<T, T *, T &>;
+	using const_iterator		 = __circular_buffer_iterator<T, T const *, T const &>;
+	using reverse_iterator		 = sx::__reverse_iterator<iterator>;
+	using const_reverse_iterator = sx::__reverse_iterator<const_iterator>;
+	using policy_type			 = circular_buffer_policy;
+
+	static constexpr size_type default_capacity = 64;
+private:
+	static Alloc			allocator;		/* 分配器 */
+	pointer					buffer;			/* 存储区 */
+	size_type				mask;			/* 存储区掩码 */
+	size_type				max_count;		/* 逻辑容量 */
+	size_type				head;			/* 第一个元素的逻辑下标 */
+	size_type				tail;			/* 最后一个元素之后的逻辑下标 */
+	policy_type				policy;			/* 满时的处理策略 */
+public:
+	circular_buffer() noexcept
+		: buffer(nullptr), mask(0), max_count(0), head(0), tail(0), policy(policy_type::overwrite) {}
+
+	explicit circular_buffer(size_type capacity, policy_type policy = policy_type::overwrite)
+		: buffer(nullptr), mask(0), max_count(capacity), head(0), tail(0), policy(policy) {
+		allocate_storage(capacity);
+	}
+
+	circular_buffer(std::initializer_list<T> const &ilst, policy_type policy = policy_type::overwrite)
+		: circular_buffer(ilst.size(), policy) {
+		for (auto const &val : ilst)
+			push_back(val);
+	}
+
+	circular_buffer(circular_buffer const &other)
+		: circular_buffer(other.max_count, other.policy) {
+		try {
+			for (auto const &val : other)
+				push_back(val);
+		} catch (...) {
+			destroy();
+			throw;
+		}
+	}
+
+	circular_buffer(circular_buffer &&other) noexcept
+		: buffer(other.buffer), mask(other.mask), max_count(other.max_count),
+		  head(other.head), tail(other.tail), policy(other.policy) {
+		other.buffer = nullptr;
+		other.mask = other.max_count = other.head = other.tail = 0;
+	}
+
+	circular_buffer &operator=(circular_buffer const &other) {
+		if (this != &other) {
+			circular_buffer tmp = other;
+			swap(tmp);
+		}
+		return *this;
+	}
+
+	circular_buffer &operator=(circular_buffer &&other) noexcept {
+		circular_buffer tmp = std::move(other);
+		swap(tmp);
+		return *this;
+	}
+
+	~circular_buffer() {
+		destroy();
+	}
+private:
+	size_type storage_size() const noexcept {
+		return buffer == nullptr ? 0 : mask + 1;
+	}
+
+	void allocate_storage(size_type capacity) {
+		if (capacity == 0)
+			return;
+		size_type n = sx::__round_up_pow2(capacity);
+		buffer = allocator.allocate(n);
+		mask = n - 1;
+	}
+
+	void destroy() {
+		clear();
+		allocator.deallocate(buffer, sizeof(value_type) * storage_size());
+		buffer = nullptr;
+	}
+
+	/* 容量为 0 时 (默认构造或被移走之后) 按 default_capacity 分配, 适配器默认构造的底层容器也能直接插入 */
+	void ensure_storage() {
+		if (max_count != 0)
+			return;
+		allocate_storage(default_capacity);
+		max_count = default_capacity;
+	}
+
+	/* 满时能否丢弃另一端的元素腾出位置 */
+	bool can_overwrite() const noexcept {
+		return max_count != 0 && policy == policy_type::overwrite;
+	}
+public:
+	iterator begin() noexcept {
+		return iterator(buffer, mask, head);
+	}
+
+	iterator end() noexcept {
+		return iterator(buffer, mask, tail);
+	}
+
+	const_iterator begin() const noexcept {
+		return cbegin();
+	}
+
+	const_iterator end() const noexcept {
+		return cend();
+	}
+
+	const_iterator cbegin() const noexcept {
+		return const_iterator(buffer, mask, head);
+	}
+
+	const_iterator cend() const noexcept {
+		return const_iterator(buffer, mask, tail);
+	}
+
+	reverse_iterator rbegin() noexcept {
+		return reverse_iterator(end());
+	}
+
+	reverse_iterator rend() noexcept {
+		return reverse_iterator(begin());
+	}
+
+	const_reverse_iterator rbegin() const noexcept {
+		return crbegin();
+	}
+
+	const_reverse_iterator rend() const noexcept {
+		return crend();
+	}
+
+	const_reverse_iterator crbegin() const noexcept {
+		return const_reverse_iterator(cend());
+	}
+
+	const_reverse_iterator crend() const noexcept {
+		return const_reverse_iterator(cbegin());
+	}
+
+	size_type size() const noexcept {
+		return tail - head;
+	}
+
+	size_type capacity() const noexcept {
+		return max_count;
+	}
+
+	bool empty() const noexcept {
+		return head == tail;
+	}
+
+	bool full() const noexcept {
+		return size() == max_count;
+	}
+
+	policy_type get_policy() const noexcept {
+		return policy;
+	}
+
+	void set_policy(policy_type new_policy) noexcept {
+		policy = new_policy;
+	}
+
+	reference front() {
+		return buffer[head & mask];
+	}
+
+	const_reference front() const {
+		return buffer[head & mask];
+	}
+
+	reference back() {
+		return buffer[(tail - 1) & mask];
+	}
+
+	const_reference back() const {
+		return buffer[(tail - 1) & mask];
+	}
+
+	reference operator[](size_type index) {
+		return buffer[(head + index) & mask];
+	}
+
+	const_reference operator[](size_type index) const {
+		return buffer[(head + index) & mask];
+	}
+
+	reference at(size_type index) {
+		if (index >= size())
+			throw std::out_of_range("circular_buffer::at(size_type index) invalid index");
+		return (*this)[index];
+	}
+
+	const_reference at(size_type index) const {
+		if (index >= size())
+			throw std::out_of_range("circular_buffer::at(size_type index) invalid index");
+		return (*this)[index];
+	}
+
+	/* 满时覆盖模式丢弃最旧的元素, 拒绝模式返回 false */
+	template<typename... Args>
+	bool try_emplace_back(Args&&... args) {
+		ensure_storage();
+		if (size() < max_count) {
+			allocator.construct(buffer + (tail & mask), std::forward<Args>(args)...);
+			++tail;
+			return true;
+		}
+		if (!can_overwrite())
+			return false;
+
+		/* 参数可能引用着要被丢弃的元素 (例如 push_back(front())), 先构造出新元素再丢弃 */
+		value_type value(std::forward<Args>(args)...);
+		pop_front();
+		allocator.construct(buffer + (tail & mask), std::move(value));
+		++tail;
+		return true;
+	}
+
+	/* 满时覆盖模式丢弃最新的元素, 拒绝模式返回 false */
+	template<typename... Args>
+	bool try_emplace_front(Args&&... args) {
+		ensure_storage();
+		if (size() < max_count) {
+			allocator.construct(buffer + ((head - 1) & mask), std::forward<Args>(args)...);
+			--head;
+			return true;
+		}
+		if (!can_overwrite())
+			return false;
+
+		value_type value(std::forward<Args>(args)...);
+		pop_back();
+		allocator.construct(buffer + ((head - 1) & mask), std::move(value));
+		--head;
+		return true;
+	}
+
+	bool try_push_back(value_type const &value) {
+		return try_emplace_back(value);
+	}
+
+	bool try_push_back(value_type &&value) {
+		return try_emplace_back(std::move(value));
+	}
+
+	bool try_push_front(value_type const &value) {
+		return try_emplace_front(value);
+	}
+
+	bool try_push_front(value_type &&value) {
+		return try_emplace_front(std::move(value));
+	}
+
+	template<typename... Args>
+	void emplace_back(Args&&... args) {
+		if (!try_emplace_back(std::forward<Args>(args)...))
+			throw circular_buffer_full();
+	}
+
+	template<typename... Args>
+	void emplace_front(Args&&... args) {
+		if (!try_emplace_front(std::forward<Args>(args)...))
+			throw circular_buffer_full();
+	}
+
+	void push_back(value_type const &value) {
+		emplace_back(value);
+	}
+
+	void push_back(value_type &&value) {
+		emplace_back(std::move(value));
+	}
+
+	void push_front(value_type const &value) {
+		emplace_front(value);
+	}
+
+	void push_front(value_type &&value) {
+		emplace_front(std::move(value));
+	}
+
+	void pop_front() {
+		if (empty())
+			throw circular_buffer_empty();
+		allocator.destroy(buffer + (head & mask));
+		++head;
+	}
+
+	void pop_back() {
+		if (empty())
+			throw circular_buffer_empty();
+		--tail;
+		allocator.destroy(buffer + (tail & mask));
+	}
+
+	/* 删除头部或尾部区间时只需移动 head / tail, 删除中间区间时把后面的元素前移 */
+	iterator erase(iterator first, iterator last) {
+		size_type count = last - first;
+		if (count == 0)
+			return first;
+
+		if (first.index == head) {
+			for (; head != last.index; ++head)
+				allocator.destroy(buffer + (head & mask));
+			return begin();
+		}
+
+		for (size_type dst = first.index, src = last.index; src != tail; ++dst, ++src)
+			buffer[dst & mask] = std::move(buffer[src & mask]);
+		for (size_type idx = tail - count; idx != tail; ++idx)
+			allocator.destroy(buffer + (idx & mask));
+		tail -= count;
+		return first;
+	}
+
+	iterator erase(iterator position) {
+		return erase(position, position + 1);
+	}
+
+	void clear() {
+		while (head != tail) {
+			allocator.destroy(buffer + (head & mask));
+			++head;
+		}
+		head = tail = 0;
+	}
+
+	bool is_linearized() const noexcept {
+		return (head & mask) + size() <= storage_size();
+	}
+
+	/* 将元素整理到存储区开头的一段连续内存中, 返回指向第一个元素的指针 */
+	pointer linearize() {
+		if (is_linearized())
+			return buffer + (head & mask);
+
+		size_type n = storage_size();
+		pointer new_buffer = allocator.allocate(n);
+		pointer new_finish = new_buffer;
+		try {
+			for (size_type idx = head; idx != tail; ++idx, ++new_finish)
+				allocator.construct(new_finish, std::move_if_noexcept(buffer[idx & mask]));
+		} catch (...) {
+			allocator.destroy(new_buffer, new_finish);
+			allocator.deallocate(new_buffer, sizeof(value_type) * n);
+			throw;
+		}
+
+		size_type count = size();
+		clear();
+		allocator.deallocate(buffer, sizeof(value_type) * n);
+		buffer = new_buffer;
+		head = 0;
+		tail = count;
+		return buffer;
+	}
+
+	void swap(circular_buffer &other) noexcept {
+		using std::swap;
+		swap(buffer, other.buffer);
+		swap(mask, other.mask);
+		swap(max_count, other.max_count);
+		swap(head, other.head);
+		swap(tail, other.tail);
+		swap(policy, other.policy);
+	}
+};
+
+template<typename T, typename Alloc>
+Alloc circular_buffer<T, Alloc>::allocator;
+
+}	// !namespace sx
+
+#endif // !M_CIRCULAR_BUFFER_HPP
@@ -68,7 +68,7 @@ void destroy_aux(ForwardIter first, ForwardIter end, std::false_type) {
 
 template<typename InputIter, typename ForwardIter> inline
 ForwardIter uninitialized_copy(InputIter first, InputIter end, ForwardIter result) {
-	using has_traivial = has_traivial_destructor_t<ForwardIter>;
+	using has_traivial = has_traivial_destructor_t<typename sx::iterator_traits<ForwardIter>::value_type>;
 	return uninitialized_copy_aux(first, end, result, has_traivial{});
 }
 
@@ -86,13 +86,13 @@ wchar_t *uninitialized_copy(wchar_t *first, wchar_t *last, wchar_t *result) {
 
 template<typename InputIter, typename ForwardIter> inline
 ForwardIter uninitialized_copy_aux(InputIter first, InputIter last, ForwardIter result, std::false_type) {
-	InputIter begin = first;
+	ForwardIter begin = result;
 	try {
 		for (; first != last; ++first, ++result)
-			sx::consruct(&*result, *first);
+			sx::construct(&*result, *first);
 		return result;
 	} catch(...) {
-		for (; begin != first; ++first)
+		for (; begin != result; ++begin)
 			sx::destroy(&*begin);
 		throw;
 	}
@@ -105,7 +105,7 @@ ForwardIter uninitialized_copy_aux(InputIter first, InputIter last, ForwardIter
 
 template<typename ForwardIter, typename T> inline
 ForwardIter uninitialized_fill(ForwardIter first, ForwardIter last, T const &value) {
-	using has_traivial = has_traivial_destructor_t< ForwardIter>;
+	using has_traivial = has_traivial_destructor_t<typename sx::iterator_traits<ForwardIter>::value_type>;
 	return uninitialized_fill_aux(first, last, value, has_traivial{});
 }
 
@@ -113,6 +113,9 @@ private:
 	}
 public:
 	static void *allocate(std::size_t bytes) {
+		if (bytes == 0)		/* 空区间不占用任何块, deallocate 会忽略 nullptr */
+			return nullptr;
+
 		if (bytes > MAX_BYTES)
 			return malloc_alloc::allocate(bytes);
 		
@@ -125,6 +128,23 @@ public:
 		return reinterpret_cast<void *>(result);
 	}
 
+	/*
+	 * 一次取出 n 个相邻的 bytes 字节的块, 之后每块都可以单独 deallocate, 和内存池的其他内存一样进入空闲链表.
+	 * 块大小不是 ALIGN 的倍数或超过 MAX_BYTES 时不能这样拆开释放, 返回 nullptr, 由调用者逐个分配
+	 */
+	static void *allocate_contiguous(std::size_t bytes, std::size_t n) {
+		if (n == 0 || bytes > MAX_BYTES || bytes % ALIGN != 0)
+			return nullptr;
+
+		std::size_t total_size = bytes * n;
+		if (static_cast<std::size_t>(end_free - start_free) >= total_size) {
+			char *result = start_free;
+			start_free += total_size;
+			return result;
+		}
+		return malloc_alloc::allocate(total_size);
+	}
+
 	static void deallocate(void *ptr, std::size_t bytes) {
 		if (ptr == nullptr)
 			return;
@@ -0,0 +1,321 @@
+﻿#ifndef M_EYTZINGER_HPP
+#define M_EYTZINGER_HPP
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include "iterator.hpp"
+#include "utility.hpp"
+#include "vector.hpp"
+
+namespace sx {
+
+template<typename Key, typename Value, typename KeyOfValue, typename Compare>
+class eytzinger_tree;
+
+
+/* 按中序访问层序数组, 就是按 key 递增的顺序; 下标 0 表示 end() */
+template<typename Value>
+struct __eytzinger_iterator {
+	template<typename, typename, typename, typename>
+	friend class eytzinger_tree;
+
+	using value_type		= Value;
+	using pointer			= Value const *;
+	using reference			= Value const &;
+	using difference_type	= std::ptrdiff_t;
+	using iterator_category = sx::bidirectional_iterator_tag;
+	using size_type			= std::size_t;
+private:
+	Value const	*base;		/* 层序数组, base[0] 不使用 */
+	size_type	slot;		/* 当前结点的层序下标 */
+	size_type	count;		/* 元素个数 */
+public:
+	__eytzinger_iterator() noexcept : base(nullptr), slot(0), count(0) {}
+	__eytzinger_iterator(Value const *base, size_type slot, size_type count) noexcept
+		: base(base), slot(slot), count(count) {}
+public:
+	reference operator*() const noexcept {
+		return base[slot];
+	}
+
+	pointer operator->() const noexcept {
+		return base + slot;
+	}
+
+	__eytzinger_iterator operator++(int) noexcept {
+		__eytzinger_iterator ret = *this;
+		increment();
+		return ret;
+	}
+
+	__eytzinger_iterator &operator++() noexcept {
+		increment();
+		return *this;
+	}
+
+	__eytzinger_iterator operator--(int) noexcept {
+		__eytzinger_iterator ret = *this;
+		decrement();
+		return ret;
+	}
+
+	__eytzinger_iterator &operator--() noexcept {
+		decrement();
+		return *this;
+	}
+
+	friend bool operator==(__eytzinger_iterator const &first, __eytzinger_iterator const &second) noexcept {
+		return first.slot == second.slot;
+	}
+
+	friend bool operator!=(__eytzinger_iterator const &first, __eytzinger_iterator const &second) noexcept {
+		return !(first == second);
+	}
+private:
+	/* 有右子树时是右子树的最左结点, 否则向上直到从左孩子上来; 走到根之上就是 end() */
+	void increment() noexcept {
+		if (2 * slot + 1 <= count) {
+			slot = 2 * slot + 1;
+			while (2 * slot <= count)
+				slot *= 2;
+		} else {
+			while (slot & 1)
+				slot >>= 1;
+			slot >>= 1;
+		}
+	}
+
+	/* end() 自减得到最右结点; 对 begin() 自减是未定义行为 */
+	void decrement() noexcept {
+		if (slot == 0) {
+			slot = 1;
+			while (2 * slot + 1 <= count)
+				slot = 2 * slot + 1;
+		} else if (2 * slot <= count) {
+			slot = 2 * slot;
+			while (2 * slot + 1 <= count)
+				slot = 2 * slot + 1;
+		} else {
+			while (!(slot & 1))
+				slot >>= 1;
+			slot >>= 1;
+		}
+	}
+};
+
+
+/*
+ * Eytzinger (BFS) 布局的静态有序容器: 元素按完全二叉树的层序存放, 结点 k 的孩子是 2k 和 2k + 1.
+ * 查找时每层只比较一次, 用比较结果直接算出下一个下标, 循环体内没有数据相关的分支;
+ * 树的前几层总在同几条缓存行里, 同时预取若干层之后子孙所在的缓存行, 访存延迟被后续比较掩盖.
+ * 找到的元素就在下降路径上, 不会再有一次缓存未命中. 建好之后只读, 中序遍历仍然有序, 但在内存中是跳跃的
+ */
+template<typename Key, typename Value, typename KeyOfValue, typename Compare>
+class eytzinger_tree : public sx::container_helpful<eytzinger_tree<Key, Value, KeyOfValue, Compare>> {
+public:
+	using key_type			= Key;
+	using value_type		= Value;
+	using size_type			= std::size_t;
+	using difference_type	= std::ptrdiff_t;
+	using pointer			= Value const *;
+	using reference			= Value const &;
+	using const_pointer		= Value const *;
+	using const_reference	= Value const &;
+	using iterator			= __eytzinger_iterator<Value>;
+	using const_iterator	= __eytzinger_iterator<Value>;
+private:
+	/* 结点 k 往下 log2(stride) 层的子孙从 k * stride 开始连续存放, 正好约一条缓存行 */
+	static constexpr size_type stride = sx::CACHE_LINE_SIZE / sizeof(Value) > 2 ? sx::CACHE_LINE_SIZE / sizeof(Value) : 2;
+
+	sx::vector<Value>	values;			/* 层序存放的元素, values[0] 不使用 */
+	size_type			node_count;		/* 元素个数 */
+	size_type			height;			/* 最深一层的深度, 根为 0 */
+	size_type			last_level;		/* 最深一层的结点数 */
+	Compare				comp;			/* key 比较器 */
+public:
+	explicit eytzinger_tree(Compare const &comp) : node_count(0), height(0), last_level(0), comp(comp) {}
+
+	eytzinger_tree(eytzinger_tree const &other)
+		: values(other.values), node_count(other.node_count), height(other.height), last_level(other.last_level), comp(other.comp) {}
+
+	eytzinger_tree(eytzinger_tree &&other) noexcept
+		: values(std::move(other.values)), node_count(other.node_count), height(other.height), last_level(other.last_level), comp(other.comp) {
+		other.node_count = other.height = other.last_level = 0;
+	}
+
+	eytzinger_tree &operator=(eytzinger_tree const &other) {
+		eytzinger_tree tmp(other);
+		swap(tmp);
+		return *this;
+	}
+
+	eytzinger_tree &operator=(eytzinger_tree &&other) noexcept {
+		eytzinger_tree tmp(std::move(other));
+		swap(tmp);
+		return *this;
+	}
+
+	~eytzinger_tree() {}
+private:
+	static Key const &__key(Value const &val) noexcept {
+		return KeyOfValue()(val);
+	}
+
+	/*
+	 * 第 depth 层的结点 k 在有序序列中的位置: 先按所有层都满时计算中序位置,
+	 * 满树的最深一层都在偶数位置上, 再减去其中实际不存在又排在它前面的结点
+	 */
+	size_type __rank(size_type k, size_type depth) const noexcept {
+		size_type position = ((2 * (k - (size_type(1) << depth)) + 1) << (height - depth)) - 1;
+		size_type leaves = (position + 1) / 2;
+		return leaves > last_level ? position - (leaves - last_level) : position;
+	}
+
+	/* 下标的二进制位记录了路径, 1 是向右; 去掉末尾的 1 和其上的一个 0, 就是最后一次向左走的结点 */
+	static size_type __last_left_turn(size_type k) noexcept {
+		while (k & 1)
+			k >>= 1;
+		return k >> 1;
+	}
+
+	/* 第一个不小于 key 的结点的层序下标, 没有时为 0 */
+	template<typename K>
+	size_type __lower_slot(K const &key) const {
+		Value const *base = values.begin();
+		size_type k = 1;
+		while (k <= node_count) {
+			sx::__prefetch(base + std::min(k * stride, node_count));
+			k = 2 * k + static_cast<size_type>(comp(__key(base[k]), key));
+		}
+		return __last_left_turn(k);
+	}
+
+	/* 第一个大于 key 的结点的层序下标, 没有时为 0 */
+	template<typename K>
+	size_type __upper_slot(K const &key) const {
+		Value const *base = values.begin();
+		size_type k = 1;
+		while (k <= node_count) {
+			sx::__prefetch(base + std::min(k * stride, node_count));
+			k = 2 * k + static_cast<size_type>(!comp(key, __key(base[k])));
+		}
+		return __last_left_turn(k);
+	}
+
+	const_iterator __make_iterator(size_type slot) const noexcept {
+		return const_iterator(values.begin(), slot, node_count);
+	}
+public:
+	/* 用 [first, last) 重建, 输入已按 key 严格递增 */
+	template<typename InputIterator>
+	void assign(InputIterator first, InputIterator last) {
+		sx::vector<Value> sorted(first, last);
+		size_type n = sorted.size();
+		eytzinger_tree layout(comp);
+		layout.node_count = n;
+		while ((size_type(2) << layout.height) <= n)
+			++layout.height;
+		layout.last_level = n - ((size_type(1) << layout.height) - 1);
+		if (n != 0) {
+			layout.values.reserve(n + 1);
+			layout.values.push_back(sorted[0]);
+			for (size_type k = 1, depth = 0; k <= n; ++k) {
+				if (k == (size_type(2) << depth))
+					++depth;
+				layout.values.push_back(std::move(sorted[layout.__rank(k, depth)]));
+			}
+		}
+		swap(layout);
+	}
+
+	size_type size() const noexcept {
+		return node_count;
+	}
+
+	bool empty() const noexcept {
+		return node_count == 0;
+	}
+
+	Compare key_comp() const {
+		return comp;
+	}
+
+	void clear() {
+		values.clear();
+		node_count = height = last_level = 0;
+	}
+
+	/* 最左结点: 从根一直向左 */
+	const_iterator begin() const noexcept {
+		size_type slot = node_count == 0 ? 0 : 1;
+		while (slot != 0 && 2 * slot <= node_count)
+			slot *= 2;
+		return __make_iterator(slot);
+	}
+
+	const_iterator end() const noexcept {
+		return __make_iterator(0);
+	}
+
+	template<typename K>
+	const_iterator lower_bound(K const &key) const {
+		return __make_iterator(__lower_slot(key));
+	}
+
+	template<typename K>
+	const_iterator upper_bound(K const &key) const {
+		return __make_iterator(__upper_slot(key));
+	}
+
+	/* 相等判断用下降路径上最后一个不小于 key 的结点, 它刚被访问过, 还在缓存里 */
+	template<typename K>
+	const_iterator find(K const &key) const {
+		size_type k = __lower_slot(key);
+		if (k == 0 || comp(key, __key(values[k])))
+			return end();
+		return __make_iterator(k);
+	}
+
+	template<typename K>
+	std::pair<const_iterator, const_iterator> equal_range(K const &key) const {
+		const_iterator position = find(key);
+		if (position == end())
+			return std::pair<const_iterator, const_iterator>(position, position);
+		const_iterator next = position;
+		return std::pair<const_iterator, const_iterator>(position, ++next);
+	}
+
+	template<typename K>
+	size_type count(K const &key) const {
+		return find(key) != end() ? 1 : 0;
+	}
+
+	/* 严格小于 key 的元素个数: 由最后一次向左走的结点的下标和深度直接算出, 不访问额外的内存 */
+	template<typename K>
+	size_type rank(K const &key) const {
+		Value const *base = values.begin();
+		size_type k = 1, depth = 0, candidate = 0, candidate_depth = 0;
+		while (k <= node_count) {
+			sx::__prefetch(base + std::min(k * stride, node_count));
+			bool right = comp(__key(base[k]), key);
+			candidate = right ? candidate : k;
+			candidate_depth = right ? candidate_depth : depth;
+			k = 2 * k + static_cast<size_type>(right);
+			++depth;
+		}
+		return candidate == 0 ? node_count : __rank(candidate, candidate_depth);
+	}
+
+	void swap(eytzinger_tree &other) noexcept {
+		using std::swap;
+		values.swap(other.values);
+		swap(node_count, other.node_count);
+		swap(height, other.height);
+		swap(last_level, other.last_level);
+		swap(comp, other.comp);
+	}
+};
+
+}
+
+#endif // !M_EYTZINGER_HPP
@@ -0,0 +1,407 @@
+﻿#ifndef M_FLAT_MAP_HPP
+#define M_FLAT_MAP_HPP
+#include "utility.hpp"
+#include "vector.hpp"
+#include "flat_tree.hpp"
+#include <tuple>
+#include <utility>
+
+namespace sx {
+
+template<typename Key, typename Value,
+	typename Compare = std::less<Key>,
+	typename Container = sx::vector<std::pair<Key, Value>>>
+class flat_map;
+
+
+/*
+ * 接口与 sx::map 相同, 底层是按 key 有序的 sx::vector.
+ * 元素要在序列中移动, 所以 value_type 是 std::pair<Key, Value>, 修改 key 会破坏顺序;
+ * 插入和删除之后所有迭代器都失效. 另外支持 O(1) 的 nth 和 O(log n) 的 rank
+ */
+template<typename Key, typename Value,
+	typename Compare, typename Container>
+class flat_map : public sx::container_helpful<flat_map<Key, Value, Compare, Container>> {
+public:
+	using key_type			= Key;
+	using mapped_type		= Value;
+	using value_type		= std::pair<Key, Value>;
+	using key_compare		= Compare;
+	using container_type	= Container;
+
+	struct value_compare {
+		Compare comp;
+		value_compare(Compare comp) : comp(comp) {}
+	public:
+		bool operator()(value_type const &first, value_type const &second) const {
+			return comp(first.first, second.first);
+		}
+	};
+
+	struct key_of_value {
+		key_type const &operator()(value_type const &par) const {
+			return par.first;
+		}
+	};
+private:
+	using Tree = sx::flat_tree<key_type, value_type, key_of_value, key_compare, Container>;
+public:
+	using pointer			= typename Tree::pointer;
+	using reference			= typename Tree::reference;
+	using const_pointer		= typename Tree::const_pointer;
+	using const_reference	= typename Tree::const_reference;
+	using difference_type	= typename Tree::difference_type;
+	using size_type			= typename Tree::size_type;
+	using iterator			= typename Tree::iterator;
+	using const_iterator	= typename Tree::const_iterator;
+private:
+	Tree container;		/* 底层有序序列 */
+public:
+	flat_map() : container(Compare()) {}
+
+	explicit flat_map(Compare const &comp) : container(comp) {}
+
+	/* 任意顺序的输入, 整体排序去重一次; key 重复时保留最先出现的 */
+	template<typename InputIterator,
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
+		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
+	flat_map(InputIterator first, InputIterator last) : container(Compare()) {
+		container.insert_unique(first, last);
+	}
+
+	/* 调用者保证输入按 key 严格递增, O(n) */
+	template<typename InputIterator,
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
+		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
+	flat_map(sx::sorted_unique_t, InputIterator first, InputIterator last) : container(Compare()) {
+		container.insert_unique(sx::sorted_unique, first, last);
+	}
+
+	/* 接管任意顺序的序列, 原地排序去重 */
+	explicit flat_map(Container &&sequence) : container(Compare()) {
+		container.assign_unique(std::move(sequence));
+	}
+
+	/* 接管已按 key 严格递增的序列, 不复制也不排序 */
+	flat_map(sx::sorted_unique_t, Container &&sequence) : container(Compare()) {
+		container.replace(std::move(sequence));
+	}
+
+	flat_map(flat_map const &other) : container(other.container) {}
+
+	flat_map(flat_map &&other) noexcept : container(std::move(other.container)) {}
+
+	flat_map &operator=(flat_map const &other) {
+		container = other.container;
+		return *this;
+	}
+
+	flat_map &operator=(flat_map &&other) noexcept {
+		container = std::move(other.container);
+		return *this;
+	}
+
+	~flat_map() {}
+public:
+	size_type size() const noexcept {
+		return container.size();
+	}
+
+	bool empty() const noexcept {
+		return container.empty();
+	}
+
+	size_type capacity() const noexcept {
+		return container.capacity();
+	}
+
+	void reserve(size_type size) {
+		container.reserve(size);
+	}
+
+	void clear() {
+		container.clear();
+	}
+
+	iterator begin() noexcept {
+		return container.begin();
+	}
+
+	iterator end() noexcept {
+		return container.end();
+	}
+
+	const_iterator begin() const noexcept {
+		return cbegin();
+	}
+
+	const_iterator end() const noexcept {
+		return cend();
+	}
+
+	const_iterator cbegin() const noexcept {
+		return container.cbegin();
+	}
+
+	const_iterator cend() const noexcept {
+		return container.cend();
+	}
+
+	void swap(flat_map &other) noexcept {
+		container.swap(other.container);
+	}
+
+	std::pair<iterator, bool> insert(value_type const &val) {
+		return container.insert_unique(val);
+	}
+
+	std::pair<iterator, bool> insert(value_type &&val) {
+		return container.insert_unique(std::move(val));
+	}
+
+	template<typename... Args>
+	std::pair<iterator, bool> emplace(Args&&... args) {
+		return container.emplace_unique(std::forward<Args>(args)...);
+	}
+
+	/* position 指向新元素的后继时省去二分查找, 例如按 key 递增追加时传入 end() */
+	iterator insert(const_iterator position, value_type const &val) {
+		return container.try_emplace_hint_unique(position, val.first, val).first;
+	}
+
+	template<typename... Args>
+	iterator emplace_hint(const_iterator position, Args&&... args) {
+		return container.emplace_hint_unique(position, std::forward<Args>(args)...).first;
+	}
+
+	/* key 已存在时什么也不做, args 也不会被移走 */
+	template<typename... Args>
+	std::pair<iterator, bool> try_emplace(key_type const &key, Args&&... args) {
+		return container.try_emplace_unique(key, std::piecewise_construct,
+			std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+	}
+
+	template<typename... Args>
+	std::pair<iterator, bool> try_emplace(key_type &&key, Args&&... args) {
+		return container.try_emplace_unique(key, std::piecewise_construct,
+			std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+	}
+
+	template<typename... Args>
+	iterator try_emplace(const_iterator position, key_type const &key, Args&&... args) {
+		return container.try_emplace_hint_unique(position, key, std::piecewise_construct,
+			std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...)).first;
+	}
+
+	template<typename... Args>
+	iterator try_emplace(const_iterator position, key_type &&key, Args&&... args) {
+		return container.try_emplace_hint_unique(position, key, std::piecewise_construct,
+			std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::forward<Args>(args)...)).first;
+	}
+
+	template<typename M>
+	std::pair<iterator, bool> insert_or_assign(key_type const &key, M &&obj) {
+		std::pair<iterator, bool> ret = container.try_emplace_unique(key, key, std::forward<M>(obj));
+		if (!ret.second)
+			(*ret.first).second = std::forward<M>(obj);
+		return ret;
+	}
+
+	template<typename M>
+	std::pair<iterator, bool> insert_or_assign(key_type &&key, M &&obj) {
+		std::pair<iterator, bool> ret = container.try_emplace_unique(key, std::move(key), std::forward<M>(obj));
+		if (!ret.second)
+			(*ret.first).second = std::forward<M>(obj);
+		return ret;
+	}
+
+	template<typename M>
+	iterator insert_or_assign(const_iterator position, key_type const &key, M &&obj) {
+		std::pair<iterator, bool> ret = container.try_emplace_hint_unique(position, key, key, std::forward<M>(obj));
+		if (!ret.second)
+			(*ret.first).second = std::forward<M>(obj);
+		return ret.first;
+	}
+
+	template<typename M>
+	iterator insert_or_assign(const_iterator position, key_type &&key, M &&obj) {
+		std::pair<iterator, bool> ret = container.try_emplace_hint_unique(position, key, std::move(key), std::forward<M>(obj));
+		if (!ret.second)
+			(*ret.first).second = std::forward<M>(obj);
+		return ret.first;
+	}
+
+	/* 先追加到末尾再排序归并, O(n + m log m); key 已存在的元素被丢弃 */
+	template<typename InputIterator,
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
+		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
+	void insert(InputIterator first, InputIterator last) {
+		container.insert_unique(first, last);
+	}
+
+	/* 调用者保证输入按 key 严格递增, 只做一次 O(n + m) 归并 */
+	template<typename InputIterator,
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
+		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
+	void insert(sx::sorted_unique_t, InputIterator first, InputIterator last) {
+		container.insert_unique(sx::sorted_unique, first, last);
+	}
+
+	template<typename Range>
+	void insert_range(Range const &range) {
+		container.insert_unique(range.begin(), range.end());
+	}
+
+	template<typename Range>
+	void insert_range(sx::sorted_unique_t, Range const &range) {
+		container.insert_unique(sx::sorted_unique, range.begin(), range.end());
+	}
+
+	/* 移出底层序列, 容器变为空; 可以修改后再用 replace 放回 */
+	Container extract_sequence() {
+		return container.extract_sequence();
+	}
+
+	/* 接管 sequence, 调用者保证它已按 key 严格递增 */
+	void replace(Container &&sequence) {
+		container.replace(std::move(sequence));
+	}
+
+	/* 返回被删除元素的后继, 其余迭代器全部失效 */
+	iterator erase(const_iterator position) {
+		return container.erase(position);
+	}
+
+	iterator erase(iterator position) {
+		return container.erase(position);
+	}
+
+	size_type erase(key_type const &key) {
+		return container.erase(key);
+	}
+
+	iterator erase(const_iterator first, const_iterator last) {
+		return container.erase(first, last);
+	}
+
+	iterator find(key_type const &key) {
+		return container.find(key);
+	}
+
+	const_iterator find(key_type const &key) const {
+		return container.find(key);
+	}
+
+	iterator lower_bound(key_type const &key) {
+		return container.lower_bound(key);
+	}
+
+	const_iterator lower_bound(key_type const &key) const {
+		return container.lower_bound(key);
+	}
+
+	iterator upper_bound(key_type const &key) {
+		return container.upper_bound(key);
+	}
+
+	const_iterator upper_bound(key_type const &key) const {
+		return container.upper_bound(key);
+	}
+
+	std::pair<iterator, iterator> equal_range(key_type const &key) {
+		return container.equal_range(key);
+	}
+
+	std::pair<const_iterator, const_iterator> equal_range(key_type const &key) const {
+		return container.equal_range(key);
+	}
+
+	iterator max() {
+		return empty() ? end() : end() - 1;
+	}
+
+	iterator min() {
+		return begin();
+	}
+
+	size_type count(key_type const &key) const {
+		return container.count(key);
+	}
+
+	/* 比较器声明了 is_transparent 时, 可以用任何能与 Key 比较的类型查找 */
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	size_type erase(K const &key) {
+		return container.erase(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	iterator find(K const &key) {
+		return container.find(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator find(K const &key) const {
+		return container.find(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	iterator lower_bound(K const &key) {
+		return container.lower_bound(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator lower_bound(K const &key) const {
+		return container.lower_bound(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	iterator upper_bound(K const &key) {
+		return container.upper_bound(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator upper_bound(K const &key) const {
+		return container.upper_bound(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	std::pair<iterator, iterator> equal_range(K const &key) {
+		return container.equal_range(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	std::pair<const_iterator, const_iterator> equal_range(K const &key) const {
+		return container.equal_range(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	size_type count(K const &key) const {
+		return container.count(key);
+	}
+
+	/* 第 k 小的元素 (从 0 开始), k >= size() 时返回 end() */
+	iterator nth(size_type k) noexcept {
+		return k < size() ? begin() + k : end();
+	}
+
+	const_iterator nth(size_type k) const noexcept {
+		return k < size() ? cbegin() + k : cend();
+	}
+
+	/* 严格小于 key 的元素个数 */
+	size_type rank(key_type const &key) const {
+		return container.lower_bound(key) - cbegin();
+	}
+
+	Value &operator[](key_type const &key) {
+		return (*try_emplace(key).first).second;
+	}
+
+	Value &operator[](key_type &&key) {
+		return (*try_emplace(std::move(key)).first).second;
+	}
+};
+
+}
+
+#endif // !M_FLAT_MAP_HPP
@@ -0,0 +1,273 @@
+﻿#ifndef M_FLAT_SET_HPP
+#define M_FLAT_SET_HPP
+#include "utility.hpp"
+#include "vector.hpp"
+#include "flat_tree.hpp"
+#include <utility>
+
+namespace sx {
+
+template<typename Key,
+	typename Compare = std::less<Key>,
+	typename Container = sx::vector<Key>>
+class flat_set;
+
+
+/*
+ * 接口与 sx::set 相同, 底层是有序的 sx::vector.
+ * 插入和删除之后所有迭代器都失效. 另外支持 O(1) 的 nth 和 O(log n) 的 rank
+ */
+template<typename Key,
+	typename Compare,
+	typename Container>
+class flat_set : public sx::container_helpful<flat_set<Key, Compare, Container>> {
+public:
+	using key_type			= Key;
+	using value_type		= Key;
+	using key_compare		= Compare;
+	using value_compare		= Compare;
+	using container_type	= Container;
+private:
+	using Tree				= sx::flat_tree<key_type, value_type, sx::identity<value_type>, Compare, Container>;
+public:
+	using pointer			= typename Tree::pointer;
+	using reference			= typename Tree::reference;
+	using const_pointer		= typename Tree::const_pointer;
+	using const_reference	= typename Tree::const_reference;
+	using difference_type	= typename Tree::difference_type;
+	using size_type			= typename Tree::size_type;
+	using iterator			= typename Tree::const_iterator;
+	using const_iterator	= typename Tree::const_iterator;
+private:
+	Tree container;			/* 底层有序序列 */
+public:
+	flat_set() : container(Compare{}) {}
+	explicit flat_set(Compare const &comp) : container(comp) {}
+
+	/* 任意顺序的输入, 整体排序去重一次 */
+	template<typename InputIterator,
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
+		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
+	flat_set(InputIterator first, InputIterator last) : container(Compare{}) {
+		container.insert_unique(first, last);
+	}
+
+	/* 调用者保证输入严格递增, O(n) */
+	template<typename InputIterator,
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
+		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
+	flat_set(sx::sorted_unique_t, InputIterator first, InputIterator last) : container(Compare{}) {
+		container.insert_unique(sx::sorted_unique, first, last);
+	}
+
+	/* 接管任意顺序的序列, 原地排序去重 */
+	explicit flat_set(Container &&sequence) : container(Compare{}) {
+		container.assign_unique(std::move(sequence));
+	}
+
+	/* 接管已严格递增的序列, 不复制也不排序 */
+	flat_set(sx::sorted_unique_t, Container &&sequence) : container(Compare{}) {
+		container.replace(std::move(sequence));
+	}
+
+	flat_set(flat_set const &other) : container(other.container) { }
+
+	flat_set(flat_set &&other) noexcept : container(std::move(other.container)) { }
+
+	flat_set &operator=(flat_set const &other) {
+		container = other.container;
+		return *this;
+	}
+
+	flat_set &operator=(flat_set &&other) noexcept {
+		container = std::move(other.container);
+		return *this;
+	}
+
+	~flat_set() { }
+public:
+	size_type size() const noexcept {
+		return container.size();
+	}
+
+	bool empty() const noexcept {
+		return container.empty();
+	}
+
+	size_type capacity() const noexcept {
+		return container.capacity();
+	}
+
+	void reserve(size_type size) {
+		container.reserve(size);
+	}
+
+	void clear() {
+		container.clear();
+	}
+
+	const_iterator begin() const noexcept {
+		return cbegin();
+	}
+
+	const_iterator end() const noexcept {
+		return cend();
+	}
+
+	const_iterator cbegin() const noexcept {
+		return container.cbegin();
+	}
+
+	const_iterator cend() const noexcept {
+		return container.cend();
+	}
+
+	std::pair<const_iterator, bool> insert(value_type const &val) {
+		return container.insert_unique(val);
+	}
+
+	std::pair<const_iterator, bool> insert(value_type &&val) {
+		return container.insert_unique(std::move(val));
+	}
+
+	template<typename... Args>
+	std::pair<const_iterator, bool> emplace(Args&&... args) {
+		return container.emplace_unique(std::forward<Args>(args)...);
+	}
+
+	/* position 指向新元素的后继时省去二分查找 */
+	std::pair<const_iterator, bool> insert(const_iterator position, value_type const &val) {
+		return container.try_emplace_hint_unique(position, val, val);
+	}
+
+	template<typename... Args>
+	const_iterator emplace_hint(const_iterator position, Args&&... args) {
+		return container.emplace_hint_unique(position, std::forward<Args>(args)...).first;
+	}
+
+	/* 先追加到末尾再排序归并, O(n + m log m) */
+	template<typename InputIterator,
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
+		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
+	void insert(InputIterator first, InputIterator last) {
+		container.insert_unique(first, last);
+	}
+
+	/* 调用者保证输入严格递增, 只做一次 O(n + m) 归并 */
+	template<typename InputIterator,
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
+		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
+	void insert(sx::sorted_unique_t, InputIterator first, InputIterator last) {
+		container.insert_unique(sx::sorted_unique, first, last);
+	}
+
+	template<typename Range>
+	void insert_range(Range const &range) {
+		container.insert_unique(range.begin(), range.end());
+	}
+
+	template<typename Range>
+	void insert_range(sx::sorted_unique_t, Range const &range) {
+		container.insert_unique(sx::sorted_unique, range.begin(), range.end());
+	}
+
+	/* 移出底层序列, 容器变为空 */
+	Container extract_sequence() {
+		return container.extract_sequence();
+	}
+
+	/* 接管 sequence, 调用者保证它已严格递增 */
+	void replace(Container &&sequence) {
+		container.replace(std::move(sequence));
+	}
+
+	/* 返回被删除元素的后继, 其余迭代器全部失效 */
+	const_iterator erase(const_iterator position) {
+		return container.erase(position);
+	}
+
+	size_type erase(value_type const &val) {
+		return container.erase(val);
+	}
+
+	const_iterator erase(const_iterator first, const_iterator last) {
+		return container.erase(first, last);
+	}
+
+	const_iterator max() const noexcept {
+		return empty() ? cend() : cend() - 1;
+	}
+
+	const_iterator min() const noexcept {
+		return cbegin();
+	}
+
+	const_iterator find(value_type const &val) const {
+		return container.find(val);
+	}
+
+	const_iterator lower_bound(value_type const &val) const {
+		return container.lower_bound(val);
+	}
+
+	const_iterator upper_bound(value_type const &val) const {
+		return container.upper_bound(val);
+	}
+
+	std::pair<const_iterator, const_iterator> equal_range(value_type const &val) const {
+		return container.equal_range(val);
+	}
+
+	size_type count(value_type const &key) const {
+		return container.count(key);
+	}
+
+	/* 比较器声明了 is_transparent 时, 可以用任何能与元素比较的类型查找 */
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	size_type erase(K const &key) {
+		return container.erase(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator find(K const &key) const {
+		return container.find(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator lower_bound(K const &key) const {
+		return container.lower_bound(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator upper_bound(K const &key) const {
+		return container.upper_bound(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	std::pair<const_iterator, const_iterator> equal_range(K const &key) const {
+		return container.equal_range(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	size_type count(K const &key) const {
+		return container.count(key);
+	}
+
+	/* 第 k 小的元素 (从 0 开始), k >= size() 时返回 end() */
+	const_iterator nth(size_type k) const noexcept {
+		return k < size() ? cbegin() + k : cend();
+	}
+
+	/* 严格小于 val 的元素个数 */
+	size_type rank(value_type const &val) const {
+		return container.lower_bound(val) - cbegin();
+	}
+
+	void swap(flat_set &other) noexcept {
+		container.swap(other.container);
+	}
+};
+
+}
+
+#endif // !M_FLAT_SET_HPP
@@ -0,0 +1,319 @@
+﻿#ifndef M_FLAT_TREE_HPP
+#define M_FLAT_TREE_HPP
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include "allocator.hpp"
+#include "type_traits.hpp"
+#include "utility.hpp"
+#include "vector.hpp"
+
+namespace sx {
+
+/*
+ * 有序序列上的关联容器: 元素按 key 严格递增连续存放在 Container (默认 sx::vector) 中.
+ * 查找是二分, 遍历是线性扫描, 没有任何结点开销; 单个插入和删除需要移动后面的元素, 是 O(n).
+ * 适合一次构建, 多次查询的表. 批量插入先把新元素排序去重, 再与原序列归并, 是 O(n + m log m)
+ */
+template<typename Key, typename Value, typename KeyOfValue,
+	typename Compare, typename Container>
+class flat_tree : public sx::container_helpful<flat_tree<Key, Value, KeyOfValue, Compare, Container>> {
+public:
+	using key_type			= Key;
+	using value_type		= Value;
+	using container_type	= Container;
+	using pointer			= Value *;
+	using reference			= Value &;
+	using const_pointer		= Value const *;
+	using const_reference	= Value const &;
+	using size_type			= typename Container::size_type;
+	using difference_type	= typename Container::difference_type;
+	using iterator			= typename Container::iterator;
+	using const_iterator	= typename Container::const_iterator;
+private:
+	Container	sequence;		/* 按 key 严格递增的元素 */
+	Compare		comp;			/* key 比较器 */
+public:
+	explicit flat_tree(Compare const &comp) : comp(comp) {}
+
+	flat_tree(flat_tree const &other) : sequence(other.sequence), comp(other.comp) {}
+
+	flat_tree(flat_tree &&other) noexcept : sequence(std::move(other.sequence)), comp(other.comp) {}
+
+	flat_tree &operator=(flat_tree const &other) {
+		sequence = other.sequence;
+		comp = other.comp;
+		return *this;
+	}
+
+	flat_tree &operator=(flat_tree &&other) noexcept {
+		sequence = std::move(other.sequence);
+		comp = other.comp;
+		return *this;
+	}
+
+	~flat_tree() {}
+private:
+	static Key const &__key(value_type const &val) noexcept {
+		return KeyOfValue()(val);
+	}
+
+	bool __value_less(value_type const &first, value_type const &second) const {
+		return comp(__key(first), __key(second));
+	}
+
+	/*
+	 * [begin, begin + old_size) 是原有的有序序列, 之后是刚追加的新元素.
+	 * 新元素先稳定排序并去重 (相同 key 保留最先出现的), 再与原序列原地归并;
+	 * inplace_merge 是稳定的, 原有元素排在相同 key 的新元素之前, 最后一次 unique 就保留了原有元素
+	 */
+	void __merge_tail(size_type old_size, bool sorted) {
+		auto less = [this](value_type const &first, value_type const &second) {
+			return __value_less(first, second);
+		};
+		auto equal = [this](value_type const &first, value_type const &second) {
+			return !__value_less(first, second);
+		};
+
+		iterator first = sequence.begin();
+		iterator middle = first + old_size;
+		iterator last = sequence.end();
+		if (!sorted) {
+			std::stable_sort(middle, last, less);
+			last = std::unique(middle, last, equal);
+		}
+		if (old_size != 0 && middle != last) {
+			if (less(*middle, *(middle - 1)))	/* 新元素都在原有元素之后时不用归并 */
+				std::inplace_merge(first, middle, last, less);
+			last = std::unique(first, last, equal);
+		}
+		sequence.erase(last, sequence.end());
+	}
+
+	/* 把 [first, last) 追加到末尾, 任何一步抛出异常都截回原来的长度 */
+	template<typename InputIterator>
+	size_type __append(InputIterator first, InputIterator last) {
+		size_type old_size = sequence.size();
+		try {
+			for (; first != last; ++first)
+				sequence.emplace_back(*first);
+		} catch (...) {
+			sequence.erase(sequence.begin() + old_size, sequence.end());
+			throw;
+		}
+		return old_size;
+	}
+public:
+	size_type size() const noexcept {
+		return sequence.size();
+	}
+
+	bool empty() const noexcept {
+		return sequence.empty();
+	}
+
+	size_type capacity() const noexcept {
+		return sequence.capacity();
+	}
+
+	void reserve(size_type size) {
+		sequence.reserve(size);
+	}
+
+	void clear() {
+		sequence.clear();
+	}
+
+	iterator begin() noexcept {
+		return sequence.begin();
+	}
+
+	iterator end() noexcept {
+		return sequence.end();
+	}
+
+	const_iterator begin() const noexcept {
+		return sequence.cbegin();
+	}
+
+	const_iterator end() const noexcept {
+		return sequence.cend();
+	}
+
+	const_iterator cbegin() const noexcept {
+		return sequence.cbegin();
+	}
+
+	const_iterator cend() const noexcept {
+		return sequence.cend();
+	}
+
+	iterator transform_iterator(const_iterator position) noexcept {
+		return sequence.begin() + (position - sequence.cbegin());
+	}
+
+	template<typename K>
+	iterator lower_bound(K const &key) {
+		return transform_iterator(static_cast<flat_tree const &>(*this).lower_bound(key));
+	}
+
+	template<typename K>
+	const_iterator lower_bound(K const &key) const {
+		return std::lower_bound(sequence.cbegin(), sequence.cend(), key,
+			[this](value_type const &val, K const &other) { return comp(__key(val), other); });
+	}
+
+	template<typename K>
+	iterator upper_bound(K const &key) {
+		return transform_iterator(static_cast<flat_tree const &>(*this).upper_bound(key));
+	}
+
+	template<typename K>
+	const_iterator upper_bound(K const &key) const {
+		return std::upper_bound(sequence.cbegin(), sequence.cend(), key,
+			[this](K const &other, value_type const &val) { return comp(other, __key(val)); });
+	}
+
+	template<typename K>
+	iterator find(K const &key) {
+		return transform_iterator(static_cast<flat_tree const &>(*this).find(key));
+	}
+
+	template<typename K>
+	const_iterator find(K const &key) const {
+		const_iterator position = lower_bound(key);
+		if (position != cend() && !comp(key, __key(*position)))
+			return position;
+		return cend();
+	}
+
+	/* key 唯一, 区间最多一个元素 */
+	template<typename K>
+	std::pair<iterator, iterator> equal_range(K const &key) {
+		iterator position = find(key);
+		return std::pair<iterator, iterator>(position, position == end() ? position : position + 1);
+	}
+
+	template<typename K>
+	std::pair<const_iterator, const_iterator> equal_range(K const &key) const {
+		const_iterator position = find(key);
+		return std::pair<const_iterator, const_iterator>(position, position == cend() ? position : position + 1);
+	}
+
+	template<typename K>
+	size_type count(K const &key) const {
+		return find(key) != cend() ? 1 : 0;
+	}
+
+	std::pair<iterator, bool> insert_unique(value_type const &val) {
+		iterator position = lower_bound(__key(val));
+		if (position != end() && !comp(__key(val), __key(*position)))
+			return std::pair<iterator, bool>(position, false);
+		return std::pair<iterator, bool>(sequence.insert(position, val), true);
+	}
+
+	std::pair<iterator, bool> insert_unique(value_type &&val) {
+		iterator position = lower_bound(__key(val));
+		if (position != end() && !comp(__key(val), __key(*position)))
+			return std::pair<iterator, bool>(position, false);
+		return std::pair<iterator, bool>(sequence.insert(position, std::move(val)), true);
+	}
+
+	template<typename... Args>
+	std::pair<iterator, bool> emplace_unique(Args&&... args) {
+		return insert_unique(value_type(std::forward<Args>(args)...));
+	}
+
+	/* 已知 key 时先查找, key 已存在就不构造元素 */
+	template<typename... Args>
+	std::pair<iterator, bool> try_emplace_unique(Key const &key, Args&&... args) {
+		iterator position = lower_bound(key);
+		if (position != end() && !comp(key, __key(*position)))
+			return std::pair<iterator, bool>(position, false);
+		return std::pair<iterator, bool>(sequence.emplace(position, std::forward<Args>(args)...), true);
+	}
+
+	/* hint 恰好是新元素的后继时直接插入, 省去二分查找 */
+	template<typename... Args>
+	std::pair<iterator, bool> try_emplace_hint_unique(const_iterator hint, Key const &key, Args&&... args) {
+		if ((hint == cend() || comp(key, __key(*hint))) && (hint == cbegin() || comp(__key(*(hint - 1)), key)))
+			return std::pair<iterator, bool>(sequence.emplace(transform_iterator(hint), std::forward<Args>(args)...), true);
+		return try_emplace_unique(key, std::forward<Args>(args)...);
+	}
+
+	template<typename... Args>
+	std::pair<iterator, bool> emplace_hint_unique(const_iterator hint, Args&&... args) {
+		value_type val(std::forward<Args>(args)...);
+		return try_emplace_hint_unique(hint, __key(val), std::move(val));
+	}
+
+	template<typename InputIterator>
+	void insert_unique(InputIterator first, InputIterator last) {
+		__merge_tail(__append(first, last), false);
+	}
+
+	/* 调用者保证 [first, last) 已按 key 严格递增, 省去排序, 只做一次归并 */
+	template<typename InputIterator>
+	void insert_unique(sx::sorted_unique_t, InputIterator first, InputIterator last) {
+		__merge_tail(__append(first, last), true);
+	}
+
+	/* 接管任意顺序的序列, 排序去重一次 */
+	void assign_unique(Container &&other) {
+		sequence = std::move(other);
+		__merge_tail(0, false);
+	}
+
+	iterator erase(iterator position) {
+		return sequence.erase(position);
+	}
+
+	iterator erase(const_iterator position) {
+		return sequence.erase(transform_iterator(position));
+	}
+
+	iterator erase(const_iterator first, const_iterator last) {
+		return sequence.erase(transform_iterator(first), transform_iterator(last));
+	}
+
+	template<typename K>
+	size_type erase(K const &key) {
+		const_iterator position = find(key);
+		if (position == cend())
+			return 0;
+		erase(position);
+		return 1;
+	}
+
+	/* 把底层序列整个移出, 容器变为空; 不复制任何元素 */
+	Container extract_sequence() {
+		Container ret = std::move(sequence);
+		sequence.clear();
+		return ret;
+	}
+
+	/* 直接接管 other 作为底层序列, 调用者保证它已按 key 严格递增 */
+	void replace(Container &&other) {
+		sequence = std::move(other);
+	}
+
+	Container const &sequence_view() const noexcept {
+		return sequence;
+	}
+
+	void swap(flat_tree &other) noexcept {
+		using std::swap;
+		sequence.swap(other.sequence);
+		swap(comp, other.comp);
+	}
+};
+
+template<typename Key, typename Value, typename KeyOfValue, typename Compare, typename Container>
+void swap(flat_tree<Key, Value, KeyOfValue, Compare, Container> &first,
+	flat_tree<Key, Value, KeyOfValue, Compare, Container> &second) noexcept {
+	first.swap(second);
+}
+
+}
+
+#endif // !M_FLAT_TREE_HPP
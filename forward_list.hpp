@@ -4,6 +4,7 @@
 #include "iterator.hpp"
 #include "allocator.hpp"
 #include "utility.hpp"
+#include "list_algorithm.hpp"
 #include <exception>
 #include <utility>
 
@@ -26,11 +27,14 @@ bool operator==(__forward_list_iterator_base<T> const &, __forward_list_iterator
 template<typename T>
 bool operator!=(__forward_list_iterator_base<T> const &, __forward_list_iterator_base<T> const &) noexcept;
 
-template<typename T, typename Alloc = sx::allocator<T>>
+template<bool TrackTail>
+struct __forward_list_tail;
+
+template<typename T, typename Alloc = sx::allocator<T>, bool TrackTail = false, bool NodeCache = false>
 class forward_list;
 
-template<typename T, typename Alloc>
-void swap(forward_list<T, Alloc> &, forward_list<T, Alloc> &) noexcept;
+template<typename T, typename Alloc, bool TrackTail, bool NodeCache>
+void swap(forward_list<T, Alloc, TrackTail, NodeCache> &, forward_list<T, Alloc, TrackTail, NodeCache> &) noexcept;
 
 
 class forward_list_empty : public std::exception {
@@ -48,6 +52,16 @@ public:
 	__forward_node(Args&&... args) : data(std::forward<Args>(args)...) {}
 };
 
+/* 尾结点指针, 只在 TrackTail 为 true 时占用空间; 链表为空时指向头结点 */
+template<bool TrackTail>
+struct __forward_list_tail {
+	__forward_node_base	*tail;
+};
+
+template<>
+struct __forward_list_tail<false> {
+};
+
 template<typename T>
 struct __forward_list_iterator_base {
 	using size_type			= std::size_t;
@@ -118,9 +132,17 @@ public:
 };
 
 
-template<typename T, typename Alloc>
-class forward_list : public sx::comparetor<forward_list<T, Alloc>> {
-	friend void swap<T, Alloc>(forward_list<T, Alloc> &, forward_list<T, Alloc> &) noexcept;
+/*
+ * 单向链表
+ * TrackTail 为 true 时额外记录尾结点, 支持 O(1) 的 back / push_back / emplace_back 和整个链表的 splice_after,
+ * 可以作为 sx::queue 的底层容器, 每个结点只比 sx::list 少一个指针.
+ * NodeCache 为 true 时删除的结点可以留在本容器中复用, 含义与 sx::list 相同
+ */
+template<typename T, typename Alloc, bool TrackTail, bool NodeCache>
+class forward_list : public sx::container_helpful<forward_list<T, Alloc, TrackTail, NodeCache>>,
+					 protected __forward_list_tail<TrackTail>,
+					 protected sx::__node_cache<__forward_node_base, NodeCache> {
+	friend void swap<T, Alloc, TrackTail, NodeCache>(forward_list<T, Alloc, TrackTail, NodeCache> &, forward_list<T, Alloc, TrackTail, NodeCache> &) noexcept;
 public:
 	using value_type		= T;
 	using pointer			= T * ;
@@ -143,15 +165,19 @@ protected:
 public:
 	forward_list() noexcept : node_size(0) {
 		head.next = nullptr; 
+		set_tail(&head);
 	}
 
-	forward_list(forward_list const &other) { 
+	forward_list(forward_list const &other) : forward_list() { 
 		alloc_and_fill(other.begin(), other.end()); 
 	}
 
 	forward_list(forward_list &&other) noexcept : head(other.head), node_size(other.node_size) {
+		if constexpr (TrackTail)
+			this->tail = head.next == nullptr ? &head : other.tail;
 		other.head.next = nullptr;
 		other.node_size = 0;
+		other.set_tail(&other.head);
 	}
 
 	forward_list &operator=(forward_list const &other) {
@@ -168,7 +194,10 @@ public:
 	}
 
 	~forward_list() { 
+		if constexpr (NodeCache)
+			this->spare_limit = 0;
 		clear();  
+		trim_node_cache(0);
 	}
 
 	template<typename InputIterator, typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>>>
@@ -176,22 +205,89 @@ public:
 		alloc_and_fill(first, end);
 	}
 private:
+	void set_tail(link_node_base *node) noexcept {
+		if constexpr (TrackTail)
+			this->tail = node;
+	}
+
+	/* 链表被整体重排之后重新找到尾结点 */
+	void reset_tail() noexcept {
+		if constexpr (TrackTail) {
+			link_node_base *node = &head;
+			while (node->next != nullptr)
+				node = node->next;
+			this->tail = node;
+		}
+	}
+
+	/* 按元素比较两个结点, 供结点级算法使用 */
+	template<typename Compare>
+	static auto node_less(Compare &comp) noexcept {
+		return [&comp](link_node_base *first, link_node_base *second) {
+			return comp(static_cast<link_node *>(first)->data, static_cast<link_node *>(second)->data);
+		};
+	}
+
+	/* pos 原来是尾结点时, 尾结点改为 node */
+	void update_tail(link_node_base *pos, link_node_base *node) noexcept {
+		if constexpr (TrackTail) {
+			if (this->tail == pos)
+				this->tail = node;
+		}
+	}
+
+	/* 优先复用本容器缓存的结点, 与 sx::list 相同 */
+	link_node *get_node() {
+		if constexpr (NodeCache) {
+			if (this->spare_nodes != nullptr) {
+				link_node *node_ptr = static_cast<link_node *>(this->spare_nodes);
+				this->spare_nodes = node_ptr->next;
+				--this->spare_count;
+				return node_ptr;
+			}
+		}
+		return allocator.allocate();
+	}
+
+	void put_node(link_node *node_ptr) noexcept {
+		if constexpr (NodeCache) {
+			if (this->spare_count < this->spare_limit) {
+				node_ptr->next = this->spare_nodes;
+				this->spare_nodes = node_ptr;
+				++this->spare_count;
+				return;
+			}
+		}
+		allocator.deallocate(node_ptr, sizeof(link_node));
+	}
+
+	void trim_node_cache(size_type count) noexcept {
+		if constexpr (NodeCache) {
+			while (this->spare_count > count) {
+				link_node *node_ptr = static_cast<link_node *>(this->spare_nodes);
+				this->spare_nodes = node_ptr->next;
+				--this->spare_count;
+				allocator.deallocate(node_ptr, sizeof(link_node));
+			}
+		}
+	}
+
 	template<typename... Args>
-	static link_node *create_node(Args&&... args) {
-		link_node *node_ptr = allocator.allocate();
+	link_node *create_node(Args&&... args) {
+		link_node *node_ptr = get_node();
 		try {
 			allocator.construct(node_ptr, std::forward<Args>(args)...);
 			node_ptr->next = nullptr;
 		} catch (...) {
-			allocator.deallocate(node_ptr, sizeof(link_node));
+			put_node(node_ptr);
 			throw;
 		}
 		return node_ptr;
 	}
 
-	static void destroy_node(link_node *ptr) {
+	void destroy_node(link_node *ptr) noexcept {
 		allocator.destroy(ptr);
-		allocator.deallocate(ptr, sizeof(link_node));
+		put_node(ptr);
 	}
 
 	template<typename InputIterator>
@@ -214,16 +310,17 @@ private:
 				node_size++;
 			}
 			new_node->next = nullptr;
+			set_tail(cur);
 		} catch (...) {
 			link_node_base *node = head.next;
-			while (node != cur) {
+			while (node != nullptr) {
 				link_node *del_node = static_cast<link_node *>(node);
 				node = node->next;
-				allocator.destroy(del_node);
-				allocator.deallocate(del_node, sizeof(link_node));
+				destroy_node(del_node);
 			}
 			head.next = nullptr;
 			node_size = 0;
+			set_tail(&head);
 			throw;
 		}
 	}
@@ -267,6 +364,48 @@ public:
 		erase_after(before_begin(), end());
 	}
 
+	/* 回收结点缓存 (需要 NodeCache 为 true), 含义与 sx::list 相同 */
+	void set_node_cache_limit(size_type limit) noexcept {
+		static_assert(NodeCache, "forward_list::set_node_cache_limit requires NodeCache");
+		this->spare_limit = limit;
+		trim_node_cache(limit);
+	}
+
+	size_type node_cache_limit() const noexcept {
+		if constexpr (NodeCache)
+			return this->spare_limit;
+		else
+			return 0;
+	}
+
+	size_type node_cache_size() const noexcept {
+		if constexpr (NodeCache)
+			return this->spare_count;
+		else
+			return 0;
+	}
+
+	/* 预先分配结点放入缓存, 使元素数量达到 n 之前的插入都不必访问分配器 */
+	void reserve(size_type n) {
+		static_assert(NodeCache, "forward_list::reserve requires NodeCache");
+		if (n <= node_size + this->spare_count)
+			return;
+
+		size_type need = n - node_size;
+		if (this->spare_limit < need)
+			this->spare_limit = need;
+		while (this->spare_count < need) {
+			link_node_base *node_ptr = allocator.allocate();
+			node_ptr->next = this->spare_nodes;
+			this->spare_nodes = node_ptr;
+			++this->spare_count;
+		}
+	}
+
+	void shrink_to_fit() noexcept {
+		trim_node_cache(0);
+	}
+
 	reference front() {
 		if (empty())
 			throw std::out_of_range("forward_list::front error!!! forward_list is empty");
@@ -281,10 +420,27 @@ public:
 		return static_cast<link_node *>(head.next)->data;
 	}
 
+	reference back() {
+		static_assert(TrackTail, "forward_list::back requires TrackTail");
+		if (empty())
+			throw std::out_of_range("forward_list::back error!!! forward_list is empty");
+
+		return static_cast<link_node *>(this->tail)->data;
+	}
+
+	const_reference back() const {
+		static_assert(TrackTail, "forward_list::back requires TrackTail");
+		if (empty())
+			throw std::out_of_range("forward_list::back error!!! forward_list is empty");
+
+		return static_cast<link_node *>(this->tail)->data;
+	}
+
 	void push_front(value_type const &value) {
 		link_node *node = create_node(value);
 		node->next = head.next;
 		head.next = node;
+		update_tail(&head, node);
 		node_size++;
 	}
 
@@ -294,6 +450,7 @@ public:
 
 		link_node *node = static_cast<link_node *>(head.next);
 		head.next = node->next;
+		update_tail(node, &head);
 		destroy_node(node);
 		node_size--;
 	}
@@ -303,6 +460,24 @@ public:
 		link_node *node = create_node(std::forward<Args>(args)...);
 		node->next = head.next;
 		head.next = node;
+		update_tail(&head, node);
+		node_size++;
+	}
+
+	void push_back(value_type const &value) {
+		emplace_back(value);
+	}
+
+	void push_back(value_type &&value) {
+		emplace_back(std::move(value));
+	}
+
+	template<typename... Args>
+	void emplace_back(Args&&... args) {
+		static_assert(TrackTail, "forward_list::emplace_back requires TrackTail");
+		link_node *node = create_node(std::forward<Args>(args)...);
+		this->tail->next = node;
+		this->tail = node;
 		node_size++;
 	}
 
@@ -313,6 +488,7 @@ public:
 			return end();
 		
 		node->next = after->next;
+		update_tail(after, node);
 		node_size--;
 		destroy_node(static_cast<link_node *>(after));
 		return iterator(node->next);
@@ -330,6 +506,8 @@ public:
 
 		link_node_base *carry = node->next;
 		node->next = last.node;
+		if (last.node == nullptr)
+			set_tail(node);
 		while (carry != last.node) {
 			link_node_base *next = carry->next;
 			destroy_node(static_cast<link_node *>(carry));
@@ -353,6 +531,7 @@ public:
 		link_node_base *new_node = create_node(value);
 		new_node->next = node->next;
 		node->next = new_node;
+		update_tail(node, new_node);
 		node_size++;
 		return iterator(new_node);
 	}
@@ -371,6 +550,7 @@ public:
 		link_node_base *new_node = create_node(std::forward<Args>(args)...);
 		new_node->next = node->next;
 		node->next = new_node;
+		update_tail(node, new_node);
 		node_size++;
 		return iterator(new_node);
 	}
@@ -404,6 +584,7 @@ public:
 			}
 			curr->next = node->next;
 			node->next = range_head;
+			update_tail(node, curr);
 			node_size += range_size;
 		} catch (...) {
 			while (range_head != curr) {
@@ -441,18 +622,37 @@ public:
 		link_node_base *first_node = first.node;
 		link_node_base *left_node = first_node->next;
 		first_node->next = last.node;
+		if (last.node == nullptr)
+			other.set_tail(first_node);
 
 		link_node_base *right_node = before.node;
 		link_node_base *pos_node = pos.node;
 		right_node->next = pos_node->next;
 		pos_node->next = left_node;
+		update_tail(pos_node, right_node);
 
 		node_size += range_size;
 		other.node_size -= range_size;
 	}
 
+	/* 记录尾结点时不需要遍历 other, O(1) */
 	void splic_after(iterator pos, forward_list &other) {
-		splic_after(pos, other, other.before_begin(), other.end());
+		if (other.empty() || this == &other)
+			return;
+
+		if constexpr (TrackTail) {
+			link_node_base *pos_node = pos.node;
+			other.tail->next = pos_node->next;
+			pos_node->next = other.head.next;
+			update_tail(pos_node, other.tail);
+			node_size += other.node_size;
+
+			other.head.next = nullptr;
+			other.node_size = 0;
+			other.set_tail(&other.head);
+		} else {
+			splic_after(pos, other, other.before_begin(), other.end());
+		}
 	}
 
 	void splic_after(iterator pos, forward_list &other, iterator i) {
@@ -463,39 +663,45 @@ public:
 		splic_after(pos, other, i, ++j);
 	}
 
+	void splice_after(iterator pos, forward_list &other, iterator first, iterator last) {
+		splic_after(pos, other, first, last);
+	}
+
+	void splice_after(iterator pos, forward_list &other) {
+		splic_after(pos, other);
+	}
+
+	void splice_after(iterator pos, forward_list &other, iterator i) {
+		splic_after(pos, other, i);
+	}
+
 	template<typename Compare>
 	void meger(forward_list &other, Compare comp) {
 		if (this == &other)
 			return;
 
-		iterator first1 = before_begin();
-		iterator first2 = other.before_begin();
-		iterator last(nullptr);
-		iterator next1;
-		iterator next2;
-		while (true) {
-			next1 = first1;
-			next2 = first2;
-			++next1;
-			++next2;
-			if (next1 == last || next2 == last)
-				break;
-
-			if (comp(*next2, *next1)) {
-				first2.node->next = next2.node->next;
-				next2.node->next = next1.node;
-				first1.node->next = next2.node;
-				first1 = next2;
-			}
-			else
-				++first1;
+		/* 比较函数抛出异常时两边的结点也都已经接在本链表中 */
+		link_node_base *first1 = head.next;
+		link_node_base *first2 = other.head.next;
+		link_node_base *old_tail = &head;
+		link_node_base *other_tail = &other.head;
+		if constexpr (TrackTail) {
+			old_tail = this->tail;
+			other_tail = other.tail;
 		}
-
-		if (next2 != last)
-			splic_after(first1, other, first2, last);
-
+		other.head.next = nullptr;
 		node_size += other.node_size;
 		other.node_size = 0;
+		other.set_tail(&other.head);
+		try {
+			sx::__forward_list_merge(head.next, first1, first2, node_less(comp));
+		} catch (...) {
+			reset_tail();
+			throw;
+		}
+		/* 原来的尾结点后面接上了结点, 说明另一个链表的尾结点排在最后 */
+		if (old_tail->next != nullptr)
+			update_tail(old_tail, other_tail);
 	}
 
 	void meger(forward_list &other) {
@@ -504,28 +710,13 @@ public:
 
 	template<typename Compare>
 	void sort(Compare comp) {
-		if (empty())
-			return;
-
-		forward_list carry;
-		forward_list counter[64];
-		int fill = 0;
-		while (!empty()) {
-			carry.splic_after(carry.before_begin(), *this, before_begin());
-			int i = 0;
-			while (i < fill && !counter[i].empty()) {
-				counter[i].meger(carry, comp);
-				carry.swap(counter[i++]);
-			}
-			carry.swap(counter[i]);
-			if (i == fill)
-				++fill;
+		try {
+			sx::__forward_list_sort(&head, node_less(comp));
+		} catch (...) {
+			reset_tail();
+			throw;
 		}
-
-		for (int i = 1; i < fill; ++i)
-			counter[i].meger(counter[i - 1], comp);
-		
-		(*this).swap(counter[fill - 1]);
+		reset_tail();
 	}
 
 	void sort() {
@@ -537,14 +728,21 @@ public:
 	}
 };
 
-template<typename T, typename Alloc>
-typename forward_list<T, Alloc>::Allocator forward_list<T, Alloc>::allocator{};
+template<typename T, typename Alloc, bool TrackTail, bool NodeCache>
+typename forward_list<T, Alloc, TrackTail, NodeCache>::Allocator forward_list<T, Alloc, TrackTail, NodeCache>::allocator{};
 
-template<typename T, typename Alloc>
-void swap(forward_list<T, Alloc> &first, forward_list<T, Alloc> &second) noexcept {
+template<typename T, typename Alloc, bool TrackTail, bool NodeCache>
+void swap(forward_list<T, Alloc, TrackTail, NodeCache> &first, forward_list<T, Alloc, TrackTail, NodeCache> &second) noexcept {
 	using std::swap;
 	swap(first.head, second.head);
 	swap(first.node_size, second.node_size);
+	if constexpr (TrackTail) {
+		swap(first.tail, second.tail);
+		if (first.head.next == nullptr)
+			first.tail = &first.head;
+		if (second.head.next == nullptr)
+			second.tail = &second.head;
+	}
 }
 
 }
@@ -0,0 +1,188 @@
+﻿#ifndef M_FROZEN_MAP_HPP
+#define M_FROZEN_MAP_HPP
+#include <stdexcept>
+#include <utility>
+#include "utility.hpp"
+#include "map.hpp"
+#include "eytzinger.hpp"
+
+namespace sx {
+
+template<typename Key, typename Value, typename Compare = std::less<Key>>
+class frozen_map;
+
+
+/*
+ * 只读的 map: 从 sx::map 或有序区间一次建成, 之后不能插入和删除.
+ * 元素按 Eytzinger 布局存放, 查找无分支下降并预取, 比沿着红黑树结点指针一路缓存未命中快得多;
+ * 遍历仍按 key 递增, 但在内存中是跳跃的. 与 flat_map 一样 value_type 是 std::pair<Key, Value>,
+ * 迭代器只读. 需要修改时用 thaw() 变回 sx::map
+ */
+template<typename Key, typename Value, typename Compare>
+class frozen_map : public sx::container_helpful<frozen_map<Key, Value, Compare>> {
+public:
+	using key_type			= Key;
+	using mapped_type		= Value;
+	using value_type		= std::pair<Key, Value>;
+	using key_compare		= Compare;
+
+	struct key_of_value {
+		key_type const &operator()(value_type const &par) const {
+			return par.first;
+		}
+	};
+private:
+	using Tree				= sx::eytzinger_tree<key_type, value_type, key_of_value, Compare>;
+public:
+	using pointer			= typename Tree::pointer;
+	using reference			= typename Tree::reference;
+	using const_pointer		= typename Tree::const_pointer;
+	using const_reference	= typename Tree::const_reference;
+	using difference_type	= typename Tree::difference_type;
+	using size_type			= typename Tree::size_type;
+	using iterator			= typename Tree::const_iterator;
+	using const_iterator	= typename Tree::const_iterator;
+private:
+	Tree container;			/* 层序存放的元素 */
+public:
+	frozen_map() : container(Compare()) {}
+
+	explicit frozen_map(Compare const &comp) : container(comp) {}
+
+	template<typename Alloc, typename NodeUpdate>
+	explicit frozen_map(sx::map<Key, Value, Compare, Alloc, NodeUpdate> const &source) : container(source.key_comp()) {
+		container.assign(source.begin(), source.end());
+	}
+
+	/* 调用者保证输入按 key 严格递增 */
+	template<typename InputIterator,
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
+		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
+	frozen_map(sx::sorted_unique_t, InputIterator first, InputIterator last, Compare const &comp = Compare())
+		: container(comp) {
+		container.assign(first, last);
+	}
+
+	frozen_map(frozen_map const &other) : container(other.container) {}
+
+	frozen_map(frozen_map &&other) noexcept : container(std::move(other.container)) {}
+
+	frozen_map &operator=(frozen_map const &other) {
+		container = other.container;
+		return *this;
+	}
+
+	frozen_map &operator=(frozen_map &&other) noexcept {
+		container = std::move(other.container);
+		return *this;
+	}
+
+	~frozen_map() {}
+public:
+	size_type size() const noexcept {
+		return container.size();
+	}
+
+	bool empty() const noexcept {
+		return container.empty();
+	}
+
+	key_compare key_comp() const {
+		return container.key_comp();
+	}
+
+	const_iterator begin() const noexcept {
+		return container.begin();
+	}
+
+	const_iterator end() const noexcept {
+		return container.end();
+	}
+
+	const_iterator cbegin() const noexcept {
+		return container.begin();
+	}
+
+	const_iterator cend() const noexcept {
+		return container.end();
+	}
+
+	const_iterator find(key_type const &key) const {
+		return container.find(key);
+	}
+
+	const_iterator lower_bound(key_type const &key) const {
+		return container.lower_bound(key);
+	}
+
+	const_iterator upper_bound(key_type const &key) const {
+		return container.upper_bound(key);
+	}
+
+	std::pair<const_iterator, const_iterator> equal_range(key_type const &key) const {
+		return container.equal_range(key);
+	}
+
+	size_type count(key_type const &key) const {
+		return container.count(key);
+	}
+
+	/* key 不存在时抛出 std::out_of_range */
+	Value const &at(key_type const &key) const {
+		const_iterator position = find(key);
+		if (position == cend())
+			throw std::out_of_range("key not found");
+		return position->second;
+	}
+
+	/* 比较器声明了 is_transparent 时, 可以用任何能与 Key 比较的类型查找 */
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator find(K const &key) const {
+		return container.find(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator lower_bound(K const &key) const {
+		return container.lower_bound(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator upper_bound(K const &key) const {
+		return container.upper_bound(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	std::pair<const_iterator, const_iterator> equal_range(K const &key) const {
+		return container.equal_range(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	size_type count(K const &key) const {
+		return container.count(key);
+	}
+
+	/* 严格小于 key 的元素个数, 与查找同样只走一次下降路径 */
+	size_type rank(key_type const &key) const {
+		return container.rank(key);
+	}
+
+	/* 按顺序重新建成可修改的 sx::map, O(n) */
+	sx::map<Key, Value, Compare> thaw() const {
+		sx::map<Key, Value, Compare> result(key_comp());
+		result.insert(sx::sorted_unique, cbegin(), cend());
+		return result;
+	}
+
+	void swap(frozen_map &other) noexcept {
+		container.swap(other.container);
+	}
+};
+
+template<typename Key, typename Value, typename Compare, typename Alloc, typename NodeUpdate>
+frozen_map<Key, Value, Compare> freeze(sx::map<Key, Value, Compare, Alloc, NodeUpdate> const &source) {
+	return frozen_map<Key, Value, Compare>(source);
+}
+
+}
+
+#endif // !M_FROZEN_MAP_HPP
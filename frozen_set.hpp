@@ -0,0 +1,172 @@
+﻿#ifndef M_FROZEN_SET_HPP
+#define M_FROZEN_SET_HPP
+#include <utility>
+#include "type_traits.hpp"
+#include "utility.hpp"
+#include "set.hpp"
+#include "eytzinger.hpp"
+
+namespace sx {
+
+template<typename Key, typename Compare = std::less<Key>>
+class frozen_set;
+
+
+/*
+ * 只读的 set: 从 sx::set 或有序区间一次建成, 元素按 Eytzinger 布局存放.
+ * 遍历仍按顺序, 但在内存中是跳跃的. 需要修改时用 thaw() 变回 sx::set
+ */
+template<typename Key, typename Compare>
+class frozen_set : public sx::container_helpful<frozen_set<Key, Compare>> {
+public:
+	using key_type			= Key;
+	using value_type		= Key;
+	using key_compare		= Compare;
+	using value_compare		= Compare;
+private:
+	using Tree				= sx::eytzinger_tree<key_type, value_type, sx::identity<value_type>, Compare>;
+public:
+	using pointer			= typename Tree::pointer;
+	using reference			= typename Tree::reference;
+	using const_pointer		= typename Tree::const_pointer;
+	using const_reference	= typename Tree::const_reference;
+	using difference_type	= typename Tree::difference_type;
+	using size_type			= typename Tree::size_type;
+	using iterator			= typename Tree::const_iterator;
+	using const_iterator	= typename Tree::const_iterator;
+private:
+	Tree container;			/* 层序存放的元素 */
+public:
+	frozen_set() : container(Compare{}) {}
+
+	explicit frozen_set(Compare const &comp) : container(comp) {}
+
+	template<typename Alloc, typename NodeUpdate>
+	explicit frozen_set(sx::set<Key, Compare, Alloc, NodeUpdate> const &source) : container(source.key_comp()) {
+		container.assign(source.begin(), source.end());
+	}
+
+	/* 调用者保证输入严格递增 */
+	template<typename InputIterator,
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
+		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
+	frozen_set(sx::sorted_unique_t, InputIterator first, InputIterator last, Compare const &comp = Compare{})
+		: container(comp) {
+		container.assign(first, last);
+	}
+
+	frozen_set(frozen_set const &other) : container(other.container) { }
+
+	frozen_set(frozen_set &&other) noexcept : container(std::move(other.container)) { }
+
+	frozen_set &operator=(frozen_set const &other) {
+		container = other.container;
+		return *this;
+	}
+
+	frozen_set &operator=(frozen_set &&other) noexcept {
+		container = std::move(other.container);
+		return *this;
+	}
+
+	~frozen_set() { }
+public:
+	size_type size() const noexcept {
+		return container.size();
+	}
+
+	bool empty() const noexcept {
+		return container.empty();
+	}
+
+	key_compare key_comp() const {
+		return container.key_comp();
+	}
+
+	const_iterator begin() const noexcept {
+		return container.begin();
+	}
+
+	const_iterator end() const noexcept {
+		return container.end();
+	}
+
+	const_iterator cbegin() const noexcept {
+		return container.begin();
+	}
+
+	const_iterator cend() const noexcept {
+		return container.end();
+	}
+
+	const_iterator find(value_type const &val) const {
+		return container.find(val);
+	}
+
+	const_iterator lower_bound(value_type const &val) const {
+		return container.lower_bound(val);
+	}
+
+	const_iterator upper_bound(value_type const &val) const {
+		return container.upper_bound(val);
+	}
+
+	std::pair<const_iterator, const_iterator> equal_range(value_type const &val) const {
+		return container.equal_range(val);
+	}
+
+	size_type count(value_type const &val) const {
+		return container.count(val);
+	}
+
+	/* 比较器声明了 is_transparent 时, 可以用任何能与元素比较的类型查找 */
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator find(K const &key) const {
+		return container.find(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator lower_bound(K const &key) const {
+		return container.lower_bound(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator upper_bound(K const &key) const {
+		return container.upper_bound(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	std::pair<const_iterator, const_iterator> equal_range(K const &key) const {
+		return container.equal_range(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	size_type count(K const &key) const {
+		return container.count(key);
+	}
+
+	/* 严格小于 val 的元素个数, 与查找同样只走一次下降路径 */
+	size_type rank(value_type const &val) const {
+		return container.rank(val);
+	}
+
+	/* 按顺序重新建成可修改的 sx::set, O(n) */
+	sx::set<Key, Compare> thaw() const {
+		sx::set<Key, Compare> result(key_comp());
+		result.insert(sx::sorted_unique, cbegin(), cend());
+		return result;
+	}
+
+	void swap(frozen_set &other) noexcept {
+		container.swap(other.container);
+	}
+};
+
+template<typename Key, typename Compare, typename Alloc, typename NodeUpdate>
+frozen_set<Key, Compare> freeze(sx::set<Key, Compare, Alloc, NodeUpdate> const &source) {
+	return frozen_set<Key, Compare>(source);
+}
+
+}
+
+#endif // !M_FROZEN_SET_HPP
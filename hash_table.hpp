@@ -4,6 +4,7 @@
 #include "utility.hpp"
 #include "iterator.hpp"
 #include "vector.hpp"
+#include "node_handle.hpp"
 #include <utility>
 #include <cstddef>
 
@@ -36,8 +37,8 @@ struct hash_table_node {
     hash_table_node     *next;      /* 下一个结点 */
     T                    data;      /* 数据域 */
 public:
-    hash_table_node(T const &val) : data(val) {}
-    hash_table_node(T &&val) : data(std::move(val)) {}
+    template<typename... Args>
+    hash_table_node(Args&&... args) : next(nullptr), data(std::forward<Args>(args)...) {}
 };
 
 /* 哈希表迭代器 */
@@ -75,7 +76,7 @@ public:
         curr = curr->next;
         if (curr == nullptr) {
             size_type bucket = table->bucket_index(old->data);
-            while (curr != nullptr && ++bucket < table->bucket_count())
+            while (curr == nullptr && ++bucket < table->bucket_count())
                 curr = table->buckets[bucket];
         }     
         return *this;
@@ -131,14 +132,14 @@ public:
         node const *old = curr;
         curr = curr->next;
         if (curr == nullptr) {
-            unsigned long bucket = table->bucket_index(old->data);
-            while (curr != nullptr && bucket < table->bucket_count())
+            size_type bucket = table->bucket_index(old->data);
+            while (curr == nullptr && ++bucket < table->bucket_count())
                curr = table->buckets[bucket]; 
         }
         return *this;
     }
 
-	hash_const_iterator &operator++(int) {
+	hash_const_iterator operator++(int) {
 		hash_const_iterator ret = *this;
         ++(*this);
         return ret;
@@ -176,9 +177,13 @@ public:
 private:
     using node              = hash_table_node<Value>;
     using Allocator         = decltype(sx::transform_alloator_type<Value, node>(Alloc{}));
+public:
+    using node_type             = sx::node_handle<Value, node, Allocator>;
+    using insert_return_type    = sx::node_insert_return<iterator, node_type>;
+private:
 
-    friend class iterator;
-    friend class const_iterator;
+    friend iterator;
+    friend const_iterator;
 private:
     static Allocator		allocator;      /* 结点分配器 */
     hasher					hash;           /* 哈希函数 */
@@ -194,7 +199,7 @@ protected:
         1543,       3079,           6151,       12289,      24593,
         49157,      98317,          196613,     393241,     786433,
         1572869,    3145739,        6291469,    12582917,   25165843,
-        50331653,   10663319,       20132611,   402653189,  805306457,
+        50331653,   100663319,      201326611,   402653189,  805306457,
         1610612741, 3221225473ul,   4294967291ul
     };
 
@@ -226,11 +231,13 @@ protected:
         put_node(ptr);
     }
 
-	unsigned long hash_index(key_type const &key, unsigned long buckets_size) const {
+	template<typename K>
+	unsigned long hash_index(K const &key, unsigned long buckets_size) const {
 		return hash(key) % buckets_size;
 	}
 
-	unsigned long hash_index(key_type const &key) const {
+	template<typename K>
+	unsigned long hash_index(K const &key) const {
 		return hash_index(key, bucket_count());
 	}
 
@@ -243,18 +250,15 @@ protected:
     }
 private:
 
+    /* 把已构造好的结点挂入桶中, 相同 key 的元素保持相邻; 唯一插入遇到重复时不挂入, 由调用者处理该结点 */
     template<bool IsUnique>
-    std::pair<iterator, bool> __insert(value_type const &val) {
-        unsigned long index = bucket_index(val);
-        if (index < first_index)
-            first_index = index;
+    std::pair<iterator, bool> __insert_node(node *new_node) {
+        key_type const &key = get_key(new_node->data);
+        unsigned long index = hash_index(key);
 
 		node *curr = buckets[index];
 		node *prev = nullptr;
-		while (curr != nullptr) {
-			if (equals(ExtractKey()(curr->data), ExtractKey()(val)))
-				break;
-
+		while (curr != nullptr && !equals(get_key(curr->data), key)) {
 			prev = curr;
 			curr = curr->next;
 		}
@@ -262,7 +266,9 @@ private:
 		if (curr != nullptr && IsUnique)
 			return { iterator(curr, this), false };
 
-        node *new_node = create_node(val);
+        if (index < first_index)
+            first_index = index;
+
 		new_node->next = curr;
         ++num_elements;
 
@@ -274,52 +280,152 @@ private:
         return std::pair<iterator, bool>(iterator(new_node, this), true);
     }
 
-	size_type remove(key_type const &key) {
-		unsigned long index = hash_index(key);
+    template<bool IsUnique, typename... Args>
+    std::pair<iterator, bool> __insert(Args&&... args) {
+        node *new_node = create_node(std::forward<Args>(args)...);
+        std::pair<iterator, bool> ret = __insert_node<IsUnique>(new_node);
+        if (!ret.second)
+            destroy_node(new_node);
+        return ret;
+    }
+
+    template<typename K>
+    node *__find_node(K const &key) const {
+        node *first = num_elements != 0 ? buckets[hash_index(key)] : nullptr;
+        while (first != nullptr && !equals(get_key(first->data), key))
+            first = first->next;
+        return first;
+    }
+
+    /* 
+     * 先按 key 查找, 不存在时才扩容并构造结点, 新结点挂在桶头. 
+     * 查找和计算桶下标都在构造之前完成, key 可以引用 args 中会被移走的对象
+     */
+    template<typename... Args>
+    std::pair<iterator, bool> __try_emplace(key_type const &key, Args&&... args) {
+        node *curr = __find_node(key);
+        if (curr != nullptr)
+            return std::pair<iterator, bool>(iterator(curr, this), false);
+
+        resize(num_elements + 1);
+        unsigned long index = hash_index(key);
+        node *new_node = create_node(std::forward<Args>(args)...);
+        __link_front(new_node, index);
+        return std::pair<iterator, bool>(iterator(new_node, this), true);
+    }
+
+    /* 已确认桶中没有相同 key, 直接挂在桶头 */
+    void __link_front(node *new_node, unsigned long index) noexcept {
+        new_node->next = buckets[index];
+        buckets[index] = new_node;
+        if (index < first_index)
+            first_index = index;
+        ++num_elements;
+    }
+
+    /* 把结点从所在的桶中摘下但不销毁 */
+    void __unlink(node *ptr) noexcept {
+        unsigned long index = bucket_index(ptr->data);
+        node *curr = buckets[index];
+        node *prev = nullptr;
+        while (curr != ptr) {
+            prev = curr;
+            curr = curr->next;
+        }
+
+        if (prev == nullptr)
+            buckets[index] = curr->next;
+        else
+            prev->next = curr->next;
+        curr->next = nullptr;
+        --num_elements;
+    }
+
+	template<typename K>
+	size_type __count(K const &key) const {
+		node *first = __find_node(key);
+		size_type distance = 0;
+		while (first != nullptr && equals(get_key(first->data), key)) {
+			first = first->next;
+			++distance;
+		}
+		return distance;
+	}
+
+	/* 相同 key 的元素在同一个桶中相邻 */
+	template<typename K>
+	std::pair<iterator, iterator> __equal_range(K const &key) const {
+		iterator first(__find_node(key), const_cast<hash_table *>(this));
+		iterator last = first;
+
+		while (last != static_cast<iterator>(end()) && equals(get_key(*last), key))
+			++last;
 		
+		return { first, last };
+	}
+
+	/* 先把相同 key 的一段结点摘下再逐个销毁, key 可能引用的是被删除元素自身 */
+	template<typename K>
+	size_type remove(K const &key) {
+		if (num_elements == 0)
+			return 0;
+
+		unsigned long index = hash_index(key);
 		node *curr = buckets[index];
 		node *prev = nullptr;
-		node *del_list = nullptr;
-		while (curr != nullptr) {
-			if (equals(get_key(curr->data), key)) {
-				del_list = curr;
-				node *right_prev = nullptr;
-				while (curr != nullptr && equals(get_key(curr->data), key)) {
-					right_prev = curr;
-					curr = curr->next;
-				}
-				right_prev->next = nullptr;
-				prev->next = curr;
-				break;
-			}
+		while (curr != nullptr && !equals(get_key(curr->data), key)) {
 			prev = curr;
 			curr = curr->next;
 		}
-		
+
 		size_type del_size = 0;
-		while (del_list != nullptr) {
-			node *del_node = del_list;
-			del_list = del_list->next;
-			destroy_node(del_node);
+		node *last = curr;
+		while (last != nullptr && equals(get_key(last->data), key)) {
+			last = last->next;
 			++del_size;
 		}
 
+		if (prev != nullptr)
+			prev->next = last;
+		else
+			buckets[index] = last;
+
+		while (curr != last) {
+			node *del_node = curr;
+			curr = curr->next;
+			destroy_node(del_node);
+		}
+
 		num_elements -= del_size;
 		return del_size;
 	}
 public:
     hash_table(HashFunc const &hash_func, EqualKey const &euqal_func)
-        : hash(hash_func), equals(euqal_func), num_elements(0), first_index(0) { 
-        first_index = bucket_count() - 1;
+        : hash_table(0, hash_func, euqal_func) { 
     }
 
     hash_table(size_type n, HashFunc const &hash_func, EqualKey const &equal_func)
-        : hash(hash_func),  equals(equal_func), num_elements(0), buckets(n, nullptr) { 
+        : hash(hash_func),  equals(equal_func), buckets(next_prime(n), nullptr), num_elements(0) { 
         first_index = bucket_count() - 1;
     }
 
-    hash_table(hash_table const &other) 
-        : hash_table(other.hash, other.equals, other.begin(), other.end()) {
+    /* 桶数相同, 逐个桶按原顺序复制链表, 不重新计算哈希, 也不比较 key */
+    hash_table(hash_table const &other)
+        : hash(other.hash), equals(other.equals), buckets(other.bucket_count(), nullptr),
+        num_elements(0), first_index(other.first_index) {
+        try {
+            for (size_type i = other.first_index; i < other.bucket_count(); ++i) {
+                node **tail = &buckets[i];
+                for (node *curr = other.buckets[i]; curr != nullptr; curr = curr->next) {
+                    *tail = create_node(curr->data);
+                    tail = &(*tail)->next;
+                    ++num_elements;
+                }
+            }
+        } catch (...) {
+            clear();
+            throw;
+        }
     }
 
     hash_table(hash_table &&other) noexcept
@@ -388,8 +494,13 @@ public:
         first_index = bucket_count() - 1;
     }
 
+    /* first_index 只是第一个非空桶的下界, 擦除元素后不再维护 */
     iterator begin() noexcept { 
-        return iterator(buckets[first_index], this);
+        for (size_type i = first_index; i < bucket_count(); ++i) {
+            if (buckets[i] != nullptr)
+                return iterator(buckets[i], this);
+        }
+        return end();
     }
 
     iterator end() noexcept {
@@ -405,23 +516,27 @@ public:
     }
 
     const_iterator cbegin() const noexcept {
-		return const_iterator(buckets[first_index], this);
+        for (size_type i = first_index; i < bucket_count(); ++i) {
+            if (buckets[i] != nullptr)
+                return const_iterator(buckets[i], this);
+        }
+		return cend();
     }
 
     const_iterator cend() const noexcept {
 		return const_iterator(nullptr, this);
     }
 
+	/* 先转换成临时元素取出 key 查找, key 已存在时不扩容也不分配结点 */
 	template<typename T,
 		typename = std::enable_if_t<std::is_convertible_v<T, value_type>>>
-	iterator insert_unique(T const &val) {
-		resize(num_elements + 1);
-		return __insert<true>(val);
+	std::pair<iterator, bool> insert_unique(T const &val) {
+		value_type tmp(val);
+		return __try_emplace(get_key(tmp), std::move(tmp));
 	}
 
     std::pair<iterator, bool> insert_unique(value_type const &val) {
-        resize(num_elements + 1);
-        return __insert<true>(val);
+        return __try_emplace(get_key(val), val);
     }
 
     template<typename InputIterator, 
@@ -429,14 +544,14 @@ public:
 		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
     void insert_unique(InputIterator first, InputIterator last) {
 		for ( ; first != last; ++first)
-			__insert<true>(*first);
+			insert_unique(*first);
     }
 
 	template<typename T,
 		typename = std::enable_if_t<std::is_convertible_v<T, value_type>>>
 	iterator insert_equal(T const &val) {
 		resize(num_elements + 1);
-		return __insert<false>(val);
+		return __insert<false>(val).first;
 	}
 
     iterator insert_equal(value_type const &val) {
@@ -444,20 +559,31 @@ public:
         return __insert<false>(val).first;
     }
 
-    template<typename InpuIterator,
+    template<typename InputIterator,
         typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator> && 
 									sx::is_convertible_iter_type_v<InputIterator, value_type>>>
-    iterator insert_equal(InpuIterator first, InpuIterator last) {
+    iterator insert_equal(InputIterator first, InputIterator last) {
         iterator ret;
         for ( ; first != last; ++first)
             ret = insert_equal(*first);
         return ret;
     }
 
+    /* 参数恰好是一个元素时直接取出 key 先查找, 否则先在栈上构造临时元素取出 key, 再移动进结点 */
     template<typename... Args> 
     std::pair<iterator, bool> emplace_unique(Args&&... args) {
-        resize(num_elements + 1);
-        return __insert<true>(std::forward<Args>(args)...);
+        if constexpr (sizeof...(Args) == 1 && (std::is_same_v<std::decay_t<Args>, value_type> && ...)) {
+            return __try_emplace(get_key(args)..., std::forward<Args>(args)...);
+        } else {
+            value_type tmp(std::forward<Args>(args)...);
+            return __try_emplace(get_key(tmp), std::move(tmp));
+        }
+    }
+
+    /* key 不存在时才用 args 构造元素, 已存在时 args 不会被使用; args 构造出的元素的 key 必须与 key 相等 */
+    template<typename... Args>
+    std::pair<iterator, bool> try_emplace_unique(key_type const &key, Args&&... args) {
+        return __try_emplace(key, std::forward<Args>(args)...);
     }
 
     template<typename... Args>
@@ -470,127 +596,137 @@ public:
         return remove(key);
     }
 
+    /* 哈希函数和 key_equal 都声明了 is_transparent 时, 可以用任何能与 key 比较的类型查找, 不构造临时 key */
+    template<typename K, typename = sx::__transparent_key_t<HashFunc, sx::__transparent_key_t<EqualKey, K>>>
+    size_type erase(K const &key) {
+        return remove(key);
+    }
+
 	iterator erase(iterator pos) {
-		if (pos == end())
+		if (pos.curr == nullptr)
 			return pos;
 
-		size_type index = bucket_index(pos.curr->data);
-		node *curr = buckets[index];
-		node *prev = nullptr;
-		while (curr != pos.curr) {
-			prev = curr;
-			curr = curr->next;
-		}
-
-		if (prev == nullptr)
-			buckets[index] = curr->next;
-		else
-			prev->next = curr->next;
+		iterator next = pos;
+		++next;
 
-		destroy_node(curr);
-		--num_elements;
-		return ++iterator(prev, this);
+		__unlink(pos.curr);
+		destroy_node(pos.curr);
+		return next;
 	}
 
 	iterator erase(iterator first, iterator last) {
-		if (first == end() || first == last)
-			return end();
+		while (first != last)
+			first = erase(first);
+		return last;
+	}
 
-		vector<node *> carry;
-		size_type first_idx = bucket_index(first.curr->data);
-		size_type last_idx = last.curr != nullptr ? bucket_index(last.curr->data) : bucket_count();
-		
-		node *curr = buckets[first_idx];
-		node *prev = nullptr;
-		node *first_curr = first.curr;
-		while (curr != first_curr) {
-			prev = curr;
-			curr = curr->next;
-		}
+	/* 把结点摘下交给句柄, 不释放也不移动元素 */
+	node_type extract(iterator pos) {
+		if (pos.curr == nullptr)
+			return node_type();
+		__unlink(pos.curr);
+		return node_type(pos.curr);
+	}
 
-		carry.push_back(curr);
-		if (prev == nullptr)
-			buckets[first_idx] = nullptr;
-		else
-			prev->next = nullptr;
+	node_type extract(key_type const &key) {
+		node *ptr = __find_node(key);
+		if (ptr == nullptr)
+			return node_type();
+		__unlink(ptr);
+		return node_type(ptr);
+	}
 
-		for (size_type i = first_idx; i != last_idx; ++i) {
-			carry.push_back(buckets[i]);
-			buckets[i] = nullptr;
-		}
+	/* 已有相同 key 时句柄原样交还给 node */
+	insert_return_type insert_unique(node_type &&handle) {
+		if (handle.empty())
+			return insert_return_type{ end(), false, node_type() };
 
-		for (auto ptr : carry) {
-			while (ptr != nullptr) {
-				node *del_node = ptr;
-				ptr = ptr->next;
-				destroy_node(del_node);
-				--num_elements;
-			}
-		}
+		node *curr = __find_node(get_key(handle.ptr->data));
+		if (curr != nullptr)
+			return insert_return_type{ iterator(curr, this), false, std::move(handle) };
 
-		if (last_idx != bucket_count()) {
-			node *left_ptr = buckets[last_idx];
-			node *last_curr = last.curr;
-			buckets[last_idx] = last_curr;
-			while (left_ptr != last_curr) {
-				node *del_node = left_ptr;
-				left_ptr = left_ptr->next;
-				destroy_node(del_node);
-				--num_elements;
-			}
+		resize(num_elements + 1);
+		node *ptr = handle.release();
+		__link_front(ptr, bucket_index(ptr->data));
+		return insert_return_type{ iterator(ptr, this), true, node_type() };
+	}
+
+	iterator insert_equal(node_type &&handle) {
+		if (handle.empty())
+			return end();
+		resize(num_elements + 1);
+		return __insert_node<false>(handle.release()).first;
+	}
+
+	/* 把 other 中 key 不重复的结点逐个摘下挂到本表, 重复的留在 other 中; 不分配也不拷贝元素 */
+	template<typename OtherHash, typename OtherEqual>
+	void merge_unique(hash_table<Value, Key, OtherHash, ExtractKey, OtherEqual, Alloc> &other) {
+		if (static_cast<void *>(&other) == static_cast<void *>(this))
+			return;
+
+		for (auto first = other.begin(); first != other.end(); ) {
+			auto pos = first++;
+			if (__find_node(get_key(*pos)) != nullptr)
+				continue;
+			resize(num_elements + 1);
+			node *ptr = other.extract(pos).release();
+			__link_front(ptr, bucket_index(ptr->data));
 		}
+	}
+
+	template<typename OtherHash, typename OtherEqual>
+	void merge_equal(hash_table<Value, Key, OtherHash, ExtractKey, OtherEqual, Alloc> &other) {
+		if (static_cast<void *>(&other) == static_cast<void *>(this))
+			return;
 
-		return iterator(buckets[last_idx], this);
+		for (auto first = other.begin(); first != other.end(); ) {
+			auto pos = first++;
+			resize(num_elements + 1);
+			__insert_node<false>(other.extract(pos).release());
+		}
 	}
 
 	size_type count(key_type const &key) const {
-		node *first = buckets[hash_index(key)];
-		size_type distance = 0;
-		while (first != nullptr) {
-			if (equals(get_key(first->data), key)) {
-				first = first->next;
-				++distance;
-			}
-		}
-		return distance;
+		return __count(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<HashFunc, sx::__transparent_key_t<EqualKey, K>>>
+	size_type count(K const &key) const {
+		return __count(key);
 	}
 
 	iterator find(key_type const &key) const {
-		node *first = buckets[hash_index(key)];
-		while (first != nullptr) {
-			if (equals(get_key(first->data), key))
-				break;
-		}
+		return iterator(__find_node(key), const_cast<hash_table *>(this));
+	}
 
-		return iterator(first, const_cast<hash_table *>(this));
+	template<typename K, typename = sx::__transparent_key_t<HashFunc, sx::__transparent_key_t<EqualKey, K>>>
+	iterator find(K const &key) const {
+		return iterator(__find_node(key), const_cast<hash_table *>(this));
 	}
 
 	std::pair<iterator, iterator> equal_range(key_type const &key) const {
-		iterator first = find(key);
-		iterator last = first;
+		return __equal_range(key);
+	}
 
-		while (last != static_cast<iterator>(end()) && equals(get_key(*last), key))
-			++last;
-		
-		return { first, last };
+	template<typename K, typename = sx::__transparent_key_t<HashFunc, sx::__transparent_key_t<EqualKey, K>>>
+	std::pair<iterator, iterator> equal_range(K const &key) const {
+		return __equal_range(key);
 	}
 
+	/* 元素数量超过桶数时扩容, 结点只重新链接而不移动, 指向元素的指针保持有效 */
 	void resize(size_type num_elements_hint) {
 		const size_type old = bucket_count();
-		if (num_elements < old)
+		if (num_elements_hint <= old)
 			return;
 
-		const size_type new_size = next_prime(old);
-		if (num_elements == old)
+		const size_type new_size = next_prime(num_elements_hint);
+		if (new_size <= old)
 			return;
 
 		vector<node *> carry(new_size, nullptr);
-		first_index = new_size;
+		first_index = new_size - 1;
 		for (unsigned long bucket = 0; bucket < old; ++bucket) {
 			node *head = buckets[bucket];
-			if (head == nullptr)
-				continue;
-
 			while (head != nullptr) {
 				node *element = head;
 				head = head->next;
@@ -599,12 +735,11 @@ public:
 				if (index < first_index)
 					first_index = index;
 
-				node *new_bucket_head = carry[index];
-				element->next = new_bucket_head;
-				new_bucket_head = element;
+				element->next = carry[index];
+				carry[index] = element;
 			}
 		}
-		sx::swap(carry, buckets);
+		buckets.swap(carry);
 	}
 
 	size_type bucket_count() const noexcept {
@@ -625,8 +760,6 @@ public:
 		swap(num_elements, other.num_elements);
 		swap(first_index, other.first_index);
 	}
-
-	friend void swap(hash_table &lhs, hash_table &rhs) noexcept;
 };
 
 
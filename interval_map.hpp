@@ -0,0 +1,253 @@
+﻿#ifndef M_INTERVAL_MAP_HPP
+#define M_INTERVAL_MAP_HPP
+#include <functional>
+#include <utility>
+#include "allocator.hpp"
+#include "rbtree.hpp"
+#include "vector.hpp"
+
+namespace sx {
+
+/*
+ * 区间树: 以区间为 key 的红黑树, 先按左端点再按右端点排序, 每个结点额外维护子树中最大的右端点.
+ * 区间是左闭右开的 [low, high), 相同的区间可以重复出现.
+ * 重叠查询和点查询 (stabbing) 剪掉最大右端点不超过查询左端的子树和左端点已越过查询右端的右子树,
+ * 区间都较短时接近 O(log n + k), k 为命中的区间个数; 但剪枝只看这两个条件,
+ * 左端点在查询点之前, 右端点散落在子树各处时仍可能走遍所有左端点不超过查询点的结点, 最坏 O(n)
+ */
+template<typename Point, typename Value,
+	typename Compare = std::less<Point>,
+	typename Alloc = sx::allocator<std::pair<const std::pair<Point, Point>, Value>>>
+class interval_map {
+public:
+	using point_type	= Point;
+	using key_type		= std::pair<Point, Point>;
+	using mapped_type	= Value;
+	using value_type	= std::pair<const key_type, Value>;
+	using point_compare	= Compare;
+
+	/* 先比较左端点, 再比较右端点 */
+	struct key_compare {
+		Compare comp;
+	public:
+		key_compare(Compare comp = Compare()) : comp(comp) {}
+
+		bool operator()(key_type const &first, key_type const &second) const {
+			if (comp(first.first, second.first))
+				return true;
+			if (comp(second.first, first.first))
+				return false;
+			return comp(first.second, second.second);
+		}
+	};
+private:
+	struct key_of_value {
+		key_type const &operator()(value_type const &val) const {
+			return val.first;
+		}
+	};
+
+	/* 子树中最大的右端点, 用默认构造的 Compare 比较 */
+	struct max_high {
+		using value_type = Point;
+
+		static Point const &lift(typename interval_map::value_type const &val) noexcept {
+			return val.first.second;
+		}
+
+		static Point const &combine(Point const &first, Point const &second) noexcept {
+			return Compare()(first, second) ? second : first;
+		}
+	};
+
+	using Container = sx::rbtree<key_type, value_type, key_of_value, key_compare, Alloc,
+		sx::rbtree_monoid_update<max_high>>;
+public:
+	using pointer			= typename Container::pointer;
+	using reference			= typename Container::reference;
+	using const_pointer		= typename Container::const_pointer;
+	using const_reference	= typename Container::const_reference;
+	using difference_type	= typename Container::difference_type;
+	using size_type			= typename Container::size_type;
+	using iterator			= typename Container::iterator;
+	using const_iterator	= typename Container::const_iterator;
+private:
+	Container	container;		/* 底层红黑树容器 */
+	Compare		comp;			/* 端点比较器 */
+public:
+	interval_map() : container(key_compare()) {}
+	explicit interval_map(Compare const &comp) : container(key_compare(comp)), comp(comp) {}
+
+	interval_map(interval_map const &other) : container(other.container), comp(other.comp) { }
+
+	interval_map(interval_map &&other) noexcept : container(std::move(other.container)), comp(other.comp) { }
+
+	interval_map &operator=(interval_map const &other) {
+		container = other.container;
+		comp = other.comp;
+		return *this;
+	}
+
+	interval_map &operator=(interval_map &&other) noexcept {
+		container = std::move(other.container);
+		comp = other.comp;
+		return *this;
+	}
+
+	~interval_map() { }
+public:
+	size_type size() const noexcept {
+		return container.size();
+	}
+
+	bool empty() const noexcept {
+		return container.empty();
+	}
+
+	void clear() {
+		container.clear();
+	}
+
+	/* 结点按中序搬到连续内存中并重新平衡, 所有迭代器失效 */
+	void compact() {
+		container.compact();
+	}
+
+	iterator begin() noexcept {
+		return container.begin();
+	}
+
+	iterator end() noexcept {
+		return container.end();
+	}
+
+	const_iterator begin() const noexcept {
+		return container.cbegin();
+	}
+
+	const_iterator end() const noexcept {
+		return container.cend();
+	}
+
+	const_iterator cbegin() const noexcept {
+		return container.cbegin();
+	}
+
+	const_iterator cend() const noexcept {
+		return container.cend();
+	}
+
+	iterator insert(value_type const &val) {
+		return container.insert_equal(val);
+	}
+
+	iterator insert(Point const &low, Point const &high, Value const &value) {
+		return container.emplace_equal(key_type(low, high), value);
+	}
+
+	template<typename... Args>
+	iterator emplace(Args&&... args) {
+		return container.emplace_equal(std::forward<Args>(args)...);
+	}
+
+	iterator erase(const_iterator position) {
+		return container.erase(position);
+	}
+
+	/* 删除所有与 key 相同的区间 */
+	size_type erase(key_type const &key) {
+		return container.erase(key);
+	}
+
+	iterator find(key_type const &key) {
+		return container.find(key);
+	}
+
+	const_iterator find(key_type const &key) const {
+		return container.find(key);
+	}
+
+	/* 按左端点顺序对每个与 [low, high) 相交的区间调用 func(value_type &) */
+	template<typename Function>
+	void for_each_overlap(Point const &low, Point const &high, Function func) {
+		__visit_overlap(low, high, [&](iterator iter) { func(*iter); });
+	}
+
+	/* 按左端点顺序对每个包含 point 的区间调用 func(value_type &) */
+	template<typename Function>
+	void for_each_containing(Point const &point, Function func) {
+		__visit_containing(point, [&](iterator iter) { func(*iter); });
+	}
+
+	/* 所有与 [low, high) 相交的区间 */
+	sx::vector<iterator> overlap(Point const &low, Point const &high) {
+		sx::vector<iterator> result;
+		__visit_overlap(low, high, [&](iterator iter) { result.push_back(iter); });
+		return result;
+	}
+
+	/* 所有包含 point 的区间 */
+	sx::vector<iterator> stab(Point const &point) {
+		sx::vector<iterator> result;
+		__visit_containing(point, [&](iterator iter) { result.push_back(iter); });
+		return result;
+	}
+
+	/* 任意一个与 [low, high) 相交的区间, 找到第一个就停止; 没有时返回 end() */
+	iterator find_overlap(Point const &low, Point const &high) {
+		iterator result = end();
+		if (!comp(low, high))
+			return result;
+		container.visit_augmented(
+			[&](Point const &max_high) { return !comp(low, max_high); },
+			[&](value_type const &val) { return result != end() || !comp(val.first.first, high); },
+			[&](iterator iter) {
+				if (comp(low, iter->first.second))
+					result = iter;
+			});
+		return result;
+	}
+
+	bool overlaps(Point const &low, Point const &high) {
+		return find_overlap(low, high) != end();
+	}
+
+	void swap(interval_map &other) noexcept {
+		using std::swap;
+		container.swap(other.container);
+		swap(comp, other.comp);
+	}
+
+	friend void swap(interval_map &first, interval_map &second) noexcept {
+		first.swap(second);
+	}
+private:
+	/* 子树最大右端点不超过 low 时整棵跳过, 左端点到达 high 后停止 */
+	template<typename Visit>
+	void __visit_overlap(Point const &low, Point const &high, Visit visit) {
+		if (!comp(low, high))
+			return;
+		container.visit_augmented(
+			[&](Point const &max_high) { return !comp(low, max_high); },
+			[&](value_type const &val) { return !comp(val.first.first, high); },
+			[&](iterator iter) {
+				if (comp(low, iter->first.second))
+					visit(iter);
+			});
+	}
+
+	template<typename Visit>
+	void __visit_containing(Point const &point, Visit visit) {
+		container.visit_augmented(
+			[&](Point const &max_high) { return !comp(point, max_high); },
+			[&](value_type const &val) { return comp(point, val.first.first); },
+			[&](iterator iter) {
+				if (comp(point, iter->first.second))
+					visit(iter);
+			});
+	}
+};
+
+}
+
+#endif // !M_INTERVAL_MAP_HPP
@@ -0,0 +1,401 @@
+﻿#ifndef M_INTRUSIVE_FORWARD_LIST_HPP
+#define M_INTRUSIVE_FORWARD_LIST_HPP
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <utility>
+#include "allocator.hpp"
+#include "iterator.hpp"
+#include "list_algorithm.hpp"
+#include "utility.hpp"
+
+namespace sx {
+
+struct forward_list_hook;
+
+template<typename T, forward_list_hook T::*Hook, typename Ptr, typename Ref>
+class __intrusive_forward_list_iterator;
+
+template<typename T, forward_list_hook T::*Hook>
+class intrusive_forward_list;
+
+
+class intrusive_forward_list_empty : public std::exception {
+};
+
+/* 嵌入到元素中的单向链接, 拷贝元素时不拷贝链接关系 */
+struct forward_list_hook {
+	forward_list_hook	*next;
+public:
+	forward_list_hook() noexcept : next(nullptr) {}
+	forward_list_hook(forward_list_hook const &) noexcept : next(nullptr) {}
+	forward_list_hook &operator=(forward_list_hook const &) noexcept { return *this; }
+};
+
+
+template<typename T, forward_list_hook T::*Hook, typename Ptr, typename Ref>
+class __intrusive_forward_list_iterator {
+	template<typename U, forward_list_hook U::*H>
+	friend class intrusive_forward_list;
+
+	template<typename U, forward_list_hook U::*H, typename P, typename R>
+	friend class __intrusive_forward_list_iterator;
+public:
+	using value_type		= T;
+	using pointer			= Ptr;
+	using reference			= Ref;
+	using difference_type	= std::ptrdiff_t;
+	using iterator_category = sx::forward_iteratpr_tag;
+private:
+	forward_list_hook	*hook;
+public:
+	__intrusive_forward_list_iterator() noexcept : hook(nullptr) {}
+	explicit __intrusive_forward_list_iterator(forward_list_hook *ptr) noexcept : hook(ptr) {}
+	__intrusive_forward_list_iterator(__intrusive_forward_list_iterator const &) = default;
+	__intrusive_forward_list_iterator &operator=(__intrusive_forward_list_iterator const &) = default;
+	~__intrusive_forward_list_iterator() = default;
+
+	/* iterator 可以转换为 const_iterator */
+	template<typename P, typename R>
+	__intrusive_forward_list_iterator(__intrusive_forward_list_iterator<T, Hook, P, R> const &other) noexcept
+		: hook(other.hook) {}
+public:
+	friend bool operator==(__intrusive_forward_list_iterator const &first,
+						   __intrusive_forward_list_iterator const &second) noexcept {
+		return first.hook == second.hook;
+	}
+
+	friend bool operator!=(__intrusive_forward_list_iterator const &first,
+						   __intrusive_forward_list_iterator const &second) noexcept {
+		return !(first == second);
+	}
+
+	reference operator*() const noexcept {
+		return *sx::__member_owner(hook, Hook);
+	}
+
+	pointer operator->() const noexcept {
+		return sx::__member_owner(hook, Hook);
+	}
+
+	__intrusive_forward_list_iterator &operator++() noexcept {
+		hook = hook->next;
+		return *this;
+	}
+
+	__intrusive_forward_list_iterator operator++(int) noexcept {
+		__intrusive_forward_list_iterator ret = *this;
+		++(*this);
+		return ret;
+	}
+};
+
+
+/*
+ * 侵入式单向链表, 接口与 sx::forward_list 一致, 插入删除都不分配内存, T 必须是标准布局类型
+ * 链表不拥有元素, 析构或 clear 时只是断开链接
+ * 单向链接无法从元素本身 O(1) 摘除, 需要 O(1) 摘除时使用 intrusive_list
+ */
+template<typename T, forward_list_hook T::*Hook>
+class intrusive_forward_list {
+	using SortAllocator = sx::allocator<forward_list_hook *>;
+public:
+	using value_type		= T;
+	using pointer			= T *;
+	using reference			= T &;
+	using const_pointer		= T const *;
+	using const_reference	= T const &;
+	using size_type			= std::size_t;
+	using difference_type	= std::ptrdiff_t;
+	using iterator			= __intrusive_forward_list_iterator<T, Hook, T *, T &>;
+	using const_iterator	= __intrusive_forward_list_iterator<T, Hook, T const *, T const &>;
+protected:
+	static SortAllocator	sort_allocator;		/* 排序缓冲区分配器 */
+	forward_list_hook		head;				/* 头结点 */
+	size_type				node_size;			/* 数量 */
+public:
+	intrusive_forward_list() noexcept : node_size(0) {}
+
+	intrusive_forward_list(intrusive_forward_list const &) = delete;
+	intrusive_forward_list &operator=(intrusive_forward_list const &) = delete;
+
+	intrusive_forward_list(intrusive_forward_list &&other) noexcept : intrusive_forward_list() {
+		swap(other);
+	}
+
+	intrusive_forward_list &operator=(intrusive_forward_list &&other) noexcept {
+		clear();
+		swap(other);
+		return *this;
+	}
+
+	~intrusive_forward_list() {
+		clear();
+	}
+private:
+	static forward_list_hook *hook_of(value_type &value) noexcept {
+		return &(value.*Hook);
+	}
+
+	static value_type &value_of(forward_list_hook *hook) noexcept {
+		return *sx::__member_owner(hook, Hook);
+	}
+
+	/* 比较两个钩子所在的元素, 供结点级算法使用 */
+	template<typename Compare>
+	static auto hook_less(Compare &comp) noexcept {
+		return [&comp](forward_list_hook *first, forward_list_hook *second) {
+			return comp(value_of(first), value_of(second));
+		};
+	}
+public:
+	iterator before_begin() noexcept {
+		return iterator(&head);
+	}
+
+	const_iterator before_begin() const noexcept {
+		return const_iterator(const_cast<forward_list_hook *>(&head));
+	}
+
+	iterator begin() noexcept {
+		return iterator(head.next);
+	}
+
+	const_iterator begin() const noexcept {
+		return const_iterator(head.next);
+	}
+
+	iterator end() noexcept {
+		return iterator(nullptr);
+	}
+
+	const_iterator end() const noexcept {
+		return const_iterator(nullptr);
+	}
+
+	const_iterator cbegin() const noexcept {
+		return begin();
+	}
+
+	const_iterator cend() const noexcept {
+		return end();
+	}
+
+	/* 由元素得到指向它的迭代器, 元素必须已经在本链表中 */
+	static iterator iterator_to(value_type &value) noexcept {
+		return iterator(hook_of(value));
+	}
+
+	size_type size() const noexcept {
+		return node_size;
+	}
+
+	bool empty() const noexcept {
+		return head.next == nullptr;
+	}
+
+	reference front() {
+		if (empty())
+			throw intrusive_forward_list_empty();
+		return value_of(head.next);
+	}
+
+	const_reference front() const {
+		if (empty())
+			throw intrusive_forward_list_empty();
+		return value_of(head.next);
+	}
+
+	iterator insert_after(iterator pos, value_type &value) noexcept {
+		forward_list_hook *hook = hook_of(value);
+		hook->next = pos.hook->next;
+		pos.hook->next = hook;
+		++node_size;
+		return iterator(hook);
+	}
+
+	void push_front(value_type &value) noexcept {
+		insert_after(before_begin(), value);
+	}
+
+	void pop_front() {
+		if (empty())
+			throw intrusive_forward_list_empty();
+		erase_after(before_begin());
+	}
+
+	iterator erase_after(iterator pos) noexcept {
+		forward_list_hook *after = pos.hook->next;
+		if (after == nullptr)
+			return end();
+
+		pos.hook->next = after->next;
+		after->next = nullptr;
+		--node_size;
+		return iterator(pos.hook->next);
+	}
+
+	iterator erase_after(iterator first, iterator last) noexcept {
+		while (first.hook->next != last.hook)
+			erase_after(first);
+		return last;
+	}
+
+	/* 需要 O(n) 查找前驱结点 */
+	void erase(value_type &value) noexcept {
+		forward_list_hook *hook = hook_of(value);
+		for (forward_list_hook *prev = &head; prev->next != nullptr; prev = prev->next) {
+			if (prev->next == hook) {
+				erase_after(iterator(prev));
+				return;
+			}
+		}
+	}
+
+	void clear() noexcept {
+		forward_list_hook *curr = head.next;
+		while (curr != nullptr) {
+			forward_list_hook *next = curr->next;
+			curr->next = nullptr;
+			curr = next;
+		}
+		head.next = nullptr;
+		node_size = 0;
+	}
+
+	template<typename Predicate>
+	void remove_if(Predicate pred) {
+		forward_list_hook *prev = &head;
+		while (prev->next != nullptr) {
+			if (pred(value_of(prev->next)))
+				erase_after(iterator(prev));
+			else
+				prev = prev->next;
+		}
+	}
+
+	/* 将 other 中 (first, last) 区间的结点移动到 pos 后面 */
+	void splice_after(iterator pos, intrusive_forward_list &other, iterator first, iterator last) noexcept {
+		forward_list_hook *before_last = first.hook;
+		size_type count = 0;
+		while (before_last->next != last.hook) {
+			before_last = before_last->next;
+			++count;
+		}
+		if (count == 0)
+			return;
+
+		forward_list_hook *range_first = first.hook->next;
+		first.hook->next = last.hook;
+		before_last->next = pos.hook->next;
+		pos.hook->next = range_first;
+
+		node_size += count;
+		other.node_size -= count;
+	}
+
+	void splice_after(iterator pos, intrusive_forward_list &other) noexcept {
+		if (this != &other)
+			splice_after(pos, other, other.before_begin(), other.end());
+	}
+
+	/* 将 i 后面的一个结点移动到 pos 后面 */
+	void splice_after(iterator pos, intrusive_forward_list &other, iterator i) noexcept {
+		forward_list_hook *node = i.hook->next;
+		if (node == nullptr || node == pos.hook || i == pos)
+			return;
+
+		i.hook->next = node->next;
+		node->next = pos.hook->next;
+		pos.hook->next = node;
+		++node_size;
+		--other.node_size;
+	}
+
+	template<typename Compare>
+	void merge(intrusive_forward_list &other, Compare comp) {
+		if (this == &other)
+			return;
+
+		/* 比较函数抛出异常时两边的结点也都已经接在本链表中 */
+		forward_list_hook *first1 = head.next;
+		forward_list_hook *first2 = other.head.next;
+		other.head.next = nullptr;
+		node_size += other.node_size;
+		other.node_size = 0;
+		sx::__forward_list_merge(head.next, first1, first2, hook_less(comp));
+	}
+
+	void merge(intrusive_forward_list &other) {
+		merge(other, std::less<>{});
+	}
+
+	void reverse() noexcept {
+		forward_list_hook *prev = nullptr;
+		forward_list_hook *curr = head.next;
+		while (curr != nullptr) {
+			forward_list_hook *next = curr->next;
+			curr->next = prev;
+			prev = curr;
+			curr = next;
+		}
+		head.next = prev;
+	}
+
+	/* 不申请额外内存的自底向上归并排序; 比较函数抛出异常时元素都还在链表中, 顺序未定 */
+	template<typename Compare>
+	void inplace_sort(Compare comp) {
+		sx::__forward_list_sort(&head, hook_less(comp));
+	}
+
+	void inplace_sort() {
+		inplace_sort(std::less<>{});
+	}
+
+	/* 与 sx::list::sort 相同, 收集钩子指针排序后一次遍历重新链接; 缓冲区申请失败时退回 inplace_sort */
+	template<typename Compare>
+	void sort(Compare comp) {
+		size_type count = node_size;
+		if (count < 2)
+			return;
+
+		forward_list_hook **buffer;
+		try {
+			buffer = sort_allocator.allocate(count);
+		} catch (...) {
+			inplace_sort(comp);
+			return;
+		}
+
+		forward_list_hook *curr = head.next;
+		for (size_type i = 0; i < count; ++i, curr = curr->next)
+			buffer[i] = curr;
+
+		try {
+			sx::__parallel_stable_sort(buffer, count, hook_less(comp));
+		} catch (...) {
+			sort_allocator.deallocate(buffer, sizeof(forward_list_hook *) * count);
+			throw;
+		}
+
+		sx::__forward_list_relink(&head, buffer, count, [](forward_list_hook *hook) { return hook; });
+		sort_allocator.deallocate(buffer, sizeof(forward_list_hook *) * count);
+	}
+
+	void sort() {
+		sort(std::less<>{});
+	}
+
+	void swap(intrusive_forward_list &other) noexcept {
+		using std::swap;
+		swap(head.next, other.head.next);
+		swap(node_size, other.node_size);
+	}
+};
+
+template<typename T, forward_list_hook T::*Hook>
+typename intrusive_forward_list<T, Hook>::SortAllocator intrusive_forward_list<T, Hook>::sort_allocator;
+
+}	// !namespace sx
+
+#endif // !M_INTRUSIVE_FORWARD_LIST_HPP
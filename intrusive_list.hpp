@@ -0,0 +1,458 @@
+﻿#ifndef M_INTRUSIVE_LIST_HPP
+#define M_INTRUSIVE_LIST_HPP
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <utility>
+#include "allocator.hpp"
+#include "iterator.hpp"
+#include "list_algorithm.hpp"
+#include "utility.hpp"
+
+namespace sx {
+
+struct list_hook;
+
+template<typename T, list_hook T::*Hook, typename Ptr, typename Ref>
+class __intrusive_list_iterator;
+
+template<typename T, list_hook T::*Hook>
+class intrusive_list;
+
+
+class intrusive_list_empty : public std::exception {
+};
+
+/* 嵌入到元素中的双向链接, 未链入任何链表时 prev / next 都为空; 拷贝元素时不拷贝链接关系 */
+struct list_hook {
+	list_hook	*prev;
+	list_hook	*next;
+public:
+	list_hook() noexcept : prev(nullptr), next(nullptr) {}
+	list_hook(list_hook const &) noexcept : prev(nullptr), next(nullptr) {}
+	list_hook &operator=(list_hook const &) noexcept { return *this; }
+
+	bool is_linked() const noexcept {
+		return next != nullptr;
+	}
+};
+
+
+template<typename T, list_hook T::*Hook, typename Ptr, typename Ref>
+class __intrusive_list_iterator {
+	template<typename U, list_hook U::*H>
+	friend class intrusive_list;
+
+	template<typename U, list_hook U::*H, typename P, typename R>
+	friend class __intrusive_list_iterator;
+public:
+	using value_type		= T;
+	using pointer			= Ptr;
+	using reference			= Ref;
+	using difference_type	= std::ptrdiff_t;
+	using iterator_category = sx::bidirectional_iterator_tag;
+private:
+	list_hook	*hook;
+public:
+	__intrusive_list_iterator() noexcept : hook(nullptr) {}
+	explicit __intrusive_list_iterator(list_hook *ptr) noexcept : hook(ptr) {}
+	__intrusive_list_iterator(__intrusive_list_iterator const &) = default;
+	__intrusive_list_iterator &operator=(__intrusive_list_iterator const &) = default;
+	~__intrusive_list_iterator() = default;
+
+	/* iterator 可以转换为 const_iterator */
+	template<typename P, typename R>
+	__intrusive_list_iterator(__intrusive_list_iterator<T, Hook, P, R> const &other) noexcept : hook(other.hook) {}
+public:
+	friend bool operator==(__intrusive_list_iterator const &first, __intrusive_list_iterator const &second) noexcept {
+		return first.hook == second.hook;
+	}
+
+	friend bool operator!=(__intrusive_list_iterator const &first, __intrusive_list_iterator const &second) noexcept {
+		return !(first == second);
+	}
+
+	reference operator*() const noexcept {
+		return *sx::__member_owner(hook, Hook);
+	}
+
+	pointer operator->() const noexcept {
+		return sx::__member_owner(hook, Hook);
+	}
+
+	__intrusive_list_iterator &operator++() noexcept {
+		hook = hook->next;
+		return *this;
+	}
+
+	__intrusive_list_iterator operator++(int) noexcept {
+		__intrusive_list_iterator ret = *this;
+		++(*this);
+		return ret;
+	}
+
+	__intrusive_list_iterator &operator--() noexcept {
+		hook = hook->prev;
+		return *this;
+	}
+
+	__intrusive_list_iterator operator--(int) noexcept {
+		__intrusive_list_iterator ret = *this;
+		--(*this);
+		return ret;
+	}
+};
+
+
+/*
+ * 侵入式双向链表, 元素通过成员 Hook 链接, 插入删除都不分配内存, T 必须是标准布局类型
+ * 链表不拥有元素: 元素的生命周期由使用者管理, 析构或 clear 时只是断开链接
+ * 同一个对象可以带多个 list_hook, 同时挂在多个链表上
+ * 通过 iterator_to / erase(value) 可以直接从元素本身 O(1) 摘除
+ */
+template<typename T, list_hook T::*Hook>
+class intrusive_list {
+	using SortAllocator = sx::allocator<list_hook *>;
+public:
+	using value_type			 = T;
+	using pointer				 = T *;
+	using reference				 = T &;
+	using const_pointer			 = T const *;
+	using const_reference		 = T const &;
+	using size_type				 = std::size_t;
+	using difference_type		 = std::ptrdiff_t;
+	using iterator				 = __intrusive_list_iterator<T, Hook, T *, T &>;
+	using const_iterator		 = __intrusive_list_iterator<T, Hook, T const *, T const &>;
+	using reverse_iterator		 = sx::__reverse_iterator<iterator>;
+	using const_reverse_iterator = sx::__reverse_iterator<const_iterator>;
+protected:
+	static SortAllocator	sort_allocator;		/* 排序缓冲区分配器 */
+	list_hook				head;				/* 头结点, 内嵌在链表对象中 */
+	size_type				node_size;			/* 数量 */
+public:
+	intrusive_list() noexcept : node_size(0) {
+		head.prev = head.next = &head;
+	}
+
+	intrusive_list(intrusive_list const &) = delete;
+	intrusive_list &operator=(intrusive_list const &) = delete;
+
+	intrusive_list(intrusive_list &&other) noexcept : intrusive_list() {
+		swap(other);
+	}
+
+	intrusive_list &operator=(intrusive_list &&other) noexcept {
+		clear();
+		swap(other);
+		return *this;
+	}
+
+	~intrusive_list() {
+		clear();
+	}
+private:
+	static list_hook *hook_of(value_type &value) noexcept {
+		return &(value.*Hook);
+	}
+
+	static void link_before(list_hook *pos, list_hook *hook) noexcept {
+		hook->prev = pos->prev;
+		hook->next = pos;
+		pos->prev->next = hook;
+		pos->prev = hook;
+	}
+
+	static void unlink(list_hook *hook) noexcept {
+		hook->prev->next = hook->next;
+		hook->next->prev = hook->prev;
+		hook->prev = hook->next = nullptr;
+	}
+
+	/* 比较两个钩子所在的元素, 供结点级算法使用 */
+	template<typename Compare>
+	static auto hook_less(Compare &comp) noexcept {
+		return [&comp](list_hook *first, list_hook *second) {
+			return comp(*sx::__member_owner(first, Hook), *sx::__member_owner(second, Hook));
+		};
+	}
+
+	/* 头结点内嵌在对象中, 交换或者移动之后要修正首尾结点指回头结点的指针 */
+	void reset_head() noexcept {
+		if (node_size == 0) {
+			head.prev = head.next = &head;
+		} else {
+			head.next->prev = &head;
+			head.prev->next = &head;
+		}
+	}
+public:
+	size_type size() const noexcept {
+		return node_size;
+	}
+
+	bool empty() const noexcept {
+		return node_size == 0;
+	}
+
+	iterator begin() noexcept {
+		return iterator(head.next);
+	}
+
+	iterator end() noexcept {
+		return iterator(&head);
+	}
+
+	const_iterator begin() const noexcept {
+		return cbegin();
+	}
+
+	const_iterator end() const noexcept {
+		return cend();
+	}
+
+	const_iterator cbegin() const noexcept {
+		return const_iterator(head.next);
+	}
+
+	const_iterator cend() const noexcept {
+		return const_iterator(const_cast<list_hook *>(&head));
+	}
+
+	reverse_iterator rbegin() noexcept {
+		return reverse_iterator(end());
+	}
+
+	reverse_iterator rend() noexcept {
+		return reverse_iterator(begin());
+	}
+
+	const_reverse_iterator crbegin() const noexcept {
+		return const_reverse_iterator(cend());
+	}
+
+	const_reverse_iterator crend() const noexcept {
+		return const_reverse_iterator(cbegin());
+	}
+
+	/* 由元素得到指向它的迭代器, 元素必须已经在本链表中 */
+	static iterator iterator_to(value_type &value) noexcept {
+		return iterator(hook_of(value));
+	}
+
+	static const_iterator iterator_to(value_type const &value) noexcept {
+		return const_iterator(const_cast<list_hook *>(&(value.*Hook)));
+	}
+
+	reference front() {
+		if (empty())
+			throw intrusive_list_empty();
+		return *begin();
+	}
+
+	const_reference front() const {
+		if (empty())
+			throw intrusive_list_empty();
+		return *begin();
+	}
+
+	reference back() {
+		if (empty())
+			throw intrusive_list_empty();
+		return *(--end());
+	}
+
+	const_reference back() const {
+		if (empty())
+			throw intrusive_list_empty();
+		return *(--end());
+	}
+
+	/* 元素不能已经链接在其他使用同一个 Hook 的链表中 */
+	iterator insert(iterator pos, value_type &value) noexcept {
+		list_hook *hook = hook_of(value);
+		link_before(pos.hook, hook);
+		++node_size;
+		return iterator(hook);
+	}
+
+	void push_front(value_type &value) noexcept {
+		insert(begin(), value);
+	}
+
+	void push_back(value_type &value) noexcept {
+		insert(end(), value);
+	}
+
+	void pop_front() {
+		if (empty())
+			throw intrusive_list_empty();
+		erase(begin());
+	}
+
+	void pop_back() {
+		if (empty())
+			throw intrusive_list_empty();
+		erase(--end());
+	}
+
+	iterator erase(iterator pos) noexcept {
+		list_hook *next = pos.hook->next;
+		unlink(pos.hook);
+		--node_size;
+		return iterator(next);
+	}
+
+	iterator erase(iterator first, iterator last) noexcept {
+		while (first != last)
+			first = erase(first);
+		return last;
+	}
+
+	/* 直接从元素摘除, O(1) */
+	void erase(value_type &value) noexcept {
+		erase(iterator_to(value));
+	}
+
+	void clear() noexcept {
+		list_hook *curr = head.next;
+		while (curr != &head) {
+			list_hook *next = curr->next;
+			curr->prev = curr->next = nullptr;
+			curr = next;
+		}
+		head.prev = head.next = &head;
+		node_size = 0;
+	}
+
+	template<typename Predicate>
+	void remove_if(Predicate pred) {
+		iterator first = begin();
+		iterator last = end();
+		while (first != last) {
+			if (pred(*first))
+				first = erase(first);
+			else
+				++first;
+		}
+	}
+
+	void splice(iterator pos, intrusive_list &other) noexcept {
+		if (!other.empty() && this != &other) {
+			sx::__list_transfer(pos.hook, other.head.next, &other.head);
+			node_size += other.node_size;
+			other.node_size = 0;
+		}
+	}
+
+	void splice(iterator pos, intrusive_list &other, iterator index) noexcept {
+		iterator after = index;
+		++after;
+		if (pos == index || pos == after)
+			return;
+
+		sx::__list_transfer(pos.hook, index.hook, after.hook);
+		node_size += 1;
+		other.node_size -= 1;
+	}
+
+	/* 从其他链表移动区间时需要 O(n) 统计结点个数 */
+	void splice(iterator pos, intrusive_list &other, iterator first, iterator last) noexcept {
+		if (first == last)
+			return;
+
+		if (this != &other) {
+			size_type count = sx::distance(first, last);
+			node_size += count;
+			other.node_size -= count;
+		}
+		sx::__list_transfer(pos.hook, first.hook, last.hook);
+	}
+
+	template<typename Compare>
+	void merge(intrusive_list &other, Compare comp) {
+		if (this == &other)
+			return;
+
+		std::size_t moved = 0;
+		try {
+			sx::__list_merge(head.next, &head, other.head.next, &other.head, hook_less(comp), moved);
+		} catch (...) {
+			node_size += moved;
+			other.node_size -= moved;
+			throw;
+		}
+		node_size += other.node_size;
+		other.node_size = 0;
+	}
+
+	void merge(intrusive_list &other) {
+		merge(other, std::less<>{});
+	}
+
+	void reverse() noexcept {
+		sx::__list_reverse(&head);
+	}
+
+	/* 不申请额外内存的自底向上归并排序; 比较函数抛出异常时元素都还在链表中, 顺序未定 */
+	template<typename Compare>
+	void inplace_sort(Compare comp) {
+		sx::__list_sort(&head, hook_less(comp));
+	}
+
+	void inplace_sort() {
+		inplace_sort(std::less<>{});
+	}
+
+	/*
+	 * 与 sx::list::sort 相同: 把钩子指针收集到连续缓冲区中稳定排序, 再一次遍历重新链接
+	 * 缓冲区申请失败时退回 inplace_sort; 比较函数抛出异常时链表保持原样
+	 */
+	template<typename Compare>
+	void sort(Compare comp) {
+		size_type count = node_size;
+		if (count < 2)
+			return;
+
+		list_hook **buffer;
+		try {
+			buffer = sort_allocator.allocate(count);
+		} catch (...) {
+			inplace_sort(comp);
+			return;
+		}
+
+		list_hook *curr = head.next;
+		for (size_type i = 0; i < count; ++i, curr = curr->next)
+			buffer[i] = curr;
+
+		try {
+			sx::__parallel_stable_sort(buffer, count, hook_less(comp));
+		} catch (...) {
+			sort_allocator.deallocate(buffer, sizeof(list_hook *) * count);
+			throw;
+		}
+
+		sx::__list_relink(&head, buffer, count, [](list_hook *hook) { return hook; });
+		sort_allocator.deallocate(buffer, sizeof(list_hook *) * count);
+	}
+
+	void sort() {
+		sort(std::less<>{});
+	}
+
+	void swap(intrusive_list &other) noexcept {
+		using std::swap;
+		swap(head.prev, other.head.prev);
+		swap(head.next, other.head.next);
+		swap(node_size, other.node_size);
+		reset_head();
+		other.reset_head();
+	}
+};
+
+template<typename T, list_hook T::*Hook>
+typename intrusive_list<T, Hook>::SortAllocator intrusive_list<T, Hook>::sort_allocator;
+
+}	// !namespace sx
+
+#endif // !M_INTRUSIVE_LIST_HPP
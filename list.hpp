@@ -3,8 +3,12 @@
 #define M_LIST_HPP
 #include "allocator.hpp"
 #include "iterator.hpp"
+#include "list_algorithm.hpp"
 #include "utility.hpp"
+#include <algorithm>
 #include <exception>
+#include <functional>
+#include <type_traits>
 
 namespace sx {
 
@@ -14,7 +18,7 @@ class list_empty : public std::exception {
 template<typename T>
 struct __link_node;
 
-template<typename T, typename Alloc = sx::allocator<T>>
+template<typename T, typename Alloc = sx::allocator<T>, bool NodeCache = false>
 class list;
 
 
@@ -31,7 +35,7 @@ public:
 template<typename T, typename Ptr, typename Ref>
 class __list_iterator {
 public:
-	template<typename T, typename Alloc>
+	template<typename T, typename Alloc, bool NodeCache>
 	friend class list;
     using value_type			= T;
 	using pointer				= Ptr;
@@ -87,9 +91,25 @@ public:
     }
 };
 
-template<typename T, typename Alloc>
-class list : public sx::container_helpful<list<T, Alloc>> {
+
+/*
+ * 双向链表
+ * NodeCache 为 true 时删除的结点可以留在本容器中复用 (见 set_node_cache_limit), 为 false 时不占用任何空间
+ */
+template<typename T, typename Alloc, bool NodeCache>
+class list : public sx::container_helpful<list<T, Alloc, NodeCache>>,
+             protected sx::__node_cache<__link_node<T>, NodeCache> {
 	using Allocator = decltype(sx::transform_alloator_type<T, __link_node<T>>(Alloc{}));
+
+	/* 排序缓冲区的元素, 小而可平凡拷贝的值连同节点指针一起拷贝出来, 比较时不必再访问节点 */
+	struct __sort_value_entry {
+		T						value;
+		__link_node<T>		   *node;
+	};
+
+	static constexpr bool sort_by_value = std::is_trivially_copyable<T>::value && sizeof(T) <= 2 * sizeof(void *);
+	using sort_entry = std::conditional_t<sort_by_value, __sort_value_entry, __link_node<T> *>;
+	using SortAllocator = decltype(sx::transform_alloator_type<T, sort_entry>(Alloc{}));
 public: 
     using value_type             = T;
     using pointer                = T *;
@@ -105,29 +125,92 @@ public:
 	using const_reverse_iterator = sx::__reverse_iterator<const_iterator>;
 protected:
     static Allocator        allocator;          /* 数据分配器 */
+    static SortAllocator    sort_allocator;     /* 排序缓冲区分配器 */
     link_node_ptr           head_node;          /* 头结点 */
     size_type               node_size;          /* 数量 */
 private:
-    static link_node_ptr get_node() {
-        return allocator.allocate(1);
+    /* 优先从本容器的回收缓存中取结点, 缓存为空时才访问分配器 */
+    link_node_ptr get_node() {
+        if constexpr (NodeCache) {
+            if (this->spare_nodes != nullptr) {
+                link_node_ptr node_ptr = this->spare_nodes;
+                this->spare_nodes = node_ptr->next;
+                --this->spare_count;
+                return node_ptr;
+            }
+        }
+        return allocator.allocate();
+    }
+
+    /* 缓存未满时留在本容器中等待复用, 否则还给分配器 */
+    void put_node(link_node_ptr node_ptr) noexcept {
+        if constexpr (NodeCache) {
+            if (this->spare_count < this->spare_limit) {
+                node_ptr->next = this->spare_nodes;
+                this->spare_nodes = node_ptr;
+                ++this->spare_count;
+                return;
+            }
+        }
+        allocator.deallocate(node_ptr, sizeof(__link_node<T>));
     }
 
-    static void put_node(link_node_ptr node_ptr) {
-        allocator.deallocate(node_ptr, 1);
+    /* 把缓存削减到 count 个结点 */
+    void trim_node_cache(size_type count) noexcept {
+        if constexpr (NodeCache) {
+            while (this->spare_count > count) {
+                link_node_ptr node_ptr = this->spare_nodes;
+                this->spare_nodes = node_ptr->next;
+                --this->spare_count;
+                allocator.deallocate(node_ptr, sizeof(__link_node<T>));
+            }
+        }
+    }
+
+    /* 释放 compact 取得的 count 个新结点 (由 next 串起), 其中前 built 个已经构造了元素 */
+    static void release_fresh_nodes(link_node_ptr first, size_type built, size_type count) noexcept {
+        for (size_type i = 0; i < count; ++i) {
+            link_node_ptr next = first->next;
+            if (i < built)
+                allocator.destroy(first);
+            allocator.deallocate(first, sizeof(__link_node<T>));
+            first = next;
+        }
     }
 
     template<typename... Args>
-    static link_node_ptr create_node(Args&&... args) {
+    link_node_ptr create_node(Args&&... args) {
         link_node_ptr node_ptr = get_node();
-        allocator.construct(node_ptr, std::forward<Args>(args)...);
+        try {
+            allocator.construct(node_ptr, std::forward<Args>(args)...);
+        } catch (...) {
+            put_node(node_ptr);
+            throw;
+        }
         return node_ptr;
     }
 
-    static void destroy_node(link_node_ptr node_ptr) {
+    void destroy_node(link_node_ptr node_ptr) noexcept {
         allocator.destroy(node_ptr);
-        allocator.deallocate(node_ptr, sizeof(__link_node<T>));
+        put_node(node_ptr);
     }
 
+	static link_node_ptr sort_node(link_node_ptr node_ptr) noexcept {
+		return node_ptr;
+	}
+
+	static link_node_ptr sort_node(__sort_value_entry const &entry) noexcept {
+		return entry.node;
+	}
+
+	static T const &sort_key(link_node_ptr node_ptr) noexcept {
+		return node_ptr->data;
+	}
+
+	static T const &sort_key(__sort_value_entry const &entry) noexcept {
+		return entry.value;
+	}
+
 	void empty_initialized() noexcept {
 		head_node = get_node();
 		head_node->next = head_node->prev = head_node;
@@ -164,20 +247,8 @@ private:
     }
 
     /* 将 begin ~ end 区间的结点, 移动到 position 前面 */
-    static void transfer(iterator position, iterator begin, iterator end) {
-        iterator last = end;
-        --last;
-        link_node_ptr pos_node = position.node_ptr;
-        link_node_ptr beg_node = begin.node_ptr;
-        link_node_ptr last_node = last.node_ptr;
-
-        beg_node->prev->next = last_node->next;
-        last_node->next->prev = beg_node->prev;
-
-        beg_node->prev = pos_node->prev;
-        beg_node->prev->next = beg_node;
-        last_node->next = pos_node;
-        pos_node->prev = last_node;
+    static void transfer(iterator position, iterator begin, iterator end) noexcept {
+        sx::__list_transfer(position.node_ptr, begin.node_ptr, end.node_ptr);
     }
 public:
 	list() { empty_initialized(); }
@@ -217,7 +288,10 @@ public:
 	}
 
 	~list() {
+		if constexpr (NodeCache)
+			this->spare_limit = 0;
 		destroy();
+		trim_node_cache(0);
 	}
 public:
     size_type size() const {
@@ -356,9 +430,130 @@ public:
         return position;
     }
 
+    /* 保留头结点, 删除的结点按缓存上限留在本容器中 */
     void clear() {
-        destroy();
-        empty_initialized();
+        link_node_ptr node = head_node->next;
+        while (node != head_node) {
+            link_node_ptr next = node->next;
+            destroy_node(node);
+            node = next;
+        }
+        head_node->next = head_node->prev = head_node;
+        node_size = 0;
+    }
+
+    /*
+     * 回收结点缓存 (需要 NodeCache 为 true): 删除元素时结点留在本容器中 (最多 limit 个), 之后的插入直接复用,
+     * 频繁删除再插入 (例如 LRU) 时不必每次都访问全局内存池; 默认上限为 0, 即不缓存
+     */
+    void set_node_cache_limit(size_type limit) noexcept {
+        static_assert(NodeCache, "list::set_node_cache_limit requires NodeCache");
+        this->spare_limit = limit;
+        trim_node_cache(limit);
+    }
+
+    size_type node_cache_limit() const noexcept {
+        if constexpr (NodeCache)
+            return this->spare_limit;
+        else
+            return 0;
+    }
+
+    size_type node_cache_size() const noexcept {
+        if constexpr (NodeCache)
+            return this->spare_count;
+        else
+            return 0;
+    }
+
+    /* 预先分配结点放入缓存, 使容器在元素数量达到 n 之前的插入都不必访问分配器; 缓存上限不足时相应提高 */
+    void reserve(size_type n) {
+        static_assert(NodeCache, "list::reserve requires NodeCache");
+        if (n <= node_size + this->spare_count)
+            return;
+
+        size_type need = n - node_size;
+        if (this->spare_limit < need)
+            this->spare_limit = need;
+        while (this->spare_count < need) {
+            link_node_ptr node_ptr = allocator.allocate();
+            node_ptr->next = this->spare_nodes;
+            this->spare_nodes = node_ptr;
+            ++this->spare_count;
+        }
+    }
+
+    /* 释放缓存中的全部结点 */
+    void shrink_to_fit() noexcept {
+        trim_node_cache(0);
+    }
+
+    /*
+     * 把所有元素按链表顺序搬到一段连续内存的新结点中并重新链接, 旧结点按缓存上限留下或还给分配器.
+     * 长期插入删除之后结点散落在内存池各处, 压缩后遍历基本是顺序访存; 分配器给不出连续内存时逐个分配.
+     * 元素被移动 (移动构造可能抛出时复制), 所有迭代器, 指针和引用都失效; 抛出异常时链表保持原样
+     */
+    void compact() {
+        if (node_size == 0)
+            return;
+
+        /* 先取得全部新结点并用 next 串起来, 分配失败时原来的元素还没有被移动过 */
+        link_node_ptr block = allocator.allocate_contiguous(node_size);
+        link_node_ptr first = block;
+        if (block != nullptr) {
+            for (size_type i = 0; i < node_size; ++i)
+                block[i].next = i + 1 < node_size ? block + i + 1 : nullptr;
+        } else {
+            link_node_ptr last = nullptr;
+            size_type acquired = 0;
+            try {
+                for (; acquired < node_size; ++acquired) {
+                    link_node_ptr node_ptr = allocator.allocate();
+                    node_ptr->next = nullptr;
+                    if (last != nullptr)
+                        last->next = node_ptr;
+                    else
+                        first = node_ptr;
+                    last = node_ptr;
+                }
+            } catch (...) {
+                release_fresh_nodes(first, 0, acquired);
+                throw;
+            }
+        }
+
+        link_node_ptr node_ptr = first;
+        link_node_ptr last = nullptr;
+        size_type built = 0;
+        try {
+            for (link_node_ptr curr = head_node->next; curr != head_node; curr = curr->next, ++built) {
+                link_node_ptr next = node_ptr->next;
+                try {
+                    allocator.construct(node_ptr, std::move_if_noexcept(curr->data));
+                } catch (...) {
+                    node_ptr->next = next;
+                    throw;
+                }
+                node_ptr->prev = last;
+                node_ptr->next = next;
+                last = node_ptr;
+                node_ptr = next;
+            }
+        } catch (...) {
+            release_fresh_nodes(first, built, node_size);
+            throw;
+        }
+
+        link_node_ptr curr = head_node->next;
+        while (curr != head_node) {
+            link_node_ptr next = curr->next;
+            destroy_node(curr);
+            curr = next;
+        }
+        first->prev = head_node;
+        head_node->next = first;
+        last->next = head_node;
+        head_node->prev = last;
     }
 
     iterator erase(iterator position) {
@@ -374,11 +569,8 @@ public:
     }
 
 	iterator erase(iterator first, iterator last) {
-		link_node_ptr first_node = first.node_ptr;
-		link_node_ptr last_node = last.node_ptr;
-		node_size -= sx::distance(first, last);
-		last_node->prev = first_node->prev;
-		first_node->prev->next = last_node;
+		while (first != last)
+			first = erase(first);
 		return last;
 	}
 
@@ -418,65 +610,87 @@ public:
         other.node_size -= 1;
     }
 
-    void merge(list &other) {
-        iterator first1 = begin();
-        iterator end1 = end();
-        iterator first2 = other.begin();
-        iterator end2 = other.end();
-
-        while (first1 != end1 && first2 != end2) {
-            if (*first2 < *first1) {
-                iterator next = first2;
-                transfer(first1, first2, ++next);
-				first2 = next;
-			} else {
-				++first1;
-			}
+    template<typename Compare>
+    void merge(list &other, Compare comp) {
+        if (this == &other)
+            return;
+
+        std::size_t moved = 0;
+        try {
+            sx::__list_merge(head_node->next, head_node, other.head_node->next, other.head_node,
+                [&comp](link_node_ptr first, link_node_ptr second) { return comp(first->data, second->data); }, moved);
+        } catch (...) {
+            node_size += moved;
+            other.node_size -= moved;
+            throw;
         }
+        node_size += other.node_size;
+        other.node_size = 0;
+    }
 
-        if (first2 != end2)
-            transfer(end1, first2, end2);
+    void merge(list &other) {
+        merge(other, std::less<>{});
+    }
 
-        node_size = other.node_size;
-        other.node_size = 0;
+    void reverse() noexcept {
+        sx::__list_reverse(head_node);
     }
 
-    void reverse() {
-        if (empty())
-            return;
+    /* 不申请额外内存的自底向上归并排序, 只调整结点链接; 比较函数抛出异常时元素都还在链表中, 顺序未定 */
+    template<typename Compare>
+    void inplace_sort(Compare comp) {
+        sx::__list_sort(head_node, [&comp](link_node_ptr first, link_node_ptr second) {
+            return comp(first->data, second->data);
+        });
+    }
 
-        iterator iter_first = begin();
-        iterator iter_end = end();
-        ++iter_first;
-        while (iter_first != iter_end) {
-            iterator iter_old = iter_first;
-            ++iter_first;
-            transfer(begin(), iter_old, iter_first);
-        }
+    void inplace_sort() {
+        inplace_sort(std::less<>{});
     }
 
-    void sort() {
-        if (empty())
+    /*
+     * 把节点指针 (小元素连同值一起) 收集到连续的缓冲区中排序, 再一次遍历重新链接
+     * 比较时顺序访问缓冲区, 不必在堆上到处跳转; 节点本身不会重新分配, 迭代器和引用仍然有效
+     * 元素足够多时分块并行排序; 缓冲区申请失败时退回 inplace_sort
+     * 比较函数抛出异常时链表保持原样
+     */
+    template<typename Compare>
+    void sort(Compare comp) {
+        size_type count = node_size;
+        if (count < 2)
             return;
 
-        list carry;
-        list counter[64];
-        int fill = 0;
-        while (!empty()) {
-            carry.splice(carry.begin(), *this, begin());
-            int i = 0;
-            while (i < fill && !counter[i].empty()) {
-                counter[i].merge(carry);
-                carry.swap(counter[i++]);
-            }
-            carry.swap(counter[i]);
-            if (i == fill)
-                ++fill;
+        sort_entry *buffer;
+        try {
+            buffer = sort_allocator.allocate(count);
+        } catch (...) {
+            inplace_sort(comp);
+            return;
+        }
+
+        link_node_ptr curr = head_node->next;
+        for (size_type i = 0; i < count; ++i, curr = curr->next) {
+            if constexpr (sort_by_value)
+                new(&buffer[i]) sort_entry{ curr->data, curr };
+            else
+                buffer[i] = curr;
+        }
+
+        try {
+            sx::__parallel_stable_sort(buffer, count, [&comp](sort_entry const &first, sort_entry const &second) {
+                return comp(sort_key(first), sort_key(second));
+            });
+        } catch (...) {
+            sort_allocator.deallocate(buffer, sizeof(sort_entry) * count);
+            throw;
         }
 
-        for (int i = 1; i < fill; ++i) 
-            counter[i].merge(counter[i - 1]);
-        swap(counter[fill-1]);
+        sx::__list_relink(head_node, buffer, count, [](sort_entry const &entry) { return sort_node(entry); });
+        sort_allocator.deallocate(buffer, sizeof(sort_entry) * count);
+    }
+
+    void sort() {
+        sort(std::less<>{});
     }
 
 	void swap(list &other) noexcept {
@@ -486,8 +700,11 @@ public:
 	}
 };
 
-template<typename T, typename Alloc>
-typename list<T, Alloc>::Allocator list<T, Alloc>::allocator;
+template<typename T, typename Alloc, bool NodeCache>
+typename list<T, Alloc, NodeCache>::Allocator list<T, Alloc, NodeCache>::allocator;
+
+template<typename T, typename Alloc, bool NodeCache>
+typename list<T, Alloc, NodeCache>::SortAllocator list<T, Alloc, NodeCache>::sort_allocator;
 
 
 }
@@ -0,0 +1,318 @@
+﻿#ifndef M_LIST_ALGORITHM_HPP
+#define M_LIST_ALGORITHM_HPP
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <thread>
+
+namespace sx {
+
+/*
+ * 链表类容器共用的结点级算法, 只通过结点的 next (双向链表还有 prev) 调整链接, 不关心结点里存放什么:
+ * sx::list / intrusive_list 的结点带 prev 和 next, 以头结点为界成环;
+ * sx::forward_list / intrusive_forward_list 的结点只有 next, 以 nullptr 结尾.
+ * 需要比较元素时由调用者传入比较两个结点的 less
+ */
+
+constexpr std::size_t __parallel_sort_threshold = 1 << 18;	/* 每个线程至少分到的元素个数 */
+constexpr std::size_t __max_sort_threads = 16;
+
+/* 用 parts 个线程执行 task(0) ~ task(parts - 1), 线程创建失败时由当前线程补做, 全部结束后重新抛出第一个异常 */
+template<typename Task>
+void __run_parallel(std::size_t parts, Task &task) {
+	std::thread workers[__max_sort_threads];
+	std::exception_ptr errors[__max_sort_threads];
+	auto guarded = [&task, &errors](std::size_t index) {
+		try {
+			task(index);
+		} catch (...) {
+			errors[index] = std::current_exception();
+		}
+	};
+
+	std::size_t started = 1;
+	try {
+		for ( ; started < parts; ++started)
+			workers[started] = std::thread(guarded, started);
+	} catch (...) {
+	}
+	for (std::size_t i = started; i < parts; ++i)
+		guarded(i);
+	guarded(0);
+	for (std::size_t i = 1; i < started; ++i)
+		workers[i].join();
+
+	for (std::size_t i = 0; i < parts; ++i) {
+		if (errors[i])
+			std::rethrow_exception(errors[i]);
+	}
+}
+
+/*
+ * 分块并行稳定排序, 再逐层两两归并; 元素太少或者只有一个核心时直接 std::stable_sort
+ * 链表类容器把节点指针收集到连续缓冲区后用它排序, 排好后再一次遍历重新链接
+ */
+template<typename Entry, typename Compare>
+void __parallel_stable_sort(Entry *first, std::size_t count, Compare comp) {
+	std::size_t parts = 1;
+	std::size_t threads = std::thread::hardware_concurrency();
+	while (parts * 2 <= threads && parts < __max_sort_threads && count / (parts * 2) >= __parallel_sort_threshold)
+		parts *= 2;
+	if (parts == 1) {
+		std::stable_sort(first, first + count, comp);
+		return;
+	}
+
+	std::size_t chunk = (count + parts - 1) / parts;
+	auto sort_task = [&](std::size_t index) {
+		std::size_t lo = std::min(index * chunk, count);
+		std::size_t hi = std::min(lo + chunk, count);
+		std::stable_sort(first + lo, first + hi, comp);
+	};
+	__run_parallel(parts, sort_task);
+
+	for (std::size_t width = chunk; parts > 1; width *= 2, parts /= 2) {
+		auto merge_task = [&](std::size_t index) {
+			std::size_t lo = std::min(index * 2 * width, count);
+			std::size_t mid = std::min(lo + width, count);
+			std::size_t hi = std::min(mid + width, count);
+			std::inplace_merge(first + lo, first + mid, first + hi, comp);
+		};
+		__run_parallel(parts / 2, merge_task);
+	}
+}
+
+/* 双向链表: 把 [first, last) 区间的结点移动到 pos 前面 */
+template<typename Node> inline
+void __list_transfer(Node *pos, Node *first, Node *last) noexcept {
+	if (first == last || pos == last)
+		return;
+
+	Node *tail = last->prev;
+	first->prev->next = last;
+	last->prev = first->prev;
+
+	first->prev = pos->prev;
+	first->prev->next = first;
+	tail->next = pos;
+	pos->prev = tail;
+}
+
+/*
+ * 双向链表: 把有序区间 [first2, last2) 的结点归并到有序区间 [first1, last1) 中, 相等时 first1 中的在前
+ * moved 记录已经移过去的结点数, 比较函数抛出异常时调用者据此修正两边的大小
+ */
+template<typename Node, typename Less>
+void __list_merge(Node *first1, Node *last1, Node *first2, Node *last2, Less less, std::size_t &moved) {
+	while (first1 != last1 && first2 != last2) {
+		if (less(first2, first1)) {
+			Node *next = first2->next;
+			sx::__list_transfer(first1, first2, next);
+			first2 = next;
+			++moved;
+		} else {
+			first1 = first1->next;
+		}
+	}
+
+	if (first2 != last2)
+		sx::__list_transfer(last1, first2, last2);
+}
+
+/* 双向链表: 前后指针互换, 头结点也一起换 */
+template<typename Node> inline
+void __list_reverse(Node *head) noexcept {
+	Node *curr = head;
+	do {
+		Node *next = curr->next;
+		curr->next = curr->prev;
+		curr->prev = next;
+		curr = next;
+	} while (curr != head);
+}
+
+/* 双向链表: 按缓冲区中的顺序重新链接全部结点, node_of(entry) 取出缓冲区元素对应的结点 */
+template<typename Node, typename Entry, typename NodeOf>
+void __list_relink(Node *head, Entry *buffer, std::size_t count, NodeOf node_of) noexcept {
+	Node *prev = head;
+	for (std::size_t i = 0; i < count; ++i) {
+		Node *node = node_of(buffer[i]);
+		prev->next = node;
+		node->prev = prev;
+		prev = node;
+	}
+	prev->next = head;
+	head->prev = prev;
+}
+
+/* 单向链表: 同上, 返回最后一个结点 (count 为 0 时是 head) */
+template<typename Node, typename Entry, typename NodeOf>
+Node *__forward_list_relink(Node *head, Entry *buffer, std::size_t count, NodeOf node_of) noexcept {
+	Node *prev = head;
+	for (std::size_t i = 0; i < count; ++i) {
+		Node *node = node_of(buffer[i]);
+		prev->next = node;
+		prev = node;
+	}
+	prev->next = nullptr;
+	return prev;
+}
+
+/*
+ * 单向链表: 把以 nullptr 结尾的有序链 first 和 second 归并, 结果写入 out (before 是 out 所在的结点),
+ * 相等时 first 中的在前. 连续来自同一边的结点本来就连着, 只在换边时写 next.
+ * LinkPrev 为 true 时顺带设置双向链表的 prev, 返回最后一个结点, 省去排序后再补一遍 prev.
+ * less 抛出异常时已归并的部分, first 和 second 剩下的结点依次接在 out 中再重新抛出, 不丢失结点
+ */
+template<bool LinkPrev, typename Node, typename Less>
+Node *__forward_list_merge_link(Node *&out, Node *before, Node *first, Node *second, Less &less) {
+	Node **tail = &out;
+	Node *last = before;
+	try {
+		while (first != nullptr && second != nullptr) {
+			if (less(second, first)) {
+				*tail = second;
+				do {
+					if constexpr (LinkPrev) {
+						second->prev = last;
+						last = second;
+					}
+					tail = &second->next;
+					second = second->next;
+				} while (second != nullptr && less(second, first));
+			} else {
+				*tail = first;
+				do {
+					if constexpr (LinkPrev) {
+						first->prev = last;
+						last = first;
+					}
+					tail = &first->next;
+					first = first->next;
+				} while (first != nullptr && !less(second, first));
+			}
+		}
+	} catch (...) {
+		*tail = first;
+		while (*tail != nullptr)
+			tail = &(*tail)->next;
+		*tail = second;
+		throw;
+	}
+
+	Node *rest = first != nullptr ? first : second;
+	*tail = rest;
+	if constexpr (LinkPrev) {
+		for (; rest != nullptr; rest = rest->next) {
+			rest->prev = last;
+			last = rest;
+		}
+	}
+	return last;
+}
+
+template<typename Node, typename Less>
+void __forward_list_merge(Node *&out, Node *first, Node *second, Less less) {
+	sx::__forward_list_merge_link<false, Node>(out, nullptr, first, second, less);
+}
+
+/*
+ * 单向链表: 对 head 之后以 nullptr 结尾的链做不申请额外内存的自底向上归并排序, 稳定
+ * counter[i] 存放长度为 2^i 的有序链, 越靠后的 counter 中的结点在原链表中越靠前.
+ * 最后一次归并直接写到 head 之后, LinkPrev 为 true 时返回最后一个结点.
+ * less 抛出异常时全部结点按未定的顺序重新接在 head 之后再重新抛出
+ */
+template<bool LinkPrev, typename Node, typename Less>
+Node *__forward_list_sort_link(Node *head, Less &less) {
+	Node *first = head->next;
+	Node *carry = nullptr;
+	Node *counter[64] = {};
+	int fill = 0;
+	head->next = nullptr;
+	try {
+		while (first != nullptr) {
+			carry = first;
+			first = first->next;
+			carry->next = nullptr;
+			int i = 0;
+			for ( ; i < fill && counter[i] != nullptr; ++i) {
+				Node *older = counter[i];
+				Node *newer = carry;
+				counter[i] = carry = nullptr;
+				sx::__forward_list_merge_link<false, Node>(carry, nullptr, older, newer, less);
+			}
+			counter[i] = carry;
+			carry = nullptr;
+			if (i == fill)
+				++fill;
+		}
+		if (fill == 0)
+			return head;
+
+		/* counter[fill - 1] 一定不为空, 它是最后一次归并 */
+		for (int i = 0; i + 1 < fill; ++i) {
+			if (counter[i] == nullptr)
+				continue;
+			Node *older = counter[i];
+			Node *newer = carry;
+			counter[i] = carry = nullptr;
+			sx::__forward_list_merge_link<false, Node>(carry, nullptr, older, newer, less);
+		}
+		Node *older = counter[fill - 1];
+		Node *newer = carry;
+		counter[fill - 1] = carry = nullptr;
+		return sx::__forward_list_merge_link<LinkPrev>(head->next, head, older, newer, less);
+	} catch (...) {
+		Node **tail = &head->next;
+		auto append = [&tail](Node *chain) noexcept {
+			*tail = chain;
+			while (*tail != nullptr)
+				tail = &(*tail)->next;
+		};
+		append(head->next);
+		append(carry);
+		for (int i = 0; i < fill; ++i)
+			append(counter[i]);
+		append(first);
+		throw;
+	}
+}
+
+template<typename Node, typename Less>
+void __forward_list_sort(Node *head, Less less) {
+	sx::__forward_list_sort_link<false>(head, less);
+}
+
+/* 双向链表: 沿 next 补回 prev, 把以 nullptr 结尾的链重新接成以 head 为界的环 */
+template<typename Node> inline
+void __list_restore_prev(Node *head) noexcept {
+	Node *prev = head;
+	for (Node *curr = head->next; curr != nullptr; curr = curr->next) {
+		curr->prev = prev;
+		prev = curr;
+	}
+	prev->next = head;
+	head->prev = prev;
+}
+
+/* 双向链表: 先断开成单向链排序, 最后一次归并时顺带补回 prev; 异常时同样保留全部结点 */
+template<typename Node, typename Less>
+void __list_sort(Node *head, Less less) {
+	if (head->next == head)
+		return;
+
+	head->prev->next = nullptr;
+	Node *last;
+	try {
+		last = sx::__forward_list_sort_link<true>(head, less);
+	} catch (...) {
+		sx::__list_restore_prev(head);
+		throw;
+	}
+	last->next = head;
+	head->prev = last;
+}
+
+}	// !namespace sx
+
+#endif // !M_LIST_ALGORITHM_HPP
@@ -0,0 +1,400 @@
+﻿#ifndef M_LRU_CACHE_HPP
+#define M_LRU_CACHE_HPP
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include "allocator.hpp"
+#include "hash_table.hpp"
+#include "intrusive_list.hpp"
+
+namespace sx {
+
+struct __lfu_bucket;
+
+
+/* 默认权重: 每个元素占一个单位, 容量即为元素个数 */
+struct __cache_unit_weight {
+	template<typename Key, typename Value>
+	std::size_t operator()(Key const &, Value const &) const noexcept {
+		return 1;
+	}
+};
+
+/* 淘汰顺序的链接, 键值类型不一定是标准布局, 链接放在标准布局的基类中, 由链表取回后再转换为缓存项 */
+struct __cache_link {
+	list_hook		hook;
+};
+
+using __cache_list = intrusive_list<__cache_link, &__cache_link::hook>;
+
+/* 缓存项, 键值、权重和淘汰顺序的链接都在同一个哈希表结点里, 每个元素只分配一次 */
+template<typename Key, typename Value>
+struct __lru_entry : __cache_link {
+	using key_type		= Key;
+	using mapped_type	= Value;
+
+	Key				key;
+	Value			value;
+	std::size_t		weight;		/* 元素在容量中所占的权重 */
+public:
+	template<typename V>
+	__lru_entry(Key const &key, V &&value, std::size_t weight)
+		: key(key), value(std::forward<V>(value)), weight(weight) {}
+};
+
+template<typename Key, typename Value>
+struct __lfu_entry : __cache_link {
+	using key_type		= Key;
+	using mapped_type	= Value;
+
+	Key				key;
+	Value			value;
+	std::size_t		weight;		/* 元素在容量中所占的权重 */
+	__lfu_bucket	*bucket;	/* 所属频率桶 */
+public:
+	template<typename V>
+	__lfu_entry(Key const &key, V &&value, std::size_t weight)
+		: key(key), value(std::forward<V>(value)), weight(weight), bucket(nullptr) {}
+};
+
+/* 访问次数相同的元素放在同一个桶中, 桶内越靠前越是最近访问 */
+struct __lfu_bucket {
+	std::size_t		freq;		/* 访问次数 */
+	list_hook		hook;		/* 链接在频率桶链表中, 按频率升序 */
+	__cache_list	entries;	/* 该频率的所有元素 */
+public:
+	explicit __lfu_bucket(std::size_t freq) : freq(freq) {}
+};
+
+
+/*
+ * 缓存的公共部分: 哈希表负责查找和内存, 淘汰顺序由派生类维护, 派生类需要提供
+ * on_insert / on_access / on_erase / victim / clear_order 五个操作
+ */
+template<typename Derived, typename Entry,
+	typename WeightFunc, typename HashFunc,
+	typename EqualKey, typename Alloc>
+class __cache_base {
+public:
+	using key_type			= typename Entry::key_type;
+	using mapped_type		= typename Entry::mapped_type;
+	using size_type			= std::size_t;
+	using hasher			= HashFunc;
+	using key_equal			= EqualKey;
+	using weight_function	= WeightFunc;
+	using evict_callback	= std::function<void(key_type const &, mapped_type &)>;
+protected:
+	struct extract_key_type {
+		key_type const &operator()(Entry const &entry) const noexcept {
+			return entry.key;
+		}
+	};
+
+	using EntryAllocator	= decltype(sx::transform_alloator_type<std::pair<const key_type, mapped_type>, Entry>(Alloc{}));
+	using hashtable			= sx::hash_table<Entry, key_type, HashFunc, extract_key_type, EqualKey, EntryAllocator>;
+protected:
+	hashtable			table;			/* 保存所有元素 */
+	size_type			max_weight;		/* 容量 */
+	size_type			total_weight;	/* 当前所有元素的权重之和 */
+	weight_function		weight_of;		/* 计算元素权重 */
+	evict_callback		on_evict;		/* 元素被淘汰时的回调 */
+public:
+	explicit __cache_base(size_type capacity, weight_function const &weight_func = weight_function(),
+			hasher const &hash_func = hasher(), key_equal const &equal_func = key_equal())
+		: table(hash_func, equal_func), max_weight(capacity), total_weight(0), weight_of(weight_func) { }
+
+	__cache_base(__cache_base const &) = delete;
+	__cache_base &operator=(__cache_base const &) = delete;
+private:
+	Derived &derived() noexcept {
+		return static_cast<Derived &>(*this);
+	}
+
+	Entry *lookup(key_type const &key) const {
+		auto it = table.find(key);
+		return it.curr != nullptr ? &*it : nullptr;
+	}
+
+	/* 从淘汰顺序和哈希表中删除, 哈希表按 key 删除时允许 key 引用被删除的元素 */
+	void remove_entry(Entry &entry) {
+		derived().on_erase(entry);
+		total_weight -= entry.weight;
+		table.erase(entry.key);
+	}
+
+	/* 淘汰直到权重之和不超过 limit, keep 是刚刚写入的元素, 不会被选中 */
+	void evict_until(size_type limit, Entry const *keep) {
+		while (total_weight > limit) {
+			Entry &victim = derived().victim(keep);
+			if (on_evict)
+				on_evict(victim.key, victim.value);
+			remove_entry(victim);
+		}
+	}
+
+	template<typename V>
+	bool __put(key_type const &key, V &&value) {
+		const size_type weight = weight_of(key, static_cast<mapped_type const &>(value));
+		Entry *entry = lookup(key);
+
+		/* 单个元素就超过了容量, 不保存, 已有的旧值也一并删除 */
+		if (weight > max_weight) {
+			if (entry != nullptr)
+				remove_entry(*entry);
+			return false;
+		}
+
+		if (entry != nullptr) {
+			derived().on_access(*entry);
+			entry->value = std::forward<V>(value);
+			total_weight = total_weight - entry->weight + weight;
+			entry->weight = weight;
+		} else {
+			entry = &*table.emplace_unique(key, std::forward<V>(value), weight).first;
+			try {
+				derived().on_insert(*entry);
+			} catch (...) {
+				table.erase(key);
+				throw;
+			}
+			total_weight += weight;
+		}
+
+		evict_until(max_weight, entry);
+		return true;
+	}
+public:
+	size_type size() const noexcept {
+		return table.size();
+	}
+
+	bool empty() const noexcept {
+		return table.empty();
+	}
+
+	size_type capacity() const noexcept {
+		return max_weight;
+	}
+
+	/* 当前所有元素的权重之和, 使用默认权重时等于 size() */
+	size_type weight() const noexcept {
+		return total_weight;
+	}
+
+	/* 缩小容量时立即淘汰多余的元素 */
+	void set_capacity(size_type capacity) {
+		max_weight = capacity;
+		evict_until(max_weight, nullptr);
+	}
+
+	/* 只在容量不足被淘汰时调用, erase / clear 不会调用 */
+	void set_evict_callback(evict_callback callback) {
+		on_evict = std::move(callback);
+	}
+
+	/* 预先分配能容纳 n 个元素的哈希桶 */
+	void reserve(size_type n) {
+		table.resize(n);
+	}
+
+	bool contains(key_type const &key) const {
+		return lookup(key) != nullptr;
+	}
+
+	/* 命中时返回值的地址并更新淘汰顺序, 未命中返回空指针; 地址在该元素被删除之前一直有效 */
+	mapped_type *get(key_type const &key) {
+		Entry *entry = lookup(key);
+		if (entry == nullptr)
+			return nullptr;
+
+		derived().on_access(*entry);
+		return &entry->value;
+	}
+
+	/* 只查看, 不影响淘汰顺序 */
+	mapped_type const *peek(key_type const &key) const {
+		Entry const *entry = lookup(key);
+		return entry != nullptr ? &entry->value : nullptr;
+	}
+
+	/* 插入或者覆盖, 权重超过容量的元素不会被保存并返回 false */
+	bool put(key_type const &key, mapped_type const &value) {
+		return __put(key, value);
+	}
+
+	bool put(key_type const &key, mapped_type &&value) {
+		return __put(key, std::move(value));
+	}
+
+	bool erase(key_type const &key) {
+		Entry *entry = lookup(key);
+		if (entry == nullptr)
+			return false;
+
+		remove_entry(*entry);
+		return true;
+	}
+
+	void clear() {
+		derived().clear_order();
+		table.clear();
+		total_weight = 0;
+	}
+};
+
+
+/* 最近最少使用淘汰, 链表头部是最近访问的元素 */
+template<typename Key, typename Value,
+	typename WeightFunc = __cache_unit_weight,
+	typename HashFunc = std::hash<Key>, typename EqualKey = std::equal_to<Key>,
+	typename Alloc = sx::allocator<std::pair<const Key, Value>>>
+class lru_cache : public __cache_base<lru_cache<Key, Value, WeightFunc, HashFunc, EqualKey, Alloc>,
+	__lru_entry<Key, Value>, WeightFunc, HashFunc, EqualKey, Alloc> {
+	using entry		= __lru_entry<Key, Value>;
+	using base		= __cache_base<lru_cache, entry, WeightFunc, HashFunc, EqualKey, Alloc>;
+
+	friend base;
+private:
+	__cache_list	order;		/* 按访问时间排序 */
+public:
+	using base::base;
+
+	~lru_cache() {
+		order.clear();
+	}
+private:
+	void on_insert(entry &value) noexcept {
+		order.push_front(value);
+	}
+
+	void on_access(entry &value) noexcept {
+		order.splice(order.begin(), order, order.iterator_to(value));
+	}
+
+	void on_erase(entry &value) noexcept {
+		order.erase(value);
+	}
+
+	entry &victim(entry const *keep) noexcept {
+		auto it = --order.end();
+		if (&*it == keep)
+			--it;
+		return static_cast<entry &>(*it);
+	}
+
+	void clear_order() noexcept {
+		order.clear();
+	}
+};
+
+
+/*
+ * 最不经常使用淘汰, 频率桶按访问次数升序排列, 访问时元素移动到下一个桶, 所有操作 O(1);
+ * 访问次数相同时淘汰其中最久未访问的元素
+ */
+template<typename Key, typename Value,
+	typename WeightFunc = __cache_unit_weight,
+	typename HashFunc = std::hash<Key>, typename EqualKey = std::equal_to<Key>,
+	typename Alloc = sx::allocator<std::pair<const Key, Value>>>
+class lfu_cache : public __cache_base<lfu_cache<Key, Value, WeightFunc, HashFunc, EqualKey, Alloc>,
+	__lfu_entry<Key, Value>, WeightFunc, HashFunc, EqualKey, Alloc> {
+	using entry				= __lfu_entry<Key, Value>;
+	using bucket			= __lfu_bucket;
+	using base				= __cache_base<lfu_cache, entry, WeightFunc, HashFunc, EqualKey, Alloc>;
+	using BucketAllocator	= decltype(sx::transform_alloator_type<std::pair<const Key, Value>, bucket>(Alloc{}));
+
+	friend base;
+public:
+	using size_type			= typename base::size_type;
+	using key_type			= typename base::key_type;
+private:
+	static BucketAllocator					allocator;	/* 频率桶分配器 */
+	intrusive_list<bucket, &bucket::hook>	buckets;	/* 按频率升序 */
+public:
+	using base::base;
+
+	~lfu_cache() {
+		clear_order();
+	}
+
+	/* 元素被访问的次数, 不存在时返回 0 */
+	size_type frequency(key_type const &key) const {
+		auto it = this->table.find(key);
+		return it.curr != nullptr ? it->bucket->freq : 0;
+	}
+private:
+	/* 在 pos 之前创建一个频率为 freq 的空桶 */
+	typename intrusive_list<bucket, &bucket::hook>::iterator
+	make_bucket(typename intrusive_list<bucket, &bucket::hook>::iterator pos, size_type freq) {
+		bucket *ptr = allocator.allocate(1);
+		allocator.construct(ptr, freq);
+		return buckets.insert(pos, *ptr);
+	}
+
+	void drop_bucket(bucket &value) noexcept {
+		buckets.erase(value);
+		allocator.destroy(&value);
+		allocator.deallocate(&value, sizeof(bucket));
+	}
+
+	void on_insert(entry &value) {
+		auto first = buckets.begin();
+		if (first == buckets.end() || first->freq != 1)
+			first = make_bucket(first, 1);
+
+		first->entries.push_front(value);
+		value.bucket = &*first;
+	}
+
+	/* 先准备好目标桶再移动元素, 分配失败时元素保持原样 */
+	void on_access(entry &value) {
+		bucket &curr = *value.bucket;
+		auto next = buckets.iterator_to(curr);
+		++next;
+		if (next == buckets.end() || next->freq != curr.freq + 1)
+			next = make_bucket(next, curr.freq + 1);
+
+		curr.entries.erase(value);
+		next->entries.push_front(value);
+		value.bucket = &*next;
+		if (curr.entries.empty())
+			drop_bucket(curr);
+	}
+
+	void on_erase(entry &value) noexcept {
+		bucket &curr = *value.bucket;
+		curr.entries.erase(value);
+		if (curr.entries.empty())
+			drop_bucket(curr);
+	}
+
+	/* keep 只有在它独占最低频率桶时才需要跳到下一个桶 */
+	entry &victim(entry const *keep) noexcept {
+		auto first = buckets.begin();
+		auto it = --first->entries.end();
+		if (&*it == keep) {
+			if (first->entries.size() > 1)
+				--it;
+			else
+				it = --(++first)->entries.end();
+		}
+		return static_cast<entry &>(*it);
+	}
+
+	void clear_order() noexcept {
+		while (!buckets.empty()) {
+			bucket &first = buckets.front();
+			first.entries.clear();
+			drop_bucket(first);
+		}
+	}
+};
+
+template<typename Key, typename Value, typename WeightFunc,
+	typename HashFunc, typename EqualKey, typename Alloc>
+typename lfu_cache<Key, Value, WeightFunc, HashFunc, EqualKey, Alloc>::BucketAllocator
+lfu_cache<Key, Value, WeightFunc, HashFunc, EqualKey, Alloc>::allocator;
+
+}
+
+#endif
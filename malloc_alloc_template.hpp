@@ -28,6 +28,11 @@ public:
 		free(ptr);
 	}
 
+	/* malloc 得到的内存不能拆开释放, 不提供连续分配 */
+	static void *allocate_contiguous(std::size_t, std::size_t) noexcept {
+		return nullptr;
+	}
+
 	static void *reallocate(void *ptr, std::size_t/* old_size */, std::size_t new_sz) {
 		void *result = realloc(ptr, new_sz);
 		if (result == nullptr)
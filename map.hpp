@@ -3,24 +3,27 @@
 #include "allocator.hpp"
 #include "utility.hpp"
 #include "rbtree.hpp"
+#include <tuple>
 #include <utility>
 
 namespace sx {
 
 template<typename Key, typename Value,
 	typename Compare = std::less<Key>,
-	typename Alloc = sx::allocator<std::pair<const Key, Value>>>
+	typename Alloc = sx::allocator<std::pair<const Key, Value>>,
+	typename NodeUpdate = sx::rbtree_null_update>
 class map;
 
 template<typename Key, typename Value,
 	typename Compare = std::less<Key>,
-	typename Alloc = sx::allocator<std::pair<const Key, Value>>>
+	typename Alloc = sx::allocator<std::pair<const Key, Value>>,
+	typename NodeUpdate = sx::rbtree_null_update>
 class multimap;
 
 
 template<typename Key, typename Value,
-	typename Compare, typename Alloc>
-class map : public sx::container_helpful<map<Key, Value, Compare, Alloc>> {
+	typename Compare, typename Alloc, typename NodeUpdate>
+class map : public sx::container_helpful<map<Key, Value, Compare, Alloc, NodeUpdate>> {
 public:
 	using key_type		= Key;
 	using value_type	= std::pair<const Key, Value>;
@@ -43,7 +46,7 @@ public:
 		}
 	};
 private:
-	using Container = sx::rbtree<key_type, value_type, key_of_value, key_compare, Alloc>;
+	using Container = sx::rbtree<key_type, value_type, key_of_value, key_compare, Alloc, NodeUpdate>;
 public:
 	using pointer			= typename Container::pointer;
 	using reference			= typename Container::reference;
@@ -53,8 +56,19 @@ public:
 	using size_type			= typename Container::size_type;
 	using iterator			= typename Container::iterator;
 	using const_iterator	= typename Container::const_iterator;
+	using node_type				= typename Container::node_type;
+	using insert_return_type	= typename Container::insert_return_type;
+	using metadata_type			= typename Container::metadata_type;
 private:
+	template<typename, typename, typename, typename, typename>
+	friend class map;
+
+	template<typename, typename, typename, typename, typename>
+	friend class multimap;
+
 	Container container;		/* 底层红黑树容器 */
+
+	explicit map(Container &&container) : container(std::move(container)) {}
 public:
 	map() : container(Compare()) {}
 
@@ -67,6 +81,14 @@ public:
 		container.insert_unique(first, last);
 	}
 
+	/* 调用者保证输入按 key 严格递增, O(n) 建树 */
+	template<typename InputIterator,
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
+		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
+	map(sx::sorted_unique_t, InputIterator first, InputIterator last) {
+		container.insert_unique(sx::sorted_unique, first, last);
+	}
+
 	map(map const &other) : container(other.container) {}
 
 	map(map &&other) : container(std::move(other.container)) {}
@@ -91,10 +113,19 @@ public:
 		return container.empty();
 	}
 
+	key_compare key_comp() const {
+		return container.key_comp();
+	}
+
 	void clear() {
 		container.clear();
 	}
 
+	/* 结点按中序搬到连续内存中并重新平衡, 所有迭代器失效 */
+	void compact() {
+		container.compact();
+	}
+
 	iterator begin() noexcept {
 		return container.begin();
 	}
@@ -132,6 +163,74 @@ public:
 		return container.emplace_unique(std::forward<Args>(args)...);
 	}
 
+	/* position 指向新元素之后的元素时均摊 O(1), 例如按时间戳递增追加时传入 end() */
+	iterator insert(const_iterator position, value_type const &val) {
+		return container.insert_unique(position, val).first;
+	}
+
+	template<typename... Args>
+	iterator emplace_hint(const_iterator position, Args&&... args) {
+		return container.emplace_hint_unique(position, std::forward<Args>(args)...).first;
+	}
+
+	/* key 已存在时什么也不做, 不会分配结点, args 也不会被移走 */
+	template<typename... Args>
+	std::pair<iterator, bool> try_emplace(key_type const &key, Args&&... args) {
+		return container.try_emplace_unique(key, std::piecewise_construct,
+			std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+	}
+
+	template<typename... Args>
+	std::pair<iterator, bool> try_emplace(key_type &&key, Args&&... args) {
+		return container.try_emplace_unique(key, std::piecewise_construct,
+			std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+	}
+
+	template<typename... Args>
+	iterator try_emplace(const_iterator position, key_type const &key, Args&&... args) {
+		return container.try_emplace_hint_unique(position, key, std::piecewise_construct,
+			std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...)).first;
+	}
+
+	template<typename... Args>
+	iterator try_emplace(const_iterator position, key_type &&key, Args&&... args) {
+		return container.try_emplace_hint_unique(position, key, std::piecewise_construct,
+			std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::forward<Args>(args)...)).first;
+	}
+
+	/* key 不存在时插入, 已存在时赋值给对应的 value */
+	template<typename M>
+	std::pair<iterator, bool> insert_or_assign(key_type const &key, M &&obj) {
+		std::pair<iterator, bool> ret = container.try_emplace_unique(key, key, std::forward<M>(obj));
+		if (!ret.second)
+			(*ret.first).second = std::forward<M>(obj);
+		return ret;
+	}
+
+	template<typename M>
+	std::pair<iterator, bool> insert_or_assign(key_type &&key, M &&obj) {
+		std::pair<iterator, bool> ret = container.try_emplace_unique(key, std::move(key), std::forward<M>(obj));
+		if (!ret.second)
+			(*ret.first).second = std::forward<M>(obj);
+		return ret;
+	}
+
+	template<typename M>
+	iterator insert_or_assign(const_iterator position, key_type const &key, M &&obj) {
+		std::pair<iterator, bool> ret = container.try_emplace_hint_unique(position, key, key, std::forward<M>(obj));
+		if (!ret.second)
+			(*ret.first).second = std::forward<M>(obj);
+		return ret.first;
+	}
+
+	template<typename M>
+	iterator insert_or_assign(const_iterator position, key_type &&key, M &&obj) {
+		std::pair<iterator, bool> ret = container.try_emplace_hint_unique(position, key, std::move(key), std::forward<M>(obj));
+		if (!ret.second)
+			(*ret.first).second = std::forward<M>(obj);
+		return ret.first;
+	}
+
 	template<typename InputIterator, 
 		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
 		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
@@ -139,6 +238,80 @@ public:
 		container.insert_unique(first, last);
 	}
 
+	template<typename InputIterator, 
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
+		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
+	void insert(sx::sorted_unique_t, InputIterator first, InputIterator last) {
+		container.insert_unique(sx::sorted_unique, first, last);
+	}
+
+	/* 摘下结点但不释放, 可以修改 key 后插回, 或者插入到另一个 map */
+	node_type extract(const_iterator position) {
+		return container.extract(position);
+	}
+
+	node_type extract(key_type const &key) {
+		return container.extract(key);
+	}
+
+	/* 已有相同 key 时插入失败, 结点通过返回值的 node 交还 */
+	insert_return_type insert(node_type &&handle) {
+		return container.insert_unique(std::move(handle));
+	}
+
+	iterator insert(const_iterator position, node_type &&handle) {
+		return container.insert_unique(position, std::move(handle));
+	}
+
+	/* 把 source 中 key 不重复的结点移过来, 重复的留在 source 中 */
+	template<typename OtherCompare>
+	void merge(map<Key, Value, OtherCompare, Alloc, NodeUpdate> &source) {
+		container.merge_unique(source.container);
+	}
+
+	template<typename OtherCompare>
+	void merge(multimap<Key, Value, OtherCompare, Alloc, NodeUpdate> &source) {
+		container.merge_unique(source.container);
+	}
+
+	/* 本映射保留小于 key 的元素, 其余元素作为新的映射返回 */
+	map split(key_type const &key) {
+		return map(container.split(key));
+	}
+
+	/* other 中的 key 都必须大于本映射中的 key, 拼接后 other 为空, O(log n) */
+	void join(map &other) noexcept {
+		container.join(other.container);
+	}
+
+	/*
+	 * 集合运算直接复用 other 的结点, 完成后 other 为空; key 相同时保留本映射中的元素.
+	 * 较小的一方有 m 个元素时为 O(m log(n / m + 1)), 带 sx::parallel 时在多个线程上递归
+	 */
+	void union_with(map &other) {
+		container.union_with(other.container);
+	}
+
+	void union_with(sx::parallel_t, map &other) {
+		container.union_with(sx::parallel, other.container);
+	}
+
+	void intersect_with(map &other) {
+		container.intersect_with(other.container);
+	}
+
+	void intersect_with(sx::parallel_t, map &other) {
+		container.intersect_with(sx::parallel, other.container);
+	}
+
+	void difference_with(map &other) {
+		container.difference_with(other.container);
+	}
+
+	void difference_with(sx::parallel_t, map &other) {
+		container.difference_with(sx::parallel, other.container);
+	}
+
 	iterator erase(iterator position) {
 		return container.erase(position);
 	}
@@ -191,6 +364,34 @@ public:
 														 container.transform_const_iterator(ret.second));
 	}
 
+	/* 从 hint 向后查找, 顺着上一次的结果查找相近的 key 时比从根开始快; hint 不小于 key 时从根开始 */
+	iterator find(const_iterator hint, key_type const &key) {
+		return container.find(hint, key);
+	}
+
+	const_iterator find(const_iterator hint, key_type const &key) const {
+		return container.find(hint, key);
+	}
+
+	iterator lower_bound(const_iterator hint, key_type const &key) {
+		return container.lower_bound(hint, key);
+	}
+
+	const_iterator lower_bound(const_iterator hint, key_type const &key) const {
+		return container.lower_bound(hint, key);
+	}
+
+	/* 调用者保证 keys 非递减, 每个 key 的查找结果 (找不到时为 end()) 依次写入 out, 共 O(k log(n / k)) */
+	template<typename Range, typename OutputIterator>
+	OutputIterator find_batch(Range const &keys, OutputIterator out) {
+		return container.find_batch(keys.begin(), keys.end(), out);
+	}
+
+	template<typename Range, typename OutputIterator>
+	OutputIterator find_batch(Range const &keys, OutputIterator out) const {
+		return container.find_batch(keys.begin(), keys.end(), out);
+	}
+
 	iterator max() {
 		return container.max();
 	}
@@ -203,17 +404,109 @@ public:
 		return container.count(key);
 	}
 
+	/* 比较器声明了 is_transparent 时 (例如 std::less<>), 可以直接用 char const * 等类型查找, 不构造临时 key */
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	size_type erase(K const &key) {
+		return container.erase(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	iterator find(K const &key) {
+		return container.find(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator find(K const &key) const {
+		return container.find(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	iterator lower_bound(K const &key) {
+		return container.lower_bound(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator lower_bound(K const &key) const {
+		return container.lower_bound(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	iterator upper_bound(K const &key) {
+		return container.upper_bound(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator upper_bound(K const &key) const {
+		return container.upper_bound(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	std::pair<iterator, iterator> equal_range(K const &key) {
+		return container.equal_range(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	std::pair<const_iterator, const_iterator> equal_range(K const &key) const {
+		return container.equal_range(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	size_type count(K const &key) const {
+		return container.count(key);
+	}
+
+	/* 以下需要 NodeUpdate 为 sx::rbtree_order_statistics, 均为 O(log n) */
+	iterator nth(size_type k) noexcept {
+		return container.nth(k);
+	}
+
+	const_iterator nth(size_type k) const noexcept {
+		return container.nth(k);
+	}
+
+	/* 小于 key 的元素个数 */
+	size_type rank(key_type const &key) const {
+		return container.rank(key);
+	}
+
+	/* 落在 [first_key, last_key) 中的元素个数 */
+	size_type count_range(key_type const &first_key, key_type const &last_key) const {
+		return container.count_range(first_key, last_key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	size_type rank(K const &key) const {
+		return container.rank(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	size_type count_range(K const &first_key, K const &last_key) const {
+		return container.count_range(first_key, last_key);
+	}
+
+	/* 以下需要 NodeUpdate 为 sx::rbtree_monoid_update: 全部元素以及 [first_key, last_key) 中元素的折叠结果 */
+	metadata_type aggregate() const {
+		return container.aggregate();
+	}
+
+	metadata_type aggregate(key_type const &first_key, key_type const &last_key) const {
+		return container.aggregate(first_key, last_key);
+	}
+
 	Value &operator[](key_type const &key) {
-		std::pair<iterator, bool> result = insert(value_type(key, Value()));
-		return (*result.first).second;
+		return (*try_emplace(key).first).second;
+	}
+
+	Value &operator[](key_type &&key) {
+		return (*try_emplace(std::move(key)).first).second;
 	}
 };
 
 
 
 template<typename Key, typename Value,
-	typename Compare, typename Alloc>
-class multimap : public sx::container_helpful<map<Key, Value, Compare, Alloc>> {
+	typename Compare, typename Alloc, typename NodeUpdate>
+class multimap : public sx::container_helpful<multimap<Key, Value, Compare, Alloc, NodeUpdate>> {
 public:
 	using key_type		= Key;
 	using value_type	= std::pair<const Key, Value>;
@@ -236,7 +529,7 @@ public:
 		}
 	};
 private:
-	using Container = sx::rbtree<key_type, value_type, key_of_value, key_compare, Alloc>;
+	using Container = sx::rbtree<key_type, value_type, key_of_value, key_compare, Alloc, NodeUpdate>;
 public:
 	using pointer			= typename Container::pointer;
 	using reference			= typename Container::reference;
@@ -246,7 +539,16 @@ public:
 	using size_type			= typename Container::size_type;
 	using iterator			= typename Container::iterator;
 	using const_iterator	= typename Container::const_iterator;
+	using node_type				= typename Container::node_type;
+	using insert_return_type	= typename Container::insert_return_type;
+	using metadata_type			= typename Container::metadata_type;
 private:
+	template<typename, typename, typename, typename, typename>
+	friend class map;
+
+	template<typename, typename, typename, typename, typename>
+	friend class multimap;
+
 	Container container;		/* �ײ��������� */
 public:
 	multimap() : container(Compare()) {}
@@ -260,6 +562,14 @@ public:
 		container.insert_equal(first, last);
 	}
 
+	/* 调用者保证输入按 key 非递减, O(n) 建树 */
+	template<typename InputIterator,
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
+		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
+	multimap(sx::sorted_equivalent_t, InputIterator first, InputIterator last) {
+		container.insert_equal(sx::sorted_equivalent, first, last);
+	}
+
 	multimap(multimap const &other) : container(other.container) {}
 
 	multimap(multimap &&other) : container(std::move(other.container)) {}
@@ -284,10 +594,19 @@ public:
 		return container.empty();
 	}
 
+	key_compare key_comp() const {
+		return container.key_comp();
+	}
+
 	void clear() {
 		container.clear();
 	}
 
+	/* 结点按中序搬到连续内存中并重新平衡, 所有迭代器失效 */
+	void compact() {
+		container.compact();
+	}
+
 	iterator begin() noexcept {
 		return container.begin();
 	}
@@ -325,11 +644,54 @@ public:
 		return container.emplace_equal(std::forward<Args>(args)...);
 	}
 
+	iterator insert(const_iterator position, value_type const &val) {
+		return container.insert_equal(position, val);
+	}
+
+	template<typename... Args>
+	iterator emplace_hint(const_iterator position, Args&&... args) {
+		return container.emplace_hint_equal(position, std::forward<Args>(args)...);
+	}
+
 	template<typename InputIterator, 
 		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
 		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
 	void insert(InputIterator first, InputIterator last) {
-		container.insert_unique(first, last);
+		container.insert_equal(first, last);
+	}
+
+	template<typename InputIterator, 
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
+		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
+	void insert(sx::sorted_equivalent_t, InputIterator first, InputIterator last) {
+		container.insert_equal(sx::sorted_equivalent, first, last);
+	}
+
+	node_type extract(const_iterator position) {
+		return container.extract(position);
+	}
+
+	node_type extract(key_type const &key) {
+		return container.extract(key);
+	}
+
+	iterator insert(node_type &&handle) {
+		return container.insert_equal(std::move(handle));
+	}
+
+	iterator insert(const_iterator position, node_type &&handle) {
+		return container.insert_equal(position, std::move(handle));
+	}
+
+	/* source 中的结点全部移过来, 相同 key 的排在已有元素之后 */
+	template<typename OtherCompare>
+	void merge(multimap<Key, Value, OtherCompare, Alloc, NodeUpdate> &source) {
+		container.merge_equal(source.container);
+	}
+
+	template<typename OtherCompare>
+	void merge(map<Key, Value, OtherCompare, Alloc, NodeUpdate> &source) {
+		container.merge_equal(source.container);
 	}
 
 	iterator erase(iterator position) {
@@ -378,6 +740,127 @@ public:
 														 container.transform_const_iterator(ret.second));
 	}
 
+	/* 从 hint 向后查找, 顺着上一次的结果查找相近的 key 时比从根开始快; hint 不小于 key 时从根开始 */
+	iterator find(const_iterator hint, key_type const &key) {
+		return container.find(hint, key);
+	}
+
+	const_iterator find(const_iterator hint, key_type const &key) const {
+		return container.find(hint, key);
+	}
+
+	iterator lower_bound(const_iterator hint, key_type const &key) {
+		return container.lower_bound(hint, key);
+	}
+
+	const_iterator lower_bound(const_iterator hint, key_type const &key) const {
+		return container.lower_bound(hint, key);
+	}
+
+	/* 调用者保证 keys 非递减, 每个 key 的查找结果 (找不到时为 end()) 依次写入 out, 共 O(k log(n / k)) */
+	template<typename Range, typename OutputIterator>
+	OutputIterator find_batch(Range const &keys, OutputIterator out) {
+		return container.find_batch(keys.begin(), keys.end(), out);
+	}
+
+	template<typename Range, typename OutputIterator>
+	OutputIterator find_batch(Range const &keys, OutputIterator out) const {
+		return container.find_batch(keys.begin(), keys.end(), out);
+	}
+
+	/* 比较器声明了 is_transparent 时 (例如 std::less<>), 可以直接用 char const * 等类型查找, 不构造临时 key */
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	size_type erase(K const &key) {
+		return container.erase(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	iterator find(K const &key) {
+		return container.find(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator find(K const &key) const {
+		return container.find(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	iterator lower_bound(K const &key) {
+		return container.lower_bound(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator lower_bound(K const &key) const {
+		return container.lower_bound(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	iterator upper_bound(K const &key) {
+		return container.upper_bound(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator upper_bound(K const &key) const {
+		return container.upper_bound(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	std::pair<iterator, iterator> equal_range(K const &key) {
+		return container.equal_range(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	std::pair<const_iterator, const_iterator> equal_range(K const &key) const {
+		return container.equal_range(key);
+	}
+
+	size_type count(key_type const &key) const {
+		return container.count(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	size_type count(K const &key) const {
+		return container.count(key);
+	}
+
+	/* 以下需要 NodeUpdate 为 sx::rbtree_order_statistics, 均为 O(log n) */
+	iterator nth(size_type k) noexcept {
+		return container.nth(k);
+	}
+
+	const_iterator nth(size_type k) const noexcept {
+		return container.nth(k);
+	}
+
+	/* 小于 key 的元素个数 */
+	size_type rank(key_type const &key) const {
+		return container.rank(key);
+	}
+
+	/* 落在 [first_key, last_key) 中的元素个数 */
+	size_type count_range(key_type const &first_key, key_type const &last_key) const {
+		return container.count_range(first_key, last_key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	size_type rank(K const &key) const {
+		return container.rank(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	size_type count_range(K const &first_key, K const &last_key) const {
+		return container.count_range(first_key, last_key);
+	}
+
+	/* 以下需要 NodeUpdate 为 sx::rbtree_monoid_update: 全部元素以及 [first_key, last_key) 中元素的折叠结果 */
+	metadata_type aggregate() const {
+		return container.aggregate();
+	}
+
+	metadata_type aggregate(key_type const &first_key, key_type const &last_key) const {
+		return container.aggregate(first_key, last_key);
+	}
+
 	iterator max() noexcept {
 		return container.max();
 	}
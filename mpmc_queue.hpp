@@ -0,0 +1,231 @@
+﻿#ifndef M_MPMC_QUEUE_HPP
+#define M_MPMC_QUEUE_HPP
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include "allocator.hpp"
+#include "utility.hpp"
+
+namespace sx {
+
+template<typename T>
+struct __mpmc_cell;
+
+template<typename T, typename Alloc = sx::allocator<T>>
+class mpmc_queue;
+
+
+/* 环形数组的槽位, seq 记录该槽位下一次可写或可读的序号 */
+template<typename T>
+struct __mpmc_cell {
+	std::atomic<std::size_t>								 seq;		/* 槽位序号 */
+	typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;	/* 元素存储区 */
+public:
+	T *data() noexcept {
+		return reinterpret_cast<T *>(&storage);
+	}
+};
+
+
+/*
+ * 有界多生产者多消费者队列
+ * 每个槽位带有序号, 生产者与消费者只通过 CAS 抢占 enqueue_pos / dequeue_pos, 没有全局锁
+ * 容量会上调至 2 的幂次, 使用掩码定位槽位
+ * 接口有意与 sx::queue 不同: 并发下 front() / back() 返回的引用随时可能失效, 因此不提供;
+ * 出队只能原子地取出元素, pop() 按值返回, try_pop(T&) / pop(T&) 写入参数
+ */
+template<typename T, typename Alloc>
+class mpmc_queue {
+	static_assert(std::is_nothrow_move_constructible<T>::value,
+		"mpmc_queue requires nothrow move constructible value_type");
+
+	using cell		= __mpmc_cell<T>;
+	using Allocator = decltype(sx::transform_alloator_type<T, cell>(Alloc{}));
+public:
+	using value_type		= T;
+	using pointer			= T *;
+	using reference			= T &;
+	using const_pointer		= T const *;
+	using const_reference	= T const &;
+	using size_type			= std::size_t;
+	using difference_type	= std::ptrdiff_t;
+protected:
+	static Allocator						allocator;		/* 槽位分配器 */
+	cell								   *buffer;			/* 环形数组 */
+	size_type								mask;			/* 容量掩码 */
+	alignas(CACHE_LINE_SIZE) std::atomic<size_type>	enqueue_pos;	/* 下一个写入位置 */
+	alignas(CACHE_LINE_SIZE) std::atomic<size_type>	dequeue_pos;	/* 下一个读取位置 */
+public:
+	explicit mpmc_queue(size_type capacity = 1024) : enqueue_pos(0), dequeue_pos(0) {
+		size_type n = sx::__round_up_pow2(capacity < 2 ? 2 : capacity);
+		buffer = allocator.allocate(n);
+		mask = n - 1;
+		for (size_type i = 0; i < n; ++i)
+			new(&buffer[i].seq) std::atomic<size_type>(i);
+	}
+
+	mpmc_queue(mpmc_queue const &) = delete;
+	mpmc_queue &operator=(mpmc_queue const &) = delete;
+
+	~mpmc_queue() {
+		size_type last = enqueue_pos.load(std::memory_order_relaxed);
+		for (size_type pos = dequeue_pos.load(std::memory_order_relaxed); pos != last; ++pos)
+			sx::destroy(buffer[pos & mask].data());
+		allocator.deallocate(buffer, sizeof(cell) * capacity());
+	}
+private:
+	/* 抢占一个可写槽位, 队列满时返回 nullptr */
+	cell *claim_enqueue(size_type &pos) noexcept {
+		pos = enqueue_pos.load(std::memory_order_relaxed);
+		for ( ; ; ) {
+			cell *curr = &buffer[pos & mask];
+			size_type seq = curr->seq.load(std::memory_order_acquire);
+			difference_type diff = static_cast<difference_type>(seq) - static_cast<difference_type>(pos);
+			if (diff == 0) {
+				if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					return curr;
+			} else if (diff < 0) {
+				return nullptr;
+			} else {
+				pos = enqueue_pos.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	/* 抢占一个可读槽位, 队列空时返回 nullptr */
+	cell *claim_dequeue(size_type &pos) noexcept {
+		pos = dequeue_pos.load(std::memory_order_relaxed);
+		for ( ; ; ) {
+			cell *curr = &buffer[pos & mask];
+			size_type seq = curr->seq.load(std::memory_order_acquire);
+			difference_type diff = static_cast<difference_type>(seq) - static_cast<difference_type>(pos + 1);
+			if (diff == 0) {
+				if (dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					return curr;
+			} else if (diff < 0) {
+				return nullptr;
+			} else {
+				pos = dequeue_pos.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	template<typename... Args>
+	bool enqueue_aux(Args&&... args) noexcept {
+		size_type pos;
+		cell *curr = claim_enqueue(pos);
+		if (curr == nullptr)
+			return false;
+
+		sx::construct(curr->data(), std::forward<Args>(args)...);
+		curr->seq.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	/* 自旋一段时间后让出时间片 */
+	static void backoff(unsigned &spin) noexcept {
+		if (++spin < 64)
+			return;
+		std::this_thread::yield();
+	}
+public:
+	size_type capacity() const noexcept {
+		return mask + 1;
+	}
+
+	/* 并发情况下只是一个近似值 */
+	size_type size() const noexcept {
+		size_type tail = enqueue_pos.load(std::memory_order_relaxed);
+		size_type head = dequeue_pos.load(std::memory_order_relaxed);
+		return tail > head ? tail - head : 0;
+	}
+
+	bool empty() const noexcept {
+		return size() == 0;
+	}
+
+	/* 构造可能抛出异常时, 先在槽位外构造好元素, 避免抢占到的槽位无法发布 */
+	template<typename... Args>
+	bool try_emplace(Args&&... args) {
+		if constexpr (std::is_nothrow_constructible<value_type, Args&&...>::value) {
+			return enqueue_aux(std::forward<Args>(args)...);
+		} else {
+			value_type tmp(std::forward<Args>(args)...);
+			return enqueue_aux(std::move(tmp));
+		}
+	}
+
+	bool try_push(value_type const &value) {
+		return try_emplace(value);
+	}
+
+	bool try_push(value_type &&value) {
+		return try_emplace(std::move(value));
+	}
+
+	bool try_pop(value_type &value) {
+		size_type pos;
+		cell *curr = claim_dequeue(pos);
+		if (curr == nullptr)
+			return false;
+
+		try {
+			value = std::move(*curr->data());
+		} catch (...) {
+			sx::destroy(curr->data());
+			curr->seq.store(pos + mask + 1, std::memory_order_release);
+			throw;
+		}
+		sx::destroy(curr->data());
+		curr->seq.store(pos + mask + 1, std::memory_order_release);
+		return true;
+	}
+
+	/* 阻塞版本, 队列满时等待 */
+	template<typename... Args>
+	void emplace(Args&&... args) {
+		if constexpr (std::is_nothrow_constructible<value_type, Args&&...>::value) {
+			for (unsigned spin = 0; !enqueue_aux(std::forward<Args>(args)...); )
+				backoff(spin);
+		} else {
+			value_type tmp(std::forward<Args>(args)...);
+			for (unsigned spin = 0; !enqueue_aux(std::move(tmp)); )
+				backoff(spin);
+		}
+	}
+
+	void push(value_type const &value) {
+		emplace(value);
+	}
+
+	void push(value_type &&value) {
+		emplace(std::move(value));
+	}
+
+	/* 阻塞版本, 队列空时等待 */
+	void pop(value_type &value) {
+		for (unsigned spin = 0; !try_pop(value); )
+			backoff(spin);
+	}
+
+	value_type pop() {
+		size_type pos;
+		cell *curr;
+		for (unsigned spin = 0; (curr = claim_dequeue(pos)) == nullptr; )
+			backoff(spin);
+
+		value_type ret(std::move(*curr->data()));
+		sx::destroy(curr->data());
+		curr->seq.store(pos + mask + 1, std::memory_order_release);
+		return ret;
+	}
+};
+
+template<typename T, typename Alloc>
+typename mpmc_queue<T, Alloc>::Allocator mpmc_queue<T, Alloc>::allocator{};
+
+}	// !namespace sx
+
+#endif // !M_MPMC_QUEUE_HPP
@@ -0,0 +1,115 @@
+﻿#ifndef M_NODE_HANDLE_HPP
+#define M_NODE_HANDLE_HPP
+#include <type_traits>
+#include <utility>
+
+namespace sx {
+
+template<typename, typename, typename, typename, typename, typename>
+class rbtree;
+
+template<typename, typename, typename, typename, typename, typename>
+class hash_table;
+
+template<typename T>
+struct __is_std_pair : std::false_type {};
+
+template<typename First, typename Second>
+struct __is_std_pair<std::pair<First, Second>> : std::true_type {};
+
+/*
+ * 结点句柄: 独占一个从容器中摘下的结点, 元素既不拷贝也不移动.
+ * 可以插入到结点类型相同的另一个容器 (比较器或哈希函数可以不同), 也可以先修改 key 再插回.
+ * 句柄析构时如果还持有结点, 就用容器的结点分配器销毁并释放它
+ */
+template<typename Value, typename Node, typename Allocator>
+class node_handle {
+	template<typename, typename, typename, typename, typename, typename>
+	friend class rbtree;
+
+	template<typename, typename, typename, typename, typename, typename>
+	friend class hash_table;
+public:
+	using value_type = Value;
+private:
+	Node	*ptr;		/* 持有的结点, 为空表示句柄为空 */
+private:
+	explicit node_handle(Node *ptr) noexcept : ptr(ptr) {}
+
+	/* 交出结点的所有权, 由容器重新链接 */
+	Node *release() noexcept {
+		Node *ret = ptr;
+		ptr = nullptr;
+		return ret;
+	}
+
+	void reset() noexcept {
+		if (ptr != nullptr) {
+			Allocator::destroy(ptr);
+			Allocator::deallocate(ptr, sizeof(Node));
+			ptr = nullptr;
+		}
+	}
+public:
+	constexpr node_handle() noexcept : ptr(nullptr) {}
+
+	node_handle(node_handle &&other) noexcept : ptr(other.release()) {}
+
+	node_handle &operator=(node_handle &&other) noexcept {
+		if (this != &other) {
+			reset();
+			ptr = other.release();
+		}
+		return *this;
+	}
+
+	node_handle(node_handle const &) = delete;
+	node_handle &operator=(node_handle const &) = delete;
+
+	~node_handle() {
+		reset();
+	}
+
+	bool empty() const noexcept {
+		return ptr == nullptr;
+	}
+
+	explicit operator bool() const noexcept {
+		return ptr != nullptr;
+	}
+
+	value_type &value() const noexcept {
+		return ptr->data;
+	}
+
+	/* map 类容器的结点可以修改 key, 插回容器时按新 key 重新定位 */
+	template<typename V = value_type, typename = std::enable_if_t<__is_std_pair<V>::value>>
+	std::remove_const_t<typename V::first_type> &key() const noexcept {
+		return const_cast<std::remove_const_t<typename V::first_type> &>(ptr->data.first);
+	}
+
+	template<typename V = value_type, typename = std::enable_if_t<__is_std_pair<V>::value>>
+	typename V::second_type &mapped() const noexcept {
+		return ptr->data.second;
+	}
+
+	void swap(node_handle &other) noexcept {
+		std::swap(ptr, other.ptr);
+	}
+
+	friend void swap(node_handle &lhs, node_handle &rhs) noexcept {
+		lhs.swap(rhs);
+	}
+};
+
+/* 插入结点句柄的结果, 插入失败时句柄交还给 node */
+template<typename Iterator, typename NodeHandle>
+struct node_insert_return {
+	Iterator	position;
+	bool		inserted;
+	NodeHandle	node;
+};
+
+}
+
+#endif
@@ -78,6 +78,98 @@ public:
 			throw;
 		}
 	}
+
+	/*
+	 * 批量压入 [first, last)
+	 * 新增 k 个元素时, 逐个 push_heap 的代价约为 k * log(n + k), 整体 make_heap 为 O(n + k),
+	 * 根据两者的大小选择其一.
+	 * 追加时抛出异常则截回原来的大小, 原有元素不受影响; 调整堆时抛出异常则保留全部元素重新建堆
+	 */
+	template<typename InputIterator,
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>>>
+	void push_range(InputIterator first, InputIterator last) {
+		size_type old_size = container.size();
+		try {
+			sx::__append_range(container, first, last);
+		} catch (...) {
+			__truncate(old_size);
+			throw;
+		}
+
+		try {
+			size_type new_size = container.size();
+			size_type count = new_size - old_size;
+			if (count * __log2(new_size) > new_size) {
+				sx::make_heap(container.begin(), container.end(), compare);
+			} else {
+				for (auto iter = container.begin() + old_size + 1; iter <= container.end(); ++iter)
+					sx::push_heap(container.begin(), iter, compare);
+			}
+		} catch (...) {
+			__restore_heap();
+			throw;
+		}
+	}
+
+	/* 按出队顺序把最多 n 个元素移动到 out; 抛出异常时还没移出的元素留在队列中 */
+	template<typename OutputIterator>
+	OutputIterator pop_n(OutputIterator out, size_type n) {
+		if (n > size())
+			n = size();
+
+		try {
+			for (size_type i = 0; i < n; ++i, ++out) {
+				sx::pop_heap(container.begin(), container.end(), compare);
+				*out = std::move(container.back());
+				container.pop_back();
+			}
+		} catch (...) {
+			__restore_heap();
+			throw;
+		}
+		return out;
+	}
+
+	/* 取出全部元素, 整体 sort_heap 后逆序移出, 避免逐个 pop_back; 抛出异常时同 pop_n */
+	template<typename OutputIterator>
+	OutputIterator drain(OutputIterator out) {
+		size_type rest = container.size();
+		try {
+			sx::sort_heap(container.begin(), container.end(), compare);
+			for (; rest != 0; ++out) {
+				*out = std::move(*(container.begin() + (rest - 1)));
+				--rest;
+			}
+			container.clear();
+		} catch (...) {
+			/* 已经移出的元素都在尾部 */
+			__truncate(rest);
+			__restore_heap();
+			throw;
+		}
+		return out;
+	}
+private:
+	void __truncate(size_type count) noexcept {
+		while (container.size() > count)
+			container.pop_back();
+	}
+
+	/* 异常之后重新建堆, 比较器再次抛出异常时只能清空 */
+	void __restore_heap() noexcept {
+		try {
+			sx::make_heap(container.begin(), container.end(), compare);
+		} catch (...) {
+			container.clear();
+		}
+	}
+
+	static size_type __log2(size_type n) noexcept {
+		size_type result = 0;
+		while (n >>= 1)
+			++result;
+		return result;
+	}
 };
 
 template<typename T, typename Container, typename Compare>
@@ -38,6 +38,8 @@ public:
 	queue &operator=(queue const &) = default;
 	queue &operator=(queue &&) = default;
 	~queue() = default;
+	explicit queue(Container const &c) : container(c) {}
+	explicit queue(Container &&c) : container(std::move(c)) {}
 public:
 	size_type size() const noexcept {
 		return container.size();
@@ -76,6 +78,33 @@ public:
 		container.emplace_back(std::forward<Args>(args)...);
 	}
 
+	/* 批量压入 [first, last) */
+	template<typename InputIterator,
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>>>
+	void push_range(InputIterator first, InputIterator last) {
+		sx::__append_range(container, first, last);
+	}
+
+	/* 按出队顺序把最多 n 个元素移动到 out, 再一次性从容器头部删除 */
+	template<typename OutputIterator>
+	OutputIterator pop_n(OutputIterator out, size_type n) {
+		if (n > size())
+			n = size();
+
+		auto first = container.begin();
+		auto last = first;
+		for (size_type i = 0; i < n; ++i, ++last, ++out)
+			*out = std::move(*last);
+		sx::__erase_front(container, first, last, 0);
+		return out;
+	}
+
+	/* 取出全部元素 */
+	template<typename OutputIterator>
+	OutputIterator drain(OutputIterator out) {
+		return pop_n(out, size());
+	}
+
 	void swap(queue const &other) {
 		if (this == &other)
 			return;
@@ -1,10 +1,16 @@
 ﻿#ifndef RBTREE_HPP
 #define RBTREE_HPP
+#include <cstdint>
+#include <future>
 #include <stdexcept>
+#include <thread>
 #include "algorithm.hpp"
 #include "allocator.hpp"
 #include "utility.hpp"
 #include "type_traits.hpp"
+#include "vector.hpp"
+#include "node_handle.hpp"
+#include <algorithm>
 
 namespace sx {
 
@@ -17,17 +23,19 @@ struct __rbtree_node;
 
 struct __rbtree_iterator_base;
 
+struct rbtree_null_update;
+
 template<typename T, typename Ptr, typename Ref>
 struct __rbtree_iterator;
 
 template<typename Key, typename Value, typename KeyOfValue,
-	typename Compare, typename Alloc>
+	typename Compare, typename Alloc, typename NodeUpdate = sx::rbtree_null_update>
 class rbtree;
 
 
 template<typename Key, typename Value, typename KeyOfValue,
-	typename Compare, typename Alloc>
-void swap(rbtree<Key, Value, KeyOfValue, Compare, Alloc> &, rbtree<Key, Value, KeyOfValue, Compare, Alloc> &) noexcept;
+	typename Compare, typename Alloc, typename NodeUpdate>
+void swap(rbtree<Key, Value, KeyOfValue, Compare, Alloc, NodeUpdate> &, rbtree<Key, Value, KeyOfValue, Compare, Alloc, NodeUpdate> &) noexcept;
 
 
 
@@ -36,28 +44,56 @@ enum __rbcolor {
 	__BLACK		= false
 };
 
+/*
+ * 颜色放在父结点指针的最低位: 结点至少按指针对齐, 地址最低位恒为 0.
+ * 叶子用 nullptr 表示, 不再需要 nil 哨兵结点
+ */
 struct __rbtree_node_base {
 	using color_type	= __rbcolor;
 	using base_ptr		= __rbtree_node_base * ;
 public:
-	color_type	color;		/* 结点颜色 */
-	base_ptr	parent;		/* 父结点 */
-	base_ptr	left;		/* 左结点 */
-	base_ptr	right;		/* 右结点 */
+	std::uintptr_t	parent_color;	/* 父结点 | 颜色 */
+	base_ptr		left;			/* 左结点 */
+	base_ptr		right;			/* 右结点 */
+
+	base_ptr parent() const noexcept {
+		return reinterpret_cast<base_ptr>(parent_color & ~std::uintptr_t(1));
+	}
+
+	void set_parent(base_ptr node) noexcept {
+		parent_color = reinterpret_cast<std::uintptr_t>(node) | (parent_color & 1);
+	}
+
+	color_type color() const noexcept {
+		return (parent_color & 1) ? __RED : __BLACK;
+	}
+
+	void set_color(color_type color) noexcept {
+		parent_color = (parent_color & ~std::uintptr_t(1)) | (color == __RED ? 1 : 0);
+	}
+
+	bool is_red() const noexcept {
+		return (parent_color & 1) != 0;
+	}
 
-	static base_ptr minimun(base_ptr node, base_ptr nil) {
-		while (node->left != nil)
+	static base_ptr minimun(base_ptr node) noexcept {
+		while (node->left != nullptr)
 			node = node->left;
 		return node;
 	}
 
-	static base_ptr maximun(base_ptr node, base_ptr nil) {
-		while (node->right != nil)
+	static base_ptr maximun(base_ptr node) noexcept {
+		while (node->right != nullptr)
 			node = node->right;
 		return node;
 	}
 };
 
+/* 空结点按黑色处理 */
+inline bool __is_black(__rbtree_node_base const *node) noexcept {
+	return node == nullptr || !node->is_red();
+}
+
 
 template<typename T>
 struct __rbtree_node : public __rbtree_node_base {
@@ -71,8 +107,78 @@ public:
 };
 
 
+/* 带附加信息的结点, 附加信息放在元素之后, 迭代器仍按 __rbtree_node<T> 访问元素 */
+template<typename T, typename Metadata>
+struct __rbtree_augmented_node : public __rbtree_node<T> {
+	Metadata	meta;
+public:
+	template<typename... Args>
+	__rbtree_augmented_node(Args&&... args) : __rbtree_node<T>(std::forward<Args>(args)...), meta() { }
+};
+
+template<typename T, typename Metadata>
+struct __rbtree_node_select {
+	using type = __rbtree_augmented_node<T, Metadata>;
+};
+
+template<typename T>
+struct __rbtree_node_select<T, void> {
+	using type = __rbtree_node<T>;
+};
+
+
+/*
+ * 结点更新策略: 结构改变 (插入, 删除, 旋转) 后由左右孩子重新计算结点的 meta,
+ * update(node, left, right) 中 left/right 可能为空. 默认不维护任何信息, 结点也不增大
+ */
+struct rbtree_null_update {
+	using metadata_type = void;
+};
+
+/* 维护子树大小, 支持 O(log n) 的 nth, rank 和 count_range */
+struct rbtree_order_statistics {
+	using metadata_type = std::size_t;
+
+	template<typename Node>
+	static void update(Node *node, Node const *left, Node const *right) noexcept {
+		node->meta = 1 + (left != nullptr ? left->meta : 0) + (right != nullptr ? right->meta : 0);
+	}
+};
+
+/*
+ * 用户给出的幺半群, 结点的 meta 是子树中所有元素按中序折叠的结果 (和, 最大值, 最大右端点等).
+ * Monoid 提供 value_type 以及静态函数 lift(元素) 和满足结合律的 combine(a, b), 二者不能抛出异常;
+ * aggregate 还需要单位元 identity(), 空树和空区间折叠的结果都是它
+ */
+template<typename Monoid>
+struct rbtree_monoid_update {
+	using metadata_type	= typename Monoid::value_type;
+	using monoid_type	= Monoid;
+
+	template<typename Node>
+	static void update(Node *node, Node const *left, Node const *right) noexcept {
+		metadata_type meta = Monoid::lift(node->data);
+		if (left != nullptr)
+			meta = Monoid::combine(left->meta, meta);
+		if (right != nullptr)
+			meta = Monoid::combine(meta, right->meta);
+		node->meta = std::move(meta);
+	}
+};
+
+template<typename NodeUpdate>
+struct __is_monoid_update : std::false_type {};
+
+template<typename Monoid>
+struct __is_monoid_update<rbtree_monoid_update<Monoid>> : std::true_type {};
+
+
+/*
+ * 迭代器只保存一个结点指针. 树内嵌的头结点就是 end(): 它的 parent 指向根, left/right 指向最小/最大结点,
+ * 并且染成红色, 用来和根结点区分 (根的 parent 也指向头结点)
+ */
 struct __rbtree_iterator_base {
-	template<typename , typename, typename, typename, typename>
+	template<typename , typename, typename, typename, typename, typename>
 	friend class rbtree;
 
 	using base_ptr			= __rbtree_node_base::base_ptr;
@@ -80,49 +186,40 @@ struct __rbtree_iterator_base {
 	using difference_type	= std::ptrdiff_t;
 protected:
 	base_ptr	node;
-	base_ptr	nil;
-	base_ptr	root;
 protected:
-	__rbtree_iterator_base(base_ptr node, base_ptr nil, base_ptr root) : node(node), nil(nil), root(root) {}
+	explicit __rbtree_iterator_base(base_ptr node) noexcept : node(node) {}
 	__rbtree_iterator_base(__rbtree_iterator_base const &) = default;
 	__rbtree_iterator_base &operator=(__rbtree_iterator_base const &) = default;
 	~__rbtree_iterator_base() = default;
 protected:
-	void increment() {
-		if (node == nil)
-			throw std::invalid_argument("iterator operator++ error");
-
-		if (node->right != nil) {
-			node = node->right;
-			while (node->left != nil)
-				node = node->left;
+	/* 对 end() 自增是未定义行为 */
+	void increment() noexcept {
+		if (node->right != nullptr) {
+			node = __rbtree_node_base::minimun(node->right);
 		} else {
-			base_ptr p = node->parent;
-			while (node == p->right && p != nil) {
+			base_ptr p = node->parent();
+			while (node == p->right) {
 				node = p;
-				p = p->parent;
+				p = p->parent();
 			}
-			node = p;
+			/* 根结点没有右子树且是最大结点时, node 已经走到头结点 */
+			if (node->right != p)
+				node = p;
 		}
 	}
 
-	void decrement() {
-		if (node == nil) {
-			node = root;
-			while (node->right != nil)
-				node = node->right;
-		} else if (node->left != nil) {
-			node = node->left;
-			while (node->right != nil)
-				node = node->right;
+	/* end() 自减得到最大结点, 对 begin() 自减是未定义行为 */
+	void decrement() noexcept {
+		if (node->is_red() && (node->parent() == nullptr || node->parent()->parent() == node)) {
+			node = node->right;
+		} else if (node->left != nullptr) {
+			node = __rbtree_node_base::maximun(node->left);
 		} else {
-			base_ptr p = node->parent;
-			while (node == p->left && p != nil) {
+			base_ptr p = node->parent();
+			while (node == p->left) {
 				node = p;
-				p = p->parent;
+				p = p->parent();
 			}
-			if (p == nil)
-				throw std::invalid_argument("iterator operator--() error!");
 			node = p;
 		}
 	}
@@ -138,44 +235,50 @@ struct __rbtree_iterator : public sx::__rbtree_iterator_base {
 	using iterator_category = sx::bidirectional_iterator_tag;
 	using sx::__rbtree_iterator_base::base_ptr;
 public:
-	__rbtree_iterator() : __rbtree_iterator_base(nullptr, nullptr, nullptr) {}
-	__rbtree_iterator(base_ptr ptr, base_ptr nil, base_ptr root) : __rbtree_iterator_base(ptr, nil, root) {}
+	__rbtree_iterator() noexcept : __rbtree_iterator_base(nullptr) {}
+	explicit __rbtree_iterator(base_ptr ptr) noexcept : __rbtree_iterator_base(ptr) {}
 	__rbtree_iterator(__rbtree_iterator const &) = default;
 	__rbtree_iterator &operator=(__rbtree_iterator const &) = default;
+
+	/* 普通迭代器可以隐式转换为 const 迭代器, 用于传递插入提示等场合 */
+	template<typename OtherPtr, typename OtherRef, typename = std::enable_if_t<
+		std::is_same_v<Ptr, T const *> && std::is_same_v<OtherPtr, T *>>>
+	__rbtree_iterator(__rbtree_iterator<T, OtherPtr, OtherRef> const &other) noexcept
+		: __rbtree_iterator_base(other) {}
 	~__rbtree_iterator() = default;
 public:
-	reference operator*() {
-		return reinterpret_cast<__rbtree_node<T> *>(this->node)->data;
+	reference operator*() const noexcept {
+		return static_cast<__rbtree_node<T> *>(this->node)->data;
 	}
 
-	pointer operator->() {
+	pointer operator->() const noexcept {
 		return &(this->operator*());
 	}
 
-	__rbtree_iterator operator++(int) {
+	__rbtree_iterator operator++(int) noexcept {
 		__rbtree_iterator ret = *this;
 		this->increment();
 		return ret;
 	}
 
-	__rbtree_iterator &operator++() {
+	__rbtree_iterator &operator++() noexcept {
 		this->increment();
 		return *this;
 	}
 
-	__rbtree_iterator operator--(int) {
+	__rbtree_iterator operator--(int) noexcept {
 		__rbtree_iterator ret = *this;
 		this->decrement();
 		return ret;
 	}
 
-	__rbtree_iterator &operator--() {
+	__rbtree_iterator &operator--() noexcept {
 		this->decrement();
 		return *this;
 	}
 
 	friend bool operator==(__rbtree_iterator const &first, __rbtree_iterator const &second) noexcept {
-		return first.root == second.root && first.node == second.node;
+		return first.node == second.node;
 	}
 
 	friend bool operator!=(__rbtree_iterator const &first, __rbtree_iterator const &second) noexcept {
@@ -184,14 +287,18 @@ public:
 };
 
 
-template<typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
-class rbtree : public sx::container_helpful<rbtree<Key, Value, KeyOfValue, Compare, Alloc>> {
+template<typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeUpdate>
+class rbtree : public sx::container_helpful<rbtree<Key, Value, KeyOfValue, Compare, Alloc, NodeUpdate>> {
 protected:
 	using void_pointer	= void *;
 	using base_ptr		= sx::__rbtree_node_base *;
-	using rb_tree_node	= sx::__rbtree_node<Value>;
+	using rb_tree_node	= typename sx::__rbtree_node_select<Value, typename NodeUpdate::metadata_type>::type;
 	using rb_tree_color = sx::__rbcolor;
-	using Allocator		= decltype(sx::transform_alloator_type<Value, __rbtree_node<Value>>(Alloc{}));
+	using Allocator		= decltype(sx::transform_alloator_type<Value, rb_tree_node>(Alloc{}));
+
+	static constexpr bool is_augmented		= !std::is_same_v<NodeUpdate, sx::rbtree_null_update>;
+	static constexpr bool is_order_statistics	= std::is_same_v<NodeUpdate, sx::rbtree_order_statistics>;
+	static constexpr bool is_monoid				= sx::__is_monoid_update<NodeUpdate>::value;
 public:
 	using key_type			= Key;
 	using value_type		= Value;
@@ -204,10 +311,14 @@ public:
 	using difference_type	= std::ptrdiff_t;
 	using iterator			= sx::__rbtree_iterator<Value, Value *, Value &>;
 	using const_iterator	= sx::__rbtree_iterator<Value, Value const *, Value const &>;
+	using node_type				= sx::node_handle<Value, rb_tree_node, Allocator>;
+	using insert_return_type	= sx::node_insert_return<iterator, node_type>;
+	using node_update			= NodeUpdate;
+	/* 不维护附加信息时 meta 为 void, 换成占位类型, 只是让相关成员函数的声明合法 */
+	using metadata_type			= std::conditional_t<is_augmented, typename NodeUpdate::metadata_type, char>;
 protected:
 	static Allocator		allocator;	/* 分配器 */
-	__rbtree_node_base		header;		/* 头结点 */
-	__rbtree_node_base     *nil;		/* nil 哨兵结点 */
+	__rbtree_node_base		header;		/* 头结点, 同时充当 end() */
 	size_type				node_size;	/* 结点数量 */
 	Compare					comp;		/* 比较器 */
 protected:
@@ -216,7 +327,7 @@ protected:
 	}
 
 	static void put_node(link_type node_ptr) {
-		allocator.deallocate(node_ptr, sizeof(link_type));
+		allocator.deallocate(node_ptr, sizeof(rb_tree_node));
 	}
 
 	template<typename... Args>
@@ -236,32 +347,36 @@ protected:
 		put_node(node_ptr);
 	}
 
-	void empty_initialize() {
-		nil = allocator.allocate(1);
-		header.parent = header.left = header.right = nil_node();
-		nil->color = __BLACK;
+	void empty_initialize() noexcept {
+		header.parent_color = 0;
+		header.set_color(__RED);
+		header.left = header.right = &header;
 		node_size = 0;
 	}
 
+	/* 交换头结点后, 根结点要重新指向自己的头结点 */
+	void __reset_header() noexcept {
+		if (node_size == 0)
+			empty_initialize();
+		else
+			root()->set_parent(end_node());
+	}
+
 	bool key_compare(base_ptr first, base_ptr second) const noexcept {
 		auto key = KeyOfValue();
 		return comp(key(((link_type)first)->data), key(((link_type)second)->data));
 	}
 
 	link_type root() noexcept {
-		return static_cast<link_type>(header.parent);
+		return static_cast<link_type>(header.parent());
 	}
 
 	const link_type root() const noexcept {
 		return const_cast<const link_type>(const_cast<rbtree *>(this)->root());
 	}
 
-	link_type nil_node() noexcept {
-		return static_cast<link_type>(nil);
-	}
-
-	const link_type nil_node() const noexcept {
-		return const_cast<const link_type>(const_cast<rbtree *>(this)->nil_node());
+	base_ptr end_node() noexcept {
+		return &header;
 	}
 	
 	link_type leftmost() noexcept {
@@ -272,281 +387,703 @@ protected:
 		return static_cast<link_type>(header.right);
 	}
 
-	void set_root(base_ptr node_ptr) {
-		header.parent = node_ptr;
+	void set_root(base_ptr node_ptr) noexcept {
+		header.set_parent(node_ptr);
 	}
 
-	void set_leftmost(base_ptr node_ptr) {
+	void set_leftmost(base_ptr node_ptr) noexcept {
 		header.left = node_ptr;
 	}
 
-	void set_rightmost(base_ptr node_ptr) {
+	void set_rightmost(base_ptr node_ptr) noexcept {
 		header.right = node_ptr;
 	}
 
+	/* 由左右孩子重新计算结点的附加信息, 不维护附加信息时什么都不做 */
+	static void __update(base_ptr node) noexcept {
+		if constexpr (is_augmented) {
+			NodeUpdate::update(static_cast<link_type>(node),
+				static_cast<link_type>(node->left), static_cast<link_type>(node->right));
+		}
+	}
+
+	/*
+	 * 根结点的父结点是头结点, 头结点的父结点又是根结点, 普通结点不会出现这种环.
+	 * 只靠结点本身判断, 旋转和插入修正就能用在挂在临时头结点下的子树上 (split/join)
+	 */
+	static bool __is_root(base_ptr node) noexcept {
+		return node->parent()->parent() == node;
+	}
+
+	/* 从 node 向上一直更新到根结点 */
+	void __update_to_root(base_ptr node) noexcept {
+		if constexpr (is_augmented) {
+			for (; node != end_node(); node = node->parent()) {
+				__update(node);
+				if (__is_root(node))
+					break;
+			}
+		}
+	}
+
+	/* 用 replace 顶替 node 在父结点中的位置, 根结点的父结点是头结点 */
+	void tranfers(base_ptr node, base_ptr replace) noexcept {
+		base_ptr parent_ptr = node->parent();
+		if (__is_root(node))
+			parent_ptr->set_parent(replace);
+		else if (node == parent_ptr->left)
+			parent_ptr->left = replace;
+		else
+			parent_ptr->right = replace;
+		if (replace != nullptr)
+			replace->set_parent(parent_ptr);
+	}
+
 	void left_rotate(base_ptr node_ptr) noexcept {
 		base_ptr right_ptr = node_ptr->right;
 
 		node_ptr->right = right_ptr->left;
-		if (right_ptr->left != nil_node())
-			right_ptr->left->parent = node_ptr;
-
-		right_ptr->parent = node_ptr->parent;
-		if (node_ptr->parent == nil_node())
-			set_root(right_ptr);
-		else if (node_ptr == node_ptr->parent->left)
-			node_ptr->parent->left = right_ptr;
-		else
-			node_ptr->parent->right = right_ptr;
+		if (right_ptr->left != nullptr)
+			right_ptr->left->set_parent(node_ptr);
 
+		tranfers(node_ptr, right_ptr);
 		right_ptr->left = node_ptr;
-		node_ptr->parent = right_ptr;
+		node_ptr->set_parent(right_ptr);
+
+		__update(node_ptr);
+		__update(right_ptr);
 	}
 
 	void right_rotate(base_ptr node_ptr) noexcept {
 		base_ptr left_ptr = node_ptr->left;
 
 		node_ptr->left = left_ptr->right;
-		if (left_ptr->right != nil_node())
-			left_ptr->right->parent = node_ptr;
-
-		left_ptr->parent = node_ptr->parent;
-		if (node_ptr->parent == nil_node())
-			set_root(left_ptr);
-		else if (node_ptr == node_ptr->parent->left)
-			node_ptr->parent->left = left_ptr;
-		else
-			node_ptr->parent->right = left_ptr;
+		if (left_ptr->right != nullptr)
+			left_ptr->right->set_parent(node_ptr);
 
+		tranfers(node_ptr, left_ptr);
 		left_ptr->right = node_ptr;
-		node_ptr->parent = left_ptr;
+		node_ptr->set_parent(left_ptr);
+
+		__update(node_ptr);
+		__update(left_ptr);
+	}
+
+	/* 把新结点挂到 parent_ptr 的左边或右边, 维护最左最右结点并修正颜色 */
+	iterator __link(base_ptr new_node, base_ptr parent_ptr, bool insert_left) noexcept {
+		new_node->left = new_node->right = nullptr;
+		new_node->parent_color = 0;
+		new_node->set_parent(parent_ptr);
+		new_node->set_color(__RED);
+
+		if (parent_ptr == end_node()) {
+			set_root(new_node);
+			set_leftmost(new_node);
+			set_rightmost(new_node);
+		} else if (insert_left) {
+			parent_ptr->left = new_node;
+			if (parent_ptr == leftmost())
+				set_leftmost(new_node);
+		} else {
+			parent_ptr->right = new_node;
+			if (parent_ptr == rightmost())
+				set_rightmost(new_node);
+		}
+
+		__update_to_root(new_node);
+		__insert_fixup(new_node);
+		++node_size;
+		return iterator(new_node);
+	}
+
+	/* 从根结点向下查找插入位置; 唯一插入遇到相同 key 时销毁新结点 */
+	template<bool Is_Unique>
+	std::pair<iterator, bool> __insert_node(base_ptr new_node) {
+		base_ptr node_ptr = root();
+		base_ptr parent_ptr = end_node();
+		bool insert_left = true;
+		while (node_ptr != nullptr) {
+			parent_ptr = node_ptr;
+			insert_left = key_compare(new_node, node_ptr);
+			if (Is_Unique && !insert_left && !key_compare(node_ptr, new_node)) {
+				destroy_node(static_cast<link_type>(new_node));
+				return std::pair<iterator, bool>(iterator(node_ptr), false);
+			}
+			node_ptr = insert_left ? node_ptr->left : node_ptr->right;
+		}
+		
+		return std::pair<iterator, bool>(__link(new_node, parent_ptr, insert_left), true);
 	}
 
 	template<bool Is_Unique, typename... Args>
 	std::pair<iterator, bool> __insert(Args&&... args) {
 		base_ptr new_node = create_node(std::forward<Args>(args)...);
-		new_node->left = new_node->right = new_node->parent = nil_node();
-		new_node->color = __RED;
+		try {
+			return __insert_node<Is_Unique>(new_node);
+		} catch (...) {
+			destroy_node(static_cast<link_type>(new_node));
+			throw;
+		}
+	}
+
+	/* 唯一插入时 first 严格小于 second, 否则 first 不大于 second */
+	template<bool Is_Unique>
+	bool __ordered(base_ptr first, base_ptr second) const {
+		return Is_Unique ? key_compare(first, second) : !key_compare(second, first);
+	}
+
+	/* 把新结点挂在相邻的 prev 和 next 之间, 二者之中必有一个在对应一侧没有孩子 */
+	iterator __link_between(base_ptr new_node, base_ptr prev, base_ptr next) noexcept {
+		if (prev->right == nullptr)
+			return __link(new_node, prev, false);
+		return __link(new_node, next, true);
+	}
+
+	/*
+	 * 按提示位置插入: 新 key 落在 hint 的前一个结点和 hint 之间, 或者 hint 和后一个结点之间时,
+	 * 直接挂到相邻结点的空孩子上, 只需常数次比较, 加上修正颜色均摊 O(1); 否则退回从根查找.
+	 * 相同 key 的唯一插入返回已有的元素
+	 */
+	template<bool Is_Unique>
+	std::pair<iterator, bool> __insert_hint_node(const_iterator hint, base_ptr new_node) {
+		base_ptr pos = hint.node;
+		if (pos == end_node()) {
+			if (node_size != 0 && __ordered<Is_Unique>(rightmost(), new_node))
+				return std::pair<iterator, bool>(__link(new_node, rightmost(), false), true);
+			return __insert_node<Is_Unique>(new_node);
+		}
+
+		if (__ordered<Is_Unique>(new_node, pos)) {
+			if (pos == leftmost())
+				return std::pair<iterator, bool>(__link(new_node, pos, true), true);
+
+			iterator before = transform_iterator(hint);
+			--before;
+			if (__ordered<Is_Unique>(before.node, new_node))
+				return std::pair<iterator, bool>(__link_between(new_node, before.node, pos), true);
+			return __insert_node<Is_Unique>(new_node);
+		}
+
+		if (__ordered<Is_Unique>(pos, new_node)) {
+			if (pos == rightmost())
+				return std::pair<iterator, bool>(__link(new_node, pos, false), true);
+
+			iterator after = transform_iterator(hint);
+			++after;
+			if (__ordered<Is_Unique>(new_node, after.node))
+				return std::pair<iterator, bool>(__link_between(new_node, pos, after.node), true);
+			return __insert_node<Is_Unique>(new_node);
+		}
+
+		/* 只有唯一插入才会走到这里: key 与 hint 相同 */
+		destroy_node(static_cast<link_type>(new_node));
+		return std::pair<iterator, bool>(transform_iterator(hint), false);
+	}
+
+	template<bool Is_Unique, typename... Args>
+	std::pair<iterator, bool> __insert_hint(const_iterator hint, Args&&... args) {
+		base_ptr new_node = create_node(std::forward<Args>(args)...);
+		try {
+			return __insert_hint_node<Is_Unique>(hint, new_node);
+		} catch (...) {
+			destroy_node(static_cast<link_type>(new_node));
+			throw;
+		}
+	}
+
+	/* 第一个不小于 key 的结点, K 是 Key 或者能与 Key 比较的类型 */
+	template<typename K>
+	iterator __lower_bound(K const &key) {
+		base_ptr result = end_node();
+		base_ptr node = root();
+		while (node != nullptr) {
+			if (!comp(__key(node), key)) {
+				result = node;
+				node = node->left;
+			} else {
+				node = node->right;
+			}
+		}
+		return iterator(result);
+	}
+
+	/* 第一个大于 key 的结点 */
+	template<typename K>
+	iterator __upper_bound(K const &key) {
+		base_ptr result = end_node();
+		base_ptr node = root();
+		while (node != nullptr) {
+			if (comp(key, __key(node))) {
+				result = node;
+				node = node->left;
+			} else {
+				node = node->right;
+			}
+		}
+		return iterator(result);
+	}
+
+	/*
+	 * finger search, 调用者保证 finger 不是头结点且 finger 的 key 小于 key.
+	 * 先向上走: 从左孩子上来且父结点不小于 key 时, 父结点就是这棵子树之后的第一个结点,
+	 * 答案只能在子树里或者就是父结点; 再在这棵子树里下降. 相邻的 key 只需走很少几层
+	 */
+	template<typename K>
+	iterator __finger_lower_bound(base_ptr finger, K const &key) {
+		base_ptr result = end_node();
+		base_ptr node = finger;
+		for (base_ptr parent = node->parent(); parent != end_node(); node = parent, parent = node->parent()) {
+			if (node == parent->left && !comp(__key(parent), key)) {
+				result = parent;
+				break;
+			}
+		}
+
+		while (node != nullptr) {
+			if (!comp(__key(node), key)) {
+				result = node;
+				node = node->left;
+			} else {
+				node = node->right;
+			}
+		}
+		return iterator(result);
+	}
+
+	/* hint 为 end() 或不小于 key 时不能从 hint 向后找, 从根开始 */
+	template<typename K>
+	iterator __lower_bound(const_iterator hint, K const &key) {
+		if (hint.node == end_node() || !comp(__key(hint.node), key))
+			return __lower_bound(key);
+		return __finger_lower_bound(hint.node, key);
+	}
+
+	/*
+	 * 按 key 非递减的顺序逐个查找, 每次从上一个下界出发做 finger search, 对每个 key 调用 visit(结点或头结点).
+	 * 下一个 key 不大于上一个下界时下界不变; 上一个下界已是 end() 时后面的 key 都找不到.
+	 * k 个 key 的查找路径大部分重合, 总共 O(k log(n / k)) 次比较, 而不是每次从根开始的 O(k log n)
+	 */
+	template<typename InputIterator, typename Visit>
+	void __find_batch(InputIterator first, InputIterator last, Visit visit) {
+		if (first == last)
+			return;
+
+		base_ptr finger = __lower_bound(*first).node;
+		for (; first != last; ++first) {
+			if (finger != end_node() && comp(__key(finger), *first))
+				finger = __finger_lower_bound(finger, *first).node;
+			visit(finger != end_node() && !comp(*first, __key(finger)) ? finger : end_node());
+		}
+	}
+
+	/* 先求下界再比较一次, 每层只做一次比较 */
+	template<typename K>
+	iterator __find(K const &key) {
+		iterator position = __lower_bound(key);
+		if (position.node == end_node() || comp(key, __key(position.node)))
+			return end();
+		return position;
+	}
+
+	template<typename K>
+	size_type __erase(K const &key) {
+		std::pair<iterator, iterator> range(__lower_bound(key), __upper_bound(key));
+		size_type cnt = 0;
+		while (range.first != range.second) {
+			++cnt;
+			remove(range.first++);
+		}
+		return cnt;
+	}
 
+	static Key const &__key(base_ptr node_ptr) noexcept {
+		return KeyOfValue()(static_cast<link_type>(node_ptr)->data);
+	}
+
+	/*
+	 * 只用 key 查找唯一插入位置, 不需要先构造结点. 已有相同 key 时返回该结点,
+	 * 否则返回 nullptr, 并通过 parent_ptr 和 insert_left 给出挂入的位置.
+	 * 每层只比较一次, 记下最后一个不大于 key 的结点, 最后再判断它是否与 key 相等
+	 */
+	base_ptr __unique_pos(Key const &key, base_ptr &parent_ptr, bool &insert_left) {
 		base_ptr node_ptr = root();
-		base_ptr parent_ptr = nil_node();
-		while (node_ptr != nil_node()) {
+		base_ptr candidate = nullptr;
+		parent_ptr = end_node();
+		insert_left = true;
+		while (node_ptr != nullptr) {
 			parent_ptr = node_ptr;
-			
-			if (Is_Unique && node_ptr != nil_node() && (!key_compare(new_node, node_ptr) && !key_compare(node_ptr, new_node))) {
-				destroy_node(static_cast<link_type>(new_node));
-				return std::pair<iterator, bool>(iterator(node_ptr, nil_node(), root()), false);
-			}
-			if (key_compare(new_node, node_ptr))
+			insert_left = comp(key, __key(node_ptr));
+			if (insert_left) {
 				node_ptr = node_ptr->left;
-			else
+			} else {
+				candidate = node_ptr;
 				node_ptr = node_ptr->right;
+			}
 		}
-		
-		new_node->parent = parent_ptr;
-		if (parent_ptr == nil_node())
-			set_root(new_node);
-		else if (key_compare(new_node, parent_ptr))
-			parent_ptr->left = new_node;
-		else
-			parent_ptr->right = new_node;
 
-		if (leftmost() == nil_node() || key_compare(new_node, leftmost()))
-			set_leftmost(new_node);
-		if (rightmost() == nil_node() || key_compare(rightmost(), new_node))
-			set_rightmost(new_node);
+		if (candidate != nullptr && !comp(__key(candidate), key))
+			return candidate;
+		return nullptr;
+	}
 
-		__insert_fixup(new_node);
-		++node_size;
-		return std::pair<iterator, bool>(iterator(new_node, nil_node(), root()), true);
-	}
-
-	void __insert_fixup(base_ptr node_ptr) {
-		while (node_ptr->parent->color == __RED) {
-			if (node_ptr->parent == node_ptr->parent->parent->left) {
-				base_ptr parnet_ptr = node_ptr->parent;
-				base_ptr uncle_ptr = parnet_ptr->parent->right;
-				if (uncle_ptr->color == __RED) {
-					uncle_ptr->color = __BLACK;
-					node_ptr->color = __BLACK;
-					node_ptr->parent->color = __RED;
-					node_ptr = parnet_ptr->parent;
+	/* 与 __insert_hint_node 相同的提示规则, 只是比较的对象换成 key */
+	base_ptr __unique_hint_pos(const_iterator hint, Key const &key, base_ptr &parent_ptr, bool &insert_left) {
+		base_ptr pos = hint.node;
+		if (pos == end_node()) {
+			if (node_size != 0 && comp(__key(rightmost()), key)) {
+				parent_ptr = rightmost();
+				insert_left = false;
+				return nullptr;
+			}
+			return __unique_pos(key, parent_ptr, insert_left);
+		}
+
+		if (comp(key, __key(pos))) {
+			if (pos == leftmost()) {
+				parent_ptr = pos;
+				insert_left = true;
+				return nullptr;
+			}
+
+			iterator before = transform_iterator(hint);
+			--before;
+			if (!comp(__key(before.node), key))
+				return __unique_pos(key, parent_ptr, insert_left);
+			insert_left = before.node->right != nullptr;
+			parent_ptr = insert_left ? pos : before.node;
+			return nullptr;
+		}
+
+		if (comp(__key(pos), key)) {
+			if (pos == rightmost()) {
+				parent_ptr = pos;
+				insert_left = false;
+				return nullptr;
+			}
+
+			iterator after = transform_iterator(hint);
+			++after;
+			if (!comp(key, __key(after.node)))
+				return __unique_pos(key, parent_ptr, insert_left);
+			insert_left = pos->right != nullptr;
+			parent_ptr = insert_left ? after.node : pos;
+			return nullptr;
+		}
+
+		return pos;
+	}
+
+	/* 位置已经确定, key 不存在时才构造结点; args 构造出的元素的 key 必须与查找用的 key 相等 */
+	template<typename... Args>
+	std::pair<iterator, bool> __emplace_at(base_ptr existing, base_ptr parent_ptr, bool insert_left, Args&&... args) {
+		if (existing != nullptr)
+			return std::pair<iterator, bool>(iterator(existing), false);
+
+		base_ptr new_node = create_node(std::forward<Args>(args)...);
+		return std::pair<iterator, bool>(__link(new_node, parent_ptr, insert_left), true);
+	}
+
+	/* 根结点的父结点是红色的头结点, 所以循环条件要先排除根结点; 返回 true 表示根由红染黑, 整棵树的黑高加一 */
+	bool __insert_fixup(base_ptr node_ptr) noexcept {
+		while (!__is_root(node_ptr) && node_ptr->parent()->is_red()) {
+			base_ptr parent_ptr = node_ptr->parent();
+			base_ptr grand_ptr = parent_ptr->parent();
+			if (parent_ptr == grand_ptr->left) {
+				base_ptr uncle_ptr = grand_ptr->right;
+				if (!__is_black(uncle_ptr)) {
+					uncle_ptr->set_color(__BLACK);
+					parent_ptr->set_color(__BLACK);
+					grand_ptr->set_color(__RED);
+					node_ptr = grand_ptr;
 				} else {
-					if (node_ptr == parnet_ptr->right) {
-						node_ptr = parnet_ptr;
+					if (node_ptr == parent_ptr->right) {
+						node_ptr = parent_ptr;
 						left_rotate(node_ptr);
-						parnet_ptr = node_ptr->parent;
+						parent_ptr = node_ptr->parent();
 					}
-					parnet_ptr->color = __BLACK;
-					parnet_ptr->parent->color = __RED;	
-					right_rotate(parnet_ptr->parent);
+					parent_ptr->set_color(__BLACK);
+					grand_ptr->set_color(__RED);
+					right_rotate(grand_ptr);
 				}
 			} else {
-				base_ptr parent_ptr = node_ptr->parent;
-				base_ptr uncle_ptr = parent_ptr->left;
-				if (uncle_ptr->color == __RED) {
-					uncle_ptr->color = __BLACK;
-					parent_ptr->color = __BLACK;
-					parent_ptr->parent->color = __RED;
-					node_ptr = parent_ptr->parent;
+				base_ptr uncle_ptr = grand_ptr->left;
+				if (!__is_black(uncle_ptr)) {
+					uncle_ptr->set_color(__BLACK);
+					parent_ptr->set_color(__BLACK);
+					grand_ptr->set_color(__RED);
+					node_ptr = grand_ptr;
 				} else {
 					if (node_ptr == parent_ptr->left) {
 						node_ptr = parent_ptr;
 						right_rotate(node_ptr);
-						parent_ptr = node_ptr->parent;
+						parent_ptr = node_ptr->parent();
 					}
-					parent_ptr->color = __BLACK;
-					parent_ptr->parent->color = __RED;
-					left_rotate(parent_ptr->parent);
+					parent_ptr->set_color(__BLACK);
+					grand_ptr->set_color(__RED);
+					left_rotate(grand_ptr);
 				}
 			}
 		}
-		root()->color = __BLACK;
-	}
-
-	void tranfers(base_ptr node, base_ptr replace) {
-		replace->parent = node->parent;
-		if (node->parent == nil_node())
-			set_root(replace);
-		else if (node == node->parent->left)
-			node->parent->left = replace;
-		else
-			node->parent->right = replace;
-	}
-
-	base_ptr minimun(base_ptr node) {
-		return __rbtree_node_base::minimun(node, nil_node());
-	}
-
-	base_ptr maxinum(base_ptr node) {
-		return __rbtree_node_base::maximun(node, nil_node());
+		/* 只有向上染色走到根时根才会变红 */
+		if (__is_root(node_ptr) && node_ptr->is_red()) {
+			node_ptr->set_color(__BLACK);
+			return true;
+		}
+		return false;
 	}
 
-	void remove_fixup(base_ptr node) {
+	/* node 可能是空叶子, 所以由调用者给出它的父结点 */
+	void remove_fixup(base_ptr node, base_ptr parent_ptr) noexcept {
 		base_ptr brother;
-		while (node != root() && node->color == __BLACK) {
-			if (node == node->parent->left) {
-				brother = node->parent->right;
-				if (brother->color == __RED) {
-					brother->color = __BLACK;
-					node->parent->color = __RED;
-					left_rotate(node->parent);
-					brother = node->parent->right;
+		while (node != root() && __is_black(node)) {
+			if (node == parent_ptr->left) {
+				brother = parent_ptr->right;
+				if (brother->is_red()) {
+					brother->set_color(__BLACK);
+					parent_ptr->set_color(__RED);
+					left_rotate(parent_ptr);
+					brother = parent_ptr->right;
 				}
-				if (brother->left->color == __BLACK && brother->right->color == __BLACK) {
-					brother->color = __RED;
-					node = node->parent;
+				if (__is_black(brother->left) && __is_black(brother->right)) {
+					brother->set_color(__RED);
+					node = parent_ptr;
+					parent_ptr = parent_ptr->parent();
 				} else {
-					if (brother->right->color == __BLACK) {
-						brother->left->color = __BLACK;
-						brother->color = __RED;
-						left_rotate(brother);
-						brother = node->parent->right;
+					if (__is_black(brother->right)) {
+						brother->left->set_color(__BLACK);
+						brother->set_color(__RED);
+						right_rotate(brother);
+						brother = parent_ptr->right;
 					}
-					brother->color = node->parent->color;
-					brother->right->color = __BLACK;
-					node->parent->color = __BLACK;
+					brother->set_color(parent_ptr->color());
+					brother->right->set_color(__BLACK);
+					parent_ptr->set_color(__BLACK);
+					left_rotate(parent_ptr);
 					node = root();
 				}
 			} else {
-				brother = node->parent->left;
-				if (brother->color == __RED) {
-					brother->color = __BLACK;
-					node->parent->color = __RED;
-					right_rotate(node->parent);
-					brother = node->parent->left;
+				brother = parent_ptr->left;
+				if (brother->is_red()) {
+					brother->set_color(__BLACK);
+					parent_ptr->set_color(__RED);
+					right_rotate(parent_ptr);
+					brother = parent_ptr->left;
 				}
-				if (brother->left->color == __BLACK && brother->right->color == __BLACK) {
-					brother->color = __RED;
-					node = node->parent;
+				if (__is_black(brother->left) && __is_black(brother->right)) {
+					brother->set_color(__RED);
+					node = parent_ptr;
+					parent_ptr = parent_ptr->parent();
 				} else {
-					if (brother->left->color == __BLACK) {
-						brother->right->color = __BLACK;
-						brother->color = __RED;
+					if (__is_black(brother->left)) {
+						brother->right->set_color(__BLACK);
+						brother->set_color(__RED);
 						left_rotate(brother);
-						brother = node->parent->left;
+						brother = parent_ptr->left;
 					}
-					brother->color = node->parent->color;
-					brother->left->color = __BLACK;
-					node->parent->color = __BLACK;
+					brother->set_color(parent_ptr->color());
+					brother->left->set_color(__BLACK);
+					parent_ptr->set_color(__BLACK);
+					right_rotate(parent_ptr);
 					node = root();
 				}
 			}
 		}
-		node->color = __BLACK;
-	}
+		if (node != nullptr)
+			node->set_color(__BLACK);
+	}
+
+	/* 把结点从树中摘下但不销毁, 其他结点只重新链接不移动 */
+	void __unlink(base_ptr node) noexcept {
+		if (node_size == 1) {
+			set_leftmost(end_node());
+			set_rightmost(end_node());
+		} else if (node == leftmost()) {
+			iterator next(node);
+			++next;
+			set_leftmost(next.node);
+		} else if (node == rightmost()) {
+			iterator prev(node);
+			--prev;
+			set_rightmost(prev.node);
+		}
 
-	iterator remove(iterator position) {
-		base_ptr node = position.node;
-		base_ptr origin_node = node;
-		rb_tree_color origin_color = origin_node->color;
+		rb_tree_color origin_color = node->color();
 		base_ptr tranfers_node;
+		base_ptr tranfers_parent;
 
-		if (node->left == nil_node()) {
+		if (node->left == nullptr) {
 			tranfers_node = node->right;
+			tranfers_parent = node->parent();
 			tranfers(node, node->right);
 		}
-		else if (node->right == nil_node()) {
+		else if (node->right == nullptr) {
 			tranfers_node = node->left;
+			tranfers_parent = node->parent();
 			tranfers(node, node->left);
 		}
 		else {
-			origin_node = minimun(node->right);
-			origin_color = origin_node->color;
+			base_ptr origin_node = __rbtree_node_base::minimun(node->right);
+			origin_color = origin_node->color();
 			tranfers_node = origin_node->right;
-			if (origin_node->parent == node)
-				tranfers_node->parent = node;
-			else {
+			if (origin_node->parent() == node) {
+				tranfers_parent = origin_node;
+			} else {
+				tranfers_parent = origin_node->parent();
 				tranfers(origin_node, tranfers_node);
 				origin_node->right = node->right;
-				origin_node->right->parent = origin_node;
+				origin_node->right->set_parent(origin_node);
 			}
 			tranfers(node, origin_node);
 			origin_node->left = node->left;
-			origin_node->color = node->color;
-			origin_node->left->parent = origin_node;
-		}
-
-		if (--node_size == 0) {
-			set_leftmost(nil_node());
-			set_rightmost(nil_node());
-		} else if (node_size != 0 && node == leftmost() && node == rightmost()) {
-			iterator new_leftmost = position;
-			++new_leftmost;
-			set_leftmost(new_leftmost.node);
-			set_rightmost(new_leftmost.node);
-		} else {
-			if (node_size != 0 && node == leftmost())
-				set_leftmost((position++).node);
-
-			if (node_size != 0 && node == rightmost())
-				set_rightmost((position--).node);
+			origin_node->left->set_parent(origin_node);
+			origin_node->set_color(node->color());
 		}
 
+		/* 先把附加信息修正到根, 之后 remove_fixup 的旋转会各自维护 */
+		__update_to_root(tranfers_parent);
 		if (origin_color == __BLACK)
-			remove_fixup(tranfers_node);
+			remove_fixup(tranfers_node, tranfers_parent);
 
-		++position;
-		destroy_node(static_cast<link_type>(node));
-		return position;
+		--node_size;
 	}
 
-	void __destroy(base_ptr node) {
-		if (node == nil_node())
+	iterator remove(iterator position) {
+		iterator next = position;
+		++next;
+		__unlink(position.node);
+		destroy_node(static_cast<link_type>(position.node));
+		return next;
+	}
+
+	static void __destroy(base_ptr node) noexcept {
+		if (node == nullptr)
 			return;
 		__destroy(node->left);
 		__destroy(node->right);
 		destroy_node(static_cast<link_type>(node));
 	}
 
-	iterator __upper_bound_aux(key_type const &key, iterator start) {
-		KeyOfValue key_of_value;
-		while (start != end()
-			&& (!comp(key, key_of_value(static_cast<link_type>(start.node)->data))
-				&& !comp(KeyOfValue()(static_cast<link_type>(start.node)->data), key))) {
-			++start;
+	/* 复制单个结点的元素, 颜色和附加信息, 子结点由调用者链接 */
+	static base_ptr __clone_node(base_ptr source, base_ptr parent) {
+		link_type node = create_node(static_cast<link_type>(source)->data);
+		node->parent_color = source->parent_color;
+		node->set_parent(parent);
+		node->left = node->right = nullptr;
+		if constexpr (is_augmented)
+			node->meta = static_cast<link_type>(source)->meta;
+		return node;
+	}
+
+	/*
+	 * 按先序照搬 source 子树的形状, 不比较 key 也不做调整, O(n).
+	 * 结点按先序分配, 父子结点在内存中相邻的概率更大
+	 */
+	static base_ptr __copy(base_ptr source, base_ptr parent) {
+		if (source == nullptr)
+			return nullptr;
+		base_ptr node = __clone_node(source, parent);
+		try {
+			node->left = __copy(source->left, node);
+			node->right = __copy(source->right, node);
+		} catch (...) {
+			__destroy(node);
+			throw;
+		}
+		return node;
+	}
+
+	/* 按 key 排好序的结点自底向上建成平衡树, 只有最深一层染红, 所有路径黑高相同 */
+	base_ptr __build_balanced(base_ptr *nodes, size_type count, base_ptr parent,
+			size_type depth, size_type red_depth) noexcept {
+		if (count == 0)
+			return nullptr;
+
+		size_type mid = count / 2;
+		base_ptr node = nodes[mid];
+		node->parent_color = 0;
+		node->set_parent(parent);
+		node->set_color(depth == red_depth ? __RED : __BLACK);
+		node->left = __build_balanced(nodes, mid, node, depth + 1, red_depth);
+		node->right = __build_balanced(nodes + mid + 1, count - mid - 1, node, depth + 1, red_depth);
+		__update(node);
+		return node;
+	}
+
+	/*
+	 * 空树批量建树: 先构造出所有结点, 边构造边检查是否有序; 无序时稳定排序一次,
+	 * 唯一插入保留相同 key 中最先出现的元素, 最后 O(n) 建树, 不需要逐个插入和旋转.
+	 * sorted 为 true 时由调用者保证有序 (唯一插入时还要保证没有重复), 不再比较
+	 */
+	template<bool IsUnique, typename InputIterator>
+	void __build_from(InputIterator first, InputIterator last, bool sorted) {
+		if (first == last)
+			return;
+
+		sx::vector<base_ptr> nodes;
+		if constexpr (sx::is_forward_iterator_v<InputIterator>)
+			nodes.reserve(sx::distance(first, last));
+
+		auto node_compare = [this](base_ptr lhs, base_ptr rhs) {
+			return key_compare(lhs, rhs);
+		};
+
+		size_type count = 0;
+		try {
+			bool ordered = true;
+			for (; first != last; ++first) {
+				nodes.push_back(nullptr);
+				nodes[count] = create_node(*first);
+				if (!sorted && ordered && count != 0) {
+					if (key_compare(nodes[count], nodes[count - 1])) {
+						ordered = false;
+					} else if (IsUnique && !key_compare(nodes[count - 1], nodes[count])) {
+						destroy_node(static_cast<link_type>(nodes[count]));
+						nodes.pop_back();
+						continue;
+					}
+				}
+				++count;
+			}
+
+			if (!ordered) {
+				std::stable_sort(nodes.begin(), nodes.end(), node_compare);
+				if (IsUnique) {
+					size_type unique_count = 1;
+					for (size_type i = 1; i < count; ++i) {
+						base_ptr node = nodes[i];
+						nodes[i] = nullptr;
+						if (key_compare(nodes[unique_count - 1], node))
+							nodes[unique_count++] = node;
+						else
+							destroy_node(static_cast<link_type>(node));
+					}
+					count = unique_count;
+				}
+			}
+		} catch (...) {
+			for (base_ptr node : nodes) {
+				if (node != nullptr)
+					destroy_node(static_cast<link_type>(node));
+			}
+			throw;
 		}
-		return start;
+
+		if (count == 0)
+			return;
+		__link_balanced(nodes.begin(), count);
+	}
+
+	/* 用按 key 排好序的 count 个结点替换整棵树, 调用者已释放或接管原来的结点 */
+	void __link_balanced(base_ptr *nodes, size_type count) noexcept {
+		size_type red_depth = 0;
+		for (size_type n = count; n > 1; n >>= 1)
+			++red_depth;
+
+		set_root(__build_balanced(nodes, count, end_node(), 0, red_depth));
+		root()->set_color(__BLACK);
+		set_leftmost(nodes[0]);
+		set_rightmost(nodes[count - 1]);
+		node_size = count;
 	}
 public:
 	rbtree() {
@@ -557,8 +1094,13 @@ public:
 		empty_initialize();
 	}
 
-	rbtree(rbtree const &other) : rbtree() {
-		insert_equal(other.begin(), other.end());
+	rbtree(rbtree const &other) : rbtree(other.comp) {
+		if (other.root() == nullptr)
+			return;
+		set_root(__copy(other.root(), end_node()));
+		set_leftmost(__rbtree_node_base::minimun(root()));
+		set_rightmost(__rbtree_node_base::maximun(root()));
+		node_size = other.node_size;
 	}
 
 	rbtree(rbtree &&other) noexcept : rbtree() {
@@ -581,15 +1123,14 @@ public:
 
 	~rbtree() {
 		clear();
-		allocator.deallocate(static_cast<link_type>(nil), sizeof(link_type));
 	}
 public:
 	iterator begin() noexcept {
-		return iterator(leftmost(), nil_node(), root());
+		return iterator(leftmost());
 	}
 
 	iterator end() noexcept {
-		return iterator(nil_node(), nil_node(), root());
+		return iterator(end_node());
 	}
 
 	const_iterator begin() const noexcept {
@@ -609,27 +1150,76 @@ public:
 		return transform_const_iterator(const_cast<rbtree *>(this)->end());
 	}
 
+	/* 先按 key 查找, 已有相同 key 时不会分配结点 */
 	std::pair<iterator, bool> insert_unique(Value const &value) {
-		return __insert<true>(value);
+		return try_emplace_unique(KeyOfValue()(value), value);
 	}
 
+	/* 空树时走批量建树, 已有元素时以 end() 为提示逐个插入, 有序追加时每次 O(1) */
 	template<typename InputIterator, 
 		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator> 
 		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
 	void insert_unique(InputIterator first, InputIterator last) {
-		InputIterator iter = first;
-		try {
-			for ( ;iter != last; ++iter)
-				insert_unique(*iter);
-		} catch (...) {
-			for (; first != iter; ++first)
-				erase(KeyOfValue()(*first));
+		if (empty()) {
+			__build_from<true>(first, last, false);
+			return;
 		}
+
+		for ( ;first != last; ++first)
+			insert_unique(cend(), *first);
+	}
+
+	/* 调用者保证 [first, last) 按 key 严格递增 */
+	template<typename InputIterator, 
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator> 
+		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
+	void insert_unique(sx::sorted_unique_t, InputIterator first, InputIterator last) {
+		if (empty())
+			__build_from<true>(first, last, true);
+		else
+			insert_unique(first, last);
 	}
 
+	/* 参数恰好是一个元素时可以直接取出 key 先查找, 否则只能先构造结点 */
 	template<typename... Args>
 	std::pair<iterator, bool> emplace_unique(Args&&... args) {
-		return __insert<true>(std::forward<Args>(args)...);
+		if constexpr (sizeof...(Args) == 1 && (std::is_same_v<std::decay_t<Args>, Value> && ...))
+			return try_emplace_unique(KeyOfValue()(args)..., std::forward<Args>(args)...);
+		else
+			return __insert<true>(std::forward<Args>(args)...);
+	}
+
+	/* hint 指向新元素应该插入的位置之后的元素时最快 */
+	std::pair<iterator, bool> insert_unique(const_iterator hint, Value const &value) {
+		return try_emplace_hint_unique(hint, KeyOfValue()(value), value);
+	}
+
+	template<typename... Args>
+	std::pair<iterator, bool> emplace_hint_unique(const_iterator hint, Args&&... args) {
+		if constexpr (sizeof...(Args) == 1 && (std::is_same_v<std::decay_t<Args>, Value> && ...))
+			return try_emplace_hint_unique(hint, KeyOfValue()(args)..., std::forward<Args>(args)...);
+		else
+			return __insert_hint<true>(hint, std::forward<Args>(args)...);
+	}
+
+	/* 
+	 * key 不存在时才用 args 构造结点, 已存在时 args 不会被使用 (右值也不会被移走).
+	 * 调用者保证 args 构造出的元素的 key 与 key 相等; key 可以引用 args 中的对象, 查找在构造之前完成
+	 */
+	template<typename... Args>
+	std::pair<iterator, bool> try_emplace_unique(Key const &key, Args&&... args) {
+		base_ptr parent_ptr = nullptr;
+		bool insert_left = false;
+		base_ptr existing = __unique_pos(key, parent_ptr, insert_left);
+		return __emplace_at(existing, parent_ptr, insert_left, std::forward<Args>(args)...);
+	}
+
+	template<typename... Args>
+	std::pair<iterator, bool> try_emplace_hint_unique(const_iterator hint, Key const &key, Args&&... args) {
+		base_ptr parent_ptr = nullptr;
+		bool insert_left = false;
+		base_ptr existing = __unique_hint_pos(hint, key, parent_ptr, insert_left);
+		return __emplace_at(existing, parent_ptr, insert_left, std::forward<Args>(args)...);
 	}
 
 	iterator insert_equal(Value const &value) {
@@ -641,14 +1231,24 @@ public:
 		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
 		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
 	void insert_equal(InputIterator first, InputIterator last) {
-		InputIterator iter = first;
-		try {
-			for (; iter != last; ++iter)
-				insert_equal(*iter);
-		} catch (...) {
-			for (; first != iter; ++first)
-				erase(KeyOfValue()(*first));
+		if (empty()) {
+			__build_from<false>(first, last, false);
+			return;
 		}
+
+		for (; first != last; ++first)
+			insert_equal(cend(), *first);
+	}
+
+	/* 调用者保证 [first, last) 按 key 非递减 */
+	template<typename InputIterator,
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
+		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
+	void insert_equal(sx::sorted_equivalent_t, InputIterator first, InputIterator last) {
+		if (empty())
+			__build_from<false>(first, last, true);
+		else
+			insert_equal(first, last);
 	}
 
 	template<typename... Args>
@@ -656,7 +1256,95 @@ public:
 		std::pair<iterator, bool> ret = __insert<false>(std::forward<Args>(args)...);
 		return ret.first;
 	}
+
+	iterator insert_equal(const_iterator hint, Value const &value) {
+		return __insert_hint<false>(hint, value).first;
+	}
+
+	template<typename... Args>
+	iterator emplace_hint_equal(const_iterator hint, Args&&... args) {
+		return __insert_hint<false>(hint, std::forward<Args>(args)...).first;
+	}
 	
+	/* 把结点摘下交给句柄, 不释放也不移动元素 */
+	node_type extract(const_iterator position) {
+		__unlink(position.node);
+		return node_type(static_cast<link_type>(position.node));
+	}
+
+	/* 摘下第一个与 key 相等的结点, 不存在时返回空句柄 */
+	node_type extract(Key const &key) {
+		iterator position = lower_bound(key);
+		if (position == end() || comp(key, KeyOfValue()(*position)))
+			return node_type();
+		return extract(position);
+	}
+
+	/* 已有相同 key 时句柄原样交还给 node */
+	insert_return_type insert_unique(node_type &&handle) {
+		if (handle.empty())
+			return insert_return_type{ end(), false, node_type() };
+
+		base_ptr parent_ptr = nullptr;
+		bool insert_left = false;
+		base_ptr existing = __unique_pos(__key(handle.ptr), parent_ptr, insert_left);
+		if (existing != nullptr)
+			return insert_return_type{ iterator(existing), false, std::move(handle) };
+		return insert_return_type{ __link(handle.release(), parent_ptr, insert_left), true, node_type() };
+	}
+
+	/* 插入失败时句柄保持不变 */
+	iterator insert_unique(const_iterator hint, node_type &&handle) {
+		if (handle.empty())
+			return end();
+
+		base_ptr parent_ptr = nullptr;
+		bool insert_left = false;
+		base_ptr existing = __unique_hint_pos(hint, __key(handle.ptr), parent_ptr, insert_left);
+		if (existing != nullptr)
+			return iterator(existing);
+		return __link(handle.release(), parent_ptr, insert_left);
+	}
+
+	iterator insert_equal(node_type &&handle) {
+		if (handle.empty())
+			return end();
+		return __insert_node<false>(handle.release()).first;
+	}
+
+	iterator insert_equal(const_iterator hint, node_type &&handle) {
+		if (handle.empty())
+			return end();
+		return __insert_hint_node<false>(hint, handle.release()).first;
+	}
+
+	/* 把 other 中 key 不重复的结点逐个摘下挂到本树, 重复的留在 other 中; 不分配也不拷贝元素 */
+	template<typename OtherKeyOfValue, typename OtherCompare>
+	void merge_unique(rbtree<Key, Value, OtherKeyOfValue, OtherCompare, Alloc, NodeUpdate> &other) {
+		if (static_cast<void *>(&other) == static_cast<void *>(this))
+			return;
+
+		for (auto first = other.begin(); first != other.end(); ) {
+			auto position = first++;
+			base_ptr parent_ptr = nullptr;
+			bool insert_left = false;
+			if (__unique_pos(KeyOfValue()(*position), parent_ptr, insert_left) == nullptr)
+				__link(other.extract(position).release(), parent_ptr, insert_left);
+		}
+	}
+
+	/* 相同 key 的结点挂在已有元素之后 */
+	template<typename OtherKeyOfValue, typename OtherCompare>
+	void merge_equal(rbtree<Key, Value, OtherKeyOfValue, OtherCompare, Alloc, NodeUpdate> &other) {
+		if (static_cast<void *>(&other) == static_cast<void *>(this))
+			return;
+
+		for (auto first = other.begin(); first != other.end(); ) {
+			auto position = first++;
+			__insert_node<false>(other.extract(position).release());
+		}
+	}
+
 	size_type size() const noexcept {
 		return node_size;
 	}
@@ -665,33 +1353,107 @@ public:
 		return size() == 0;
 	}
 
+	Compare key_comp() const {
+		return comp;
+	}
+
 	void clear() {
 		__destroy(root());
-		allocator.deallocate(nil_node(), sizeof(link_type));
 		empty_initialize();
 	}
 
+	/*
+	 * 把所有元素按中序搬到一段连续内存的新结点中, 重新链接成平衡树, 再释放旧结点.
+	 * 长期插入删除之后结点散落在内存池各处, 压缩后顺序遍历基本是顺序访存, 树高也回到最小.
+	 * 分配器给不出连续内存时逐个分配新结点. 元素被移动 (移动构造可能抛出时复制),
+	 * 所有迭代器, 指针和引用都失效; 抛出异常时树保持原样
+	 */
+	void compact() {
+		if (node_size == 0)
+			return;
+
+		sx::vector<base_ptr> nodes;
+		nodes.reserve(node_size);
+		link_type block = allocator.allocate_contiguous(node_size);
+		size_type built = 0;
+		try {
+			for (size_type i = 0; i < node_size; ++i)
+				nodes.push_back(block != nullptr ? block + i : get_node());
+			for (iterator iter = begin(); iter != end(); ++iter, ++built)
+				allocator.construct(static_cast<link_type>(nodes[built]), std::move_if_noexcept(*iter));
+		} catch (...) {
+			for (size_type i = 0; i < nodes.size(); ++i) {
+				if (i < built)
+					allocator.destroy(static_cast<link_type>(nodes[i]));
+				put_node(static_cast<link_type>(nodes[i]));
+			}
+			throw;
+		}
+
+		size_type count = node_size;
+		__destroy(root());
+		__link_balanced(nodes.begin(), count);
+	}
+
 	iterator find(Key const &key) {
-		base_ptr node = root();
-		KeyOfValue key_of_value;
+		return __find(key);
+	}
 
-		while (node != nil_node()) {
-			bool test1 = comp(key, key_of_value(static_cast<link_type>(node)->data));
-			bool test2 = comp(key_of_value(static_cast<link_type>(node)->data), key);
+	const_iterator find(Key const &key) const {
+		return transform_const_iterator(const_cast<rbtree *>(this)->__find(key));
+	}
 
-			if (!test1 && !test2)
-				break;
-			else if (test1)
-				node = node->left;
-			else
-				node = node->right;
-		}
-		return iterator(node, nil_node(), root());
+	/* 比较器声明了 is_transparent 时, 可以用任何能与 Key 比较的类型查找, 不需要先构造 Key */
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	iterator find(K const &key) {
+		return __find(key);
 	}
 
-	const_iterator find(Key const &value) const {
-		iterator ret = (const_cast<rbtree *>(this)->find(value));
-		return const_iterator(ret.node, nil_node(), root());
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator find(K const &key) const {
+		return transform_const_iterator(const_cast<rbtree *>(this)->__find(key));
+	}
+
+	/*
+	 * 从 hint 向后查找 (finger search): hint 的 key 小于 key 时先向上走到能覆盖 key 的子树再下降,
+	 * 顺着上一次的结果查找相近的 key 时比从根开始少走很多层; 否则从根开始查找
+	 */
+	iterator find(const_iterator hint, Key const &key) {
+		iterator position = __lower_bound(hint, key);
+		if (position.node == end_node() || comp(key, __key(position.node)))
+			return end();
+		return position;
+	}
+
+	const_iterator find(const_iterator hint, Key const &key) const {
+		return transform_const_iterator(const_cast<rbtree *>(this)->find(hint, key));
+	}
+
+	iterator lower_bound(const_iterator hint, Key const &key) {
+		return __lower_bound(hint, key);
+	}
+
+	const_iterator lower_bound(const_iterator hint, Key const &key) const {
+		return transform_const_iterator(const_cast<rbtree *>(this)->__lower_bound(hint, key));
+	}
+
+	/* 调用者保证 [first, last) 按 key 非递减, 每个 key 的查找结果 (找不到时为 end()) 依次写入 out */
+	template<typename InputIterator, typename OutputIterator>
+	OutputIterator find_batch(InputIterator first, InputIterator last, OutputIterator out) {
+		__find_batch(first, last, [&out](base_ptr node) {
+			*out = iterator(node);
+			++out;
+		});
+		return out;
+	}
+
+	template<typename InputIterator, typename OutputIterator>
+	OutputIterator find_batch(InputIterator first, InputIterator last, OutputIterator out) const {
+		const_cast<rbtree *>(this)->__find_batch(first, last, [&out](base_ptr node) {
+			*out = const_iterator(node);
+			++out;
+		});
+		return out;
 	}
 
 	iterator erase(iterator position) {
@@ -705,30 +1467,26 @@ public:
 	}
 
 	const_iterator erase(const_iterator first, const_iterator last) {
-		const_iterator ret;
 		while (first != last)
-			ret = erase(first++);
-		return ret;
+			erase(first++);
+		return last;
 	}
 
-	size_type erase(Key const &key) {			
-		std::pair<const_iterator, const_iterator> range = const_cast<rbtree const *>(this)->equal_range(key);
-		size_type cnt = 0;
-
-		while (range.first != range.second) {
-			++cnt;
-			erase(range.first++);
-		}
+	size_type erase(Key const &key) {
+		return __erase(key);
+	}
 
-		return cnt;
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	size_type erase(K const &key) {
+		return __erase(key);
 	}
 
 	iterator min() {
-		return iterator(leftmost(), nil_node(), root());
+		return iterator(leftmost());
 	}
 
 	iterator max() {
-		return iterator(rightmost(), nil_node(), root());
+		return iterator(rightmost());
 	}
 
 	const_iterator min() const noexcept {
@@ -739,9 +1497,8 @@ public:
 		return transform_const_iterator(const_cast<rbtree *>(this)->max());
 	}
 
-	std::pair<iterator, iterator> equal_range(Key const &key) {		
-		iterator first = lower_bound(key);
-		return std::pair<iterator, iterator>(first, __upper_bound_aux(key, first));
+	std::pair<iterator, iterator> equal_range(Key const &key) {
+		return std::pair<iterator, iterator>(__lower_bound(key), __upper_bound(key));
 	}
 
 	std::pair<const_iterator, const_iterator> equal_range(Key const &key) const {
@@ -750,87 +1507,642 @@ public:
 														 transform_const_iterator(ret.second));
 	}
 
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	std::pair<iterator, iterator> equal_range(K const &key) {
+		return std::pair<iterator, iterator>(__lower_bound(key), __upper_bound(key));
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	std::pair<const_iterator, const_iterator> equal_range(K const &key) const {
+		std::pair<iterator, iterator> ret = const_cast<rbtree *>(this)->equal_range(key);
+		return std::pair<const_iterator, const_iterator>(transform_const_iterator(ret.first), 
+														 transform_const_iterator(ret.second));
+	}
+
 	iterator lower_bound(Key const &key) {
-		base_ptr old_pos = nil_node();
-		base_ptr node = root();
-		KeyOfValue key_of_value;
+		return __lower_bound(key);
+	}
 
-		while (node != nil_node()) {
-			bool test1 = comp(key, key_of_value(static_cast<link_type>(node)->data));
-			bool test2 = comp(key_of_value(static_cast<link_type>(node)->data), key);
-			if (!test1 && !test2) {
-				old_pos = node;
-				node = node->left;
-			} else if (test1)
+	const_iterator lower_bound(Key const &key) const {
+		return transform_const_iterator(const_cast<rbtree *>(this)->__lower_bound(key));
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	iterator lower_bound(K const &key) {
+		return __lower_bound(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator lower_bound(K const &key) const {
+		return transform_const_iterator(const_cast<rbtree *>(this)->__lower_bound(key));
+	}
+
+	iterator upper_bound(Key const &key) {
+		return __upper_bound(key);
+	}
+
+	const_iterator upper_bound(Key const &key) const {
+		return transform_const_iterator(const_cast<rbtree *>(this)->__upper_bound(key));
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	iterator upper_bound(K const &key) {
+		return __upper_bound(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator upper_bound(K const &key) const {
+		return transform_const_iterator(const_cast<rbtree *>(this)->__upper_bound(key));
+	}
+
+	size_type count(Key const &key) const {
+		return __count(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	size_type count(K const &key) const {
+		return __count(key);
+	}
+
+	/* 第 k 小的元素 (从 0 开始), k 不小于 size() 时返回 end(); 需要 rbtree_order_statistics */
+	iterator nth(size_type k) noexcept {
+		static_assert(is_order_statistics, "nth requires sx::rbtree_order_statistics");
+		if (k >= node_size)
+			return end();
+
+		base_ptr node = root();
+		for (;;) {
+			size_type left_size = __subtree_size(node->left);
+			if (k < left_size) {
 				node = node->left;
-			else
+			} else if (k == left_size) {
+				return iterator(node);
+			} else {
+				k -= left_size + 1;
 				node = node->right;
+			}
 		}
+	}
 
-		return iterator(old_pos, nil_node(), root());
+	const_iterator nth(size_type k) const noexcept {
+		return transform_const_iterator(const_cast<rbtree *>(this)->nth(k));
 	}
 
-	const_iterator lower_bound(Key const key) const {
-		return transform_const_iterator(const_cast<rbtree *>(this)->lower_bound(key));
+	/* 小于 key 的元素个数, 即 lower_bound(key) 的下标 */
+	size_type rank(Key const &key) const {
+		return __rank<false>(key);
 	}
 
-	iterator upper_bound(Key const &key) {
-		base_ptr old_pos = nil_node();
-		base_ptr node = root();
-		KeyOfValue key_of_value;
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	size_type rank(K const &key) const {
+		return __rank<false>(key);
+	}
+
+	/* 落在 [first_key, last_key) 中的元素个数 */
+	size_type count_range(Key const &first_key, Key const &last_key) const {
+		return __count_range(first_key, last_key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	size_type count_range(K const &first_key, K const &last_key) const {
+		return __count_range(first_key, last_key);
+	}
+
+	/* 所有元素折叠的结果, O(1), 空树时返回 identity(); 需要 rbtree_monoid_update */
+	metadata_type aggregate() const {
+		static_assert(is_monoid, "aggregate requires sx::rbtree_monoid_update");
+		if (empty())
+			return NodeUpdate::monoid_type::identity();
+		return __meta(const_cast<rbtree *>(this)->root());
+	}
+
+	/* [first_key, last_key) 中的元素按顺序折叠, O(log n), 区间为空时返回 identity() */
+	metadata_type aggregate(Key const &first_key, Key const &last_key) const {
+		static_assert(is_monoid, "aggregate requires sx::rbtree_monoid_update");
+		return __fold(const_cast<rbtree *>(this)->root(), &first_key, &last_key);
+	}
+
+	/*
+	 * 按附加信息剪枝的中序遍历: prune(子树的 meta) 为 true 的子树整体跳过;
+	 * stop(元素) 为 true 时该结点之后的元素都不再访问; 其余结点的迭代器交给 visit.
+	 * 区间树之类的查找用它做到 O(log n + k)
+	 */
+	template<typename Prune, typename Stop, typename Visit>
+	void visit_augmented(Prune prune, Stop stop, Visit visit) {
+		static_assert(is_augmented, "visit_augmented requires a node update policy");
+		__visit(root(), prune, stop, visit);
+	}
+
+	/*
+	 * 本树保留小于 key 的元素, 其余元素作为新树返回. 拆分本身 O(log n), 不维护子树大小时
+	 * 还要从两端同时数出较小一侧的元素个数, 为 O(min(k, n - k))
+	 */
+	rbtree split(Key const &key) {
+		rbtree result(comp);
+		size_type total = node_size;
+		size_type left_size = __count_less(key);
+		__subtree left, right;
+		__split_lower(__whole(__detach()), key, left, right);
+		__attach(left.node, left_size);
+		result.__attach(right.node, total - left_size);
+		return result;
+	}
+
+	/* right 中的元素都不能排在本树的元素之前 (唯一插入时要严格在后), 拼接后 right 为空, O(log n) */
+	void join(rbtree &right) noexcept {
+		if (static_cast<void *>(&right) == static_cast<void *>(this) || right.node_size == 0)
+			return;
+		size_type total = node_size + right.node_size;
+		__subtree first = __whole(__detach());
+		__attach(__join2(first, __whole(right.__detach())).node, total);
+	}
+
+	/*
+	 * 基于 split/join 的集合运算, 只用于唯一插入的树. other 被拆开, 它的结点直接挂到本树上,
+	 * 相同的元素保留本树中的那个, 用不到的结点最后统一销毁, 完成后 other 为空.
+	 * 较小的一方有 m 个元素时为 O(m log(n / m + 1)); 比较器和附加信息的更新不能抛出异常.
+	 * 带 sx::parallel 时左右子树的递归拆成多个线程执行, 要求比较器可以并发调用
+	 */
+	void union_with(rbtree &other) {
+		__set_operation(other, 0, &rbtree::__union);
+	}
+
+	void union_with(sx::parallel_t, rbtree &other) {
+		__set_operation(other, __fork_depth(), &rbtree::__union);
+	}
 
-		while (node != nil_node()) {
-			bool test1 = comp(key, key_of_value(static_cast<link_type>(node)->data));
-			bool test2 = comp(key_of_value(static_cast<link_type>(node)->data), key);
-			if (!test1 && !test2) {
-				old_pos = old_pos == nil_node() ? node->parent : old_pos;
+	/* 只保留两棵树中都有的元素 */
+	void intersect_with(rbtree &other) {
+		__set_operation(other, 0, &rbtree::__intersect);
+	}
+
+	void intersect_with(sx::parallel_t, rbtree &other) {
+		__set_operation(other, __fork_depth(), &rbtree::__intersect);
+	}
+
+	/* 删除 other 中也有的元素 */
+	void difference_with(rbtree &other) {
+		__set_operation(other, 0, &rbtree::__difference);
+	}
+
+	void difference_with(sx::parallel_t, rbtree &other) {
+		__set_operation(other, __fork_depth(), &rbtree::__difference);
+	}
+
+	static const_iterator transform_const_iterator(iterator iter) noexcept {
+		return const_iterator(iter.node);
+	}
+
+	static iterator transform_iterator(const_iterator iter) noexcept {
+		return iterator(iter.node);
+	}
+
+private:
+	static auto const &__meta(base_ptr node) noexcept {
+		return static_cast<link_type>(node)->meta;
+	}
+
+	static size_type __subtree_size(base_ptr node) noexcept {
+		return node == nullptr ? 0 : __meta(node);
+	}
+
+	/* 先找到落在区间内的最高结点, 再分别折叠它左边不小于 first_key 和右边小于 last_key 的部分 */
+	metadata_type __fold(base_ptr node, Key const *first_key, Key const *last_key) const {
+		using monoid = typename NodeUpdate::monoid_type;
+		while (node != nullptr) {
+			if (first_key != nullptr && comp(__key(node), *first_key))
 				node = node->right;
-			} else if (test1) {
-				old_pos = node;
+			else if (last_key != nullptr && !comp(__key(node), *last_key))
 				node = node->left;
-			} else
+			else
+				break;
+		}
+		if (node == nullptr)
+			return monoid::identity();
+		if (first_key == nullptr && last_key == nullptr)
+			return __meta(node);
+		if (first_key != nullptr && last_key != nullptr && !comp(*first_key, *last_key))
+			return monoid::identity();
+
+		auto result = monoid::combine(__fold(node->left, first_key, nullptr),
+			monoid::lift(static_cast<link_type>(node)->data));
+		return monoid::combine(result, __fold(node->right, nullptr, last_key));
+	}
+
+	/* 返回 false 表示已经 stop, 后面的结点不再访问 */
+	template<typename Prune, typename Stop, typename Visit>
+	bool __visit(base_ptr node, Prune &prune, Stop &stop, Visit &visit) {
+		if (node == nullptr || prune(__meta(node)))
+			return true;
+		if (!__visit(node->left, prune, stop, visit))
+			return false;
+		if (stop(static_cast<link_type>(node)->data))
+			return false;
+		visit(iterator(node));
+		return __visit(node->right, prune, stop, visit);
+	}
+
+	/* Upper 为 false 时统计小于 key 的元素, 为 true 时统计不大于 key 的元素 */
+	template<bool Upper, typename K>
+	size_type __rank(K const &key) const {
+		static_assert(is_order_statistics, "rank requires sx::rbtree_order_statistics");
+		size_type result = 0;
+		base_ptr node = const_cast<rbtree *>(this)->root();
+		while (node != nullptr) {
+			if (Upper ? !comp(key, __key(node)) : comp(__key(node), key)) {
+				result += __subtree_size(node->left) + 1;
 				node = node->right;
+			} else {
+				node = node->left;
+			}
 		}
+		return result;
+	}
 
-		return iterator(old_pos, nil_node(), root());
+	template<typename K>
+	size_type __count_range(K const &first_key, K const &last_key) const {
+		if (!comp(first_key, last_key))
+			return 0;
+		return __rank<false>(last_key) - __rank<false>(first_key);
 	}
 
-	const_iterator upper_bound(Key const key) const {
-		return transform_const_iterator(const_cast<rbtree *>(this)->upper_bound(key));
+	/* 维护了子树大小时两次下降即可, 否则数出相同 key 的区间长度 */
+	template<typename K>
+	size_type __count(K const &key) const {
+		if constexpr (is_order_statistics) {
+			return __rank<true>(key) - __rank<false>(key);
+		} else {
+			std::pair<const_iterator, const_iterator> range = equal_range(key);
+			return sx::distance(range.first, range.second);
+		}
 	}
 
-	size_type count(Key const &key) const {
-		std::pair<const_iterator, const_iterator> range = equal_range(key);
-		return sx::distance(range.first, range.second);
+	/* 小于 key 的元素个数; 不维护子树大小时从两端同时数, 先数完的一侧决定结果 */
+	size_type __count_less(Key const &key) {
+		if constexpr (is_order_statistics) {
+			return __rank<false>(key);
+		} else {
+			iterator middle = __lower_bound(key);
+			iterator left = begin(), right = middle;
+			size_type count = 0;
+			for (;;) {
+				if (left == middle)
+					return count;
+				if (right == end())
+					return node_size - count;
+				++left;
+				++right;
+				++count;
+			}
+		}
 	}
 
-	static const_iterator transform_const_iterator(iterator iter) noexcept {
-		return const_iterator(iter.node, iter.nil, iter.root);
+	/* 把整棵树摘下来作为独立的子树, 本树变为空 */
+	base_ptr __detach() noexcept {
+		base_ptr node = root();
+		empty_initialize();
+		return node;
 	}
 
-	static iterator transform_iterator(const_iterator iter) noexcept {
-		return iterator(iter.node, iter.nil, iter.root);
+	/* 把独立的子树挂到空的本树上 */
+	void __attach(base_ptr node, size_type count) noexcept {
+		empty_initialize();
+		if (node == nullptr)
+			return;
+		node->set_parent(end_node());
+		node->set_color(__BLACK);
+		set_root(node);
+		set_leftmost(__rbtree_node_base::minimun(node));
+		set_rightmost(__rbtree_node_base::maximun(node));
+		node_size = count;
+	}
+
+	/* 黑高: 从 node 到叶子路径上黑色结点的个数, 空树为 0. O(log n), 只在整棵树摘下来时算一次 */
+	static size_type __black_height(base_ptr node) noexcept {
+		size_type height = 0;
+		for (; node != nullptr; node = node->left) {
+			if (!node->is_red())
+				++height;
+		}
+		return height;
+	}
+
+	/* 独立的子树连同它的黑高一起传递, 拼接时不必再沿边界数黑高 */
+	struct __subtree {
+		base_ptr	node;
+		size_type	height;
+	};
+
+	static __subtree __whole(base_ptr node) noexcept {
+		return __subtree{ node, __black_height(node) };
+	}
+
+	/* 非空子树的左右孩子作为独立子树, 黑色的根下降一层黑高减一 */
+	static __subtree __left_of(__subtree tree) noexcept {
+		return __subtree{ tree.node->left, tree.node->is_red() ? tree.height : tree.height - 1 };
+	}
+
+	static __subtree __right_of(__subtree tree) noexcept {
+		return __subtree{ tree.node->right, tree.node->is_red() ? tree.height : tree.height - 1 };
+	}
+
+	/* 红色的根染黑, 黑高加一 */
+	static void __blacken(__subtree &tree) noexcept {
+		if (tree.node != nullptr && tree.node->is_red()) {
+			tree.node->set_color(__BLACK);
+			++tree.height;
+		}
+	}
+
+	/*
+	 * 以 middle 为分隔把两棵子树连起来, left 中的元素都不大于 middle, right 中的都不小于 middle.
+	 * 沿较高一棵树的右 (左) 边界下降到黑高相同的黑色结点, 把 middle 染红挂在那里, 再做一次插入修正.
+	 * 子树挂在栈上的临时头结点下, 所以多个线程可以同时拼接互不相交的子树. 黑高由调用者给出, O(|黑高差| + 1)
+	 */
+	__subtree __join(__subtree left, base_ptr middle, __subtree right) noexcept {
+		__blacken(left);
+		__blacken(right);
+
+		middle->parent_color = 0;
+		if (left.height == right.height) {
+			middle->left = left.node;
+			middle->right = right.node;
+			if (left.node != nullptr)
+				left.node->set_parent(middle);
+			if (right.node != nullptr)
+				right.node->set_parent(middle);
+			middle->set_color(__BLACK);
+			__update(middle);
+			return __subtree{ middle, left.height + 1 };
+		}
+
+		__rbtree_node_base holder;
+		holder.parent_color = 0;
+		holder.set_color(__RED);
+
+		bool taller_left = left.height > right.height;
+		base_ptr node = taller_left ? left.node : right.node;
+		size_type height = taller_left ? left.height : right.height;
+		size_type target = taller_left ? right.height : left.height;
+		size_type result_height = height;
+		holder.set_parent(node);
+		node->set_parent(&holder);
+
+		base_ptr parent_ptr = &holder;
+		while (!(__is_black(node) && height == target)) {
+			if (!node->is_red())
+				--height;
+			parent_ptr = node;
+			node = taller_left ? node->right : node->left;
+		}
+
+		middle->left = taller_left ? node : left.node;
+		middle->right = taller_left ? right.node : node;
+		if (middle->left != nullptr)
+			middle->left->set_parent(middle);
+		if (middle->right != nullptr)
+			middle->right->set_parent(middle);
+		middle->set_parent(parent_ptr);
+		middle->set_color(__RED);
+		if (taller_left)
+			parent_ptr->right = middle;
+		else
+			parent_ptr->left = middle;
+
+		__update_to_root(middle);
+		if (__insert_fixup(middle))
+			++result_height;
+
+		base_ptr result = holder.parent();
+		result->set_parent(nullptr);
+		return __subtree{ result, result_height };
+	}
+
+	/* 摘下最大的结点, 其余结点留在 rest 中 */
+	base_ptr __split_last(__subtree tree, __subtree &rest) noexcept {
+		if (tree.node->right == nullptr) {
+			rest = __left_of(tree);
+			return tree.node;
+		}
+		base_ptr last = __split_last(__right_of(tree), rest);
+		rest = __join(__left_of(tree), tree.node, rest);
+		return last;
+	}
+
+	/* 没有分隔结点时借用 left 的最大结点 */
+	__subtree __join2(__subtree left, __subtree right) noexcept {
+		if (left.node == nullptr)
+			return right;
+		if (right.node == nullptr)
+			return left;
+		__subtree rest;
+		base_ptr last = __split_last(left, rest);
+		return __join(rest, last, right);
+	}
+
+	/* 小于 key 的结点放进 left, 其余放进 right. 各层拼接的黑高差加起来不超过树高, O(log n) */
+	void __split_lower(__subtree tree, Key const &key, __subtree &left, __subtree &right) noexcept {
+		if (tree.node == nullptr) {
+			left = right = __subtree{ nullptr, 0 };
+			return;
+		}
+		__subtree tree_left = __left_of(tree);
+		__subtree tree_right = __right_of(tree);
+		if (comp(__key(tree.node), key)) {
+			__split_lower(tree_right, key, left, right);
+			left = __join(tree_left, tree.node, left);
+		} else {
+			__split_lower(tree_left, key, left, right);
+			right = __join(right, tree.node, tree_right);
+		}
+	}
+
+	/* 三路拆分: 返回与 key 相同的结点 (没有时为 nullptr), 小于和大于 key 的分别放进 left 和 right */
+	base_ptr __split(__subtree tree, Key const &key, __subtree &left, __subtree &right) noexcept {
+		if (tree.node == nullptr) {
+			left = right = __subtree{ nullptr, 0 };
+			return nullptr;
+		}
+		__subtree tree_left = __left_of(tree);
+		__subtree tree_right = __right_of(tree);
+		if (comp(key, __key(tree.node))) {
+			base_ptr middle = __split(tree_left, key, left, right);
+			right = __join(right, tree.node, tree_right);
+			return middle;
+		}
+		if (comp(__key(tree.node), key)) {
+			base_ptr middle = __split(tree_right, key, left, right);
+			left = __join(tree_left, tree.node, left);
+			return middle;
+		}
+		left = tree_left;
+		right = tree_right;
+		return tree.node;
 	}
 
+	/* 待销毁的结点借用 left 指针串成链表, 各个任务各有一条, 最后统一销毁, 并行时不会并发访问分配器 */
+	static void __discard(base_ptr node, base_ptr &garbage) noexcept {
+		node->left = garbage;
+		garbage = node;
+	}
+
+	static void __discard_tree(base_ptr node, base_ptr &garbage) noexcept {
+		while (node != nullptr) {
+			__discard_tree(node->right, garbage);
+			base_ptr left = node->left;
+			__discard(node, garbage);
+			node = left;
+		}
+	}
+
+	/* 把 tail 链表接到 garbage 之后 */
+	static void __append_garbage(base_ptr &garbage, base_ptr tail) noexcept {
+		base_ptr *link = &garbage;
+		while (*link != nullptr)
+			link = &(*link)->left;
+		*link = tail;
+	}
+
+	static size_type __destroy_garbage(base_ptr garbage) noexcept {
+		size_type count = 0;
+		while (garbage != nullptr) {
+			base_ptr next = garbage->left;
+			destroy_node(static_cast<link_type>(garbage));
+			garbage = next;
+			++count;
+		}
+		return count;
+	}
+
+	/* 分叉的层数, 大约让每个硬件线程分到一个任务 */
+	static size_type __fork_depth() noexcept {
+		size_type depth = 0;
+		for (unsigned int threads = std::thread::hardware_concurrency(); threads > 1; threads >>= 1)
+			++depth;
+		return depth;
+	}
+
+	/* 子树太小时不值得开线程 */
+	static constexpr size_type parallel_black_height = 8;
+
+	using set_operation = __subtree (rbtree::*)(__subtree, __subtree, base_ptr &, size_type);
+
+	/*
+	 * 对左右两对子树分别递归执行 operation, 层数和规模都允许时左边放到新线程上.
+	 * 此时树已经拆开, 开线程失败也不能抛出, 退回顺序执行
+	 */
+	std::pair<__subtree, __subtree> __fork(set_operation operation, size_type fork_depth, base_ptr &garbage,
+			__subtree left_first, __subtree left_second, __subtree right_first, __subtree right_second) noexcept {
+		if (fork_depth != 0 && left_first.height + left_second.height >= parallel_black_height) {
+			base_ptr left_garbage = nullptr;
+			std::future<__subtree> future;
+			try {
+				future = std::async(std::launch::async, [=, &left_garbage] {
+					return (this->*operation)(left_first, left_second, left_garbage, fork_depth - 1);
+				});
+			} catch (...) {
+				fork_depth = 0;
+			}
+			if (fork_depth != 0) {
+				__subtree right = (this->*operation)(right_first, right_second, garbage, fork_depth - 1);
+				__subtree left = future.get();
+				__append_garbage(garbage, left_garbage);
+				return std::pair<__subtree, __subtree>(left, right);
+			}
+		}
+		__subtree left = (this->*operation)(left_first, left_second, garbage, 0);
+		__subtree right = (this->*operation)(right_first, right_second, garbage, 0);
+		return std::pair<__subtree, __subtree>(left, right);
+	}
+
+	/* 以 first 的根拆分 second, 两边分别求并再用这个根拼起来; 重复的结点来自 second, 丢弃 */
+	__subtree __union(__subtree first, __subtree second, base_ptr &garbage, size_type fork_depth) noexcept {
+		if (first.node == nullptr)
+			return second;
+		if (second.node == nullptr)
+			return first;
+
+		__subtree second_left, second_right;
+		base_ptr middle = __split(second, __key(first.node), second_left, second_right);
+		if (middle != nullptr)
+			__discard(middle, garbage);
+		std::pair<__subtree, __subtree> children = __fork(&rbtree::__union, fork_depth, garbage,
+			__left_of(first), second_left, __right_of(first), second_right);
+		return __join(children.first, first.node, children.second);
+	}
+
+	__subtree __intersect(__subtree first, __subtree second, base_ptr &garbage, size_type fork_depth) noexcept {
+		if (first.node == nullptr || second.node == nullptr) {
+			__discard_tree(first.node, garbage);
+			__discard_tree(second.node, garbage);
+			return __subtree{ nullptr, 0 };
+		}
+
+		__subtree second_left, second_right;
+		base_ptr middle = __split(second, __key(first.node), second_left, second_right);
+		std::pair<__subtree, __subtree> children = __fork(&rbtree::__intersect, fork_depth, garbage,
+			__left_of(first), second_left, __right_of(first), second_right);
+		if (middle != nullptr) {
+			__discard(middle, garbage);
+			return __join(children.first, first.node, children.second);
+		}
+		__discard(first.node, garbage);
+		return __join2(children.first, children.second);
+	}
+
+	/* 以 second 的根拆分 first, 与之相同的结点和 second 的所有结点都丢弃 */
+	__subtree __difference(__subtree first, __subtree second, base_ptr &garbage, size_type fork_depth) noexcept {
+		if (first.node == nullptr || second.node == nullptr) {
+			__discard_tree(second.node, garbage);
+			return first;
+		}
+
+		__subtree first_left, first_right;
+		base_ptr middle = __split(first, __key(second.node), first_left, first_right);
+		std::pair<__subtree, __subtree> children = __fork(&rbtree::__difference, fork_depth, garbage,
+			first_left, __left_of(second), first_right, __right_of(second));
+		if (middle != nullptr)
+			__discard(middle, garbage);
+		__discard(second.node, garbage);
+		return __join2(children.first, children.second);
+	}
+
+	/* 两棵树都摘下来做运算, 结点总数减去丢弃的个数就是结果的大小 */
+	void __set_operation(rbtree &other, size_type fork_depth, set_operation operation) {
+		if (static_cast<void *>(&other) == static_cast<void *>(this)) {
+			if (operation == &rbtree::__difference)
+				clear();
+			return;
+		}
+
+		size_type total = node_size + other.node_size;
+		__subtree first = __whole(__detach());
+		__subtree second = __whole(other.__detach());
+		base_ptr garbage = nullptr;
+		__subtree result = (this->*operation)(first, second, garbage, fork_depth);
+		__attach(result.node, total - __destroy_garbage(garbage));
+	}
+public:
 	void swap(rbtree &other) noexcept {
 		using std::swap;
 		swap(this->header, other.header);
-		swap(this->nil, other.nil);
 		swap(this->node_size, other.node_size);
 		swap(this->comp, other.comp);
+		this->__reset_header();
+		other.__reset_header();
 	}
 };
 
 template<typename Key, typename Value, typename KeyOfValue,
-	typename Compare, typename Alloc>
-void swap(rbtree<Key, Value, KeyOfValue, Compare, Alloc> &lhs, rbtree<Key, Value, KeyOfValue, Compare, Alloc> &rhs) noexcept {
+	typename Compare, typename Alloc, typename NodeUpdate>
+void swap(rbtree<Key, Value, KeyOfValue, Compare, Alloc, NodeUpdate> &lhs, rbtree<Key, Value, KeyOfValue, Compare, Alloc, NodeUpdate> &rhs) noexcept {
 	lhs.swap(rhs);
 }
 
 
-template<typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc>
-typename rbtree<Key, Value, KeyOfValue, Compare, Alloc>::Allocator
-rbtree<Key, Value, KeyOfValue, Compare, Alloc>::allocator{};
+template<typename Key, typename Value, typename KeyOfValue, typename Compare, typename Alloc, typename NodeUpdate>
+typename rbtree<Key, Value, KeyOfValue, Compare, Alloc, NodeUpdate>::Allocator
+rbtree<Key, Value, KeyOfValue, Compare, Alloc, NodeUpdate>::allocator{};
 }
 
 #endif // !RBTREE_HPP
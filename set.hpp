@@ -6,31 +6,34 @@
 
 namespace sx {
 
-template<typename Key, typename Compare = std::less<Key>, typename Alloc = sx::allocator<Key>>
+template<typename Key, typename Compare = std::less<Key>, typename Alloc = sx::allocator<Key>,
+	typename NodeUpdate = sx::rbtree_null_update>
 class set;
 
-template<typename Key, typename Compare, typename Alloc>
-void swap(set<Key, Compare, Alloc> &first, set<Key, Compare, Alloc> &second) noexcept;
+template<typename Key, typename Compare, typename Alloc, typename NodeUpdate>
+void swap(set<Key, Compare, Alloc, NodeUpdate> &first, set<Key, Compare, Alloc, NodeUpdate> &second) noexcept;
 
 
-template<typename Key, typename Compare = std::less<Key>, typename Alloc = sx::allocator<Key>>
+template<typename Key, typename Compare = std::less<Key>, typename Alloc = sx::allocator<Key>,
+	typename NodeUpdate = sx::rbtree_null_update>
 class multiset;
 
-template<typename Key, typename Compare, typename Alloc>
-void swap(multiset<Key, Compare, Alloc> &, multiset<Key, Compare, Alloc> &) noexcept;
+template<typename Key, typename Compare, typename Alloc, typename NodeUpdate>
+void swap(multiset<Key, Compare, Alloc, NodeUpdate> &, multiset<Key, Compare, Alloc, NodeUpdate> &) noexcept;
 
 
 template<typename Key,
 	typename Compare, 
-	typename Alloc>
-class set : public sx::container_helpful<set<Key, Compare, Alloc>> {
+	typename Alloc,
+	typename NodeUpdate>
+class set : public sx::container_helpful<set<Key, Compare, Alloc, NodeUpdate>> {
 public:
 	using key_type			= Key;
 	using value_type		= Key;
 	using key_compare		= Compare;
 	using value_compare		= Compare;
 private:
-	using Container			= sx::rbtree<key_type, value_type, sx::identity<value_type>, Compare, Alloc>;
+	using Container			= sx::rbtree<key_type, value_type, sx::identity<value_type>, Compare, Alloc, NodeUpdate>;
 public:
 	using pointer			= typename Container::pointer;
 	using reference			= typename Container::reference;
@@ -40,8 +43,19 @@ public:
 	using size_type			= typename Container::size_type;
 	using iterator			= typename Container::const_iterator;
 	using const_iterator	= typename Container::const_iterator;
+	using node_type				= typename Container::node_type;
+	using insert_return_type	= sx::node_insert_return<const_iterator, node_type>;
+	using metadata_type			= typename Container::metadata_type;
 private:
+	template<typename, typename, typename, typename>
+	friend class set;
+
+	template<typename, typename, typename, typename>
+	friend class multiset;
+
 	Container container;			/* 底层红黑树容器 */
+
+	explicit set(Container &&container) : container(std::move(container)) {}
 public:
 	set() : container(Compare{}) {}
 	explicit set(Compare const &comp) : container(comp) {}
@@ -53,7 +67,15 @@ public:
 		container.insert_unique(first, last);
 	}
 
-	set(set const &other) noexcept : container(other.container) { }
+	/* 调用者保证输入严格递增, O(n) 建树 */
+	template<typename InputIterator, 
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
+		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
+	set(sx::sorted_unique_t, InputIterator first, InputIterator last) {
+		container.insert_unique(sx::sorted_unique, first, last);
+	}
+
+	set(set const &other) : container(other.container) { }
 
 	set(set &&other) noexcept : container(std::move(other.container)) { }
 
@@ -77,10 +99,19 @@ public:
 		return container.empty();
 	}
 
+	key_compare key_comp() const {
+		return container.key_comp();
+	}
+
 	void clear() {
 		container.clear();
 	}
 
+	/* 结点按中序搬到连续内存中并重新平衡, 所有迭代器失效 */
+	void compact() {
+		container.compact();
+	}
+
 	const_iterator begin() const noexcept {
 		return cbegin();
 	}
@@ -108,11 +139,18 @@ public:
 		return std::pair<const_iterator, bool>(container.transform_const_iterator(ret.first), ret.second);
 	}
 
+	/* position 指向新元素之后的元素时均摊 O(1) */
 	std::pair<const_iterator, bool> insert(const_iterator position, value_type const &val) {
-		std::pair<typename Container::iterator, bool> ret = container.insert_unique(val);
+		std::pair<typename Container::iterator, bool> ret = container.insert_unique(position, val);
 		return std::pair<const_iterator, bool>(container.transform_const_iterator(ret.first), ret.second);
 	}
 
+	template<typename... Args>
+	const_iterator emplace_hint(const_iterator position, Args&&... args) {
+		std::pair<typename Container::iterator, bool> ret = container.emplace_hint_unique(position, std::forward<Args>(args)...);
+		return container.transform_const_iterator(ret.first);
+	}
+
 	template<typename InputIterator,
 		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
 		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
@@ -120,6 +158,81 @@ public:
 		container.insert_unique(first, last);
 	}
 
+	template<typename InputIterator,
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
+		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
+	void insert(sx::sorted_unique_t, InputIterator first, InputIterator last) {
+		container.insert_unique(sx::sorted_unique, first, last);
+	}
+
+	/* 摘下结点但不释放, 可以修改值后插回, 或者插入到另一个 set */
+	node_type extract(const_iterator position) {
+		return container.extract(position);
+	}
+
+	node_type extract(value_type const &val) {
+		return container.extract(val);
+	}
+
+	/* 已有相同的值时插入失败, 结点通过返回值的 node 交还 */
+	insert_return_type insert(node_type &&handle) {
+		typename Container::insert_return_type ret = container.insert_unique(std::move(handle));
+		return insert_return_type{ container.transform_const_iterator(ret.position), ret.inserted, std::move(ret.node) };
+	}
+
+	const_iterator insert(const_iterator position, node_type &&handle) {
+		return container.transform_const_iterator(container.insert_unique(position, std::move(handle)));
+	}
+
+	/* 把 source 中不重复的结点移过来, 重复的留在 source 中 */
+	template<typename OtherCompare>
+	void merge(set<Key, OtherCompare, Alloc, NodeUpdate> &source) {
+		container.merge_unique(source.container);
+	}
+
+	template<typename OtherCompare>
+	void merge(multiset<Key, OtherCompare, Alloc, NodeUpdate> &source) {
+		container.merge_unique(source.container);
+	}
+
+	/* 本集合保留小于 key 的元素, 其余元素作为新的集合返回 */
+	set split(value_type const &key) {
+		return set(container.split(key));
+	}
+
+	/* other 中的 key 都必须大于本集合中的 key, 拼接后 other 为空, O(log n) */
+	void join(set &other) noexcept {
+		container.join(other.container);
+	}
+
+	/*
+	 * 集合运算直接复用 other 的结点, 完成后 other 为空; key 相同时保留本集合中的元素.
+	 * 较小的一方有 m 个元素时为 O(m log(n / m + 1)), 带 sx::parallel 时在多个线程上递归
+	 */
+	void union_with(set &other) {
+		container.union_with(other.container);
+	}
+
+	void union_with(sx::parallel_t, set &other) {
+		container.union_with(sx::parallel, other.container);
+	}
+
+	void intersect_with(set &other) {
+		container.intersect_with(other.container);
+	}
+
+	void intersect_with(sx::parallel_t, set &other) {
+		container.intersect_with(sx::parallel, other.container);
+	}
+
+	void difference_with(set &other) {
+		container.difference_with(other.container);
+	}
+
+	void difference_with(sx::parallel_t, set &other) {
+		container.difference_with(sx::parallel, other.container);
+	}
+
 	const_iterator erase(const_iterator position) {
 		return container.erase(position);
 	}
@@ -159,6 +272,90 @@ public:
 		return container.equal_range(val);
 	}
 
+	/* 从 hint 向后查找, 顺着上一次的结果查找相近的元素时比从根开始快; hint 不小于 val 时从根开始 */
+	const_iterator find(const_iterator hint, value_type const &val) const {
+		return container.find(hint, val);
+	}
+
+	const_iterator lower_bound(const_iterator hint, value_type const &val) const {
+		return container.lower_bound(hint, val);
+	}
+
+	/* 调用者保证 keys 非递减, 每个元素的查找结果 (找不到时为 end()) 依次写入 out, 共 O(k log(n / k)) */
+	template<typename Range, typename OutputIterator>
+	OutputIterator find_batch(Range const &keys, OutputIterator out) const {
+		return container.find_batch(keys.begin(), keys.end(), out);
+	}
+
+	/* 比较器声明了 is_transparent 时, 可以用任何能与元素比较的类型查找, 不构造临时元素 */
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	size_type erase(K const &key) {
+		return container.erase(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator find(K const &key) const {
+		return container.find(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator lower_bound(K const &key) const {
+		return container.lower_bound(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator upper_bound(K const &key) const {
+		return container.upper_bound(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	std::pair<const_iterator, const_iterator> equal_range(K const &key) const {
+		return container.equal_range(key);
+	}
+
+	size_type count(value_type const &key) const {
+		return container.count(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	size_type count(K const &key) const {
+		return container.count(key);
+	}
+
+	/* 以下需要 NodeUpdate 为 sx::rbtree_order_statistics, 均为 O(log n) */
+	const_iterator nth(size_type k) const noexcept {
+		return container.nth(k);
+	}
+
+	/* 小于 key 的元素个数 */
+	size_type rank(value_type const &key) const {
+		return container.rank(key);
+	}
+
+	/* 落在 [first_key, last_key) 中的元素个数 */
+	size_type count_range(value_type const &first_key, value_type const &last_key) const {
+		return container.count_range(first_key, last_key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	size_type rank(K const &key) const {
+		return container.rank(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	size_type count_range(K const &first_key, K const &last_key) const {
+		return container.count_range(first_key, last_key);
+	}
+
+	/* 以下需要 NodeUpdate 为 sx::rbtree_monoid_update: 全部元素以及 [first_key, last_key) 中元素的折叠结果 */
+	metadata_type aggregate() const {
+		return container.aggregate();
+	}
+
+	metadata_type aggregate(value_type const &first_key, value_type const &last_key) const {
+		return container.aggregate(first_key, last_key);
+	}
+
 	void swap(set &other) noexcept {
 		container.swap(other.container);
 	}
@@ -171,15 +368,16 @@ public:
 
 template<typename Key,
 	typename Compare, 
-	typename Alloc>
-class multiset : public sx::container_helpful<set<Key, Compare, Alloc>> {
+	typename Alloc,
+	typename NodeUpdate>
+class multiset : public sx::container_helpful<multiset<Key, Compare, Alloc, NodeUpdate>> {
 public:
 	using key_type			= Key;
 	using value_type		= Key;
 	using key_compare		= Compare;
 	using value_compare		= Compare;
 private:
-	using Container			= sx::rbtree<key_type, value_type, sx::identity<value_type>, Compare, Alloc>;
+	using Container			= sx::rbtree<key_type, value_type, sx::identity<value_type>, Compare, Alloc, NodeUpdate>;
 public:
 	using pointer			= typename Container::pointer;
 	using reference			= typename Container::reference;
@@ -189,7 +387,15 @@ public:
 	using size_type			= typename Container::size_type;
 	using iterator			= typename Container::const_iterator;
 	using const_iterator	= typename Container::const_iterator;
+	using node_type			= typename Container::node_type;
+	using metadata_type		= typename Container::metadata_type;
 private:
+	template<typename, typename, typename, typename>
+	friend class set;
+
+	template<typename, typename, typename, typename>
+	friend class multiset;
+
 	Container container;			/* 底层容器 */
 public:
 	multiset() : container(Compare{}) {}
@@ -203,7 +409,15 @@ public:
 		container.insert_equal(first, last);
 	}
 
-	multiset(multiset const &other) noexcept : container(other.container) { }
+	/* 调用者保证输入非递减, O(n) 建树 */
+	template<typename InputIterator, 
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
+		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
+	multiset(sx::sorted_equivalent_t, InputIterator first, InputIterator last) {
+		container.insert_equal(sx::sorted_equivalent, first, last);
+	}
+
+	multiset(multiset const &other) : container(other.container) { }
 
 	multiset(multiset &&other) noexcept : container(std::move(other.container)) { }
 
@@ -227,10 +441,19 @@ public:
 		return container.empty();
 	}
 
+	key_compare key_comp() const {
+		return container.key_comp();
+	}
+
 	void clear() {
 		container.clear();
 	}
 
+	/* 结点按中序搬到连续内存中并重新平衡, 所有迭代器失效 */
+	void compact() {
+		container.compact();
+	}
+
 	const_iterator begin() const noexcept {
 		return cbegin();
 	}
@@ -258,8 +481,15 @@ public:
 		return container.transform_const_iterator(ret);
 	}
 
+	/* position 指向新元素之后的元素时均摊 O(1) */
 	const_iterator insert(const_iterator position, value_type const &val) {
-		typename Container::iterator ret = container.insert_equal(val);
+		typename Container::iterator ret = container.insert_equal(position, val);
+		return container.transform_const_iterator(ret);
+	}
+
+	template<typename... Args>
+	const_iterator emplace_hint(const_iterator position, Args&&... args) {
+		typename Container::iterator ret = container.emplace_hint_equal(position, std::forward<Args>(args)...);
 		return container.transform_const_iterator(ret);
 	}
 
@@ -270,6 +500,40 @@ public:
 		container.insert_equal(first, last);
 	}
 
+	template<typename InputIterator,
+		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
+		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
+	void insert(sx::sorted_equivalent_t, InputIterator first, InputIterator last) {
+		container.insert_equal(sx::sorted_equivalent, first, last);
+	}
+
+	node_type extract(const_iterator position) {
+		return container.extract(position);
+	}
+
+	node_type extract(value_type const &val) {
+		return container.extract(val);
+	}
+
+	const_iterator insert(node_type &&handle) {
+		return container.transform_const_iterator(container.insert_equal(std::move(handle)));
+	}
+
+	const_iterator insert(const_iterator position, node_type &&handle) {
+		return container.transform_const_iterator(container.insert_equal(position, std::move(handle)));
+	}
+
+	/* source 中的结点全部移过来, 相同的值排在已有元素之后 */
+	template<typename OtherCompare>
+	void merge(multiset<Key, OtherCompare, Alloc, NodeUpdate> &source) {
+		container.merge_equal(source.container);
+	}
+
+	template<typename OtherCompare>
+	void merge(set<Key, OtherCompare, Alloc, NodeUpdate> &source) {
+		container.merge_equal(source.container);
+	}
+
 	const_iterator erase(const_iterator position) {
 		return container.erase(position);
 	}
@@ -306,6 +570,90 @@ public:
 		return container.equal_range(val);
 	}
 
+	/* 从 hint 向后查找, 顺着上一次的结果查找相近的元素时比从根开始快; hint 不小于 val 时从根开始 */
+	const_iterator find(const_iterator hint, value_type const &val) const {
+		return container.find(hint, val);
+	}
+
+	const_iterator lower_bound(const_iterator hint, value_type const &val) const {
+		return container.lower_bound(hint, val);
+	}
+
+	/* 调用者保证 keys 非递减, 每个元素的查找结果 (找不到时为 end()) 依次写入 out, 共 O(k log(n / k)) */
+	template<typename Range, typename OutputIterator>
+	OutputIterator find_batch(Range const &keys, OutputIterator out) const {
+		return container.find_batch(keys.begin(), keys.end(), out);
+	}
+
+	/* 比较器声明了 is_transparent 时, 可以用任何能与元素比较的类型查找, 不构造临时元素 */
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	size_type erase(K const &key) {
+		return container.erase(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator find(K const &key) const {
+		return container.find(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator lower_bound(K const &key) const {
+		return container.lower_bound(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	const_iterator upper_bound(K const &key) const {
+		return container.upper_bound(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	std::pair<const_iterator, const_iterator> equal_range(K const &key) const {
+		return container.equal_range(key);
+	}
+
+	size_type count(value_type const &key) const {
+		return container.count(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	size_type count(K const &key) const {
+		return container.count(key);
+	}
+
+	/* 以下需要 NodeUpdate 为 sx::rbtree_order_statistics, 均为 O(log n) */
+	const_iterator nth(size_type k) const noexcept {
+		return container.nth(k);
+	}
+
+	/* 小于 key 的元素个数 */
+	size_type rank(value_type const &key) const {
+		return container.rank(key);
+	}
+
+	/* 落在 [first_key, last_key) 中的元素个数 */
+	size_type count_range(value_type const &first_key, value_type const &last_key) const {
+		return container.count_range(first_key, last_key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	size_type rank(K const &key) const {
+		return container.rank(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<Compare, K>>
+	size_type count_range(K const &first_key, K const &last_key) const {
+		return container.count_range(first_key, last_key);
+	}
+
+	/* 以下需要 NodeUpdate 为 sx::rbtree_monoid_update: 全部元素以及 [first_key, last_key) 中元素的折叠结果 */
+	metadata_type aggregate() const {
+		return container.aggregate();
+	}
+
+	metadata_type aggregate(value_type const &first_key, value_type const &last_key) const {
+		return container.aggregate(first_key, last_key);
+	}
+
 	void swap(multiset &other) noexcept {
 		container.swap(other.container);
 	}
@@ -37,6 +37,8 @@ public:
     stack &operator=(stack const &) = default;
     stack &operator=(stack &&) = default;
     ~stack() = default;
+    explicit stack(Container const &c) : container(c) {}
+    explicit stack(Container &&c) : container(std::move(c)) {}
 public:
     bool empty() const noexcept {
         return container.empty();
@@ -63,6 +65,35 @@ public:
         container.emplace_back(std::forward<Args>(args)...);
     }
 
+    /* 批量压入 [first, last), 最后一个元素位于栈顶 */
+    template<typename InputIterator,
+        typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>>>
+    void push_range(InputIterator first, InputIterator last) {
+        sx::__append_range(container, first, last);
+    }
+
+    /* 按出栈顺序把最多 n 个元素移动到 out, 再一次性从容器尾部删除 */
+    template<typename OutputIterator>
+    OutputIterator pop_n(OutputIterator out, size_type n) {
+        if (n > size())
+            n = size();
+
+        auto last = container.end();
+        auto first = last;
+        for (size_type i = 0; i < n; ++i, ++out) {
+            --first;
+            *out = std::move(*first);
+        }
+        container.erase(first, last);
+        return out;
+    }
+
+    /* 取出全部元素 */
+    template<typename OutputIterator>
+    OutputIterator drain(OutputIterator out) {
+        return pop_n(out, size());
+    }
+
     void pop(value_type const &value) {
         container.pop_back();
     }
@@ -0,0 +1,188 @@
+#include <iostream>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+#include <iterator>
+#include <stdexcept>
+#include "vector.hpp"
+#include "list.hpp"
+#include "circular_buffer.hpp"
+#include "queue.hpp"
+#include "stack.hpp"
+#include "priority_queue.hpp"
+
+using std::cout;
+using std::endl;
+
+template<typename Container>
+static void print(Container const &container) {
+	for (auto &val : container)
+		cout << val << " ";
+	cout << "size:" << container.size() << endl;
+}
+
+static void adapter_bulk_basic() {
+	int values[] = { 5, 1, 4, 2, 3, 6 };
+
+	/* 队列: 按入队顺序取出 */
+	sx::queue<int, sx::list<int>> fifo;
+	fifo.push_range(std::begin(values), std::end(values));
+	sx::vector<int> out;
+	fifo.pop_n(std::back_inserter(out), 2);
+	print(out);
+	out.clear();
+	fifo.drain(std::back_inserter(out));
+	print(out);
+	cout << "fifo.empty:" << fifo.empty() << endl;
+
+	/* 以有界环形缓冲区为底层容器的队列 */
+	sx::queue<int, sx::circular_buffer<int>> ring(sx::circular_buffer<int>(8));
+	ring.push_range(std::begin(values), std::end(values));
+	out.clear();
+	ring.pop_n(std::back_inserter(out), 10);
+	print(out);
+
+	/* 栈: 最后压入的先出 */
+	sx::stack<int, sx::vector<int>> lifo;
+	lifo.push_range(std::begin(values), std::end(values));
+	out.clear();
+	lifo.pop_n(std::back_inserter(out), 4);
+	print(out);
+	cout << "lifo.top:" << lifo.top() << endl;
+
+	/* 优先队列: 按优先级从高到低取出 */
+	sx::priority_queue<int> heap;
+	heap.push(10);
+	heap.push_range(std::begin(values), std::end(values));
+	out.clear();
+	heap.pop_n(std::back_inserter(out), 3);
+	print(out);
+	out.clear();
+	heap.drain(std::back_inserter(out));
+	print(out);
+}
+
+/* 拷贝负数时抛出异常 */
+struct fragile {
+	int value;
+
+	fragile(int val) : value(val) {}
+	fragile(fragile const &other) : value(other.value) {
+		if (value < 0)
+			throw std::runtime_error("copy");
+	}
+	fragile &operator=(fragile const &) = default;
+
+	bool operator<(fragile const &other) const {
+		return value < other.value;
+	}
+};
+
+/* 比较次数用完时抛出一次异常, 为负数时不限制 */
+static int compare_budget = -1;
+
+struct throwing_less {
+	bool operator()(int first, int second) const {
+		if (compare_budget == 0) {
+			compare_budget = -1;
+			throw std::runtime_error("compare");
+		}
+		if (compare_budget > 0)
+			--compare_budget;
+		return first < second;
+	}
+};
+
+template<typename Queue>
+static bool is_drained_in_order(Queue &heap, sx::vector<int> &out) {
+	heap.drain(std::back_inserter(out));
+	for (std::size_t i = 1; i < out.size(); ++i) {
+		if (out[i] < out[i - 1])
+			return false;
+	}
+	return true;
+}
+
+/* 批量操作抛出异常时不能丢掉队列中原有的元素 */
+static void priority_queue_bulk_exception() {
+	sx::priority_queue<fragile> heap;
+	for (int i = 5; i >= 1; --i)
+		heap.push(fragile(i));
+	fragile input[] = { 6, 0, -1, 7 };
+	try {
+		heap.push_range(std::begin(input), std::end(input));
+	} catch (std::runtime_error const &) {
+		cout << "push_range failed size:" << heap.size() << " top:" << heap.top().value << endl;
+	}
+
+	sx::priority_queue<int, sx::vector<int>, throwing_less> ints;
+	for (int i = 20; i >= 1; --i)
+		ints.push(i);
+	sx::vector<int> popped;
+	compare_budget = 12;
+	try {
+		ints.pop_n(std::back_inserter(popped), 10);
+	} catch (std::runtime_error const &) {
+		cout << "pop_n failed popped:" << popped.size() << " left:" << ints.size() << endl;
+	}
+	std::size_t left = ints.size();
+
+	compare_budget = 3;
+	try {
+		sx::vector<int> out;
+		ints.drain(std::back_inserter(out));
+	} catch (std::runtime_error const &) {
+		cout << "drain failed left:" << ints.size() << endl;
+	}
+
+	compare_budget = -1;
+	sx::vector<int> rest;
+	bool ordered = is_drained_in_order(ints, rest);
+	cout << "check:" << (popped.size() + rest.size() == 20 && rest.size() == left && ordered) << endl;
+}
+
+/* 逐个 push/pop 与 push_range/drain 对比 */
+static void priority_queue_bulk_bench() {
+	using clock = std::chrono::steady_clock;
+	const int count = 1000000;
+	std::mt19937 engine(20240901);
+	sx::vector<int> values;
+	for (int i = 0; i < count; ++i)
+		values.push_back(static_cast<int>(engine() >> 1));
+
+	long long sum1 = 0, sum2 = 0;
+	auto start = clock::now();
+	{
+		sx::priority_queue<int> heap;
+		for (int val : values)
+			heap.push(val);
+		for (long long i = 1; !heap.empty(); ++i) {
+			sum1 += heap.top() * i % 1000;
+			heap.pop();
+		}
+	}
+	auto single_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	start = clock::now();
+	{
+		sx::priority_queue<int> heap;
+		heap.push_range(values.begin(), values.end());
+		sx::vector<int> sorted;
+		sorted.reserve(count);
+		heap.drain(std::back_inserter(sorted));
+		for (long long i = 1; i <= count; ++i)
+			sum2 += sorted[i - 1] * i % 1000;
+	}
+	auto bulk_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	cout << "push/pop:" << single_ms << "ms push_range/drain:" << bulk_ms << "ms check:" << (sum1 == sum2) << endl;
+}
+
+#if 0
+int main(void) {
+	//adapter_bulk_basic();
+	//priority_queue_bulk_exception();
+	//priority_queue_bulk_bench();
+	system("pause");
+}
+#endif
@@ -0,0 +1,104 @@
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include "vector.hpp"
+#include "map.hpp"
+#include "btree_map.hpp"
+#include "btree_set.hpp"
+
+using std::cout;
+using std::endl;
+using std::string;
+
+static void btree_basic() {
+	sx::btree_map<string, int> ages;
+	ages["tom"] = 20;
+	ages["jerry"] = 18;
+	ages.insert(std::make_pair(string("spike"), 30));
+	ages.insert_or_assign("tom", 21);
+	for (auto &val : ages)
+		cout << val.first << ":" << val.second << " ";
+	cout << endl;
+
+	auto iter = ages.find("jerry");
+	cout << "jerry:" << (iter != ages.end() ? iter->second : -1) << endl;
+	ages.erase("jerry");
+	cout << "size:" << ages.size() << " count(jerry):" << ages.count("jerry") << endl;
+
+	/* 有序输入直接追加到最右叶子, 结点几乎全满 */
+	sx::vector<int> sorted;
+	for (int i = 0; i < 100; ++i)
+		sorted.push_back(i * 2);
+	sx::btree_set<int> evens(sx::sorted_unique, sorted.begin(), sorted.end());
+	cout << "lower_bound(51):" << *evens.lower_bound(51) << " max:" << *evens.max() << endl;
+
+	sx::btree_multiset<int> bag;
+	for (int i = 0; i < 20; ++i)
+		bag.insert(i % 4);
+	auto range = bag.equal_range(2);
+	int n = 0;
+	for (auto first = range.first; first != range.second; ++first)
+		++n;
+	cout << "count(2):" << n << " erase(2):" << bag.erase(2) << " size:" << bag.size() << endl;
+}
+
+/* 随机 int key: 红黑树每层一次缓存未命中, B 树一个结点比较一批 key */
+static void btree_bench() {
+	using clock = std::chrono::steady_clock;
+	const int count = 1000000;
+	std::mt19937 engine(20240601);
+	sx::vector<int> keys;
+	for (int i = 0; i < count; ++i)
+		keys.push_back(static_cast<int>(engine() >> 1));
+
+	auto start = clock::now();
+	sx::map<int, int> tree;
+	for (int i = 0; i < count; ++i)
+		tree[keys[i]] = i;
+	auto tree_insert_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	start = clock::now();
+	sx::btree_map<int, int> btree;
+	for (int i = 0; i < count; ++i)
+		btree[keys[i]] = i;
+	auto btree_insert_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	std::shuffle(keys.begin(), keys.end(), engine);
+	long long sum1 = 0, sum2 = 0;
+	start = clock::now();
+	for (int key : keys)
+		sum1 += tree.find(key)->second;
+	auto tree_find_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	start = clock::now();
+	for (int key : keys)
+		sum2 += btree.find(key)->second;
+	auto btree_find_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	long long scan1 = 0, scan2 = 0;
+	start = clock::now();
+	for (auto &val : tree)
+		scan1 += val.second;
+	auto tree_scan_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	start = clock::now();
+	for (auto &val : btree)
+		scan2 += val.second;
+	auto btree_scan_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	cout << "insert map:" << tree_insert_ms << "ms btree_map:" << btree_insert_ms << "ms" << endl;
+	cout << "find map:" << tree_find_ms << "ms btree_map:" << btree_find_ms << "ms" << endl;
+	cout << "scan map:" << tree_scan_ms << "ms btree_map:" << btree_scan_ms << "ms" << endl;
+	cout << "check:" << (sum1 == sum2 && scan1 == scan2 && tree.size() == btree.size()) << endl;
+}
+
+#if 0
+int main(void) {
+	//btree_basic();
+	//btree_bench();
+	system("pause");
+}
+#endif
@@ -0,0 +1,181 @@
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "circular_buffer.hpp"
+#include "queue.hpp"
+#include "mpmc_queue.hpp"
+
+using std::cout;
+using std::endl;
+using std::string;
+
+template<typename Buffer>
+static void print(Buffer const &buffer) {
+	for (auto &val : buffer)
+		cout << val << " ";
+	cout << "size:" << buffer.size() << endl;
+}
+
+static void circular_buffer_basic() {
+	/* 覆盖模式: 满了之后尾部插入丢弃最旧的元素 */
+	sx::circular_buffer<int> recent(3);
+	for (int i = 1; i <= 5; ++i)
+		recent.push_back(i);
+	print(recent);
+	recent.push_front(0);
+	print(recent);
+
+	/* 拒绝模式: 满了之后 try_push 返回 false, push 抛出 circular_buffer_full */
+	sx::circular_buffer<int> bounded(2, sx::circular_buffer_policy::reject);
+	cout << bounded.try_push_back(1) << bounded.try_push_back(2) << bounded.try_push_back(3) << endl;
+	try {
+		bounded.push_back(4);
+	} catch (sx::circular_buffer_full const &) {
+		cout << "full" << endl;
+	}
+
+	/* 删除中间元素, 再整理成一段连续内存 */
+	sx::circular_buffer<int> ring{ 1, 2, 3, 4, 5 };
+	ring.push_back(6);
+	ring.erase(ring.begin() + 2);
+	print(ring);
+	int *first = ring.linearize();
+	cout << "linearized:" << ring.is_linearized() << " first:" << *first << endl;
+}
+
+/* 满时插入的参数引用着要被丢弃的那个元素, 新元素必须在旧元素销毁之前构造好 */
+static void circular_buffer_self_push() {
+	sx::circular_buffer<string> names(3);
+	names.push_back(string("alpha with a long tail to defeat small string optimization"));
+	names.push_back(string("beta with a long tail to defeat small string optimization"));
+	names.push_back(string("gamma with a long tail to defeat small string optimization"));
+
+	names.push_back(names.front());
+	names.push_front(names.back());
+	names.emplace_back(names.front(), 0, 5);
+	for (auto &name : names)
+		cout << name.substr(0, name.find(' ')) << " ";
+	cout << "size:" << names.size() << endl;
+}
+
+/* 作为 sx::queue 的底层容器: 默认构造的缓冲区第一次插入时分配 default_capacity */
+static void circular_buffer_adapter() {
+	sx::queue<int, sx::circular_buffer<int>> fifo;
+	for (int i = 1; i <= 5; ++i)
+		fifo.push(i);
+	fifo.pop();
+	cout << "front:" << fifo.front() << " back:" << fifo.back() << " size:" << fifo.size() << endl;
+
+	sx::circular_buffer<int> ring;
+	cout << "capacity:" << ring.capacity() << endl;
+	ring.push_back(1);
+	cout << "capacity:" << ring.capacity() << endl;
+
+	/* iterator 转换为 const_iterator, const 对象的逆序遍历 */
+	for (int i = 2; i <= 4; ++i)
+		ring.push_back(i);
+	sx::circular_buffer<int>::const_iterator first = ring.begin();
+	cout << "first:" << *first << " distance:" << (ring.cend() - first) << endl;
+	sx::circular_buffer<int> const &view = ring;
+	for (auto iter = view.rbegin(); iter != view.rend(); ++iter)
+		cout << *iter << " ";
+	cout << endl;
+}
+
+/* 用互斥锁保护的有界 sx::circular_buffer, 容量与 mpmc_queue 相同 */
+template<typename T>
+class locked_queue {
+	sx::circular_buffer<T>	container;
+	std::mutex				mutex;
+public:
+	explicit locked_queue(std::size_t capacity) : container(capacity, sx::circular_buffer_policy::reject) {}
+
+	bool try_push(T const &value) {
+		std::lock_guard<std::mutex> lock(mutex);
+		return container.try_push_back(value);
+	}
+
+	bool try_pop(T &value) {
+		std::lock_guard<std::mutex> lock(mutex);
+		if (container.empty())
+			return false;
+		value = container.front();
+		container.pop_front();
+		return true;
+	}
+};
+
+/* producers 个生产者和 consumers 个消费者, 每个生产者写入 count 个元素, 返回消费到的总和 */
+template<typename Queue>
+static long long run_producer_consumer(Queue &queue, int producers, int consumers, int count) {
+	std::atomic<long long> sum(0);
+	std::atomic<int> remain(producers * count);
+	std::vector<std::thread> threads;
+
+	for (int p = 0; p < producers; ++p) {
+		threads.emplace_back([&queue, count]() {
+			for (int i = 1; i <= count; ++i) {
+				while (!queue.try_push(i))
+					std::this_thread::yield();
+			}
+		});
+	}
+
+	for (int c = 0; c < consumers; ++c) {
+		threads.emplace_back([&queue, &sum, &remain]() {
+			long long local = 0;
+			int value;
+			while (remain.load(std::memory_order_relaxed) > 0) {
+				if (queue.try_pop(value)) {
+					local += value;
+					remain.fetch_sub(1, std::memory_order_relaxed);
+				}
+			}
+			sum += local;
+		});
+	}
+
+	for (auto &thread : threads)
+		thread.join();
+
+	return sum;
+}
+
+/* 同样有界的两种队列: 无锁的 sx::mpmc_queue 与互斥锁 + circular_buffer */
+static void circular_buffer_locked_bench() {
+	using clock = std::chrono::steady_clock;
+	const int total = 4000000;
+	for (int threads = 1; threads <= 64; threads *= 2) {
+		int count = total / threads;
+
+		sx::mpmc_queue<int> queue(4096);
+		auto start = clock::now();
+		long long sum1 = run_producer_consumer(queue, threads, threads, count);
+		auto mpmc_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+		locked_queue<int> lqueue(4096);
+		start = clock::now();
+		long long sum2 = run_producer_consumer(lqueue, threads, threads, count);
+		auto locked_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+		cout << "threads:" << threads
+			 << " mpmc_queue:" << mpmc_ms << "ms"
+			 << " mutex + circular_buffer:" << locked_ms << "ms"
+			 << " check:" << (sum1 == sum2) << endl;
+	}
+}
+
+#if 0
+int main(void) {
+	//circular_buffer_basic();
+	//circular_buffer_self_push();
+	//circular_buffer_adapter();
+	//circular_buffer_locked_bench();
+	system("pause");
+}
+#endif
@@ -0,0 +1,91 @@
+#include <iostream>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+#include "vector.hpp"
+#include "map.hpp"
+#include "list.hpp"
+
+using std::cout;
+using std::endl;
+
+/* 反复插入删除之后结点散落在内存池各处, 压缩前后各顺序遍历若干次 */
+static void map_compact_bench() {
+	using clock = std::chrono::steady_clock;
+	const int count = 1000000;
+	const int rounds = 20;
+	std::mt19937 engine(20240701);
+	sx::map<int, int> tree;
+	while (static_cast<int>(tree.size()) < count)
+		tree[static_cast<int>(engine() >> 1)] = 1;
+	for (int i = 0; i < 4 * count; ++i) {
+		auto iter = tree.lower_bound(static_cast<int>(engine() >> 1));
+		if (iter != tree.end())
+			tree.erase(iter);
+		tree[static_cast<int>(engine() >> 1)] = 1;
+	}
+
+	long long sum1 = 0, sum2 = 0;
+	auto start = clock::now();
+	for (int i = 0; i < rounds; ++i) {
+		for (auto &val : tree)
+			sum1 += val.first & 0xff;
+	}
+	auto before_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	start = clock::now();
+	tree.compact();
+	auto compact_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	start = clock::now();
+	for (int i = 0; i < rounds; ++i) {
+		for (auto &val : tree)
+			sum2 += val.first & 0xff;
+	}
+	auto after_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	cout << "map scan before:" << before_ms << "ms compact:" << compact_ms << "ms after:" << after_ms << "ms" << endl;
+	cout << "check:" << (sum1 == sum2) << endl;
+}
+
+/* sort 只重新链接结点, 排序之后按链表顺序遍历就是在内存中随机跳转 */
+static void list_compact_bench() {
+	using clock = std::chrono::steady_clock;
+	const int count = 1000000;
+	const int rounds = 20;
+	std::mt19937 engine(20240702);
+	sx::list<int> lst;
+	for (int i = 0; i < count; ++i)
+		lst.push_back(static_cast<int>(engine() >> 1));
+	lst.sort();
+
+	long long sum1 = 0, sum2 = 0;
+	auto start = clock::now();
+	for (int i = 0; i < rounds; ++i) {
+		for (int val : lst)
+			sum1 += val & 0xff;
+	}
+	auto before_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	start = clock::now();
+	lst.compact();
+	auto compact_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	start = clock::now();
+	for (int i = 0; i < rounds; ++i) {
+		for (int val : lst)
+			sum2 += val & 0xff;
+	}
+	auto after_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	cout << "list scan before:" << before_ms << "ms compact:" << compact_ms << "ms after:" << after_ms << "ms" << endl;
+	cout << "check:" << (sum1 == sum2) << endl;
+}
+
+#if 0
+int main(void) {
+	//map_compact_bench();
+	//list_compact_bench();
+	system("pause");
+}
+#endif
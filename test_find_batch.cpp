@@ -0,0 +1,102 @@
+#include <iostream>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include "vector.hpp"
+#include "map.hpp"
+
+using std::cout;
+using std::endl;
+
+static void find_batch_basic() {
+	sx::map<int, char> table;
+	for (int i = 0; i < 26; ++i)
+		table[i * 2] = static_cast<char>('a' + i);
+
+	/* 有序的一批 key, 每次从上一个结果出发查找 */
+	sx::vector<int> keys{ 0, 3, 4, 4, 20, 51, 60 };
+	sx::vector<sx::map<int, char>::iterator> found(keys.size(), table.end());
+	table.find_batch(keys, found.begin());
+	for (std::size_t i = 0; i < keys.size(); ++i)
+		cout << keys[i] << ":" << (found[i] != table.end() ? found[i]->second : '-') << " ";
+	cout << endl;
+
+	/* 游标式查找: 把上一次的结果作为提示 */
+	auto cursor = table.begin();
+	for (int key : { 10, 11, 30, 31 }) {
+		cursor = table.lower_bound(cursor, key);
+		cout << "lower_bound(" << key << "):" << cursor->first << " ";
+	}
+	cout << endl;
+}
+
+/* 逐个 find 每次从根开始, find_batch 每次从上一个结果出发 */
+template<typename Map>
+static void find_batch_compare(char const *name, Map &tree, sx::vector<int> const &keys) {
+	using clock = std::chrono::steady_clock;
+	const int rounds = 20;
+	sx::vector<typename Map::iterator> found(keys.size(), tree.end());
+
+	long long sum1 = 0, sum2 = 0;
+	auto start = clock::now();
+	for (int i = 0; i < rounds; ++i) {
+		for (int key : keys) {
+			auto iter = tree.find(key);
+			sum1 += iter != tree.end() ? iter->second : 0;
+		}
+	}
+	auto find_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	start = clock::now();
+	for (int i = 0; i < rounds; ++i) {
+		tree.find_batch(keys, found.begin());
+		for (auto &iter : found)
+			sum2 += iter != tree.end() ? iter->second : 0;
+	}
+	auto batch_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	cout << name << " find:" << find_ms << "ms find_batch:" << batch_ms << "ms check:" << (sum1 == sum2) << endl;
+}
+
+static void find_batch_bench() {
+	const int count = 1000000;
+	const int batch = 100000;
+	std::mt19937 engine(20240801);
+	sx::map<int, int> tree;
+	while (static_cast<int>(tree.size()) < count)
+		tree[static_cast<int>(engine() % (8 * count))] = 1;
+
+	/* 一段连续区间里的 key */
+	sx::vector<int> sequential;
+	int base = static_cast<int>(engine() % (7 * count));
+	for (int i = 0; i < batch; ++i)
+		sequential.push_back(base + i);
+
+	/* 100 簇, 每簇在一个小范围内随机取 key */
+	sx::vector<int> clustered;
+	for (int i = 0; i < 100; ++i) {
+		int center = static_cast<int>(engine() % (8 * count));
+		for (int j = 0; j < batch / 100; ++j)
+			clustered.push_back(center + static_cast<int>(engine() % 20000));
+	}
+	std::sort(clustered.begin(), clustered.end());
+
+	/* 整个 key 空间内均匀随机, 排序后相邻 key 平均相隔 n / k 个元素 */
+	sx::vector<int> uniform;
+	for (int i = 0; i < batch; ++i)
+		uniform.push_back(static_cast<int>(engine() % (8 * count)));
+	std::sort(uniform.begin(), uniform.end());
+
+	find_batch_compare("sequential", tree, sequential);
+	find_batch_compare("clustered", tree, clustered);
+	find_batch_compare("uniform", tree, uniform);
+}
+
+#if 0
+int main(void) {
+	//find_batch_basic();
+	//find_batch_bench();
+	system("pause");
+}
+#endif
@@ -0,0 +1,111 @@
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+#include "vector.hpp"
+#include "map.hpp"
+#include "flat_map.hpp"
+#include "flat_set.hpp"
+
+using std::cout;
+using std::endl;
+using std::string;
+
+static void flat_basic() {
+	/* 任意顺序的输入, 排序去重一次; 重复的 key 保留最先出现的 */
+	sx::vector<std::pair<string, int>> raw;
+	raw.push_back(std::make_pair(string("tom"), 20));
+	raw.push_back(std::make_pair(string("jerry"), 18));
+	raw.push_back(std::make_pair(string("tom"), 99));
+	sx::flat_map<string, int> ages(std::move(raw));
+	for (auto &val : ages)
+		cout << val.first << ":" << val.second << " ";
+	cout << endl;
+
+	ages["spike"] = 30;
+	cout << "rank(spike):" << ages.rank("spike") << " nth(0):" << ages.nth(0)->first << endl;
+
+	/* 取出底层序列直接修改, 再放回去, 全程不复制元素 */
+	auto sequence = ages.extract_sequence();
+	for (auto &val : sequence)
+		val.second += 1;
+	ages.replace(std::move(sequence));
+	cout << "tom:" << ages["tom"] << " size:" << ages.size() << endl;
+
+	sx::flat_set<int> numbers(sx::vector<int>{ 5, 1, 4, 1, 5, 9, 2, 6 });
+	sx::vector<int> more{ 3, 5, 8, 9, 7 };
+	numbers.insert_range(more);
+	for (int val : numbers)
+		cout << val << " ";
+	cout << endl;
+}
+
+/* 中间插入和删除要移动后面的元素, 非平凡类型不能泄漏也不能被覆盖 */
+static void flat_string() {
+	sx::flat_set<string> words;
+	words.reserve(8);
+	for (char const *word : { "apple", "cherry", "grape", "melon" })
+		words.insert(string(word) + " with a long tail to defeat small string optimization");
+	words.insert(string("banana") + " with a long tail to defeat small string optimization");
+	words.emplace(string("date") + " with a long tail to defeat small string optimization");
+	words.erase(words.find(string("cherry") + " with a long tail to defeat small string optimization"));
+	for (auto &word : words)
+		cout << word.substr(0, word.find(' ')) << " ";
+	cout << "size:" << words.size() << endl;
+}
+
+/* 一次构建多次查询的表: 对比逐个插入的 map 和排序一次的 flat_map */
+static void flat_bench() {
+	using clock = std::chrono::steady_clock;
+	const int count = 1000000;
+	std::mt19937 engine(20240601);
+	sx::vector<std::pair<int, int>> input;
+	for (int i = 0; i < count; ++i)
+		input.push_back(std::make_pair(static_cast<int>(engine() >> 1), i));
+
+	auto start = clock::now();
+	sx::map<int, int> tree;
+	for (auto &val : input)
+		tree.insert(val);
+	auto tree_build_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	start = clock::now();
+	sx::flat_map<int, int> flat(input.begin(), input.end());
+	auto flat_build_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	long long sum1 = 0, sum2 = 0;
+	start = clock::now();
+	for (auto &val : input)
+		sum1 += tree.find(val.first)->second;
+	auto tree_find_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	start = clock::now();
+	for (auto &val : input)
+		sum2 += flat.find(val.first)->second;
+	auto flat_find_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	/* 批量合入 1% 的新数据: 归并一次, 而不是每个元素都搬动后面的元素 */
+	sx::vector<std::pair<int, int>> batch;
+	for (int i = 0; i < count / 100; ++i)
+		batch.push_back(std::make_pair(static_cast<int>(engine() >> 1), i));
+	start = clock::now();
+	flat.insert_range(batch);
+	auto merge_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+	for (auto &val : batch)
+		tree.insert(val);
+
+	cout << "build map:" << tree_build_ms << "ms flat_map:" << flat_build_ms << "ms" << endl;
+	cout << "find map:" << tree_find_ms << "ms flat_map:" << flat_find_ms << "ms" << endl;
+	cout << "insert_range " << batch.size() << ":" << merge_ms << "ms" << endl;
+	cout << "check:" << (sum1 == sum2 && tree.size() == flat.size()) << endl;
+}
+
+#if 0
+int main(void) {
+	//flat_basic();
+	//flat_string();
+	//flat_bench();
+	system("pause");
+}
+#endif
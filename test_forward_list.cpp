@@ -0,0 +1,101 @@
+#include <iostream>
+#include <cstdlib>
+#include <chrono>
+#include <iterator>
+#include "vector.hpp"
+#include "list.hpp"
+#include "forward_list.hpp"
+#include "queue.hpp"
+
+using std::cout;
+using std::endl;
+
+template<typename T, typename Alloc, bool TrackTail>
+static void print(sx::forward_list<T, Alloc, TrackTail> const &lst) {
+	for (auto &val : lst)
+		cout << val << " ";
+	cout << "size:" << lst.size() << endl;
+}
+
+/* 记录尾结点的单向链表: 每次修改之后 back() 都要指向真正的最后一个元素 */
+static void forward_list_tail() {
+	using tail_list = sx::forward_list<int, sx::allocator<int>, true>;
+	tail_list lst;
+	lst.push_back(2);
+	lst.push_front(1);
+	lst.emplace_back(3);
+	print(lst);
+	cout << "back:" << lst.back() << endl;
+
+	/* 删除最后一个元素之后尾结点前移 */
+	auto iter = lst.begin();
+	++iter;
+	lst.erase_after(iter);
+	lst.push_back(4);
+	print(lst);
+	cout << "back:" << lst.back() << endl;
+
+	/* 整个链表接到尾部, 不需要遍历另一个链表 */
+	tail_list other;
+	other.push_back(9);
+	other.push_back(7);
+	auto last = lst.before_begin();
+	for (auto next = lst.begin(); next != lst.end(); ++next)
+		last = next;
+	lst.splice_after(last, other);
+	cout << "back:" << lst.back() << " other.empty:" << other.empty() << endl;
+
+	/* 排序之后尾结点是最大的元素 */
+	lst.sort();
+	lst.push_back(10);
+	print(lst);
+
+	/* 清空之后尾结点回到头结点 */
+	lst.clear();
+	lst.push_back(5);
+	cout << "front:" << lst.front() << " back:" << lst.back() << endl;
+
+	cout << "sizeof forward_list:" << sizeof(sx::forward_list<int>) << " with tail:" << sizeof(tail_list) << endl;
+}
+
+/* 作为 sx::queue 的底层容器, 与 sx::list 对比 */
+template<typename Container>
+static long long queue_round(int count) {
+	sx::queue<int, Container> fifo;
+	long long sum = 0;
+	for (int i = 0; i < count; ++i) {
+		fifo.push(i);
+		if (i % 4 == 3) {
+			sum += fifo.front();
+			fifo.pop();
+		}
+	}
+	sx::vector<int> rest;
+	fifo.drain(std::back_inserter(rest));
+	for (int val : rest)
+		sum += val;
+	return sum;
+}
+
+static void forward_list_queue_bench() {
+	using clock = std::chrono::steady_clock;
+	const int count = 4000000;
+
+	auto start = clock::now();
+	long long sum1 = queue_round<sx::list<int>>(count);
+	auto list_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	start = clock::now();
+	long long sum2 = queue_round<sx::forward_list<int, sx::allocator<int>, true>>(count);
+	auto forward_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	cout << "queue list:" << list_ms << "ms forward_list:" << forward_ms << "ms check:" << (sum1 == sum2) << endl;
+}
+
+#if 0
+int main(void) {
+	//forward_list_tail();
+	//forward_list_queue_bench();
+	system("pause");
+}
+#endif
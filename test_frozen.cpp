@@ -0,0 +1,98 @@
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+#include "vector.hpp"
+#include "map.hpp"
+#include "set.hpp"
+#include "flat_map.hpp"
+#include "frozen_map.hpp"
+#include "frozen_set.hpp"
+
+using std::cout;
+using std::endl;
+using std::string;
+
+static void frozen_basic() {
+	sx::map<string, int> config;
+	config["timeout"] = 30;
+	config["retries"] = 3;
+	config["port"] = 8080;
+
+	/* 增量构建完之后冻结, 之后只读 */
+	auto table = sx::freeze(config);
+	for (auto &val : table)
+		cout << val.first << ":" << val.second << " ";
+	cout << endl;
+	cout << "port:" << table.at("port") << " count(host):" << table.count("host") << endl;
+
+	/* 需要修改时解冻成 sx::map */
+	auto editable = table.thaw();
+	editable["host"] = 1;
+	cout << "thawed size:" << editable.size() << " frozen size:" << table.size() << endl;
+
+	sx::set<int> primes;
+	for (int val : { 2, 3, 5, 7, 11, 13 })
+		primes.insert(val);
+	auto frozen_primes = sx::freeze(primes);
+	cout << "lower_bound(6):" << *frozen_primes.lower_bound(6) << " rank(11):" << frozen_primes.rank(11) << endl;
+}
+
+/* 随机查找: 红黑树逐个结点指针, 有序数组二分, Eytzinger 布局无分支下降加预取 */
+static void frozen_bench() {
+	using clock = std::chrono::steady_clock;
+	const int count = 1000000;
+	const int queries = 10000000;
+	std::mt19937 engine(20240601);
+	sx::map<int, int> tree;
+	while (static_cast<int>(tree.size()) < count) {
+		int key = static_cast<int>(engine() >> 1);
+		tree[key] = key & 0xff;
+	}
+	sx::vector<int> keys;
+	for (auto &val : tree)
+		keys.push_back(val.first);
+	sx::vector<int> probes;
+	for (int i = 0; i < queries; ++i)
+		probes.push_back(i % 2 ? keys[engine() % count] : static_cast<int>(engine() >> 1));
+
+	sx::flat_map<int, int> flat(sx::sorted_unique, tree.begin(), tree.end());
+	auto start = clock::now();
+	auto frozen = sx::freeze(tree);
+	auto freeze_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	long long sum1 = 0, sum2 = 0, sum3 = 0;
+	start = clock::now();
+	for (int key : probes) {
+		auto iter = tree.find(key);
+		sum1 += iter != tree.end() ? iter->second : 0;
+	}
+	auto tree_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	start = clock::now();
+	for (int key : probes) {
+		auto iter = flat.find(key);
+		sum2 += iter != flat.end() ? iter->second : 0;
+	}
+	auto flat_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	start = clock::now();
+	for (int key : probes) {
+		auto iter = frozen.find(key);
+		sum3 += iter != frozen.end() ? iter->second : 0;
+	}
+	auto frozen_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	cout << "freeze:" << freeze_ms << "ms" << endl;
+	cout << "find map:" << tree_ms << "ms flat_map:" << flat_ms << "ms frozen_map:" << frozen_ms << "ms" << endl;
+	cout << "check:" << (sum1 == sum2 && sum1 == sum3) << endl;
+}
+
+#if 0
+int main(void) {
+	//frozen_basic();
+	//frozen_bench();
+	system("pause");
+}
+#endif
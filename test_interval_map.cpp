@@ -0,0 +1,118 @@
+#include <iostream>
+#include "interval_map.hpp"
+#include "map.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+using std::cout;
+using std::endl;
+using sx::interval_map;
+
+static void interval_map_basic() {
+	interval_map<int, std::string> meetings;
+	meetings.insert(9, 10, "standup");
+	meetings.insert(10, 12, "review");
+	meetings.insert(11, 13, "lunch");
+	meetings.insert(14, 16, "planning");
+
+	cout << "at 11:";
+	meetings.for_each_containing(11, [](auto &val) { cout << " " << val.second; });
+	cout << endl;
+
+	cout << "overlap [12, 15):";
+	for (auto iter : meetings.overlap(12, 15))
+		cout << " " << iter->second << "[" << iter->first.first << "," << iter->first.second << ")";
+	cout << endl;
+
+	cout << "free [13, 14):" << !meetings.overlaps(13, 14) << endl;
+	meetings.erase(std::make_pair(11, 13));
+	cout << "at 12 after erase:" << meetings.stab(12).size() << endl;
+}
+
+/* 子树和: 任意 key 区间内 value 的和都是 O(log n) */
+static void monoid_sum() {
+	struct sum_of_values {
+		using value_type = long long;
+
+		static long long identity() noexcept {
+			return 0;
+		}
+
+		static long long lift(std::pair<const int, int> const &val) noexcept {
+			return val.second;
+		}
+
+		static long long combine(long long first, long long second) noexcept {
+			return first + second;
+		}
+	};
+
+	sx::map<int, int, std::less<int>, sx::allocator<std::pair<const int, int>>,
+		sx::rbtree_monoid_update<sum_of_values>> sales;
+	/* 空表折叠得到单位元 */
+	cout << "empty total:" << sales.aggregate() << endl;
+	for (int day = 1; day <= 30; ++day)
+		sales[day] = day * 10;
+
+	cout << "total:" << sales.aggregate() << endl;
+	cout << "days [8, 15):" << sales.aggregate(8, 15) << endl;
+	sales.erase(10);
+	cout << "after erase day 10:" << sales.aggregate(8, 15) << endl;
+	sales.clear();
+	cout << "cleared total:" << sales.aggregate() << endl;
+}
+
+/* 每个 IP 段映射到一个编号, 对比区间树和在 multimap 上线性扫描 */
+static void interval_map_bench() {
+	using clock = std::chrono::steady_clock;
+	const int count = 50000;
+	const int queries = 1000;
+	std::mt19937 engine(20240601);
+	std::uniform_int_distribution<unsigned int> start_dist(0, 1u << 30);
+	std::uniform_int_distribution<unsigned int> length_dist(1, 1u << 14);
+
+	interval_map<unsigned int, int> tree;
+	sx::multimap<unsigned int, std::pair<unsigned int, int>> scan;
+	for (int i = 0; i < count; ++i) {
+		unsigned int low = start_dist(engine);
+		unsigned int high = low + length_dist(engine);
+		tree.insert(low, high, i);
+		scan.insert(std::make_pair(low, std::make_pair(high, i)));
+	}
+
+	std::vector<unsigned int> points(queries);
+	for (auto &point : points)
+		point = start_dist(engine);
+
+	long long tree_hits = 0;
+	auto start = clock::now();
+	for (unsigned int point : points)
+		tree.for_each_containing(point, [&](auto &) { ++tree_hits; });
+	auto tree_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	long long scan_hits = 0;
+	start = clock::now();
+	for (unsigned int point : points) {
+		for (auto iter = scan.begin(); iter != scan.end(); ++iter) {
+			if (iter->first <= point && point < iter->second.first)
+				++scan_hits;
+		}
+	}
+	auto scan_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	cout << "interval_map:" << tree_ms << "ms"
+		 << " multimap scan:" << scan_ms << "ms"
+		 << " check:" << (tree_hits == scan_hits) << endl;
+}
+
+#if 0
+int main(void) {
+	//interval_map_basic();
+	//monoid_sum();
+	//interval_map_bench();
+	system("pause");
+}
+#endif
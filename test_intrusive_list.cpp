@@ -0,0 +1,157 @@
+﻿#include <iostream>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+#include "vector.hpp"
+#include "intrusive_list.hpp"
+#include "intrusive_forward_list.hpp"
+
+using std::cout;
+using std::endl;
+
+/* 同一个对象可以同时挂在双向链表和单向链表上 */
+struct item {
+	int						value;
+	sx::list_hook			hook;
+	sx::forward_list_hook	forward_hook;
+
+	explicit item(int val = 0) : value(val) {}
+};
+
+using item_list = sx::intrusive_list<item, &item::hook>;
+using item_forward_list = sx::intrusive_forward_list<item, &item::forward_hook>;
+
+static auto item_less = [](item const &first, item const &second) { return first.value < second.value; };
+
+template<typename List>
+static void print(List const &lst) {
+	for (auto &val : lst)
+		cout << val.value << " ";
+	cout << "size:" << lst.size() << endl;
+}
+
+static void intrusive_list_basic() {
+	item items[10];
+	for (int i = 0; i < 10; ++i)
+		items[i].value = (i * 7) % 10;
+
+	/* 挂上与摘下都不分配内存 */
+	item_list lst, other;
+	for (int i = 0; i < 5; ++i)
+		lst.push_back(items[i]);
+	for (int i = 5; i < 10; ++i)
+		other.push_front(items[i]);
+	print(lst);
+	print(other);
+
+	lst.erase(items[2]);
+	cout << "unlinked:" << !items[2].hook.is_linked() << endl;
+
+	/* 把 other 的第一个元素和剩余部分分别接过来 */
+	lst.splice(lst.begin(), other, other.begin());
+	lst.splice(lst.end(), other);
+	print(lst);
+	cout << "other.empty:" << other.empty() << endl;
+
+	lst.reverse();
+	print(lst);
+	lst.inplace_sort(item_less);
+	print(lst);
+
+	/* 有序的两个链表合并 */
+	other.push_back(items[2]);
+	lst.merge(other, item_less);
+	print(lst);
+
+	lst.sort([](item const &first, item const &second) { return first.value > second.value; });
+	print(lst);
+	lst.clear();
+	cout << "cleared:" << !items[0].hook.is_linked() << endl;
+}
+
+static void intrusive_forward_list_basic() {
+	item items[10];
+	for (int i = 0; i < 10; ++i)
+		items[i].value = (i * 3) % 10;
+
+	item_forward_list lst, other;
+	for (int i = 0; i < 5; ++i)
+		lst.push_front(items[i]);
+	for (int i = 5; i < 10; ++i)
+		other.push_front(items[i]);
+	print(lst);
+
+	lst.erase(items[3]);
+	lst.splice_after(lst.before_begin(), other, other.before_begin());
+	print(lst);
+
+	lst.reverse();
+	print(lst);
+	lst.inplace_sort(item_less);
+	other.sort(item_less);
+	lst.merge(other, item_less);
+	print(lst);
+	cout << "other.empty:" << other.empty() << endl;
+
+	lst.push_front(items[3]);
+	lst.sort(item_less);
+	print(lst);
+	lst.clear();
+}
+
+/* 借助缓冲区的 sort 与不分配内存的 inplace_sort 对比 */
+static void intrusive_list_sort_bench() {
+	using clock = std::chrono::steady_clock;
+	const int count = 1000000;
+	std::mt19937 engine(20241101);
+	sx::vector<item> items;
+	items.reserve(count);
+	for (int i = 0; i < count; ++i)
+		items.push_back(item(static_cast<int>(engine() >> 1)));
+
+	item_list lst;
+	for (auto &val : items)
+		lst.push_back(val);
+	auto start = clock::now();
+	lst.sort(item_less);
+	auto sort_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+	long long sum1 = 0, index = 0;
+	for (auto &val : lst)
+		sum1 += val.value % 1000 * (++index % 7);
+	lst.clear();
+
+	for (auto &val : items)
+		lst.push_back(val);
+	start = clock::now();
+	lst.inplace_sort(item_less);
+	auto inplace_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+	long long sum2 = 0;
+	index = 0;
+	for (auto &val : lst)
+		sum2 += val.value % 1000 * (++index % 7);
+	lst.clear();
+
+	item_forward_list flst;
+	for (auto &val : items)
+		flst.push_front(val);
+	start = clock::now();
+	flst.inplace_sort(item_less);
+	auto forward_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+	long long sum3 = 0;
+	index = 0;
+	for (auto &val : flst)
+		sum3 += val.value % 1000 * (++index % 7);
+	flst.clear();
+
+	cout << "sort:" << sort_ms << "ms inplace_sort:" << inplace_ms << "ms forward inplace_sort:" << forward_ms
+		<< "ms check:" << (sum1 == sum2 && sum2 == sum3) << endl;
+}
+
+#if 0
+int main(void) {
+	//intrusive_list_basic();
+	//intrusive_forward_list_basic();
+	//intrusive_list_sort_bench();
+	system("pause");
+}
+#endif
@@ -1,9 +1,12 @@
 #include <iostream>
 #include "test_head.hpp"
 #include "list.hpp"
+#include "forward_list.hpp"
 #include <array>
 #include <cstdlib>
 #include <ctime>
+#include <chrono>
+#include <random>
 
 using std::cout;
 using std::endl;
@@ -129,6 +132,138 @@ static void list_sort() {
 	print(lst, "lst");
 }
 
+/* 原来的 list::sort: 借助 64 个临时链表, 通过 splice / merge 归并, 留作排序的对比基准 */
+template<typename T>
+static void splice_merge_sort(list<T> &lst) {
+	if (lst.empty())
+		return;
+
+	list<T> carry;
+	list<T> counter[64];
+	int fill = 0;
+	while (!lst.empty()) {
+		carry.splice(carry.begin(), lst, lst.begin());
+		int i = 0;
+		while (i < fill && !counter[i].empty()) {
+			counter[i].merge(carry);
+			carry.swap(counter[i++]);
+		}
+		carry.swap(counter[i]);
+		if (i == fill)
+			++fill;
+	}
+
+	for (int i = 1; i < fill; ++i)
+		counter[i].merge(counter[i - 1]);
+	lst.swap(counter[fill - 1]);
+}
+
+/*
+ * 排完序的结点在内存中是乱序的, 直接清空重建会从分配器拿回打乱的结点.
+ * 按地址把结点排回物理顺序再重新填入同样的随机数, 每种排序都面对相同的内存布局
+ */
+static void refill(list<int> &lst, std::size_t count) {
+	lst.inplace_sort([](int const &first, int const &second) { return &first < &second; });
+	std::mt19937 engine(static_cast<unsigned int>(count));
+	for (int &val : lst)
+		val = static_cast<int>(engine());
+}
+
+/* 对比指针数组排序, 结点级的自底向上归并和原来基于 splice / merge 的归并排序, 元素个数 1M ~ 100M */
+static void list_sort_bench() {
+	using clock = std::chrono::steady_clock;
+	for (std::size_t count = 1000000; count <= 100000000; count *= 10) {
+		list<int> lst;
+		for (std::size_t i = 0; i < count; ++i)
+			lst.emplace_back(0);
+
+		refill(lst, count);
+		auto start = clock::now();
+		splice_merge_sort(lst);
+		auto splice_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+		refill(lst, count);
+		start = clock::now();
+		lst.inplace_sort();
+		auto inplace_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+		refill(lst, count);
+		start = clock::now();
+		lst.sort();
+		auto sort_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+		cout << "count:" << count
+			 << " splice/merge:" << splice_ms << "ms"
+			 << " inplace_sort:" << inplace_ms << "ms"
+			 << " sort:" << sort_ms << "ms" << endl;
+	}
+}
+
+/* 回收结点缓存: 只有 NodeCache 为 true 的链表才多出三个字段 */
+static void list_node_cache() {
+	using cached_list = list<int, sx::allocator<int>, true>;
+	using cached_forward_list = sx::forward_list<int, sx::allocator<int>, false, true>;
+	cout << "sizeof list:" << sizeof(list<int>) << " cached:" << sizeof(cached_list) << endl;
+	cout << "sizeof forward_list:" << sizeof(sx::forward_list<int>) << " cached:" << sizeof(cached_forward_list) << endl;
+
+	cached_list lst;
+	lst.reserve(100);
+	cout << "reserve cache:" << lst.node_cache_size() << " limit:" << lst.node_cache_limit() << endl;
+	for (int i = 0; i < 100; ++i)
+		lst.push_back(i);
+	cout << "push_back cache:" << lst.node_cache_size() << endl;
+	for (int i = 0; i < 30; ++i)
+		lst.pop_front();
+	cout << "pop_front cache:" << lst.node_cache_size() << endl;
+	lst.set_node_cache_limit(10);
+	lst.clear();
+	cout << "clear cache:" << lst.node_cache_size() << " size:" << lst.size() << endl;
+	lst.shrink_to_fit();
+	cout << "shrink_to_fit cache:" << lst.node_cache_size() << endl;
+
+	cached_forward_list flst;
+	flst.set_node_cache_limit(4);
+	for (int i = 0; i < 8; ++i)
+		flst.push_front(i);
+	flst.clear();
+	flst.push_front(1);
+	cout << "forward_list cache:" << flst.node_cache_size() << " size:" << flst.size() << endl;
+}
+
+/* 频繁在头部删除, 尾部插入 (类似 LRU), 对比有无结点缓存 */
+static void list_node_cache_bench() {
+	using clock = std::chrono::steady_clock;
+	const int count = 1000;
+	const int rounds = 20000000;
+
+	list<int> plain;
+	list<int, sx::allocator<int>, true> cached;
+	cached.set_node_cache_limit(count);
+	for (int i = 0; i < count; ++i) {
+		plain.push_back(i);
+		cached.push_back(i);
+	}
+
+	long long sum1 = 0, sum2 = 0;
+	auto start = clock::now();
+	for (int i = 0; i < rounds; ++i) {
+		sum1 += plain.front();
+		plain.pop_front();
+		plain.push_back(i);
+	}
+	auto plain_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	start = clock::now();
+	for (int i = 0; i < rounds; ++i) {
+		sum2 += cached.front();
+		cached.pop_front();
+		cached.push_back(i);
+	}
+	auto cached_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	cout << "churn plain:" << plain_ms << "ms cached:" << cached_ms << "ms check:" << (sum1 == sum2) << endl;
+}
+
 #if 0
 int main(void) {
 	//list_constrcut();
@@ -138,6 +273,9 @@ int main(void) {
 	//list_unique();
 	//list_splice();
 	//list_sort();
+	//list_sort_bench();
+	//list_node_cache();
+	//list_node_cache_bench();
 	system("pause");
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,182 @@
+#include <iostream>
+#include "lru_cache.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <list>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using std::cout;
+using std::endl;
+using sx::lru_cache;
+using sx::lfu_cache;
+
+static void lru_cache_basic() {
+	lru_cache<int, std::string> cache(3);
+	cache.set_evict_callback([](int const &key, std::string &value) {
+		cout << "evict:" << key << " " << value << endl;
+	});
+	cache.put(1, "one");
+	cache.put(2, "two");
+	cache.put(3, "three");
+	cache.get(1);
+	cache.put(4, "four");			/* 淘汰 2 */
+	cout << "cache.size:" << cache.size() << endl;
+	cout << "contains 2:" << cache.contains(2) << endl;
+	cout << "get 1:" << *cache.get(1) << endl;
+
+	cache.put(3, "THREE");
+	cache.erase(4);
+	cache.set_capacity(1);			/* 淘汰 1 */
+	cout << "peek 3:" << *cache.peek(3) << endl;
+}
+
+/* 按字符串长度计算权重, 容量表示总字节数 */
+static void lru_cache_weight() {
+	struct length_weight {
+		std::size_t operator()(int const &, std::string const &value) const noexcept {
+			return value.size();
+		}
+	};
+
+	lru_cache<int, std::string, length_weight> cache(10);
+	cache.put(1, "aaaa");
+	cache.put(2, "bbbb");
+	cache.put(3, "cccc");			/* 淘汰 1 */
+	cout << "cache.weight:" << cache.weight() << " size:" << cache.size() << endl;
+	cout << "put too large:" << cache.put(4, "xxxxxxxxxxxx") << endl;
+}
+
+static void lfu_cache_basic() {
+	lfu_cache<int, int> cache(2);
+	cache.put(1, 1);
+	cache.put(2, 2);
+	cache.get(1);
+	cache.get(1);
+	cache.put(3, 3);				/* 淘汰访问次数最少的 2 */
+	cout << "contains 2:" << cache.contains(2) << endl;
+	cout << "frequency 1:" << cache.frequency(1) << endl;
+	cache.get(3);
+	cache.put(4, 4);				/* 1 和 3 中淘汰访问次数少的 3 */
+	cout << "contains 3:" << cache.contains(3) << endl;
+}
+
+/* 带虚函数的值类型不是标准布局, 链接在缓存项的基类中, 仍然可以缓存 */
+static void lru_cache_polymorphic() {
+	struct shape {
+		int size;
+	public:
+		explicit shape(int size = 0) : size(size) {}
+		virtual ~shape() {}
+		virtual int area() const { return size * size; }
+	};
+
+	lru_cache<int, shape> lru(2);
+	lfu_cache<int, shape> lfu(2);
+	for (int i = 1; i <= 3; ++i) {
+		lru.put(i, shape(i));
+		lfu.put(i, shape(i));
+		lfu.get(i);
+	}
+	cout << "lru contains 1:" << lru.contains(1) << " area 3:" << lru.get(3)->area() << endl;
+	cout << "lfu contains 1:" << lfu.contains(1) << " area 2:" << lfu.get(2)->area() << endl;
+}
+
+/* 按 Zipf 分布生成访问序列, 排名越靠前的 key 被访问的概率越大 */
+static std::vector<int> zipf_trace(int keys, std::size_t length, double skew, unsigned int seed) {
+	std::vector<double> cdf(keys);
+	double sum = 0;
+	for (int i = 0; i < keys; ++i) {
+		sum += 1.0 / std::pow(i + 1.0, skew);
+		cdf[i] = sum;
+	}
+
+	std::mt19937 engine(seed);
+	std::uniform_real_distribution<double> dist(0, sum);
+	std::vector<int> trace(length);
+	for (auto &key : trace)
+		key = static_cast<int>(std::lower_bound(cdf.begin(), cdf.end(), dist(engine)) - cdf.begin());
+	return trace;
+}
+
+/* 手写的 std::list + std::unordered_map 版本, 每个元素分配两次, 作为对照 */
+class hand_rolled_lru {
+	std::size_t										capacity;
+	std::list<std::pair<int, int>>					order;
+	std::unordered_map<int, std::list<std::pair<int, int>>::iterator>	index;
+public:
+	explicit hand_rolled_lru(std::size_t capacity) : capacity(capacity) {}
+
+	int *get(int key) {
+		auto it = index.find(key);
+		if (it == index.end())
+			return nullptr;
+		order.splice(order.begin(), order, it->second);
+		return &it->second->second;
+	}
+
+	void put(int key, int value) {
+		if (order.size() == capacity) {
+			index.erase(order.back().first);
+			order.pop_back();
+		}
+		order.emplace_front(key, value);
+		index[key] = order.begin();
+	}
+};
+
+template<typename Cache>
+static void run_trace(char const *name, Cache &cache, std::vector<int> const &trace) {
+	using clock = std::chrono::steady_clock;
+	std::size_t hits = 0;
+	auto start = clock::now();
+	for (int key : trace) {
+		if (cache.get(key) != nullptr)
+			++hits;
+		else
+			cache.put(key, key);
+	}
+	auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	cout << name << " hit:" << 100.0 * hits / trace.size() << "%"
+		 << " time:" << ms << "ms"
+		 << " ops/ms:" << (ms == 0 ? 0 : trace.size() / ms) << endl;
+}
+
+/* 不同容量下 LRU / LFU 的命中率以及每秒操作数 */
+static void lru_cache_bench() {
+	const int keys = 1000000;
+	const std::size_t length = 10000000;
+	for (double skew : { 0.8, 0.99, 1.2 }) {
+		std::vector<int> trace = zipf_trace(keys, length, skew, 20240601);
+		for (std::size_t capacity : { keys / 100, keys / 20, keys / 10 }) {
+			cout << "skew:" << skew << " capacity:" << capacity << endl;
+
+			lru_cache<int, int> lru(capacity);
+			lru.reserve(capacity);
+			run_trace("  lru_cache  ", lru, trace);
+
+			lfu_cache<int, int> lfu(capacity);
+			lfu.reserve(capacity);
+			run_trace("  lfu_cache  ", lfu, trace);
+
+			hand_rolled_lru hand(capacity);
+			run_trace("  hand_rolled", hand, trace);
+		}
+	}
+}
+
+#if 0
+int main(void) {
+	//lru_cache_basic();
+	//lru_cache_weight();
+	//lfu_cache_basic();
+	//lru_cache_polymorphic();
+	//lru_cache_bench();
+	system("pause");
+}
+#endif
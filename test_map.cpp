@@ -1,6 +1,8 @@
 #include <iostream>
 #include <string>
 #include <cstdlib>
+#include <chrono>
+#include <string_view>
 #include "vector.hpp"
 #include "map.hpp"
 #include "unordered_set.hpp"
@@ -191,6 +193,212 @@ static void multi_find() {
 		cout << (*result).first << endl;
 }
 
+/* 有序数据建 map: 逐个插入, 区间构造 (自动检测有序) 和 sorted_unique 构造 */
+static void map_sorted_build_bench() {
+	using clock = std::chrono::steady_clock;
+	for (int count = 1000000; count <= 16000000; count *= 4) {
+		vector<std::pair<int, int>> vec;
+		vec.reserve(count);
+		for (int i = 0; i < count; ++i)
+			vec.push_back({ i, i });
+
+		auto start = clock::now();
+		type map1;
+		for (auto &val : vec)
+			map1.insert(val);
+		auto insert_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+		start = clock::now();
+		type map2(vec.begin(), vec.end());
+		auto range_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+		start = clock::now();
+		type map3(sx::sorted_unique, vec.begin(), vec.end());
+		auto sorted_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+		cout << "count:" << count
+			 << " insert:" << insert_ms << "ms"
+			 << " range:" << range_ms << "ms"
+			 << " sorted_unique:" << sorted_ms << "ms" << endl;
+	}
+}
+
+/* 时间戳递增追加: 普通插入每次从根查找, 以 end() 为提示时直接挂到最右结点 */
+static void map_hint_bench() {
+	using clock = std::chrono::steady_clock;
+	for (int count = 1000000; count <= 16000000; count *= 4) {
+		auto start = clock::now();
+		type map1;
+		for (int i = 0; i < count; ++i)
+			map1.emplace(i, i);
+		auto emplace_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+		start = clock::now();
+		type map2;
+		for (int i = 0; i < count; ++i)
+			map2.emplace_hint(map2.end(), i, i);
+		auto hint_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+		cout << "count:" << count
+			 << " emplace:" << emplace_ms << "ms"
+			 << " emplace_hint:" << hint_ms << "ms" << endl;
+	}
+}
+
+/* key 已存在时 try_emplace 不会构造 value, 也不会移走参数; insert_or_assign 覆盖旧值 */
+static void try_emplace() {
+	sx::map<int, string> map1;
+	string name = "one";
+	map1.try_emplace(1, std::move(name));
+	string other = "uno";
+	auto ret = map1.try_emplace(1, std::move(other));
+	cout << "inserted:" << ret.second << " value:" << (*ret.first).second << " other:" << other << endl;
+
+	ret = map1.insert_or_assign(1, string("ONE"));
+	cout << "inserted:" << ret.second << " value:" << (*ret.first).second << endl;
+	map1.insert_or_assign(map1.end(), 2, string("two"));
+	map1[3] = "three";
+	for (auto &val : map1)
+		cout << "[" << val.first << ", " << val.second << "]" << endl;
+
+	sx::unordered_map<string, int> map2;
+	for (string word : { "a", "b", "a", "c", "a" })
+		++map2[word];
+	map2.try_emplace("d", 0);
+	map2.insert_or_assign("b", 10);
+	for (auto &val : map2)
+		cout << "[" << val.first << ", " << val.second << "]" << endl;
+
+	/* 桶恰好用满时, 可转换的参数和多个构造参数插入已有的 key 也不会扩容 */
+	for (int i = 0; map2.size() < map2.bucket_count(); ++i)
+		map2.try_emplace(std::to_string(i), i);
+	std::size_t buckets = map2.bucket_count();
+	for (int i = 0; i < 1000; ++i) {
+		map2.insert(std::pair<char const *, int>("a", i));
+		map2.emplace("b", i);
+	}
+	cout << "size:" << map2.size() << " a:" << map2["a"] << " rehashed:" << (map2.bucket_count() != buckets) << endl;
+}
+
+/* 结点句柄: 修改 key 和在容器之间移动元素都不分配内存 */
+static void node_handle() {
+	sx::map<int, string> map1;
+	for (int i = 0; i < 5; ++i)
+		map1.try_emplace(i, std::to_string(i));
+
+	auto handle = map1.extract(2);
+	handle.key() = 20;
+	map1.insert(std::move(handle));
+
+	sx::map<int, string> map2;
+	map2.try_emplace(0, "zero");
+	map2.try_emplace(30, "thirty");
+	map1.merge(map2);			/* key 0 已存在, 留在 map2 中 */
+
+	for (auto &val : map1)
+		cout << "[" << val.first << ", " << val.second << "]" << endl;
+	cout << "map2.size:" << map2.size() << endl;
+}
+
+/* 用 string_view 查找: std::less<string> 每次都要构造临时 string, std::less<> 直接比较 */
+static void transparent_find_bench() {
+	using clock = std::chrono::steady_clock;
+	const int count = 100000;
+	vector<string> words;
+	for (int i = 0; i < count; ++i)
+		words.push_back("request-header-field-" + std::to_string(i));
+	vector<std::string_view> views;
+	for (int i = 0; i < count; ++i)
+		views.push_back(words[i]);
+
+	sx::map<string, int> map1;
+	sx::map<string, int, std::less<>> map2;
+	for (int i = 0; i < count; ++i) {
+		map1.try_emplace(words[i], i);
+		map2.try_emplace(words[i], i);
+	}
+
+	long long sum1 = 0, sum2 = 0;
+	auto start = clock::now();
+	for (int round = 0; round < 10; ++round)
+		for (int i = 0; i < count; ++i)
+			sum1 += map1.find(string(views[i]))->second;
+	auto plain_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	start = clock::now();
+	for (int round = 0; round < 10; ++round)
+		for (int i = 0; i < count; ++i)
+			sum2 += map2.find(views[i])->second;
+	auto transparent_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	cout << "less<string>:" << plain_ms << "ms"
+		 << " less<>:" << transparent_ms << "ms"
+		 << " check:" << (sum1 == sum2) << endl;
+}
+
+/* 排行榜: 分数 -> 玩家编号, 维护子树大小后第 k 名和区间人数都是 O(log n) */
+static void order_statistics() {
+	using score_map = sx::multimap<int, int, std::less<int>,
+		sx::allocator<std::pair<const int, int>>, sx::rbtree_order_statistics>;
+	score_map scores;
+	for (int player = 0; player < 1000; ++player)
+		scores.insert(std::make_pair(player * 37 % 1000, player));
+
+	cout << "10th lowest score:" << scores.nth(9)->first << endl;
+	cout << "players below 500:" << scores.rank(500) << endl;
+	cout << "players in [100, 200):" << scores.count_range(100, 200) << endl;
+	cout << "median:" << scores.nth(scores.size() / 2)->first << endl;
+
+	scores.erase(scores.nth(0));
+	cout << "after erase, lowest:" << scores.nth(0)->first << " size:" << scores.size() << endl;
+}
+
+/* 给读者拍快照: 拷贝构造直接复制树形和桶, 快照按先序分配, 遍历比乱序插入建成的原表更快 */
+static void snapshot_bench() {
+	using clock = std::chrono::steady_clock;
+	const int count = 1000000;
+	sx::map<int, int> live;
+	sx::unordered_map<int, int> live_hash;
+	unsigned int seed = 20240601;
+	for (int i = 0; i < count; ++i) {
+		seed = seed * 1103515245 + 12345;
+		live[static_cast<int>(seed >> 1)] = i;
+		live_hash[static_cast<int>(seed >> 1)] = i;
+	}
+
+	auto start = clock::now();
+	sx::map<int, int> snapshot(live);
+	auto copy_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	start = clock::now();
+	sx::map<int, int> replay;
+	for (auto &val : live)
+		replay.insert(val);
+	auto replay_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	start = clock::now();
+	sx::unordered_map<int, int> hash_snapshot(live_hash);
+	auto hash_copy_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	long long sum1 = 0, sum2 = 0;
+	start = clock::now();
+	for (auto &val : live)
+		sum1 += val.second;
+	auto live_scan_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	start = clock::now();
+	for (auto &val : snapshot)
+		sum2 += val.second;
+	auto snapshot_scan_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	cout << "map copy:" << copy_ms << "ms"
+		 << " insert one by one:" << replay_ms << "ms"
+		 << " unordered_map copy:" << hash_copy_ms << "ms" << endl;
+	cout << "scan live:" << live_scan_ms << "ms"
+		 << " scan snapshot:" << snapshot_scan_ms << "ms"
+		 << " check:" << (sum1 == sum2 && hash_snapshot.size() == live_hash.size()) << endl;
+}
+
 #if 0
 int main() {
 	//construct();
@@ -203,6 +411,13 @@ int main() {
 	//multi_insert();
 	//erase();
 	//multi_find();
+	//map_sorted_build_bench();
+	//map_hint_bench();
+	//try_emplace();
+	//node_handle();
+	//transparent_find_bench();
+	//order_statistics();
+	//snapshot_bench();
 
 	cout << endl;
 	system("pause");
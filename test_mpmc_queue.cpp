@@ -0,0 +1,138 @@
+﻿#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "mpmc_queue.hpp"
+#include "queue.hpp"
+#include "list.hpp"
+
+using std::cout;
+using std::endl;
+using sx::mpmc_queue;
+
+/* 用互斥锁保护的 sx::queue, 超过 capacity 时拒绝写入, 容量与 mpmc_queue 相同, 作为基准对照 */
+template<typename T>
+class locked_queue {
+	sx::queue<T, sx::list<T>>	container;
+	std::size_t					capacity;
+	std::mutex					mutex;
+public:
+	explicit locked_queue(std::size_t capacity) : capacity(capacity) {}
+
+	bool try_push(T const &value) {
+		std::lock_guard<std::mutex> lock(mutex);
+		if (container.size() >= capacity)
+			return false;
+		container.push(value);
+		return true;
+	}
+
+	bool try_pop(T &value) {
+		std::lock_guard<std::mutex> lock(mutex);
+		if (container.empty())
+			return false;
+		value = container.front();
+		container.pop();
+		return true;
+	}
+};
+
+/* producers 个生产者和 consumers 个消费者, 每个生产者写入 count 个元素, 返回消费到的总和 */
+template<typename Queue>
+static long long run_producer_consumer(Queue &queue, int producers, int consumers, int count) {
+	std::atomic<long long> sum(0);
+	std::atomic<int> remain(producers * count);
+	std::vector<std::thread> threads;
+
+	for (int p = 0; p < producers; ++p) {
+		threads.emplace_back([&queue, count]() {
+			for (int i = 1; i <= count; ++i) {
+				while (!queue.try_push(i))
+					std::this_thread::yield();
+			}
+		});
+	}
+
+	for (int c = 0; c < consumers; ++c) {
+		threads.emplace_back([&queue, &sum, &remain]() {
+			long long local = 0;
+			int value;
+			while (remain.load(std::memory_order_relaxed) > 0) {
+				if (queue.try_pop(value)) {
+					local += value;
+					remain.fetch_sub(1, std::memory_order_relaxed);
+				}
+			}
+			sum += local;
+		});
+	}
+
+	for (auto &thread : threads)
+		thread.join();
+
+	return sum;
+}
+
+static void mpmc_queue_basic() {
+	mpmc_queue<int> queue(5);
+	cout << "queue.capacity:" << queue.capacity() << endl;
+
+	for (int i = 0; i < 10; ++i)
+		cout << "try_push(" << i << "):" << queue.try_push(i) << endl;
+	cout << "queue.size:" << queue.size() << endl;
+
+	int value;
+	while (queue.try_pop(value))
+		cout << value << endl;
+	cout << "queue.empty:" << queue.empty() << endl;
+
+	queue.push(100);
+	queue.emplace(200);
+	cout << queue.pop() << endl;
+	queue.pop(value);
+	cout << value << endl;
+}
+
+static void mpmc_queue_stress() {
+	const int count = 100000;
+	for (int threads = 1; threads <= 8; threads *= 2) {
+		mpmc_queue<int> queue(1024);
+		long long sum = run_producer_consumer(queue, threads, threads, count);
+		long long expect = static_cast<long long>(count) * (count + 1) / 2 * threads;
+		cout << "threads:" << threads << (sum == expect ? " ok" : " failed") << endl;
+	}
+}
+
+static void mpmc_queue_bench() {
+	using clock = std::chrono::steady_clock;
+	const int total = 4000000;
+	for (int threads = 1; threads <= 64; threads *= 2) {
+		int count = total / threads;
+
+		mpmc_queue<int> queue(4096);
+		auto start = clock::now();
+		run_producer_consumer(queue, threads, threads, count);
+		auto mpmc_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+		locked_queue<int> lqueue(4096);
+		start = clock::now();
+		run_producer_consumer(lqueue, threads, threads, count);
+		auto locked_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+		cout << "threads:" << threads
+			 << " mpmc_queue:" << mpmc_ms << "ms"
+			 << " mutex + queue:" << locked_ms << "ms" << endl;
+	}
+}
+
+#if 0
+int main(void) {
+	//mpmc_queue_basic();
+	//mpmc_queue_stress();
+	//mpmc_queue_bench();
+	system("pause");
+}
+#endif
@@ -5,6 +5,8 @@
 #include <string>
 #include <utility>
 #include <array>
+#include <chrono>
+#include <random>
 
 // extern template class sx::set<int>;
 using std::cout;
@@ -361,6 +363,67 @@ void multi_find() {
 }
 #endif
 
+#if 0
+/* 基于 join/split 的集合运算, other 中的结点被直接复用 */
+void set_algebra() {
+	set<int> set1, set2;
+	for (int i = 0; i < 10; ++i) {
+		set1.insert(i);
+		set2.insert(i + 5);
+	}
+
+	set<int> upper = set1.split(5);
+	print(set1, "set1 split < 5");
+	print(upper, "upper >= 5");
+	set1.join(upper);
+
+	set1.union_with(set2);
+	print(set1, "set1 union set2");
+	cout << "set2.size: " << set2.size() << endl;
+
+	set<int> evens;
+	for (int i = 0; i < 20; i += 2)
+		evens.insert(i);
+	set1.intersect_with(evens);
+	print(set1, "set1 intersect evens");
+}
+#endif
+
+#if 0
+/* 两个各 n 个元素的 set 求并: 逐个插入 / union_with / 并行 union_with */
+void set_algebra_bench() {
+	using clock = std::chrono::steady_clock;
+	const int count = 1000000;
+	std::mt19937 engine(20240601);
+	set<int> shard1, shard2;
+	for (int i = 0; i < count; ++i) {
+		shard1.insert(static_cast<int>(engine()));
+		shard2.insert(static_cast<int>(engine()));
+	}
+
+	set<int> copy1(shard1), copy2(shard2);
+	auto start = clock::now();
+	for (int val : copy2)
+		copy1.insert(val);
+	auto insert_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	set<int> join1(shard1), join2(shard2);
+	start = clock::now();
+	join1.union_with(join2);
+	auto join_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	set<int> parallel1(shard1), parallel2(shard2);
+	start = clock::now();
+	parallel1.union_with(sx::parallel, parallel2);
+	auto parallel_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	cout << "insert:" << insert_ms << "ms"
+		 << " union_with:" << join_ms << "ms"
+		 << " parallel:" << parallel_ms << "ms"
+		 << " check:" << (copy1.size() == join1.size() && join1.size() == parallel1.size()) << endl;
+}
+#endif
+
 #if 0
 int main(void) {
 	construct();
@@ -374,6 +437,9 @@ int main(void) {
 	multi_emplace();
 	multi_erase();
 	multi_find();
+
+	//set_algebra();
+	//set_algebra_bench();
 	
 	cout << endl;
 	system("pause");
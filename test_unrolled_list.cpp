@@ -0,0 +1,148 @@
+#include <iostream>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+#include "list.hpp"
+#include "unrolled_list.hpp"
+
+using std::cout;
+using std::endl;
+
+template<typename T, std::size_t K, typename Alloc>
+static void print(sx::unrolled_list<T, K, Alloc> const &lst) {
+	for (auto &val : lst)
+		cout << val << " ";
+	cout << "size:" << lst.size() << endl;
+}
+
+static void unrolled_list_basic() {
+	/* 每个结点只放 4 个元素, 方便观察分裂与合并 */
+	sx::unrolled_list<int, 4> lst{ 1, 2, 3, 4, 5, 6, 7, 8 };
+	auto iter = lst.begin();
+	++iter;
+	lst.insert(iter, 100);
+	lst.push_front(0);
+	lst.push_back(9);
+	print(lst);
+
+	iter = lst.begin();
+	for (int i = 0; i < 3; ++i)
+		++iter;
+	iter = lst.erase(iter);
+	cout << "after erase:" << *iter << endl;
+	lst.erase(lst.begin(), iter);
+	print(lst);
+
+	lst.reverse();
+	print(lst);
+	lst.sort();
+	print(lst);
+}
+
+/* remove_if / unique 之后不足半满的结点会合并, merge 复用两边的结点 */
+static void unrolled_list_merge() {
+	sx::unrolled_list<int, 4> odd, even;
+	for (int i = 0; i < 20; ++i) {
+		odd.push_back(2 * i + 1);
+		even.push_back(2 * i);
+	}
+	odd.merge(even);
+	print(odd);
+	cout << "even.empty:" << even.empty() << endl;
+
+	odd.remove_if([](int val) { return val % 3 != 0; });
+	print(odd);
+
+	sx::unrolled_list<int, 4> dup{ 1, 1, 2, 2, 2, 3, 4, 4, 5, 5, 5, 5 };
+	dup.unique();
+	print(dup);
+
+	/* 两边不交错时整个结点直接链入 */
+	sx::unrolled_list<int, 4> low{ 1, 2, 3, 4, 5 }, high{ 10, 11, 12 };
+	high.merge(low);
+	print(high);
+
+	sx::unrolled_list<int, 4> tail{ 20, 21 };
+	auto pos = high.begin();
+	++pos;
+	high.splice(pos, tail);
+	print(high);
+}
+
+/* 顺序遍历, 按条件删除与 merge 对比 sx::list (sx::list 没有 remove_if, 逐个 erase) */
+static void unrolled_list_bench() {
+	using clock = std::chrono::steady_clock;
+	const int count = 2000000;
+	const int rounds = 20;
+	std::mt19937 engine(20241001);
+
+	sx::list<int> lst, lst2;
+	sx::unrolled_list<int> ulst, ulst2;
+	for (int i = 0; i < count; ++i) {
+		int val = static_cast<int>(engine() >> 1);
+		lst.push_back(val);
+		ulst.push_back(val);
+		val = static_cast<int>(engine() >> 1);
+		lst2.push_back(val);
+		ulst2.push_back(val);
+	}
+
+	long long sum1 = 0, sum2 = 0;
+	auto start = clock::now();
+	for (int i = 0; i < rounds; ++i) {
+		for (int val : lst)
+			sum1 += val & 0xff;
+	}
+	auto list_scan_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	start = clock::now();
+	for (int i = 0; i < rounds; ++i) {
+		for (int val : ulst)
+			sum2 += val & 0xff;
+	}
+	auto unrolled_scan_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+	cout << "scan list:" << list_scan_ms << "ms unrolled_list:" << unrolled_scan_ms << "ms check:" << (sum1 == sum2) << endl;
+
+	auto pred = [](int val) { return val % 3 == 0; };
+	start = clock::now();
+	for (auto iter = lst.begin(); iter != lst.end(); ) {
+		if (pred(*iter))
+			iter = lst.erase(iter);
+		else
+			++iter;
+	}
+	auto list_remove_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	start = clock::now();
+	ulst.remove_if(pred);
+	auto unrolled_remove_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+	cout << "remove_if list:" << list_remove_ms << "ms unrolled_list:" << unrolled_remove_ms << "ms check:" << (lst.size() == ulst.size()) << endl;
+
+	lst.sort();
+	lst2.sort();
+	ulst.sort();
+	ulst2.sort();
+	start = clock::now();
+	lst.merge(lst2);
+	auto list_merge_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	start = clock::now();
+	ulst.merge(ulst2);
+	auto unrolled_merge_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+	unsigned long long hash1 = 0, hash2 = 0;
+	for (int val : lst)
+		hash1 = hash1 * 31 + static_cast<unsigned int>(val);
+	for (int val : ulst)
+		hash2 = hash2 * 31 + static_cast<unsigned int>(val);
+	cout << "merge list:" << list_merge_ms << "ms unrolled_list:" << unrolled_merge_ms << "ms check:" << (hash1 == hash2) << endl;
+}
+
+#if 0
+int main(void) {
+	//unrolled_list_basic();
+	//unrolled_list_merge();
+	//unrolled_list_bench();
+	system("pause");
+}
+#endif
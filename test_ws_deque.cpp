@@ -0,0 +1,119 @@
+﻿#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "ws_deque.hpp"
+
+using std::cout;
+using std::endl;
+using sx::ws_deque;
+
+static void ws_deque_basic() {
+	ws_deque<int> deque(2);
+	for (int i = 0; i < 10; ++i)
+		deque.push(i);
+	cout << "deque.size:" << deque.size() << endl;
+	cout << "deque.capacity:" << deque.capacity() << endl;
+
+	int value;
+	deque.steal(value);
+	cout << "steal:" << value << endl;
+	deque.pop(value);
+	cout << "pop:" << value << endl;
+
+	while (deque.pop(value))
+		cout << value << endl;
+	cout << "deque.empty:" << deque.empty() << endl;
+}
+
+/* 所有者不断 push / pop, 多个窃取线程同时 steal, 检查每个元素恰好被取出一次 */
+static void ws_deque_stress() {
+	const int count = 1000000;
+	const int thieves = 4;
+	ws_deque<int> deque(4);
+	std::unique_ptr<std::atomic<int>[]> taken(new std::atomic<int>[count]);
+	for (int i = 0; i < count; ++i)
+		taken[i] = 0;
+
+	std::atomic<int> remain(count);
+	std::vector<std::thread> threads;
+	for (int i = 0; i < thieves; ++i) {
+		threads.emplace_back([&]() {
+			int value;
+			while (remain.load(std::memory_order_relaxed) > 0) {
+				if (deque.steal(value)) {
+					taken[value]++;
+					remain--;
+				}
+			}
+		});
+	}
+
+	int value;
+	for (int i = 0; i < count; ++i) {
+		deque.push(i);
+		if (i % 3 == 0 && deque.pop(value)) {
+			taken[value]++;
+			remain--;
+		}
+	}
+	while (deque.pop(value)) {
+		taken[value]++;
+		remain--;
+	}
+
+	for (auto &thread : threads)
+		thread.join();
+
+	int errors = 0;
+	for (int i = 0; i < count; ++i)
+		errors += taken[i] != 1;
+	cout << "ws_deque stress: " << (errors == 0 ? "ok" : "failed") << endl;
+}
+
+/* 所有者持续压入元素, 统计不同窃取线程数量下的窃取吞吐量 */
+static void ws_deque_bench() {
+	using clock = std::chrono::steady_clock;
+	const int count = 4000000;
+	for (int thieves = 1; thieves <= 16; thieves *= 2) {
+		ws_deque<int> deque(1024);
+		std::atomic<int> stolen(0);
+		std::atomic<bool> done(false);
+		std::vector<std::thread> threads;
+
+		auto start = clock::now();
+		for (int i = 0; i < thieves; ++i) {
+			threads.emplace_back([&]() {
+				int value;
+				int local = 0;
+				while (!done.load(std::memory_order_relaxed) || !deque.empty()) {
+					if (deque.steal(value))
+						++local;
+				}
+				stolen += local;
+			});
+		}
+
+		for (int i = 0; i < count; ++i)
+			deque.push(i);
+		done = true;
+
+		for (auto &thread : threads)
+			thread.join();
+		auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+		cout << "thieves:" << thieves << " stolen:" << stolen
+			 << " time:" << ms << "ms" << endl;
+	}
+}
+
+#if 0
+int main(void) {
+	//ws_deque_basic();
+	//ws_deque_stress();
+	//ws_deque_bench();
+	system("pause");
+}
+#endif
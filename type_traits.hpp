@@ -258,5 +258,17 @@ using has_operator_not_equal_t = decltype(IsValid(std::equal_to<T>())(std::declv
 template<typename T>
 static constexpr bool has_operator_not_equal_v = has_operator_not_equal_t<T>::value;
 
+/* 比较器或哈希函数声明了 is_transparent 时才有 type, 用来启用以任意可比较类型查找的重载 */
+template<typename Func, typename K, typename = void>
+struct __transparent_key {};
+
+template<typename Func, typename K>
+struct __transparent_key<Func, K, std::void_t<typename Func::is_transparent>> {
+	using type = K;
+};
+
+template<typename Func, typename K>
+using __transparent_key_t = typename __transparent_key<Func, K>::type;
+
 } 	// !nampscace sx
 
@@ -1,6 +1,7 @@
 #ifndef M_UNORDERED_MAP_HPP
 #define M_UNORDERED_MAP_HPP
 #include "hash_table.hpp"
+#include <tuple>
 #include <utility>
 #include <functional>
 
@@ -44,7 +45,12 @@ public:
 	using size_type			= typename hashtable::size_type;
 	using iterator			= typename hashtable::iterator;
 	using const_iterator	= typename hashtable::const_iterator;
+	using node_type				= typename hashtable::node_type;
+	using insert_return_type	= typename hashtable::insert_return_type;
 private:
+	template<typename, typename, typename, typename, typename>
+	friend class unordered_map;
+
 	hashtable				table;		/* 底层 hash table 容器 */
 public:
 	unordered_map() : table(100, HashFunc(), EqualFunc()) { }
@@ -165,6 +171,60 @@ public:
 		return table.emplace_unique(std::forward<Args>(args) ...);
 	}
 
+	/* key 已存在时什么也不做, 不会分配结点, args 也不会被移走 */
+	template<typename... Args>
+	std::pair<iterator, bool> try_emplace(key_type const &key, Args&&... args) {
+		return table.try_emplace_unique(key, std::piecewise_construct,
+			std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+	}
+
+	template<typename... Args>
+	std::pair<iterator, bool> try_emplace(key_type &&key, Args&&... args) {
+		return table.try_emplace_unique(key, std::piecewise_construct,
+			std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+	}
+
+	/* key 不存在时插入, 已存在时赋值给对应的 value */
+	template<typename M>
+	std::pair<iterator, bool> insert_or_assign(key_type const &key, M &&obj) {
+		std::pair<iterator, bool> ret = table.try_emplace_unique(key, key, std::forward<M>(obj));
+		if (!ret.second)
+			(*ret.first).second = std::forward<M>(obj);
+		return ret;
+	}
+
+	template<typename M>
+	std::pair<iterator, bool> insert_or_assign(key_type &&key, M &&obj) {
+		std::pair<iterator, bool> ret = table.try_emplace_unique(key, std::move(key), std::forward<M>(obj));
+		if (!ret.second)
+			(*ret.first).second = std::forward<M>(obj);
+		return ret;
+	}
+
+	/* 摘下结点但不释放, 可以修改 key 后插回, 或者插入到另一个 unordered_map */
+	node_type extract(const_iterator pos) {
+		return table.extract(static_cast<iterator>(pos));
+	}
+
+	node_type extract(key_type const &key) {
+		return table.extract(key);
+	}
+
+	/* 已有相同 key 时插入失败, 结点通过返回值的 node 交还 */
+	insert_return_type insert(node_type &&handle) {
+		return table.insert_unique(std::move(handle));
+	}
+
+	iterator insert(const_iterator, node_type &&handle) {
+		return table.insert_unique(std::move(handle)).position;
+	}
+
+	/* 把 source 中 key 不重复的结点移过来, 重复的留在 source 中 */
+	template<typename OtherHash, typename OtherEqual>
+	void merge(unordered_map<Key, Value, OtherHash, OtherEqual, Alloc> &source) {
+		table.merge_unique(source.table);
+	}
+
 	size_type erase(key_type const &key) {
 		return table.erase(key);
 	}
@@ -189,6 +249,27 @@ public:
 		return table.equal_range(key);
 	}
 
+	/* HashFunc 和 EqualFunc 都声明了 is_transparent 时, 可以直接用 string_view 等类型查找, 不构造临时 key */
+	template<typename K, typename = sx::__transparent_key_t<HashFunc, sx::__transparent_key_t<EqualFunc, K>>>
+	size_type erase(K const &key) {
+		return table.erase(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<HashFunc, sx::__transparent_key_t<EqualFunc, K>>>
+	iterator find(K const &key) const {
+		return table.find(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<HashFunc, sx::__transparent_key_t<EqualFunc, K>>>
+	size_type count(K const &key) const {
+		return table.count(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<HashFunc, sx::__transparent_key_t<EqualFunc, K>>>
+	std::pair<iterator, iterator> equal_range(K const &key) const {
+		return table.equal_range(key);
+	}
+
 	void swap(unordered_map &other) noexcept {
 		table.swap(other.table);
 	}
@@ -210,8 +291,11 @@ public:
 	}
 
 	Value &operator[](key_type const &key) {
-		std::pair<iterator, bool> ret = table.insert_unique(value_type());
-		return (*(ret.first)).second;
+		return (*try_emplace(key).first).second;
+	}
+
+	Value &operator[](key_type &&key) {
+		return (*try_emplace(std::move(key)).first).second;
 	}
 };
 
@@ -374,10 +458,10 @@ public:
 		return static_cast<iterator>(ret);
 	}
 
-	template<typename InpuIterator,
+	template<typename InputIterator,
 		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
 		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
-	void insert(InpuIterator first, InpuIterator last) {
+	void insert(InputIterator first, InputIterator last) {
 		return static_cast<iterator>(table.insert_equal(first, last));
 	}
 
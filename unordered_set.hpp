@@ -27,6 +27,8 @@ public:
 	using size_type			= typename hashtable::size_type;
 	using iterator			= typename hashtable::const_iterator;
 	using const_iterator	= typename hashtable::const_iterator;
+	using node_type			= typename hashtable::node_type;
+	using insert_return_type	= sx::node_insert_return<const_iterator, node_type>;
 public:
 	hashtable	table;		/* 底层 hash table 容器 */
 public:
@@ -144,15 +146,38 @@ public:
 		return { static_cast<const_iterator>(ret.first), static_cast<const_iterator>(ret.second) };
 	}
 
+	/* HashFunc 和 EqualFunc 都声明了 is_transparent 时, 可以直接用 string_view 等类型查找, 不构造临时元素 */
+	template<typename K, typename = sx::__transparent_key_t<HashFunc, sx::__transparent_key_t<EqualFunc, K>>>
+	size_type erase(K const &key) {
+		return table.erase(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<HashFunc, sx::__transparent_key_t<EqualFunc, K>>>
+	iterator find(K const &key) const {
+		return static_cast<iterator>(table.find(key));
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<HashFunc, sx::__transparent_key_t<EqualFunc, K>>>
+	size_type count(K const &key) const {
+		return table.count(key);
+	}
+
+	template<typename K, typename = sx::__transparent_key_t<HashFunc, sx::__transparent_key_t<EqualFunc, K>>>
+	std::pair<const_iterator, const_iterator> equal_range(K const &key) const {
+		using hash_iterator = typename hashtable::iterator;
+		std::pair<hash_iterator, hash_iterator> ret = table.equal_range(key);
+		return { static_cast<const_iterator>(ret.first), static_cast<const_iterator>(ret.second) };
+	}
+
 	std::pair<iterator, bool> insert(value_type const &val) {
 		std::pair<typename hashtable::iterator, bool> ret = table.insert_unique(val);
 		return { static_cast<iterator>(ret.first), ret.second };
 	}
 
-	template<typename InpuIterator,
+	template<typename InputIterator,
 		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
 		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
-	void insert(InpuIterator first, InpuIterator last) {
+	void insert(InputIterator first, InputIterator last) {
 		return static_cast<iterator>(table.insert_unique(first, last));
 	}
 
@@ -161,6 +186,32 @@ public:
 		return static_cast<iterator>(table.emplace_unique(std::forward<Args>(args)...));
 	}
 
+	/* 摘下结点但不释放, 可以修改值后插回, 或者插入到另一个 unordered_set */
+	node_type extract(const_iterator pos) {
+		using hash_iterator = typename hashtable::iterator;
+		return table.extract(static_cast<hash_iterator>(pos));
+	}
+
+	node_type extract(key_type const &key) {
+		return table.extract(key);
+	}
+
+	/* 已有相同的值时插入失败, 结点通过返回值的 node 交还 */
+	insert_return_type insert(node_type &&handle) {
+		typename hashtable::insert_return_type ret = table.insert_unique(std::move(handle));
+		return insert_return_type{ static_cast<iterator>(ret.position), ret.inserted, std::move(ret.node) };
+	}
+
+	iterator insert(const_iterator, node_type &&handle) {
+		return static_cast<iterator>(table.insert_unique(std::move(handle)).position);
+	}
+
+	/* 把 source 中不重复的结点移过来, 重复的留在 source 中 */
+	template<typename OtherHash, typename OtherEqual>
+	void merge(unordered_set<Key, OtherHash, OtherEqual, Alloc> &source) {
+		table.merge_unique(source.table);
+	}
+
 	size_type erase(key_type const &key) {
 		return table.erase(key);
 	}
@@ -336,10 +387,10 @@ public:
 		return static_cast<iterator>(ret);
 	}
 
-	template<typename InpuIterator,
+	template<typename InputIterator,
 		typename = std::enable_if_t<sx::is_input_iterator_v<InputIterator>
 		&& sx::is_convertible_iter_type_v<InputIterator, value_type>>>
-	void insert(InpuIterator first, InpuIterator last) {
+	void insert(InputIterator first, InputIterator last) {
 		return static_cast<iterator>(table.insert_equal(first, last));
 	}
 
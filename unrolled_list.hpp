@@ -0,0 +1,799 @@
+﻿#ifndef M_UNROLLED_LIST_HPP
+#define M_UNROLLED_LIST_HPP
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <type_traits>
+#include <utility>
+#include "allocator.hpp"
+#include "default_alloc_template.hpp"
+#include "iterator.hpp"
+#include "utility.hpp"
+
+namespace sx {
+
+struct __unrolled_node_base;
+
+template<typename T, std::size_t K>
+struct __unrolled_node;
+
+template<typename T, std::size_t K, typename Ptr, typename Ref>
+class __unrolled_list_iterator;
+
+/* 默认每个结点容纳的元素个数: 让结点不超过内存池管理的最大块 (MAX_BYTES), 至少 2 个 */
+template<typename T>
+constexpr std::size_t __unrolled_list_default_capacity() noexcept {
+	return (MAX_BYTES - 3 * sizeof(void *)) / sizeof(T) >= 2
+		 ? (MAX_BYTES - 3 * sizeof(void *)) / sizeof(T)
+		 : 2;
+}
+
+template<typename T, std::size_t K = __unrolled_list_default_capacity<T>(), typename Alloc = sx::allocator<T>>
+class unrolled_list;
+
+
+class unrolled_list_empty : public std::exception {
+};
+
+struct __unrolled_node_base {
+	__unrolled_node_base	*prev;
+	__unrolled_node_base	*next;
+	std::size_t				 count;		/* 结点中的元素个数 */
+};
+
+/* 每个结点连续存放最多 K 个元素 */
+template<typename T, std::size_t K>
+struct __unrolled_node : public __unrolled_node_base {
+	typename std::aligned_storage<sizeof(T), alignof(T)>::type storage[K];
+public:
+	T *data() noexcept {
+		return reinterpret_cast<T *>(storage);
+	}
+};
+
+
+template<typename T, std::size_t K, typename Ptr, typename Ref>
+class __unrolled_list_iterator {
+	template<typename U, std::size_t N, typename Alloc>
+	friend class unrolled_list;
+
+	template<typename U, std::size_t N, typename P, typename R>
+	friend class __unrolled_list_iterator;
+public:
+	using value_type		= T;
+	using pointer			= Ptr;
+	using reference			= Ref;
+	using difference_type	= std::ptrdiff_t;
+	using iterator_category = sx::bidirectional_iterator_tag;
+private:
+	__unrolled_node_base	*node;		/* 所在结点 */
+	std::size_t				 index;		/* 结点内下标 */
+public:
+	__unrolled_list_iterator() noexcept : node(nullptr), index(0) {}
+	__unrolled_list_iterator(__unrolled_node_base *ptr, std::size_t idx) noexcept : node(ptr), index(idx) {}
+	__unrolled_list_iterator(__unrolled_list_iterator const &) = default;
+	__unrolled_list_iterator &operator=(__unrolled_list_iterator const &) = default;
+	~__unrolled_list_iterator() = default;
+
+	/* iterator 可以转换为 const_iterator */
+	template<typename P, typename R>
+	__unrolled_list_iterator(__unrolled_list_iterator<T, K, P, R> const &other) noexcept
+		: node(other.node), index(other.index) {}
+public:
+	friend bool operator==(__unrolled_list_iterator const &first, __unrolled_list_iterator const &second) noexcept {
+		return first.node == second.node && first.index == second.index;
+	}
+
+	friend bool operator!=(__unrolled_list_iterator const &first, __unrolled_list_iterator const &second) noexcept {
+		return !(first == second);
+	}
+
+	reference operator*() const noexcept {
+		return static_cast<__unrolled_node<T, K> *>(node)->data()[index];
+	}
+
+	pointer operator->() const noexcept {
+		return &(operator*());
+	}
+
+	__unrolled_list_iterator &operator++() noexcept {
+		if (++index == node->count) {
+			node = node->next;
+			index = 0;
+		}
+		return *this;
+	}
+
+	__unrolled_list_iterator operator++(int) noexcept {
+		__unrolled_list_iterator ret = *this;
+		++(*this);
+		return ret;
+	}
+
+	__unrolled_list_iterator &operator--() noexcept {
+		if (index == 0) {
+			node = node->prev;
+			index = node->count;
+		}
+		--index;
+		return *this;
+	}
+
+	__unrolled_list_iterator operator--(int) noexcept {
+		__unrolled_list_iterator ret = *this;
+		--(*this);
+		return ret;
+	}
+};
+
+
+/*
+ * 展开链表: 每个结点连续存放最多 K 个元素, 顺序遍历接近数组的速度, 中间插入删除只需移动一个结点内的元素
+ * 插入到满结点时对半分裂, 删除后结点不足半满且能与相邻结点放下时合并
+ * 结点从 sx::allocator 分配, 默认的 K 让结点落在内存池管理的范围内
+ * 插入删除会使所在结点 (分裂合并时还有相邻结点) 上的迭代器失效; 要求元素的移动构造不抛出异常
+ */
+template<typename T, std::size_t K, typename Alloc>
+class unrolled_list : public sx::container_helpful<unrolled_list<T, K, Alloc>> {
+	static_assert(K >= 2, "unrolled_list requires at least 2 elements per node");
+
+	using node_base = __unrolled_node_base;
+	using node		= __unrolled_node<T, K>;
+	using Allocator = decltype(sx::transform_alloator_type<T, node>(Alloc{}));
+	using ValueAllocator = decltype(sx::transform_alloator_type<T, T>(Alloc{}));
+public:
+	using value_type			 = T;
+	using pointer				 = T *;
+	using reference				 = T &;
+	using const_pointer			 = T const *;
+	using const_reference		 = T const &;
+	using size_type				 = std::size_t;
+	using difference_type		 = std::ptrdiff_t;
+	using iterator				 = __unrolled_list_iterator<T, K, T *, T &>;
+	using const_iterator		 = __unrolled_list_iterator<T, K, T const *, T const &>;
+	using reverse_iterator		 = sx::__reverse_iterator<iterator>;
+	using const_reverse_iterator = sx::__reverse_iterator<const_iterator>;
+protected:
+	static Allocator		allocator;			/* 结点分配器 */
+	static ValueAllocator	value_allocator;	/* 排序缓冲区分配器 */
+	node_base				head;				/* 头结点, 内嵌在容器中 */
+	size_type				node_size;			/* 元素数量 */
+public:
+	unrolled_list() noexcept : node_size(0) {
+		empty_initialized();
+	}
+
+	unrolled_list(size_type count, value_type const &value) : unrolled_list() {
+		insert(end(), count, value);
+	}
+
+	template<typename InputIter,
+			 typename = std::enable_if_t<sx::is_input_iterator_v<InputIter>>>
+	unrolled_list(InputIter first, InputIter last) : unrolled_list() {
+		insert(end(), first, last);
+	}
+
+	unrolled_list(std::initializer_list<value_type> const &ilst) : unrolled_list(ilst.begin(), ilst.end()) {}
+
+	unrolled_list(unrolled_list const &other) : unrolled_list(other.begin(), other.end()) {}
+
+	unrolled_list(unrolled_list &&other) noexcept : unrolled_list() {
+		swap(other);
+	}
+
+	unrolled_list &operator=(unrolled_list const &other) {
+		if (this == &other)
+			return *this;
+		unrolled_list tmp = other;
+		swap(tmp);
+		return *this;
+	}
+
+	unrolled_list &operator=(unrolled_list &&other) noexcept {
+		unrolled_list tmp = std::move(other);
+		swap(tmp);
+		return *this;
+	}
+
+	unrolled_list &operator=(std::initializer_list<value_type> const &ilst) {
+		unrolled_list tmp(ilst);
+		swap(tmp);
+		return *this;
+	}
+
+	~unrolled_list() {
+		clear();
+	}
+private:
+	void empty_initialized() noexcept {
+		head.prev = head.next = &head;
+		head.count = 0;
+	}
+
+	/* 头结点内嵌在容器中, 交换之后要修正首尾结点指回头结点的指针 */
+	void reset_head() noexcept {
+		if (node_size == 0) {
+			empty_initialized();
+		} else {
+			head.next->prev = &head;
+			head.prev->next = &head;
+		}
+	}
+
+	static T *elements(node_base *base) noexcept {
+		return static_cast<node *>(base)->data();
+	}
+
+	/* 在 pos 后面链入一个空结点 */
+	static node *link_node_after(node_base *pos) {
+		node *new_node = allocator.allocate();
+		new_node->count = 0;
+		new_node->prev = pos;
+		new_node->next = pos->next;
+		pos->next->prev = new_node;
+		pos->next = new_node;
+		return new_node;
+	}
+
+	static void unlink_node(node_base *base) noexcept {
+		base->prev->next = base->next;
+		base->next->prev = base->prev;
+		allocator.deallocate(static_cast<node *>(base), sizeof(node));
+	}
+
+	/* 把 src 开始的 n 个元素移动到 dst 开始的未初始化空间, dst 在 src 之前或者不重叠时使用 */
+	static void move_forward(T *dst, T *src, size_type n) noexcept {
+		for (size_type i = 0; i < n; ++i) {
+			sx::construct(dst + i, std::move(src[i]));
+			sx::destroy(src + i);
+		}
+	}
+
+	/* 同上, dst 在 src 之后并且可能重叠时使用 */
+	static void move_backward(T *dst, T *src, size_type n) noexcept {
+		for (size_type i = n; i > 0; --i) {
+			sx::construct(dst + i - 1, std::move(src[i - 1]));
+			sx::destroy(src + i - 1);
+		}
+	}
+
+	/* 找到放置新元素的结点和下标, 必要时分配新结点或者分裂满结点 */
+	iterator make_room(iterator pos) {
+		node_base *base = pos.node;
+		size_type index = pos.index;
+		if (base == &head) {
+			base = head.prev;
+			if (base == &head || base->count == K)
+				base = link_node_after(head.prev);
+			return iterator(base, base->count);
+		}
+
+		if (base->count < K)
+			return iterator(base, index);
+
+		if (index == 0) {
+			/* 插入到满结点的开头: 放到前一个结点的末尾, 放不下就在前面新建结点 */
+			node_base *prev = base->prev;
+			if (prev == &head || prev->count == K)
+				prev = link_node_after(prev);
+			return iterator(prev, prev->count);
+		}
+
+		node *upper = link_node_after(base);
+		size_type half = K / 2;
+		move_forward(upper->data(), elements(base) + half, K - half);
+		upper->count = K - half;
+		base->count = half;
+		if (index > half)
+			return iterator(upper, index - half);
+		return iterator(base, index);
+	}
+
+	template<typename... Args>
+	iterator insert_aux(iterator pos, Args&&... args) {
+		value_type tmp(std::forward<Args>(args)...);
+		iterator place = make_room(pos);
+		node_base *base = place.node;
+		T *data = elements(base);
+		move_backward(data + place.index + 1, data + place.index, base->count - place.index);
+		sx::construct(data + place.index, std::move(tmp));
+		++base->count;
+		++node_size;
+		return place;
+	}
+
+	/* 结点不足半满时尝试与相邻结点合并, 返回 (base, index) 处元素合并后的位置 */
+	iterator rebalance(node_base *base, size_type index) noexcept {
+		if (base->count == 0) {
+			node_base *next = base->next;
+			unlink_node(base);
+			return iterator(next, 0);
+		}
+
+		if (base->count < K / 2) {
+			node_base *prev = base->prev;
+			node_base *next = base->next;
+			if (prev != &head && prev->count + base->count <= K) {
+				move_forward(elements(prev) + prev->count, elements(base), base->count);
+				index += prev->count;
+				prev->count += base->count;
+				unlink_node(base);
+				base = prev;
+			} else if (next != &head && base->count + next->count <= K) {
+				move_forward(elements(base) + base->count, elements(next), next->count);
+				base->count += next->count;
+				unlink_node(next);
+			}
+		}
+
+		if (index == base->count)
+			return iterator(base->next, 0);
+		return iterator(base, index);
+	}
+
+	/*
+	 * 与 rebalance 相同的合并规则: 自己或前一个结点不足半满并且两者能放进一个结点时, 把自己并入前一个结点.
+	 * 从前向后对每个结点调用一次, 就和逐个删除之后的结点布局一样. 返回合并之后元素所在的结点
+	 */
+	node_base *merge_into_prev(node_base *base) noexcept {
+		node_base *prev = base->prev;
+		if (prev == &head || prev->count + base->count > K)
+			return base;
+		if (base->count >= K / 2 && prev->count >= K / 2)
+			return base;
+
+		move_forward(elements(prev) + prev->count, elements(base), base->count);
+		prev->count += base->count;
+		unlink_node(base);
+		return prev;
+	}
+
+	/*
+	 * 一次遍历在结点内部压缩保留下来的元素, 空结点直接释放, 不足半满的结点按 erase 的规则与前一个结点合并
+	 * drop(last, elem) 判断是否删除 elem, last 指向上一个保留下来的元素 (还没有时为空)
+	 */
+	template<typename Predicate>
+	void compact(Predicate drop) {
+		value_type const *last = nullptr;
+		node_base *curr = head.next;
+		while (curr != &head) {
+			T *data = elements(curr);
+			size_type kept = 0;
+			for (size_type i = 0; i < curr->count; ++i) {
+				if (drop(last, data[i])) {
+					sx::destroy(data + i);
+				} else {
+					if (kept != i)
+						move_forward(data + kept, data + i, 1);
+					last = data + kept;
+					++kept;
+				}
+			}
+			node_size -= curr->count - kept;
+			curr->count = kept;
+
+			node_base *next = curr->next;
+			if (kept == 0) {
+				unlink_node(curr);
+			} else {
+				node_base *merged = merge_into_prev(curr);
+				last = elements(merged) + merged->count - 1;
+			}
+			curr = next;
+		}
+	}
+
+	/* 从 base 的 index 处把结点一分为二, 返回后半部分的第一个结点 */
+	node_base *split_at(node_base *base, size_type index) {
+		if (index == 0)
+			return base;
+
+		node *upper = link_node_after(base);
+		move_forward(upper->data(), elements(base) + index, base->count - index);
+		upper->count = base->count - index;
+		base->count = index;
+		return upper;
+	}
+public:
+	size_type size() const noexcept {
+		return node_size;
+	}
+
+	bool empty() const noexcept {
+		return node_size == 0;
+	}
+
+	iterator begin() noexcept {
+		return iterator(head.next, 0);
+	}
+
+	iterator end() noexcept {
+		return iterator(&head, 0);
+	}
+
+	const_iterator begin() const noexcept {
+		return cbegin();
+	}
+
+	const_iterator end() const noexcept {
+		return cend();
+	}
+
+	const_iterator cbegin() const noexcept {
+		return const_iterator(head.next, 0);
+	}
+
+	const_iterator cend() const noexcept {
+		return const_iterator(const_cast<node_base *>(&head), 0);
+	}
+
+	reverse_iterator rbegin() noexcept {
+		return reverse_iterator(end());
+	}
+
+	reverse_iterator rend() noexcept {
+		return reverse_iterator(begin());
+	}
+
+	const_reverse_iterator crbegin() const noexcept {
+		return const_reverse_iterator(cend());
+	}
+
+	const_reverse_iterator crend() const noexcept {
+		return const_reverse_iterator(cbegin());
+	}
+
+	reference front() {
+		if (empty())
+			throw unrolled_list_empty();
+		return *begin();
+	}
+
+	const_reference front() const {
+		if (empty())
+			throw unrolled_list_empty();
+		return *begin();
+	}
+
+	reference back() {
+		if (empty())
+			throw unrolled_list_empty();
+		return *(--end());
+	}
+
+	const_reference back() const {
+		if (empty())
+			throw unrolled_list_empty();
+		return *(--end());
+	}
+
+	void push_front(value_type const &value) {
+		insert_aux(begin(), value);
+	}
+
+	void push_front(value_type &&value) {
+		insert_aux(begin(), std::move(value));
+	}
+
+	void push_back(value_type const &value) {
+		insert_aux(end(), value);
+	}
+
+	void push_back(value_type &&value) {
+		insert_aux(end(), std::move(value));
+	}
+
+	template<typename... Args>
+	void emplace_front(Args&&... args) {
+		insert_aux(begin(), std::forward<Args>(args)...);
+	}
+
+	template<typename... Args>
+	void emplace_back(Args&&... args) {
+		insert_aux(end(), std::forward<Args>(args)...);
+	}
+
+	void pop_front() {
+		if (empty())
+			throw unrolled_list_empty();
+		erase(begin());
+	}
+
+	void pop_back() {
+		if (empty())
+			throw unrolled_list_empty();
+		erase(--end());
+	}
+
+	template<typename... Args>
+	iterator emplace(iterator pos, Args&&... args) {
+		return insert_aux(pos, std::forward<Args>(args)...);
+	}
+
+	iterator insert(iterator pos, value_type const &value) {
+		return insert_aux(pos, value);
+	}
+
+	iterator insert(iterator pos, value_type &&value) {
+		return insert_aux(pos, std::move(value));
+	}
+
+	template<typename InputIter,
+			 typename = std::enable_if_t<sx::is_input_iterator_v<InputIter> &&
+										 sx::is_convertible_iter_type_v<InputIter, value_type>>>
+	void insert(iterator pos, InputIter first, InputIter last) {
+		for ( ; first != last; ++first) {
+			pos = insert_aux(pos, *first);
+			++pos;
+		}
+	}
+
+	void insert(iterator pos, std::initializer_list<value_type> const &ilst) {
+		insert(pos, ilst.begin(), ilst.end());
+	}
+
+	void insert(iterator pos, size_type count, value_type const &value) {
+		for (size_type i = 0; i < count; ++i) {
+			pos = insert_aux(pos, value);
+			++pos;
+		}
+	}
+
+	iterator erase(iterator pos) noexcept {
+		node_base *base = pos.node;
+		T *data = elements(base);
+		sx::destroy(data + pos.index);
+		move_forward(data + pos.index, data + pos.index + 1, base->count - pos.index - 1);
+		--base->count;
+		--node_size;
+		return rebalance(base, pos.index);
+	}
+
+	/* 合并结点会使 last 失效, 所以先数出要删除的个数 */
+	iterator erase(iterator first, iterator last) noexcept {
+		size_type count = sx::distance(first, last);
+		while (count-- > 0)
+			first = erase(first);
+		return first;
+	}
+
+	void clear() noexcept {
+		node_base *curr = head.next;
+		while (curr != &head) {
+			node_base *next = curr->next;
+			sx::destroy(elements(curr), elements(curr) + curr->count);
+			allocator.deallocate(static_cast<node *>(curr), sizeof(node));
+			curr = next;
+		}
+		empty_initialized();
+		node_size = 0;
+	}
+
+	template<typename Predicate>
+	void remove_if(Predicate pred) {
+		compact([&pred](value_type const *, value_type &elem) { return pred(elem); });
+	}
+
+	void remove(value_type const &value) {
+		remove_if([&value](value_type const &elem) { return elem == value; });
+	}
+
+	void unique() {
+		compact([](value_type const *last, value_type &elem) { return last != nullptr && *last == elem; });
+	}
+
+	/* 整个链表的结点直接链入, 插入位置在结点中间时先把结点拆开 */
+	void splice(iterator pos, unrolled_list &other) {
+		if (other.empty() || this == &other)
+			return;
+
+		node_base *after = pos.node == &head ? &head : split_at(pos.node, pos.index);
+		node_base *before = after->prev;
+		node_base *first = other.head.next;
+		node_base *last = other.head.prev;
+		before->next = first;
+		first->prev = before;
+		last->next = after;
+		after->prev = last;
+
+		node_size += other.node_size;
+		other.empty_initialized();
+		other.node_size = 0;
+	}
+
+	void splice(iterator pos, unrolled_list &other, iterator index) {
+		iterator after = index;
+		if (this == &other && (pos == index || pos == ++after))
+			return;
+
+		value_type tmp(std::move(*index));
+		other.erase(index);
+		insert_aux(pos, std::move(tmp));
+	}
+
+	/*
+	 * 整个结点都排在另一边当前元素之前时直接把结点链入结果, 否则逐个元素移动到结果的最后一个结点;
+	 * 读完的输入结点回收给结果使用, 只有两边交错的时候才可能分配一两个结点.
+	 * 比较函数或分配器抛出异常时, 已合并的部分和两边剩下的元素都留在 *this 中 (顺序未定), other 为空
+	 */
+	template<typename Compare>
+	void merge(unrolled_list &other, Compare comp) {
+		if (this == &other || other.empty())
+			return;
+
+		node_base out;					/* 结果链表的临时头结点 */
+		out.prev = out.next = &out;
+		node_base *free_nodes = nullptr;	/* 读完的输入结点, 通过 next 串起来 */
+		node_base *first1 = head.next, *first2 = other.head.next;
+		node_base *last1 = head.prev, *last2 = other.head.prev;
+		size_type index1 = 0, index2 = 0;
+
+		auto append = [&out](node_base *base) noexcept {
+			base->prev = out.prev;
+			base->next = &out;
+			out.prev->next = base;
+			out.prev = base;
+		};
+
+		auto finish = [&]() noexcept {
+			if (first1 != &head && index1 != 0) {
+				move_forward(elements(first1), elements(first1) + index1, first1->count - index1);
+				first1->count -= index1;
+			}
+			if (first2 != &other.head && index2 != 0) {
+				move_forward(elements(first2), elements(first2) + index2, first2->count - index2);
+				first2->count -= index2;
+			}
+
+			node_base *tail = &head;
+			auto link = [&tail](node_base *first, node_base *last) noexcept {
+				tail->next = first;
+				first->prev = tail;
+				tail = last;
+			};
+			if (out.next != &out)
+				link(out.next, out.prev);
+			if (first1 != &head)
+				link(first1, last1);
+			if (first2 != &other.head)
+				link(first2, last2);
+			tail->next = &head;
+			head.prev = tail;
+
+			node_size += other.node_size;
+			other.empty_initialized();
+			other.node_size = 0;
+
+			while (free_nodes != nullptr) {
+				node_base *next = free_nodes->next;
+				allocator.deallocate(static_cast<node *>(free_nodes), sizeof(node));
+				free_nodes = next;
+			}
+			for (node_base *curr = head.next; curr != &head; ) {
+				node_base *next = curr->next;
+				merge_into_prev(curr);
+				curr = next;
+			}
+		};
+
+		try {
+			while (first1 != &head && first2 != &other.head) {
+				T *data1 = elements(first1);
+				T *data2 = elements(first2);
+				if (index1 == 0 && !comp(data2[index2], data1[first1->count - 1])) {
+					node_base *next = first1->next;
+					append(first1);
+					first1 = next;
+					continue;
+				}
+				if (index2 == 0 && comp(data2[first2->count - 1], data1[index1])) {
+					node_base *next = first2->next;
+					append(first2);
+					first2 = next;
+					continue;
+				}
+
+				bool take2 = comp(data2[index2], data1[index1]);
+				node_base *&src = take2 ? first2 : first1;
+				size_type &index = take2 ? index2 : index1;
+
+				node_base *dst = out.prev;
+				if (dst == &out || dst->count == K) {
+					if (free_nodes != nullptr) {
+						dst = free_nodes;
+						free_nodes = free_nodes->next;
+					} else {
+						dst = allocator.allocate();
+					}
+					dst->count = 0;
+					append(dst);
+				}
+
+				move_forward(elements(dst) + dst->count, elements(src) + index, 1);
+				++dst->count;
+				if (++index == src->count) {
+					node_base *next = src->next;
+					src->next = free_nodes;
+					free_nodes = src;
+					src = next;
+					index = 0;
+				}
+			}
+		} catch (...) {
+			finish();
+			throw;
+		}
+		finish();
+	}
+
+	void merge(unrolled_list &other) {
+		merge(other, std::less<>{});
+	}
+
+	void reverse() noexcept {
+		node_base *curr = &head;
+		do {
+			node_base *next = curr->next;
+			std::swap(curr->prev, curr->next);
+			if (curr != &head)
+				std::reverse(elements(curr), elements(curr) + curr->count);
+			curr = next;
+		} while (curr != &head);
+	}
+
+	/* 元素移动到连续缓冲区中稳定排序后按原来的结点布局放回; 比较函数抛出异常时元素按当时的顺序放回再重新抛出 */
+	template<typename Compare>
+	void sort(Compare comp) {
+		size_type count = node_size;
+		if (count < 2)
+			return;
+
+		T *buffer = value_allocator.allocate(count);
+		size_type pos = 0;
+		for (node_base *curr = head.next; curr != &head; curr = curr->next) {
+			move_forward(buffer + pos, elements(curr), curr->count);
+			pos += curr->count;
+		}
+
+		std::exception_ptr error;
+		try {
+			std::stable_sort(buffer, buffer + count, comp);
+		} catch (...) {
+			error = std::current_exception();
+		}
+
+		pos = 0;
+		for (node_base *curr = head.next; curr != &head; curr = curr->next) {
+			move_forward(elements(curr), buffer + pos, curr->count);
+			pos += curr->count;
+		}
+		value_allocator.deallocate(buffer, sizeof(T) * count);
+		if (error)
+			std::rethrow_exception(error);
+	}
+
+	void sort() {
+		sort(std::less<>{});
+	}
+
+	void swap(unrolled_list &other) noexcept {
+		using std::swap;
+		swap(head.prev, other.head.prev);
+		swap(head.next, other.head.next);
+		swap(node_size, other.node_size);
+		reset_head();
+		other.reset_head();
+	}
+};
+
+template<typename T, std::size_t K, typename Alloc>
+typename unrolled_list<T, K, Alloc>::Allocator unrolled_list<T, K, Alloc>::allocator;
+
+template<typename T, std::size_t K, typename Alloc>
+typename unrolled_list<T, K, Alloc>::ValueAllocator unrolled_list<T, K, Alloc>::value_allocator;
+
+}	// !namespace sx
+
+#endif // !M_UNROLLED_LIST_HPP
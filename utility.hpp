@@ -1,8 +1,114 @@
 ﻿#ifndef M_UTILITY_HPP
 #define M_UTILITY_HPP
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include "iterator.hpp"
+#if defined(_MSC_VER)
+#include <xmmintrin.h>
+#endif
 
 namespace sx {
 
+constexpr std::size_t CACHE_LINE_SIZE = 64;		/* 缓存行大小 */
+
+/* 标记输入区间已按 key 严格递增排列且没有重复, 有序容器可以直接建树 */
+struct sorted_unique_t {
+	explicit sorted_unique_t() = default;
+};
+inline constexpr sorted_unique_t sorted_unique{};
+
+/* 标记输入区间已按 key 非递减排列, 供 multi 容器使用 */
+struct sorted_equivalent_t {
+	explicit sorted_equivalent_t() = default;
+};
+inline constexpr sorted_equivalent_t sorted_equivalent{};
+
+/* 标记操作可以拆成多个任务在多个线程上执行 */
+struct parallel_t {
+	explicit parallel_t() = default;
+};
+inline constexpr parallel_t parallel{};
+
+/* 提示 CPU 把 ptr 所在的缓存行读入缓存, 不会因无效地址出错 */
+inline void __prefetch(void const *ptr) noexcept {
+#if defined(_MSC_VER)
+	_mm_prefetch(static_cast<char const *>(ptr), _MM_HINT_T0);
+#else
+	__builtin_prefetch(ptr);
+#endif
+}
+
+/* 将 n 上调至 2 的幂次 */
+constexpr inline std::size_t __round_up_pow2(std::size_t n) noexcept {
+	std::size_t result = 1;
+	while (result < n)
+		result <<= 1;
+	return result;
+}
+
+/*
+ * 由成员的地址反推所属对象的地址, 侵入式容器用它从链接钩子找到元素
+ * 只有标准布局类型的成员偏移是确定的, 其他类型应把钩子放进一个标准布局的基类
+ */
+template<typename T, typename M> inline
+T *__member_owner(M *member, M T::*ptr) noexcept {
+	static_assert(std::is_standard_layout<T>::value,
+		"intrusive hooks require a standard layout owner, put the hook in a standard layout base");
+	typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+	T *object = reinterpret_cast<T *>(&storage);
+	std::ptrdiff_t offset = reinterpret_cast<char *>(&(object->*ptr)) - reinterpret_cast<char *>(object);
+	return reinterpret_cast<T *>(reinterpret_cast<char *>(member) - offset);
+}
+
+/* 容器支持 reserve 时, 批量插入前先预留好空间, 只需一次扩容 (仍按两倍增长, 避免小批量反复扩容) */
+template<typename Container, typename Size> inline
+auto __reserve_for_append(Container &container, Size n, int)
+	-> decltype(container.reserve(n), container.capacity(), void()) {
+	std::size_t need = container.size() + n;
+	std::size_t double_capacity = 2 * container.capacity();
+	if (need > container.capacity())
+		container.reserve(need > double_capacity ? need : double_capacity);
+}
+
+template<typename Container, typename Size> inline
+void __reserve_for_append(Container &, Size, long) {
+}
+
+/* 将 [first, last) 追加到容器尾部, 供容器适配器的 push_range 使用 */
+template<typename Container, typename InputIterator> inline
+void __append_range(Container &container, InputIterator first, InputIterator last) {
+	if constexpr (sx::is_forward_iterator_v<InputIterator>)
+		sx::__reserve_for_append(container, sx::distance(first, last), 0);
+
+	for (; first != last; ++first)
+		container.emplace_back(*first);
+}
+
+/* 删除容器头部的 [first, last), 供 queue::pop_n 使用; 单向链表没有 erase, 改用 erase_after */
+template<typename Container, typename Iterator> inline
+auto __erase_front(Container &container, Iterator first, Iterator last, int)
+	-> decltype(container.erase(first, last), void()) {
+	container.erase(first, last);
+}
+
+template<typename Container, typename Iterator> inline
+void __erase_front(Container &container, Iterator, Iterator last, long) {
+	container.erase_after(container.before_begin(), last);
+}
+
+/* list / forward_list 的回收结点缓存, 只在 Enable 为 true 时占用空间, 默认的链表布局不变 */
+template<typename Node, bool Enable>
+struct __node_cache {
+	Node		   *spare_nodes = nullptr;	/* 回收的结点, 通过 next 串起来 */
+	std::size_t		spare_count = 0;		/* 缓存的结点数量 */
+	std::size_t		spare_limit = 0;		/* 缓存上限, 0 表示不缓存 */
+};
+
+template<typename Node>
+struct __node_cache<Node, false> {
+};
+
 
 /* 容器助手 */
 template<typename Derived>
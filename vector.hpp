@@ -64,7 +64,7 @@ public:
 
 	vector &operator=(vector &&other) {
 		vector tmp = std::move(other);
-		swap(*this, tmp);
+		swap(tmp);
 		return *this;
 	}
 
@@ -90,7 +90,7 @@ public:
 		difference_type distance = sx::distance(first, end);
 		start = allocator.allocate(distance);
 		try {
-			finish = uninitialized_copy(first, end, start);
+			finish = sx::uninitialized_copy(first, end, start);
 			end_of_store = finish;
 		} catch (...) {
 			allocator.deallocate(start, distance);
@@ -107,7 +107,7 @@ private:
 		difference_type distance = sx::distance(first, end);
 		iterator result = allocator.allocate(distance);
 		try {
-			uninitialized_copy(first, end, result);
+			sx::uninitialized_copy(first, end, result);
 			return result;
 		} catch (...) {
 			allocator.deallocate(result, distance);
@@ -120,15 +120,25 @@ private:
 	iterator insert_aux(iterator position, ConstructFunc const &construct_func) {
 		if (finish != end_of_store) {
 			if (position == end()) {
-				++finish;
 				construct_func(position);
+				++finish;
 				return position;
 			}
 
-			allocator.construct(finish, *(finish - 1));
-			++finish;
-			std::copy_backward(position, finish - 2, finish - 1);
-			construct_func(position);
+			/* 先在临时空间构造新元素: 参数可能引用后面要被移动的元素, 构造失败时容器也保持原样 */
+			alignas(T) unsigned char buffer[sizeof(T)];
+			iterator value = reinterpret_cast<iterator>(buffer);
+			construct_func(value);
+			try {
+				allocator.construct(finish, std::move(*(finish - 1)));
+				++finish;
+				std::move_backward(position, finish - 2, finish - 1);
+				*position = std::move(*value);
+			} catch (...) {
+				allocator.destroy(value);
+				throw;
+			}
+			allocator.destroy(value);
 			return position;
 		}
 
@@ -350,7 +360,7 @@ public:
 	}
 
 	iterator erase(iterator first, iterator last) {
-		iterator iter = std::copy(last, finish, first);
+		iterator iter = std::move(last, finish, first);
 		allocator.destroy(iter, finish);
 		finish = iter;
 		return first;
@@ -358,7 +368,7 @@ public:
 
 	iterator erase(iterator position) {
 		if (position+1 != end()) 
-			std::copy(position+1, finish, position);
+			std::move(position+1, finish, position);
 		--finish;
 		allocator.destroy(finish);
 		return position;
@@ -0,0 +1,192 @@
+﻿#ifndef M_WS_DEQUE_HPP
+#define M_WS_DEQUE_HPP
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+#include "allocator.hpp"
+#include "utility.hpp"
+
+namespace sx {
+
+template<typename T>
+struct __ws_deque_array;
+
+template<typename T, typename Alloc = sx::allocator<T>>
+class ws_deque;
+
+
+/* 可增长的环形数组, 扩容后旧数组通过 prev 串起来, 等待 ws_deque 析构时统一回收 */
+template<typename T>
+struct __ws_deque_array {
+	using size_type = std::ptrdiff_t;
+public:
+	size_type				 mask;		/* 容量掩码 */
+	std::atomic<T>			*buffer;	/* 元素存储区 */
+	__ws_deque_array		*prev;		/* 被替换下来的旧数组 */
+public:
+	size_type capacity() const noexcept {
+		return mask + 1;
+	}
+
+	T get(size_type index) const noexcept {
+		return buffer[index & mask].load(std::memory_order_relaxed);
+	}
+
+	void put(size_type index, T value) noexcept {
+		buffer[index & mask].store(value, std::memory_order_relaxed);
+	}
+};
+
+
+/*
+ * Chase-Lev 工作窃取双端队列
+ * 所有者线程在 bottom 端 push / pop, 窃取线程在 top 端 steal
+ * 内存序参照 "Correct and Efficient Work-Stealing for Weak Memory Models" (Le et al. 2013)
+ * 窃取线程可能仍在读取扩容前的数组, 所以旧数组不会立即释放, 而是挂在新数组的 prev 链上,
+ * 直到 ws_deque 析构时才回收; 由于每次扩容容量翻倍, 旧数组总大小不会超过当前数组
+ */
+template<typename T, typename Alloc>
+class ws_deque {
+	static_assert(std::is_trivially_copyable<T>::value,
+		"ws_deque requires trivially copyable value_type, store pointers or handles for larger tasks");
+
+	using array				= __ws_deque_array<T>;
+	using ArrayAlloc		= decltype(sx::transform_alloator_type<T, array>(Alloc{}));
+	using SlotAlloc			= decltype(sx::transform_alloator_type<T, std::atomic<T>>(Alloc{}));
+public:
+	using value_type		= T;
+	using size_type			= std::size_t;
+	using difference_type	= std::ptrdiff_t;
+protected:
+	static ArrayAlloc		array_allocator;		/* 数组头分配器 */
+	static SlotAlloc		slot_allocator;			/* 槽位分配器 */
+	alignas(CACHE_LINE_SIZE) std::atomic<difference_type>	top;		/* 窃取端 */
+	alignas(CACHE_LINE_SIZE) std::atomic<difference_type>	bottom;		/* 所有者端 */
+	alignas(CACHE_LINE_SIZE) std::atomic<array *>			active;		/* 当前使用的数组 */
+public:
+	explicit ws_deque(size_type capacity = 64) : top(0), bottom(0) {
+		active.store(create_array(sx::__round_up_pow2(capacity < 2 ? 2 : capacity), nullptr),
+			std::memory_order_relaxed);
+	}
+
+	ws_deque(ws_deque const &) = delete;
+	ws_deque &operator=(ws_deque const &) = delete;
+
+	~ws_deque() {
+		array *arr = active.load(std::memory_order_relaxed);
+		while (arr != nullptr) {
+			array *prev = arr->prev;
+			destroy_array(arr);
+			arr = prev;
+		}
+	}
+private:
+	static array *create_array(difference_type capacity, array *prev) {
+		array *arr = array_allocator.allocate();
+		try {
+			arr->buffer = slot_allocator.allocate(capacity);
+		} catch (...) {
+			array_allocator.deallocate(arr, sizeof(array));
+			throw;
+		}
+		for (difference_type i = 0; i < capacity; ++i)
+			new(&arr->buffer[i]) std::atomic<T>();
+		arr->mask = capacity - 1;
+		arr->prev = prev;
+		return arr;
+	}
+
+	static void destroy_array(array *arr) {
+		slot_allocator.deallocate(arr->buffer, sizeof(std::atomic<T>) * arr->capacity());
+		array_allocator.deallocate(arr, sizeof(array));
+	}
+
+	/* 容量翻倍, 只由所有者线程调用 */
+	array *grow(array *old, difference_type b, difference_type t) {
+		array *arr = create_array(old->capacity() * 2, old);
+		for (difference_type i = t; i < b; ++i)
+			arr->put(i, old->get(i));
+		active.store(arr, std::memory_order_release);
+		return arr;
+	}
+public:
+	/* 并发情况下只是一个近似值 */
+	size_type size() const noexcept {
+		difference_type b = bottom.load(std::memory_order_relaxed);
+		difference_type t = top.load(std::memory_order_relaxed);
+		return b > t ? static_cast<size_type>(b - t) : 0;
+	}
+
+	bool empty() const noexcept {
+		return size() == 0;
+	}
+
+	size_type capacity() const noexcept {
+		return active.load(std::memory_order_relaxed)->capacity();
+	}
+
+	/* 仅所有者线程调用 */
+	void push(value_type value) {
+		difference_type b = bottom.load(std::memory_order_relaxed);
+		difference_type t = top.load(std::memory_order_acquire);
+		array *arr = active.load(std::memory_order_relaxed);
+		if (b - t > arr->capacity() - 1)
+			arr = grow(arr, b, t);
+
+		arr->put(b, value);
+		std::atomic_thread_fence(std::memory_order_release);
+		bottom.store(b + 1, std::memory_order_relaxed);
+	}
+
+	/* 仅所有者线程调用, 从 bottom 端取出最近压入的元素 */
+	bool pop(value_type &value) {
+		difference_type b = bottom.load(std::memory_order_relaxed) - 1;
+		array *arr = active.load(std::memory_order_relaxed);
+		bottom.store(b, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		difference_type t = top.load(std::memory_order_relaxed);
+
+		if (t > b) {
+			bottom.store(b + 1, std::memory_order_relaxed);
+			return false;
+		}
+
+		value = arr->get(b);
+		if (t == b) {
+			/* 只剩最后一个元素, 与窃取线程竞争 */
+			bool success = top.compare_exchange_strong(t, t + 1,
+				std::memory_order_seq_cst, std::memory_order_relaxed);
+			bottom.store(b + 1, std::memory_order_relaxed);
+			return success;
+		}
+		return true;
+	}
+
+	/* 任意线程调用, 从 top 端窃取最早压入的元素; 返回 false 表示队列为空或者竞争失败 */
+	bool steal(value_type &value) {
+		difference_type t = top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		difference_type b = bottom.load(std::memory_order_acquire);
+		if (t >= b)
+			return false;
+
+		array *arr = active.load(std::memory_order_acquire);
+		value_type result = arr->get(t);
+		if (!top.compare_exchange_strong(t, t + 1,
+				std::memory_order_seq_cst, std::memory_order_relaxed))
+			return false;
+
+		value = result;
+		return true;
+	}
+};
+
+template<typename T, typename Alloc>
+typename ws_deque<T, Alloc>::ArrayAlloc ws_deque<T, Alloc>::array_allocator{};
+
+template<typename T, typename Alloc>
+typename ws_deque<T, Alloc>::SlotAlloc ws_deque<T, Alloc>::slot_allocator{};
+
+}	// !namespace sx
+
+#endif // !M_WS_DEQUE_HPP